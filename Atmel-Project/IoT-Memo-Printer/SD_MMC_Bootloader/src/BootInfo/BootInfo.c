@@ -0,0 +1,174 @@
+/**************************************************************************//**
+* @file      BootInfo.c
+* @brief     Boot records kept in reserved NVM rows, right below the application
+* @details   The record is the encoded image header (Image/ImageFormat.h) of the installed application,
+*			 written at the start of BOOTINFO_ROW_ADDRESS. Its header CRC tells a valid record apart from
+*			 an erased or half written row.
+*			 A request is three words at the start of BOOTINFO_REQUEST_ROW_ADDRESS: BOOTINFO_REQUEST_MAGIC,
+*			 the BOOT_REQUEST_* bits and their complement.
+* @author
+* @date      2026-10-17
+
+******************************************************************************/
+
+
+/******************************************************************************
+* Includes
+******************************************************************************/
+#include <string.h>
+#include "BootInfo.h"
+#include "Image/ImageCheck.h"
+
+/******************************************************************************
+* Forward Declarations
+******************************************************************************/
+static enum status_code BootInfo_WaitReady(void);
+static enum status_code BootInfo_EraseRow(uint32_t rowAddress);
+
+/******************************************************************************
+* Global Functions
+******************************************************************************/
+
+/**************************************************************************//**
+* @fn		bool BootInfo_GetInstalled(struct ImageHeader *header)
+* @brief	Reads the header of the installed application
+* @param[out]	header	Header of the installed application. Only valid if the function returns true
+* @return	True if the row holds a valid record. False if it is erased, corrupt, or was never written
+*****************************************************************************/
+bool BootInfo_GetInstalled(struct ImageHeader *header)
+{
+	const uint8_t *record = (const uint8_t *)BOOTINFO_ROW_ADDRESS;
+
+	if (ImageFormat_ParseHeader(record, header) != 0)
+	{
+		return false;
+	}
+
+	return (Image_HeaderCrc(record) == header->headerCrc);
+}
+
+
+/**************************************************************************//**
+* @fn		enum status_code BootInfo_SetInstalled(const struct ImageHeader *header)
+* @brief	Records the header of the application that was just installed
+* @details	Erases the row and writes the encoded header on its first page. The header CRC is
+*			recalculated, so any headerCrc value can be passed.
+* @param[in]	header	Header of the installed application
+* @return	STATUS_OK on success, error reported by the NVM driver otherwise
+*****************************************************************************/
+enum status_code BootInfo_SetInstalled(const struct ImageHeader *header)
+{
+	COMPILER_WORD_ALIGNED uint8_t page[NVMCTRL_PAGE_SIZE];
+	enum status_code status;
+
+	memset(page, 0xFF, sizeof(page));
+	ImageFormat_WriteHeader(page, header);
+	ImageFormat_WriteU32(&page[IMAGE_HEADER_CRC_OFFSET], Image_HeaderCrc(page));
+
+	status = BootInfo_Clear();
+	if (status != STATUS_OK)
+	{
+		return status;
+	}
+
+	do
+	{
+		status = nvm_write_buffer(BOOTINFO_ROW_ADDRESS, page, NVMCTRL_PAGE_SIZE);
+	} while (status == STATUS_BUSY);
+
+	if (status == STATUS_OK)
+	{
+		status = BootInfo_WaitReady();
+	}
+
+	return status;
+}
+
+
+/**************************************************************************//**
+* @fn		enum status_code BootInfo_Clear(void)
+* @brief	Erases the record. Used when the installed application has no image header
+* @return	STATUS_OK on success, error reported by the NVM driver otherwise
+*****************************************************************************/
+enum status_code BootInfo_Clear(void)
+{
+	return BootInfo_EraseRow(BOOTINFO_ROW_ADDRESS);
+}
+
+
+/**************************************************************************//**
+* @fn		uint32_t BootInfo_GetRequests(void)
+* @brief	Reads the requests left by the application before its last reset
+* @return	BOOT_REQUEST_* bits. 0 if the row is erased or does not hold a valid request
+*****************************************************************************/
+uint32_t BootInfo_GetRequests(void)
+{
+	const uint32_t *request = (const uint32_t *)BOOTINFO_REQUEST_ROW_ADDRESS;
+
+	if (request[0] != BOOTINFO_REQUEST_MAGIC || request[1] != ~request[2])
+	{
+		return 0;
+	}
+
+	return request[1];
+}
+
+
+/**************************************************************************//**
+* @fn		enum status_code BootInfo_ClearRequests(void)
+* @brief	Erases the request row once the requests were served
+* @details	Does nothing if the row is already erased, so normal boots never erase it.
+* @return	STATUS_OK on success, error reported by the NVM driver otherwise
+*****************************************************************************/
+enum status_code BootInfo_ClearRequests(void)
+{
+	if (*(const uint32_t *)BOOTINFO_REQUEST_ROW_ADDRESS == 0xFFFFFFFFUL)
+	{
+		return STATUS_OK;
+	}
+
+	return BootInfo_EraseRow(BOOTINFO_REQUEST_ROW_ADDRESS);
+}
+
+
+/******************************************************************************
+* Static Functions
+******************************************************************************/
+
+/**************************************************************************//**
+* @fn		static enum status_code BootInfo_WaitReady(void)
+* @brief	Waits until the NVM controller finishes the current operation
+* @return	STATUS_OK if the operation finished without errors, STATUS_ABORTED otherwise
+*****************************************************************************/
+static enum status_code BootInfo_WaitReady(void)
+{
+	while (!nvm_is_ready())
+	{
+	}
+
+	return (nvm_get_error() == NVM_ERROR_NONE) ? STATUS_OK : STATUS_ABORTED;
+}
+
+
+/**************************************************************************//**
+* @fn		static enum status_code BootInfo_EraseRow(uint32_t rowAddress)
+* @brief	Erases one of the reserved rows and waits for the erase to finish
+* @param[in]	rowAddress	BOOTINFO_ROW_ADDRESS or BOOTINFO_REQUEST_ROW_ADDRESS
+* @return	STATUS_OK on success, error reported by the NVM driver otherwise
+*****************************************************************************/
+static enum status_code BootInfo_EraseRow(uint32_t rowAddress)
+{
+	enum status_code status;
+
+	do
+	{
+		status = nvm_erase_row(rowAddress);
+	} while (status == STATUS_BUSY);
+
+	if (status == STATUS_OK)
+	{
+		status = BootInfo_WaitReady();
+	}
+
+	return status;
+}
@@ -0,0 +1,49 @@
+/**************************************************************************//**
+* @file      BootInfo.h
+* @brief     Boot records kept in reserved NVM rows, right below the application
+* @details   After a verified update the bootloader stores the image header of the installed application
+*			 in the last row of the bootloader region, right below the application. It is used to skip
+*			 updates whose version is already installed.
+*			 The row below it holds the requests left by the application (WINC1500_HTTP_DOWNLOADER
+*			 src/BootRequest): the bootloader only touches the SD card when one is pending.
+*			 The three rows below hold the progress journal of the flasher (Flasher/FlasherJournal.h).
+*			 BOOTPROT must not cover these rows and the bootloader must end below BOOTINFO_JOURNAL_ROW_ADDRESS.
+* @author
+* @date      2026-10-17
+
+******************************************************************************/
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+* Includes
+******************************************************************************/
+#include <asf.h>
+#include "Image/ImageFormat.h"
+
+/******************************************************************************
+* Defines
+******************************************************************************/
+#define BOOTINFO_ROW_ADDRESS	((uint32_t)0x11F00)	///< Last NVM row below the application (0x12000)
+#define BOOTINFO_REQUEST_ROW_ADDRESS	((uint32_t)0x11E00)	///< Row written by the application to request an update. Must match BootRequest.h
+#define BOOTINFO_REQUEST_MAGIC	0x51455242UL		///< "BREQ" read as a little endian word. Marks a valid request
+#define BOOTINFO_JOURNAL_ROW_ADDRESS	((uint32_t)0x11B00)	///< First of the FLASHER_JOURNAL_ROWS rows of the flasher journal
+
+#define BOOT_REQUEST_UPDATE		0x00000001UL		///< Mount the SD card and look for an update flag file
+#define BOOT_REQUEST_DIAGNOSTIC	0x00000002UL		///< Also run the SD card write test
+
+/******************************************************************************
+* Global Function Declaration
+******************************************************************************/
+bool BootInfo_GetInstalled(struct ImageHeader *header);
+enum status_code BootInfo_SetInstalled(const struct ImageHeader *header);
+enum status_code BootInfo_Clear(void);
+uint32_t BootInfo_GetRequests(void);
+enum status_code BootInfo_ClearRequests(void);
+
+#ifdef __cplusplus
+}
+#endif
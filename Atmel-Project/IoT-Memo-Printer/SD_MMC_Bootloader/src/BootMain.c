@@ -20,6 +20,10 @@
 #include "SD Card/SdCard.h"
 #include "Systick/Systick.h"
 #include "SerialConsole/SerialConsole.h"
+#include "Flasher/Flasher.h"
+#include "Image/ImageCheck.h"
+#include "BootInfo/BootInfo.h"
+#include "BootTiming/BootTiming.h"
 #include "ASF/sam0/drivers/dsu/crc32/crc32.h"
 
 
@@ -43,8 +47,10 @@ struct usart_module cdc_uart_module; ///< Structure for UART module connected to
 * Local Function Declaration
 ******************************************************************************/
 static void jumpToApplication(void);
-static bool StartFilesystemAndTest(void);
+static bool StartFilesystemAndTest(bool writeTest);
 static void configure_nvm(void);
+static bool applicationIsPresent(void);
+static enum status_code checkUpdateFile(FIL *file, struct ImageHeader *header, uint32_t *imageOffset);
 
 
 /******************************************************************************
@@ -64,6 +70,7 @@ char test_b_file_name[] = "FlagB.txt";	///<Test TEXT File name
 char test_b_bin_file[] = "TestB.bin";	///<Test BINARY File name
 
 uint8_t update = 0;
+uint32_t bootRequests = 0; ///< BOOT_REQUEST_* bits left by the application before the reset. See BootInfo/BootInfo.h
 /******************************************************************************
 * Global Functions
 ******************************************************************************/
@@ -82,10 +89,10 @@ int main(void)
 	/*1.) INIT SYSTEM PERIPHERALS INITIALIZATION*/
 	system_init();
 	delay_init();
+	InitSystick();
+	BootTiming_Start();
 	InitializeSerialConsole();
 	system_interrupt_enable_global();
-	/* Initialize SD MMC stack */
-	sd_mmc_init();
 
 	//Initialize the NVM driver
 	configure_nvm();
@@ -97,17 +104,41 @@ int main(void)
 	dsu_crc32_init();
 
 	SerialConsoleWriteString("ESE516 - ENTER BOOTLOADER");	//Order to add string to TX Buffer
+	BootTiming_Mark(BOOT_PHASE_INIT);
 
 	/*END SYSTEM PERIPHERALS INITIALIZATION*/
 
 
+	//The SD card is only used when the application requested it before its last reset (see BootInfo/BootInfo.h),
+	//or when there is no application to boot. Normal boots go straight to the application.
+	bootRequests = BootInfo_GetRequests();
+	if (!applicationIsPresent())
+	{
+		bootRequests |= BOOT_REQUEST_UPDATE;
+	}
+
+	BootTiming_Mark(BOOT_PHASE_FLAGS);
+
+	if (bootRequests == 0)
+	{
+		SerialConsoleWriteString("\r\nNo update pending.\r\n");
+		goto exit_bootloader;
+	}
+
+	/* Initialize SD MMC stack */
+	sd_mmc_init();
+	BootTiming_SetOutcome(BOOT_RECORD_FLAG_SD, STATUS_OK);
+	BootTiming_Mark(BOOT_PHASE_SD_INIT);
+
+
 	/*2.) STARTS SIMPLE SD CARD MOUNTING AND TEST!*/
 
 	//EXAMPLE CODE ON MOUNTING THE SD CARD AND WRITING TO A FILE
 	//See function inside to see how to open a file
 	SerialConsoleWriteString("\x0C\n\r-- SD/MMC Card Example on FatFs --\n\r");
 
-	if(StartFilesystemAndTest() == false)
+	//The write test only runs when the application asks for a diagnostic boot
+	if(StartFilesystemAndTest((bootRequests & BOOT_REQUEST_DIAGNOSTIC) != 0) == false)
 	{
 		SerialConsoleWriteString("SD CARD failed! Check your connections. System will restart in 5 seconds...");
 		delay_cycles_ms(5000);
@@ -117,6 +148,7 @@ int main(void)
 	{
 		SerialConsoleWriteString("SD CARD mount success! Filesystem also mounted. \r\n");
 	}
+	BootTiming_Mark(BOOT_PHASE_MOUNT);
 
 	/*END SIMPLE SD CARD MOUNTING AND TEST!*/
 
@@ -136,13 +168,12 @@ int main(void)
 	snprintf(helpStr, 63,"NVM Info: Number of Pages %u. Size of a page: %u bytes. \r\n", parameters.nvm_number_of_pages, parameters.page_size);
 	SerialConsoleWriteString(helpStr);
 	
-	// check flags
+	// check flags. The flag is only deleted once the new image is verified, so an interrupted update is retried on the next boot
 	res = f_open(&file_object, (char const *)test_a_file_name, FA_READ);
 	if (res == FR_OK)
 	{
 		f_close(&file_object);
-		res = f_unlink(test_a_file_name);
-		SerialConsoleWriteString("FlagA.txt detected and deleted!\r\n");
+		SerialConsoleWriteString("FlagA.txt detected!\r\n");
 		update = 1;
 	}
 	else
@@ -151,8 +182,7 @@ int main(void)
 		if (res == FR_OK)
 		{
 			f_close(&file_object);
-			res = f_unlink(test_b_file_name);
-			SerialConsoleWriteString("FlagB.txt detected and deleted!\r\n");
+			SerialConsoleWriteString("FlagB.txt detected!\r\n");
 			update = 2;
 		}
 		else
@@ -161,19 +191,19 @@ int main(void)
 		}
 	}
 
+	BootTiming_Mark(BOOT_PHASE_FLAGS);
+
 	if (update != 0)
 	{
 		//The SAMD21 NVM (and most if not all NVMs) can only erase and write by certain chunks of data size.
 		//The SAMD21 can WRITE on pages. However erase are done by ROW. One row is conformed by four (4) pages.
 		//An erase is mandatory before writing to a page.
-	
+		//The Flasher module streams the binary row by row: the next row is read from the SD card while the current
+		//row is erased, then the current row is programmed. The CRC32 of the file is chained while it streams in and
+		//compared against one DSU CRC32 pass over the programmed flash range.
+		//The file may also be LZ compressed, or a delta patch against the installed image (see Tools/deltadiff.c).
+		//Files stamped with Tools/fwstamp.c start with an image header: it and the payload CRC32 are checked before anything is erased.
 
-		//We will do the following in this example:
-		//Erase the first row of the application data
-		//Read a page of data from the SD Card. The SD CARD initialization writes a file with this data as its test for initialization
-		//Write it to the first row.
-		//CheckCRC32 of both files.
-		
 		//Read SD Card File
 		res = f_open(&file_object, (char const *)(update == 1)?test_a_bin_file:test_b_bin_file, FA_READ);
 		if (res != FR_OK)
@@ -182,152 +212,104 @@ int main(void)
 		}
 		else
 		{
-			uint32_t file_size = f_size(&file_object);
-			enum status_code nvmError;
-			enum status_code crcres = STATUS_OK;
-			uint32_t resultCrcSd = 0;
-			uint32_t resultCrcNvm = 0;
-
-			uint8_t readBuffer[row_size]; //Buffer the size of one row
-			UINT numBytesRead;
-			uint32_t row_addr = APP_START_ADDRESS;
-		
-			// 		f_lseek(&file_object, 0); // rewind read/write pointer
-
-			// 		snprintf(helpStr, 63,"file size: %u, row size: %u\r\n", file_size, row_size);
-			// 		SerialConsoleWriteString(helpStr);
-		
-			for (uint32_t i = 0; i < file_size/row_size; i++)
-			{
-				// erase row
-				nvmError = nvm_erase_row(row_addr);
-				if(nvmError != STATUS_OK)
-				{
-					SerialConsoleWriteString("Erase error");
-				}
-			
-				//Make sure it got erased - we read the page. Erasure in NVM is an 0xFF
-				for(int iter = 0; iter < row_size; iter++)
-				{
-					char *a = (char *)(row_addr + iter); //Pointer pointing to address APP_START_ADDRESS
-					if(*a != 0xFF)
-					{
-						SerialConsoleWriteString("Error - test page is not erased!");
-						break;
-					}
-				}
-			
-				// read row from bin file
-				numBytesRead = 0;
-				// 		FRESULT f_read (
-				// 		FIL *fp, 		/* Pointer to the file object */
-				// 		void *buff,		/* Pointer to data buffer */
-				// 		UINT btr,		/* Number of bytes to read */
-				// 		UINT *br		/* Pointer to number of bytes read */
-				// 		)
-				res = f_read(&file_object, readBuffer, row_size, &numBytesRead);
-			
-				//Write data to row. Writes are per page, so we need four writes to write a complete row
-				for (int pg = 0; pg < 4; pg++)
-				{
-					res = nvm_write_buffer (row_addr + pg*parameters.page_size, &readBuffer[pg*parameters.page_size], parameters.page_size);
-				}
-
-				if (res != FR_OK)
-				{
-					snprintf(helpStr, 63, "Test write to NVM failed at row address 0x%X!\r\n", row_addr);
-					SerialConsoleWriteString(helpStr);
-				}
-				else
-				{
-					snprintf(helpStr, 63, "Test write to NVM succeeded at row address 0x%X!\r\n", row_addr);
-					SerialConsoleWriteString(helpStr);
-				}
-				delay_cycles_ms(10); // avoid buffering issues
-			
-				*((volatile unsigned int*) 0x41007058) &= ~0x30000UL;
-				crcres |= dsu_crc32_cal	(readBuffer, row_size, &resultCrcSd);
-				*((volatile unsigned int*) 0x41007058) |= 0x20000UL;
-				crcres |= dsu_crc32_cal	(row_addr, row_size, &resultCrcNvm);
-			
-				row_addr += row_size;
-			}
-			// last row
-			nvmError = nvm_erase_row(row_addr);
-			if(nvmError != STATUS_OK)
+			struct FlasherStats flasherStats;
+			struct ImageHeader imageHeader;
+			uint32_t imageOffset = 0;
+			enum status_code checkStatus = checkUpdateFile(&file_object, &imageHeader, &imageOffset);
+			enum status_code flashStatus = checkStatus;
+			BootTiming_Mark(BOOT_PHASE_CHECK);
+
+			if (checkStatus == STATUS_OK)
 			{
-				SerialConsoleWriteString("Erase error");
+				flashStatus = Flasher_ProgramFromFile(&file_object, imageOffset, APP_START_ADDRESS, &flasherStats);
+				BootTiming_Mark(BOOT_PHASE_FLASH);
+				BootTiming_Add(BOOT_PHASE_FLASH_READ, flasherStats.readUs);
+				BootTiming_Add(BOOT_PHASE_FLASH_ERASE, flasherStats.eraseUs);
+				BootTiming_Add(BOOT_PHASE_FLASH_PROGRAM, flasherStats.programUs);
+				BootTiming_Add(BOOT_PHASE_FLASH_VERIFY, flasherStats.verifyUs);
+				Flasher_PrintStats(&flasherStats);
 			}
-			for(int iter = 0; iter < row_size; iter++)
-			{
-				char *a = (char *)(row_addr + iter); //Pointer pointing to address APP_START_ADDRESS
-				if(*a != 0xFF)
-				{
-					SerialConsoleWriteString("Error - test page is not erased!");
-					break;
-				}
-			}
-			numBytesRead = 0;
-			res = f_read(&file_object, readBuffer, file_size%row_size, &numBytesRead);
-			for (int i = numBytesRead; i < row_size; i++)
+			f_close(&file_object);
+			BootTiming_SetOutcome((flashStatus == STATUS_OK && checkStatus == STATUS_OK) ? BOOT_RECORD_FLAG_UPDATED : 0, flashStatus);
+
+			if (checkStatus == STATUS_NO_CHANGE)
 			{
-				readBuffer[i] = 1;
+				snprintf(helpStr, 63, "Version %lu already installed. Skipping update.\r\n", (unsigned long)imageHeader.version);
+				SerialConsoleWriteString(helpStr);
 			}
-			for (int pg = 0; pg < numBytesRead/parameters.page_size + 1; pg++)
+			else if (checkStatus != STATUS_OK || flashStatus == STATUS_ERR_BAD_FORMAT || flashStatus == STATUS_ERR_BAD_ADDRESS || flashStatus == STATUS_ERR_DENIED)
 			{
-				res = nvm_write_buffer (row_addr + pg*parameters.page_size, &readBuffer[pg*parameters.page_size], parameters.page_size);
+				//Rejected before anything was erased (bad header, payload CRC mismatch, image too large, or a delta patch made against another image).
+				//The installed image is intact, so drop the update and boot it. A patch that cannot be resumed (STATUS_ERR_BAD_DATA) is not in this list: the flash may hold a half patched image
+				snprintf(helpStr, 63, "Update rejected (%d)! Keeping installed image.\r\n", flashStatus);
+				SerialConsoleWriteString(helpStr);
 			}
-
-			if (res != FR_OK)
+			else if (flashStatus != STATUS_OK)
 			{
-				snprintf(helpStr, 63, "Test write to NVM failed at row address 0x%X!\r\n", row_addr);
+				//Never jump into a partially written or corrupted image. The flag is kept so the update is retried
+				snprintf(helpStr, 63, "Flashing failed (%d) at row address 0x%lX!\r\n", flashStatus, (unsigned long)(APP_START_ADDRESS + (flasherStats.rowsResumed + flasherStats.rowsWritten + flasherStats.rowsSkipped) * row_size));
 				SerialConsoleWriteString(helpStr);
+				SerialConsoleWriteString("Image not verified. System will restart in 5 seconds...\r\n");
+				delay_cycles_ms(5000);
+				system_reset();
 			}
 			else
 			{
-				snprintf(helpStr, 63, "Test write to NVM succeeded at row address 0x%X!\r\n", row_addr);
-				SerialConsoleWriteString(helpStr);
-			}
-
-
-			//CRC32 Calculation example: Please read http://asf.atmel.com/docs/latest/samd21/html/group__asfdoc__sam0__drivers__crc32__group.html
-
-			//ERRATA Part 1 - To be done before RAM CRC
-			//CRC of SD Card. Errata 1.8.3 determines we should run this code every time we do CRC32 from a RAM source. See http://ww1.microchip.com/downloads/en/DeviceDoc/SAM-D21-Family-Silicon-Errata-and-DataSheet-Clarification-DS80000760D.pdf Section 1.8.3
-			*((volatile unsigned int*) 0x41007058) &= ~0x30000UL;
+				SerialConsoleWriteString("Flashing succeeded!\r\n");
 
-			//CRC of SD Card
-			crcres |= dsu_crc32_cal	(readBuffer, numBytesRead, &resultCrcSd); //Instructor note: Was it the third parameter used for? Please check how you can use the third parameter to do the CRC of a long data stream in chunks - you will need it!
-		
-			//Errata Part 2 - To be done after RAM CRC
-			*((volatile unsigned int*) 0x41007058) |= 0x20000UL;
-		
-		
-			//CRC of memory (NVM)
-			crcres |= dsu_crc32_cal	(row_addr, numBytesRead, &resultCrcNvm);
-		
+				//Remember what is installed, so the same file is not flashed again. Plain binaries carry no version
+				if (imageOffset == 0)
+				{
+					BootInfo_Clear();
+				}
+				else if (flasherStats.flashCrc != imageHeader.imageCrc)
+				{
+					BootInfo_Clear();
+					SerialConsoleWriteString("Image CRC does not match the header! Version not recorded.\r\n");
+				}
+				else if (BootInfo_SetInstalled(&imageHeader) != STATUS_OK)
+				{
+					SerialConsoleWriteString("Could not record the installed version!\r\n");
+				}
+			}
 
-			if (crcres != STATUS_OK)
+			res = f_unlink((update == 1) ? test_a_file_name : test_b_file_name);
+			if (res == FR_OK)
 			{
-				SerialConsoleWriteString("Could not calculate CRC!!\r\n");
+				SerialConsoleWriteString((update == 1) ? "FlagA.txt deleted!\r\n" : "FlagB.txt deleted!\r\n");
+				update = 0;
 			}
 			else
 			{
-				snprintf(helpStr, 63,"CRC SD CARD: %u  CRC NVM: %u \r\n", resultCrcSd, resultCrcNvm);
+				snprintf(helpStr, 63, "Could not delete %s (res %d)! Update kept pending.\r\n", (update == 1) ? "FlagA.txt" : "FlagB.txt", res);
 				SerialConsoleWriteString(helpStr);
 			}
 		}
 	}
 
+	//The request stays pending, and the SD card is checked again on the next boot, while a flag file is left
+	if (update == 0)
+	{
+		BootInfo_ClearRequests();
+	}
+	BootTiming_Mark(BOOT_PHASE_FLAGS);
+
 	/*END BOOTLOADER HERE!*/
 
 	//4.) DEINITIALIZE HW AND JUMP TO MAIN APPLICATION!
+	exit_bootloader:
+	BootTiming_Print();
 	SerialConsoleWriteString("ESE516 - EXIT BOOTLOADER");	//Order to add string to TX Buffer
 	delay_cycles_ms(100); //Delay to allow print
 		
 	//Deinitialize HW - deinitialize started HW here!
 	DeinitializeSerialConsole(); //Deinitializes UART
-	sd_mmc_deinit(); //Deinitialize SD CARD
+	if (bootRequests != 0)
+	{
+		sd_mmc_deinit(); //Deinitialize SD CARD
+	}
+	BootTiming_Finish(); //Seals the timing record left in RAM for the main application
+	DeinitSystick(); //Stops the Systick timer so no tick fires before the main application sets its own vector table up
 
 
 	//Jump to application
@@ -350,13 +332,14 @@ int main(void)
 
 
 /**************************************************************************//**
-* function      static void StartFilesystemAndTest()
+* function      static bool StartFilesystemAndTest(bool writeTest)
 * @brief        Starts the filesystem and tests it. Sets the filesystem to the global variable fs
 * @details      Jumps to the main application. Please turn off ALL PERIPHERALS that were turned on by the bootloader
 *				before performing the jump!
+* @param[in]    writeTest	True to also write the test files (sd_mmc_test.txt and sd_binary.bin). Diagnostic boots only
 * @return       Returns true is SD card and file system test passed. False otherwise.
 ******************************************************************************/
-static bool StartFilesystemAndTest(void)
+static bool StartFilesystemAndTest(bool writeTest)
 {
 	bool sdCardPass = true;
 	uint8_t binbuff[256];
@@ -386,6 +369,12 @@ static bool StartFilesystemAndTest(void)
 		}
 		SerialConsoleWriteString("[OK]\r\n");
 
+		//Writing the test files costs boot time and SD card wear, so it is skipped on update boots
+		if (!writeTest)
+		{
+			goto main_end_of_test;
+		}
+
 		//Create and open a file
 		SerialConsoleWriteString("Create a file (f_open)...\r\n");
 
@@ -491,6 +480,61 @@ applicationCodeEntry();
 
 
 
+/**************************************************************************//**
+* function      static enum status_code checkUpdateFile(FIL *file, struct ImageHeader *header, uint32_t *imageOffset)
+* @brief        Validates an update file before anything is erased
+* @details      Stamped files (Image/ImageFormat.h) must have a valid header, be linked at APP_START_ADDRESS and
+*				match their payload CRC32. Files without a header are still accepted as plain images for
+*				compatibility with older update files; they are then checked by the Flasher only.
+* @param[in]    file			Update file opened for reading
+* @param[out]   header			Image header of the file. Only valid if imageOffset is not 0
+* @param[out]   imageOffset		Offset of the image in the file. 0 for a file without header
+* @return       STATUS_OK if the file can be flashed, STATUS_NO_CHANGE if the same image is already installed,
+*				error from Image_ReadHeader() or Image_CheckPayload() otherwise
+******************************************************************************/
+static enum status_code checkUpdateFile(FIL *file, struct ImageHeader *header, uint32_t *imageOffset)
+{
+	char helpStr[64];
+	enum status_code status = Image_ReadHeader(file, header);
+
+	*imageOffset = 0;
+	if (status == STATUS_ERR_NOT_FOUND)
+	{
+		SerialConsoleWriteString("No image header. Flashing as a plain image.\r\n");
+		return STATUS_OK;
+	}
+	if (status != STATUS_OK)
+	{
+		return status;
+	}
+
+	*imageOffset = IMAGE_HEADER_SIZE;
+	snprintf(helpStr, 63, "Image version %lu, %lu bytes\r\n", (unsigned long)header->version, (unsigned long)header->imageSize);
+	SerialConsoleWriteString(helpStr);
+
+	if (Image_IsInstalled(header))
+	{
+		return STATUS_NO_CHANGE;
+	}
+
+	return Image_CheckPayload(file, header, APP_START_ADDRESS);
+}
+
+
+
+/**************************************************************************//**
+* function      static bool applicationIsPresent(void)
+* @brief        Checks that the application area holds something to jump to
+* @details      The first word of the application is its initial stack pointer. Erased flash reads 0xFFFFFFFF.
+* @return       True if the application area is not erased
+******************************************************************************/
+static bool applicationIsPresent(void)
+{
+	return (*(uint32_t *)APP_START_ADDRESS != 0xFFFFFFFFUL);
+}
+
+
+
 /**************************************************************************//**
 * function      static void configure_nvm(void)
 * @brief        Configures the NVM driver
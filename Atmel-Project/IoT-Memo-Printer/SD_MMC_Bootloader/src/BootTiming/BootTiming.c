@@ -0,0 +1,138 @@
+/**************************************************************************//**
+* @file      BootTiming.c
+* @brief     Boot phase timing, printed on the serial console and kept in RAM for the application
+* @details   BootTiming_Mark() charges the time since the previous mark to a phase, so the marks in
+*			 BootMain.c only need to follow the order of the boot. The record is sealed with its check
+*			 word by BootTiming_Finish(), right before the jump.
+* @author
+* @date      2026-10-17
+
+******************************************************************************/
+
+
+/******************************************************************************
+* Includes
+******************************************************************************/
+#include <string.h>
+#include <stddef.h>
+#include "BootTiming.h"
+#include "Systick/Systick.h"
+#include "SerialConsole/SerialConsole.h"
+
+/******************************************************************************
+* Variables
+******************************************************************************/
+__attribute__((section(".bootrecord"))) static struct BootRecord bootRecord;	///< Record of this boot. Not cleared by the startup code
+static uint32_t startUs = 0;	///< Time of BootTiming_Start()
+static uint32_t lastMarkUs = 0;	///< Time of the previous mark
+
+/// Names of the phases, in enum BootPhase order
+static const char *const phaseNames[BOOT_PHASE_COUNT] = {
+	"init", "sd init", "mount", "flags", "check", "flash", " read", " erase", " program", " verify", "deinit"
+};
+
+/******************************************************************************
+* Global Functions
+******************************************************************************/
+
+/**************************************************************************//**
+* @fn		void BootTiming_Start(void)
+* @brief	Clears the record and starts timing. Call right after InitSystick()
+*****************************************************************************/
+void BootTiming_Start(void)
+{
+	memset(&bootRecord, 0, sizeof(bootRecord));
+	bootRecord.magic = BOOT_RECORD_MAGIC;
+	bootRecord.size = sizeof(bootRecord);
+	bootRecord.phaseCount = BOOT_PHASE_COUNT;
+	bootRecord.updateStatus = STATUS_OK;
+
+	startUs = GetSystickUs();
+	lastMarkUs = startUs;
+}
+
+
+/**************************************************************************//**
+* @fn		void BootTiming_Mark(enum BootPhase phase)
+* @brief	Ends a phase: the time since the previous mark is added to it
+* @param[in]	phase	Phase that just finished
+*****************************************************************************/
+void BootTiming_Mark(enum BootPhase phase)
+{
+	uint32_t nowUs = GetSystickUs();
+
+	BootTiming_Add(phase, nowUs - lastMarkUs);
+	lastMarkUs = nowUs;
+}
+
+
+/**************************************************************************//**
+* @fn		void BootTiming_Add(enum BootPhase phase, uint32_t us)
+* @brief	Adds time measured elsewhere (e.g. FlasherStats) to a phase
+* @param[in]	phase	Phase to add the time to
+* @param[in]	us		Time, in us
+*****************************************************************************/
+void BootTiming_Add(enum BootPhase phase, uint32_t us)
+{
+	if (phase < BOOT_PHASE_COUNT)
+	{
+		bootRecord.phaseUs[phase] += us;
+	}
+}
+
+
+/**************************************************************************//**
+* @fn		void BootTiming_SetOutcome(uint32_t flags, enum status_code updateStatus)
+* @brief	Records what the boot did
+* @param[in]	flags			BOOT_RECORD_FLAG_* bits, added to the ones already set
+* @param[in]	updateStatus	Result of the update
+*****************************************************************************/
+void BootTiming_SetOutcome(uint32_t flags, enum status_code updateStatus)
+{
+	bootRecord.flags |= flags;
+	bootRecord.updateStatus = updateStatus;
+}
+
+
+/**************************************************************************//**
+* @fn		void BootTiming_Print(void)
+* @brief	Prints the phases timed so far, in ms, on the serial console. Phases that did not run are left out
+*****************************************************************************/
+void BootTiming_Print(void)
+{
+	char helpStr[64];
+	uint32_t elapsedUs = GetSystickUs() - startUs;
+
+	SerialConsoleWriteString("\r\nBoot timing (ms)\r\n");
+	for (uint8_t phase = 0; phase < BOOT_PHASE_COUNT; phase++)
+	{
+		uint32_t us = bootRecord.phaseUs[phase];
+		if (us != 0)
+		{
+			snprintf(helpStr, 63, "%-9s %6lu.%03lu\r\n", phaseNames[phase], (unsigned long)(us / 1000UL), (unsigned long)(us % 1000UL));
+			SerialConsoleWriteString(helpStr);
+		}
+	}
+	snprintf(helpStr, 63, "%-9s %6lu.%03lu\r\n", "so far", (unsigned long)(elapsedUs / 1000UL), (unsigned long)(elapsedUs % 1000UL));
+	SerialConsoleWriteString(helpStr);
+}
+
+
+/**************************************************************************//**
+* @fn		void BootTiming_Finish(void)
+* @brief	Ends the deinit phase and seals the record. Call right before the jump, while the Systick still runs
+*****************************************************************************/
+void BootTiming_Finish(void)
+{
+	const uint32_t *word = (const uint32_t *)&bootRecord;
+	uint32_t sum = 0;
+
+	BootTiming_Mark(BOOT_PHASE_DEINIT);
+	bootRecord.totalUs = lastMarkUs - startUs;
+
+	for (uint32_t i = 0; i < offsetof(struct BootRecord, check) / 4; i++)
+	{
+		sum += word[i];
+	}
+	bootRecord.check = ~sum;
+}
@@ -0,0 +1,76 @@
+/**************************************************************************//**
+* @file      BootTiming.h
+* @brief     Boot phase timing, printed on the serial console and kept in RAM for the application
+* @details   Each phase of the boot is timed with the Systick (GetSystickUs). The record of the current
+*			 boot lives in the .bootrecord section: the last 256 bytes of RAM, which both linker scripts
+*			 keep out of the RAM region. The application finds it there after the jump
+*			 (WINC1500_HTTP_DOWNLOADER src/BootRecord, same layout).
+*			 The clock setup (system_init) runs before the Systick is started, so it is not covered.
+* @author
+* @date      2026-10-17
+
+******************************************************************************/
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+* Includes
+******************************************************************************/
+#include <asf.h>
+
+/******************************************************************************
+* Defines
+******************************************************************************/
+#define BOOT_RECORD_ADDRESS		((uint32_t)0x20007F00)	///< Start of the .bootrecord section
+#define BOOT_RECORD_MAGIC		0x43455242UL			///< "BREC" read as a little endian word
+
+#define BOOT_RECORD_FLAG_SD			0x00000001UL	///< The SD card was mounted (update requested or no application)
+#define BOOT_RECORD_FLAG_UPDATED	0x00000002UL	///< A new image was flashed and verified
+
+/******************************************************************************
+* Structures and Enumerations
+******************************************************************************/
+/// Boot phases, in the order they run. The FLASH_* phases split BOOT_PHASE_FLASH and are not added to the total
+enum BootPhase {
+	BOOT_PHASE_INIT = 0,		///< Console, NVM and CRC32 set up, after the clock setup
+	BOOT_PHASE_SD_INIT,			///< SD/MMC stack init
+	BOOT_PHASE_MOUNT,			///< SD card init and FatFs mount (and the write test on diagnostic boots)
+	BOOT_PHASE_FLAGS,			///< Boot requests, update flag files and installed version record
+	BOOT_PHASE_CHECK,			///< Image header and payload CRC32 checks
+	BOOT_PHASE_FLASH,			///< Flasher_ProgramFromFile, as a whole
+	BOOT_PHASE_FLASH_READ,		///< SD card reads, decompression and patching
+	BOOT_PHASE_FLASH_ERASE,		///< Row erases not hidden behind the reads
+	BOOT_PHASE_FLASH_PROGRAM,	///< Page writes
+	BOOT_PHASE_FLASH_VERIFY,	///< CRC32 checks
+	BOOT_PHASE_DEINIT,			///< Console flush, peripheral deinit, up to the jump
+	BOOT_PHASE_COUNT
+};
+
+/// Record of one boot. Shared with the application: only append fields
+struct BootRecord {
+	uint32_t magic;							///< BOOT_RECORD_MAGIC
+	uint16_t size;							///< sizeof(struct BootRecord)
+	uint16_t phaseCount;					///< BOOT_PHASE_COUNT
+	uint32_t flags;							///< BOOT_RECORD_FLAG_*
+	int32_t updateStatus;					///< Result of the update (enum status_code). STATUS_OK if there was none
+	uint32_t phaseUs[BOOT_PHASE_COUNT];		///< Time spent in each phase, in us
+	uint32_t totalUs;						///< Time from the Systick start to the jump, in us
+	uint32_t check;							///< Complement of the sum of the words above. Tells a record apart from RAM garbage
+};
+
+/******************************************************************************
+* Global Function Declaration
+******************************************************************************/
+void BootTiming_Start(void);
+void BootTiming_Mark(enum BootPhase phase);
+void BootTiming_Add(enum BootPhase phase, uint32_t us);
+void BootTiming_SetOutcome(uint32_t flags, enum status_code updateStatus);
+void BootTiming_Print(void);
+void BootTiming_Finish(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,129 @@
+/**************************************************************************//**
+* @file      DeltaFormat.h
+* @brief     Layout of the binary delta (patch) firmware update file
+* @details   Shared between the bootloader and the host tools (Tools/deltadiff.c). Plain C only, no ASF.
+*
+*			 A patch rebuilds a new image from the image currently in flash (the base), one NVM row at a time,
+*			 in place: every new row is assembled in RAM from base bytes and literal bytes, then written over
+*			 the same row of the base. Rows are processed in ascending or descending order (DELTA_FLAG_DESCENDING).
+*			 To keep the base bytes a row needs intact, a copy may only read base bytes that have not been
+*			 overwritten yet:
+*				ascending order:	source offset >= start of the row being built
+*				descending order:	source offset + length <= end of the row being built
+*
+*			 Header: 32 bytes, all fields little endian.
+*				offset 0	magic		DELTA_MAGIC ("DLT1")
+*				offset 4	baseSize	Size of the base image, in bytes
+*				offset 8	baseCrc		CRC32 of the base image padded with 0xFF to whole rows
+*				offset 12	newSize		Size of the new image, in bytes
+*				offset 16	newCrc		CRC32 of the new image padded with 0xFF to whole rows
+*				offset 20	recordsSize	Size of the records that follow the header, in bytes
+*				offset 24	flags		DELTA_FLAG_*
+*				offset 25	reserved	7 bytes, written as 0
+*
+*			 CRC32 is the usual IEEE 802.3 / zlib CRC (reflected 0xEDB88320, initial value and final XOR
+*			 0xFFFFFFFF). On target it is the DSU CRC32 seeded with 0xFFFFFFFF, complemented.
+*
+*			 Records: for every row, in processing order, a list of operations that produce exactly the row's
+*			 bytes of the new image (DELTA_ROW_SIZE, less for the last row, which is then padded with 0xFF).
+*				0LLLLLLL <L+1 bytes>					Literal: L+1 new bytes follow
+*				1LLLLLLL <offset, 3 bytes LE>			Copy: L+1 bytes from the base image at offset
+* @author
+* @date      2026-10-17
+
+******************************************************************************/
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+* Includes
+******************************************************************************/
+#include <stdint.h>
+
+/******************************************************************************
+* Defines
+******************************************************************************/
+#define DELTA_MAGIC				0x31544C44UL	///< "DLT1" read as a little endian word
+#define DELTA_HEADER_SIZE		32				///< Size of the patch header, in bytes
+#define DELTA_ROW_SIZE			256				///< Rows are SAMD21 NVM rows (4 pages of 64 bytes)
+#define DELTA_FLAG_DESCENDING	0x01			///< Rows are rebuilt from the last one down to the first one
+
+#define DELTA_OP_COPY			0x80			///< Operation byte bit: copy from the base image
+#define DELTA_OP_LENGTH_MASK	0x7F			///< Operation byte bits holding length - 1
+#define DELTA_OP_MAX_LENGTH		128				///< Longest run a single operation can describe
+#define DELTA_COPY_OFFSET_SIZE	3				///< Bytes of the copy source offset
+
+/******************************************************************************
+* Structures and Enumerations
+******************************************************************************/
+/// Decoded patch header
+struct DeltaHeader {
+	uint32_t magic;			///< Must be DELTA_MAGIC
+	uint32_t baseSize;		///< Size of the base image, in bytes
+	uint32_t baseCrc;		///< CRC32 of the base image padded to whole rows
+	uint32_t newSize;		///< Size of the new image, in bytes
+	uint32_t newCrc;		///< CRC32 of the new image padded to whole rows
+	uint32_t recordsSize;	///< Size of the records, in bytes
+	uint8_t flags;			///< DELTA_FLAG_*
+};
+
+/******************************************************************************
+* Inline Functions
+******************************************************************************/
+/// Number of rows an image of size bytes takes
+static inline uint32_t DeltaFormat_Rows(uint32_t size)
+{
+	return (size + DELTA_ROW_SIZE - 1) / DELTA_ROW_SIZE;
+}
+
+/// Reads a little endian 32 bit word from a byte buffer
+static inline uint32_t DeltaFormat_ReadU32(const uint8_t *data)
+{
+	return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+/// Writes a little endian 32 bit word into a byte buffer
+static inline void DeltaFormat_WriteU32(uint8_t *data, uint32_t value)
+{
+	data[0] = (uint8_t)value;
+	data[1] = (uint8_t)(value >> 8);
+	data[2] = (uint8_t)(value >> 16);
+	data[3] = (uint8_t)(value >> 24);
+}
+
+/// Decodes a patch header. Returns 0 if the magic matches, -1 otherwise
+static inline int DeltaFormat_ParseHeader(const uint8_t *data, struct DeltaHeader *header)
+{
+	header->magic = DeltaFormat_ReadU32(&data[0]);
+	header->baseSize = DeltaFormat_ReadU32(&data[4]);
+	header->baseCrc = DeltaFormat_ReadU32(&data[8]);
+	header->newSize = DeltaFormat_ReadU32(&data[12]);
+	header->newCrc = DeltaFormat_ReadU32(&data[16]);
+	header->recordsSize = DeltaFormat_ReadU32(&data[20]);
+	header->flags = data[24];
+
+	return (header->magic == DELTA_MAGIC) ? 0 : -1;
+}
+
+/// Encodes a patch header into DELTA_HEADER_SIZE bytes
+static inline void DeltaFormat_WriteHeader(uint8_t *data, const struct DeltaHeader *header)
+{
+	DeltaFormat_WriteU32(&data[0], DELTA_MAGIC);
+	DeltaFormat_WriteU32(&data[4], header->baseSize);
+	DeltaFormat_WriteU32(&data[8], header->baseCrc);
+	DeltaFormat_WriteU32(&data[12], header->newSize);
+	DeltaFormat_WriteU32(&data[16], header->newCrc);
+	DeltaFormat_WriteU32(&data[20], header->recordsSize);
+	data[24] = header->flags;
+	for (int i = 25; i < DELTA_HEADER_SIZE; i++)
+	{
+		data[i] = 0;
+	}
+}
+
+#ifdef __cplusplus
+}
+#endif
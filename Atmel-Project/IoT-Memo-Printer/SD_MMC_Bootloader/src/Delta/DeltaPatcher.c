@@ -0,0 +1,180 @@
+/**************************************************************************//**
+* @file      DeltaPatcher.c
+* @brief     Rebuilds the rows of a new image from a base image and a delta patch
+* @details   See DeltaFormat.h for the record layout and the rules copies must follow so that a row can
+*			 be written over the base in place.
+* @author
+* @date      2026-10-17
+
+******************************************************************************/
+
+
+/******************************************************************************
+* Includes
+******************************************************************************/
+#include <string.h>
+#include "DeltaPatcher.h"
+
+/******************************************************************************
+* Defines
+******************************************************************************/
+#define DELTA_ERASED_BYTE	0xFF	///< Padding of the last row
+
+/******************************************************************************
+* Forward Declarations
+******************************************************************************/
+static bool DeltaPatcher_NextByte(struct DeltaPatcher *patcher, uint8_t *value);
+
+/******************************************************************************
+* Global Functions
+******************************************************************************/
+
+/**************************************************************************//**
+* @fn		void DeltaPatcher_Init(struct DeltaPatcher *patcher, const struct DeltaHeader *header, const uint8_t *base, DeltaFillFn fill, void *context)
+* @brief	Prepares a patcher for a new patch
+* @param[out]	patcher	Patcher to initialize
+* @param[in]	header	Decoded patch header
+* @param[in]	base	Start of the base image. Must stay readable until the last row is returned
+* @param[in]	fill	Callback that provides the records, starting right after the header
+* @param[in]	context	Passed to fill
+*****************************************************************************/
+void DeltaPatcher_Init(struct DeltaPatcher *patcher, const struct DeltaHeader *header, const uint8_t *base, DeltaFillFn fill, void *context)
+{
+	patcher->fill = fill;
+	patcher->context = context;
+	patcher->base = base;
+	patcher->baseLimit = DeltaFormat_Rows(header->baseSize) * DELTA_ROW_SIZE;
+	patcher->newSize = header->newSize;
+	patcher->rowCount = DeltaFormat_Rows(header->newSize);
+	patcher->rowsDone = 0;
+	patcher->inputPos = 0;
+	patcher->inputLen = 0;
+	patcher->descending = (header->flags & DELTA_FLAG_DESCENDING) != 0;
+	patcher->error = false;
+	patcher->ownRow = false;
+}
+
+
+/**************************************************************************//**
+* @fn		int32_t DeltaPatcher_NextRow(struct DeltaPatcher *patcher, uint8_t *row, uint32_t *rowIndex)
+* @brief	Builds the next row of the new image, in the order given by the patch
+* @details	Reads base bytes for the row being built, so the caller must write the row back only after
+*			this function returns. The row is padded with 0xFF past the end of the new image.
+* @param[in,out]	patcher	Patcher initialized with DeltaPatcher_Init
+* @param[out]	row		Row buffer, DELTA_ROW_SIZE bytes long
+* @param[out]	rowIndex	Index of the row that was built, counted from the start of the image
+* @return	Number of new image bytes in row, 0 once all rows were returned, DELTA_PATCHER_ERROR if the
+*			records are corrupt, truncated or read base bytes that may already be overwritten
+*****************************************************************************/
+int32_t DeltaPatcher_NextRow(struct DeltaPatcher *patcher, uint8_t *row, uint32_t *rowIndex)
+{
+	uint32_t index;
+	uint32_t rowStart;
+	uint32_t rowBytes;
+	uint32_t filled = 0;
+
+	if (patcher->error)
+	{
+		return DELTA_PATCHER_ERROR;
+	}
+	if (patcher->rowsDone >= patcher->rowCount)
+	{
+		return 0;
+	}
+
+	index = patcher->descending ? (patcher->rowCount - 1 - patcher->rowsDone) : patcher->rowsDone;
+	rowStart = index * DELTA_ROW_SIZE;
+	rowBytes = patcher->newSize - rowStart;
+	if (rowBytes > DELTA_ROW_SIZE)
+	{
+		rowBytes = DELTA_ROW_SIZE;
+	}
+
+	patcher->ownRow = false;
+	while (filled < rowBytes)
+	{
+		uint8_t op;
+		uint32_t length;
+
+		if (!DeltaPatcher_NextByte(patcher, &op))
+		{
+			break;
+		}
+		length = (uint32_t)(op & DELTA_OP_LENGTH_MASK) + 1;
+		if (filled + length > rowBytes)
+		{
+			patcher->error = true;
+			break;
+		}
+
+		if (op & DELTA_OP_COPY)
+		{
+			uint8_t b0, b1, b2;
+			if (!DeltaPatcher_NextByte(patcher, &b0) || !DeltaPatcher_NextByte(patcher, &b1) || !DeltaPatcher_NextByte(patcher, &b2))
+			{
+				break;
+			}
+
+			uint32_t offset = (uint32_t)b0 | ((uint32_t)b1 << 8) | ((uint32_t)b2 << 16);
+			bool overwritten = patcher->descending ? (offset + length > rowStart + DELTA_ROW_SIZE) : (offset < rowStart);
+			if (offset + length > patcher->baseLimit || overwritten)
+			{
+				patcher->error = true;
+				break;
+			}
+			patcher->ownRow |= (offset < rowStart + DELTA_ROW_SIZE) && (offset + length > rowStart);
+			memcpy(&row[filled], &patcher->base[offset], length);
+			filled += length;
+		}
+		else
+		{
+			while (length-- > 0)
+			{
+				if (!DeltaPatcher_NextByte(patcher, &row[filled]))
+				{
+					break;
+				}
+				filled++;
+			}
+		}
+	}
+
+	if (filled < rowBytes)
+	{
+		patcher->error = true;
+		return DELTA_PATCHER_ERROR;
+	}
+
+	memset(&row[rowBytes], DELTA_ERASED_BYTE, DELTA_ROW_SIZE - rowBytes);
+	patcher->rowsDone++;
+	*rowIndex = index;
+	return (int32_t)rowBytes;
+}
+
+
+/******************************************************************************
+* Static Functions
+******************************************************************************/
+
+/**************************************************************************//**
+* @fn		static bool DeltaPatcher_NextByte(struct DeltaPatcher *patcher, uint8_t *value)
+* @brief	Returns the next patch byte, refilling the input buffer when it runs empty
+* @param[in,out]	patcher	Patcher state
+* @param[out]	value	Next patch byte
+* @return	False if the fill callback has no more data
+*****************************************************************************/
+static bool DeltaPatcher_NextByte(struct DeltaPatcher *patcher, uint8_t *value)
+{
+	if (patcher->inputPos >= patcher->inputLen)
+	{
+		patcher->inputLen = (uint16_t)patcher->fill(patcher->context, patcher->input, DELTA_INPUT_BUFFER_SIZE);
+		patcher->inputPos = 0;
+		if (patcher->inputLen == 0)
+		{
+			return false;
+		}
+	}
+
+	*value = patcher->input[patcher->inputPos++];
+	return true;
+}
@@ -0,0 +1,63 @@
+/**************************************************************************//**
+* @file      DeltaPatcher.h
+* @brief     Rebuilds the rows of a new image from a base image and a delta patch
+* @details   Reads the records described in DeltaFormat.h through a fill callback and assembles one row
+*			 at a time. The base image is read through a plain pointer (memory mapped flash on target).
+*			 Only a small input buffer is kept, so RAM use does not depend on the image size.
+*			 Plain C only, no ASF, so the same file is used by the host tools.
+* @author
+* @date      2026-10-17
+
+******************************************************************************/
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+* Includes
+******************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "DeltaFormat.h"
+
+/******************************************************************************
+* Defines
+******************************************************************************/
+#define DELTA_INPUT_BUFFER_SIZE		64		///< Patch bytes requested from the fill callback at a time
+#define DELTA_PATCHER_ERROR			(-1)	///< Returned by DeltaPatcher_NextRow on corrupt or truncated records
+
+/******************************************************************************
+* Structures and Enumerations
+******************************************************************************/
+/// Fill callback. Copies up to length patch bytes into buffer and returns how many were copied. 0 means end of input or error
+typedef size_t (*DeltaFillFn)(void *context, uint8_t *buffer, size_t length);
+
+/// Patcher state
+struct DeltaPatcher {
+	uint8_t input[DELTA_INPUT_BUFFER_SIZE];	///< Patch bytes not yet consumed
+	DeltaFillFn fill;						///< Callback used to refill input
+	void *context;							///< Passed to fill
+	const uint8_t *base;					///< Start of the base image
+	uint32_t baseLimit;						///< Base bytes that can be read (base rows * DELTA_ROW_SIZE)
+	uint32_t newSize;						///< Size of the new image
+	uint32_t rowCount;						///< Number of rows of the new image
+	uint32_t rowsDone;						///< Rows returned so far
+	uint16_t inputPos;						///< Next byte to consume in input
+	uint16_t inputLen;						///< Number of valid bytes in input
+	bool descending;						///< Rows are rebuilt from the last one down
+	bool error;								///< Set once corrupt or truncated records were found
+	bool ownRow;							///< The last row returned copied base bytes from its own row, so it can not be rebuilt once that row is erased
+};
+
+/******************************************************************************
+* Global Function Declaration
+******************************************************************************/
+void DeltaPatcher_Init(struct DeltaPatcher *patcher, const struct DeltaHeader *header, const uint8_t *base, DeltaFillFn fill, void *context);
+int32_t DeltaPatcher_NextRow(struct DeltaPatcher *patcher, uint8_t *row, uint32_t *rowIndex);
+
+#ifdef __cplusplus
+}
+#endif
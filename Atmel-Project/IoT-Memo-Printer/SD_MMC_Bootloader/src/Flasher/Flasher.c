@@ -0,0 +1,344 @@
+/**************************************************************************//**
+* @file      Flasher.c
+* @brief     Pipelined SD card to NVM flashing engine used by the bootloader
+* @details   Target side of the flashing engine: the struct FlasherHal callbacks for the SAMD21 and the
+*			 mapping of enum FlasherResult onto enum status_code. The image file is a FatFs file, row
+*			 erases are issued straight to the NVM controller so they run while the next row is read,
+*			 pages are written with nvm_write_buffer() and the CRC32s come from the DSU.
+* @author
+* @date      2026-10-17
+
+******************************************************************************/
+
+
+/******************************************************************************
+* Includes
+******************************************************************************/
+#include <string.h>
+#include "Flasher.h"
+#include "Systick/Systick.h"
+#include "SerialConsole/SerialConsole.h"
+#include "BootInfo/BootInfo.h"
+#include "ASF/sam0/drivers/dsu/crc32/crc32.h"
+
+/******************************************************************************
+* Defines
+******************************************************************************/
+#define FLASHER_DSU_ERRATA_REG		(*((volatile unsigned int*) 0x41007058))	///< Register touched by the errata 1.8.3 workaround for CRC32 from RAM
+
+/******************************************************************************
+* Forward Declarations
+******************************************************************************/
+static void Flasher_GetHal(FIL *file, struct FlasherHal *hal);
+static enum status_code Flasher_Status(enum FlasherResult result);
+static enum FlasherResult Flasher_Read(void *context, uint8_t *buffer, uint32_t length, uint32_t *numBytesRead);
+static enum FlasherResult Flasher_Seek(void *context, uint32_t offset);
+static uint32_t Flasher_Size(void *context);
+static enum FlasherResult Flasher_StartErase(void *context, uint32_t rowAddress);
+static enum FlasherResult Flasher_WaitReady(void *context);
+static enum FlasherResult Flasher_WritePage(void *context, uint32_t address, const uint8_t *data);
+static enum FlasherResult Flasher_CrcRam(void *context, const uint8_t *data, uint32_t length, uint32_t *crc);
+static enum FlasherResult Flasher_CrcFlashRaw(void *context, uint32_t address, uint32_t length, uint32_t *crc);
+static const uint8_t *Flasher_Flash(void *context, uint32_t address);
+static uint32_t Flasher_TimeUs(void *context);
+
+/******************************************************************************
+* Global Functions
+******************************************************************************/
+
+/**************************************************************************//**
+* @fn		enum status_code Flasher_ProgramFromFile(FIL *file, uint32_t fileOffset, uint32_t startAddress, struct FlasherStats *stats)
+* @brief	Programs the content of an open file into the NVM, starting at startAddress
+* @details	See FlasherCore_Program for the image formats and the order of the operations.
+* @param[in]	file			Pointer to a FatFs file object opened for reading
+* @param[in]	fileOffset		Offset of the image in the file, in bytes. 0 for a plain binary
+* @param[in]	startAddress	NVM address of the first row to program. Must be aligned to a row
+* @param[out]	stats			Filled with statistics of the run. Valid even if the function fails
+* @return	STATUS_OK if the whole file was programmed and verified. STATUS_ERR_BAD_ADDRESS if the
+*			start address is not row aligned or the image does not fit in the NVM, STATUS_ERR_IO if the
+*			SD card could not be read, STATUS_ERR_BAD_FORMAT if the file header is inconsistent,
+*			STATUS_ERR_DENIED if a delta patch does not match the installed image (nothing is erased
+*			then), STATUS_ERR_BAD_DATA if an interrupted patch cannot be resumed, STATUS_ABORTED if the
+*			NVM reported an error or the programmed image does not match.
+*****************************************************************************/
+enum status_code Flasher_ProgramFromFile(FIL *file, uint32_t fileOffset, uint32_t startAddress, struct FlasherStats *stats)
+{
+	struct FlasherHal hal;
+
+	Flasher_GetHal(file, &hal);
+	return Flasher_Status(FlasherCore_Program(&hal, fileOffset, startAddress, stats));
+}
+
+
+/**************************************************************************//**
+* @fn		void Flasher_PrintStats(const struct FlasherStats *stats)
+* @brief	Prints the statistics of a flashing run on the serial console
+* @param[in]	stats	Statistics filled by Flasher_ProgramFromFile
+*****************************************************************************/
+void Flasher_PrintStats(const struct FlasherStats *stats)
+{
+	static const char *const imageTypeNames[] = { "raw", "LZ", "delta" };
+	char helpStr[64];
+	uint32_t elapsedMs = (stats->elapsedMs == 0) ? 1 : stats->elapsedMs;
+
+	uint32_t imageRows = stats->rowsWritten + stats->rowsSkipped;
+
+	snprintf(helpStr, 63, "Flashed %lu bytes (%s image) in %lu ms\r\n", (unsigned long)stats->bytesWritten, imageTypeNames[stats->imageType], (unsigned long)stats->elapsedMs);
+	SerialConsoleWriteString(helpStr);
+	snprintf(helpStr, 63, "Rows written: %lu, skipped: %lu\r\n", (unsigned long)stats->rowsWritten, (unsigned long)stats->rowsSkipped);
+	SerialConsoleWriteString(helpStr);
+	if (stats->rowsResumed > 0)
+	{
+		snprintf(helpStr, 63, "Resumed interrupted update after %lu rows\r\n", (unsigned long)stats->rowsResumed);
+		SerialConsoleWriteString(helpStr);
+	}
+	snprintf(helpStr, 63, "Throughput: %lu rows/s, %lu B/s\r\n", (unsigned long)((imageRows * 1000UL) / elapsedMs), (unsigned long)((stats->bytesWritten * 1000UL) / elapsedMs));
+	SerialConsoleWriteString(helpStr);
+	snprintf(helpStr, 63, "CRC SD CARD: 0x%08lX  CRC NVM: 0x%08lX\r\n", (unsigned long)stats->imageCrc, (unsigned long)stats->flashCrc);
+	SerialConsoleWriteString(helpStr);
+}
+
+
+/**************************************************************************//**
+* @fn		enum status_code Flasher_CrcFlash(uint32_t address, uint32_t length, uint32_t *crc)
+* @brief	Runs the DSU CRC32 over a flash range and returns the usual (zlib) CRC32
+* @details	Seeds the DSU with FLASHER_CRC_SEED and complements the result, so the value can be compared
+*			with CRCs computed by the host tools.
+* @param[in]	address	Word aligned flash address
+* @param[in]	length	Length of the range, in bytes. Must be a multiple of 4
+* @param[out]	crc		CRC32 of the range
+* @return	Result of dsu_crc32_cal()
+*****************************************************************************/
+enum status_code Flasher_CrcFlash(uint32_t address, uint32_t length, uint32_t *crc)
+{
+	uint32_t value = FLASHER_CRC_SEED;
+	enum status_code status = dsu_crc32_cal(address, length, &value);
+
+	*crc = ~value;
+	return status;
+}
+
+
+/**************************************************************************//**
+* @fn		enum status_code Flasher_CrcFile(FIL *file, uint32_t offset, uint32_t length, uint32_t *crc)
+* @brief	Calculates the usual (zlib) CRC32 of a range of a file on the SD card
+* @details	See FlasherCore_CrcFile. Nothing is written to the NVM.
+* @param[in]	file	FatFs file object opened for reading. Its read pointer is moved
+* @param[in]	offset	Offset of the first byte, in bytes
+* @param[in]	length	Number of bytes to cover
+* @param[out]	crc		CRC32 of the range
+* @return	STATUS_OK, STATUS_ERR_IO if the file could not be read or is shorter than offset + length
+*****************************************************************************/
+enum status_code Flasher_CrcFile(FIL *file, uint32_t offset, uint32_t length, uint32_t *crc)
+{
+	struct FlasherHal hal;
+
+	Flasher_GetHal(file, &hal);
+	return Flasher_Status(FlasherCore_CrcFile(&hal, offset, length, crc));
+}
+
+
+/******************************************************************************
+* Static Functions
+******************************************************************************/
+
+/**************************************************************************//**
+* @fn		static void Flasher_GetHal(FIL *file, struct FlasherHal *hal)
+* @brief	Fills the hardware access of the core for a file on the SD card
+* @param[in]	file	Image file, passed to the callbacks as their context
+* @param[out]	hal		Callbacks for the SAMD21
+*****************************************************************************/
+static void Flasher_GetHal(FIL *file, struct FlasherHal *hal)
+{
+	hal->context = file;
+	hal->flashSize = FLASH_SIZE;
+	hal->journalAddress = BOOTINFO_JOURNAL_ROW_ADDRESS;
+	hal->read = Flasher_Read;
+	hal->seek = Flasher_Seek;
+	hal->size = Flasher_Size;
+	hal->startErase = Flasher_StartErase;
+	hal->waitReady = Flasher_WaitReady;
+	hal->writePage = Flasher_WritePage;
+	hal->crcRam = Flasher_CrcRam;
+	hal->crcFlash = Flasher_CrcFlashRaw;
+	hal->flash = Flasher_Flash;
+	hal->timeUs = Flasher_TimeUs;
+}
+
+
+/**************************************************************************//**
+* @fn		static enum status_code Flasher_Status(enum FlasherResult result)
+* @brief	Maps a result of the core onto the ASF status codes used by the bootloader
+* @param[in]	result	Result of the core
+* @return	Matching status code
+*****************************************************************************/
+static enum status_code Flasher_Status(enum FlasherResult result)
+{
+	switch (result)
+	{
+		case FLASHER_OK:				return STATUS_OK;
+		case FLASHER_ERR_IO:			return STATUS_ERR_IO;
+		case FLASHER_ERR_BAD_FORMAT:	return STATUS_ERR_BAD_FORMAT;
+		case FLASHER_ERR_BAD_ADDRESS:	return STATUS_ERR_BAD_ADDRESS;
+		case FLASHER_ERR_BAD_DATA:		return STATUS_ERR_BAD_DATA;
+		case FLASHER_ERR_BAD_BASE:		return STATUS_ERR_DENIED;
+		case FLASHER_ERR_BUSY:			return STATUS_BUSY;
+		default:						return STATUS_ABORTED;
+	}
+}
+
+
+/**************************************************************************//**
+* @fn		static enum FlasherResult Flasher_Read(void *context, uint8_t *buffer, uint32_t length, uint32_t *numBytesRead)
+* @brief	Reads from the image file with f_read()
+*****************************************************************************/
+static enum FlasherResult Flasher_Read(void *context, uint8_t *buffer, uint32_t length, uint32_t *numBytesRead)
+{
+	UINT count = 0;
+	FRESULT res = f_read((FIL *)context, buffer, (UINT)length, &count);
+
+	*numBytesRead = count;
+	return (res == FR_OK) ? FLASHER_OK : FLASHER_ERR_IO;
+}
+
+
+/**************************************************************************//**
+* @fn		static enum FlasherResult Flasher_Seek(void *context, uint32_t offset)
+* @brief	Moves the read pointer of the image file with f_lseek()
+*****************************************************************************/
+static enum FlasherResult Flasher_Seek(void *context, uint32_t offset)
+{
+	return (f_lseek((FIL *)context, offset) == FR_OK) ? FLASHER_OK : FLASHER_ERR_IO;
+}
+
+
+/**************************************************************************//**
+* @fn		static uint32_t Flasher_Size(void *context)
+* @brief	Returns the size of the image file
+*****************************************************************************/
+static uint32_t Flasher_Size(void *context)
+{
+	return f_size((FIL *)context);
+}
+
+
+/**************************************************************************//**
+* @fn		static enum FlasherResult Flasher_StartErase(void *context, uint32_t rowAddress)
+* @brief	Issues a row erase command and returns without waiting for it to finish
+* @details	Same sequence as nvm_erase_row(), minus the final busy wait. The core waits on
+*			Flasher_WaitReady() before issuing another NVM command.
+* @param[in]	context		Unused
+* @param[in]	rowAddress	Address of the row to erase. Must be aligned to a row
+* @return	FLASHER_OK if the erase was started, FLASHER_ERR_BUSY if the NVM controller is busy
+*****************************************************************************/
+static enum FlasherResult Flasher_StartErase(void *context, uint32_t rowAddress)
+{
+	(void)context;
+
+	if (!nvm_is_ready())
+	{
+		return FLASHER_ERR_BUSY;
+	}
+
+	NVMCTRL->STATUS.reg = NVMCTRL_STATUS_MASK;
+	NVMCTRL->ADDR.reg = (uintptr_t)&NVM_MEMORY[rowAddress / 4];
+	NVMCTRL->CTRLA.reg = NVM_COMMAND_ERASE_ROW | NVMCTRL_CTRLA_CMDEX_KEY;
+
+	return FLASHER_OK;
+}
+
+
+/**************************************************************************//**
+* @fn		static enum FlasherResult Flasher_WaitReady(void *context)
+* @brief	Waits until the NVM controller finishes the current operation
+* @return	FLASHER_OK if the operation finished without errors, FLASHER_ERR_NVM otherwise
+*****************************************************************************/
+static enum FlasherResult Flasher_WaitReady(void *context)
+{
+	(void)context;
+
+	while (!nvm_is_ready())
+	{
+	}
+
+	return (nvm_get_error() == NVM_ERROR_NONE) ? FLASHER_OK : FLASHER_ERR_NVM;
+}
+
+
+/**************************************************************************//**
+* @fn		static enum FlasherResult Flasher_WritePage(void *context, uint32_t address, const uint8_t *data)
+* @brief	Writes one page with nvm_write_buffer()
+* @details	The NVM is configured with automatic page writes, so the call starts the page write and
+*			returns; the core waits on the ready flag before the next command.
+*****************************************************************************/
+static enum FlasherResult Flasher_WritePage(void *context, uint32_t address, const uint8_t *data)
+{
+	(void)context;
+
+	switch (nvm_write_buffer(address, data, FLASHER_PAGE_SIZE))
+	{
+		case STATUS_OK:		return FLASHER_OK;
+		case STATUS_BUSY:	return FLASHER_ERR_BUSY;
+		default:			return FLASHER_ERR_NVM;
+	}
+}
+
+
+/**************************************************************************//**
+* @fn		static enum FlasherResult Flasher_CrcRam(void *context, const uint8_t *data, uint32_t length, uint32_t *crc)
+* @brief	Runs the DSU CRC32 over a RAM buffer
+* @details	Wraps dsu_crc32_cal() with the workaround from errata 1.8.3, required every time the
+*			CRC32 is calculated from a RAM source.
+* @param[in]	context	Unused
+* @param[in]	data	Word aligned RAM buffer
+* @param[in]	length	Length of the buffer, in bytes. Must be a multiple of 4
+* @param[in,out]	crc	Seed on input, result on output
+* @return	FLASHER_OK, FLASHER_ERR_NVM if the DSU reported an error
+*****************************************************************************/
+static enum FlasherResult Flasher_CrcRam(void *context, const uint8_t *data, uint32_t length, uint32_t *crc)
+{
+	enum status_code status;
+
+	(void)context;
+	FLASHER_DSU_ERRATA_REG &= ~0x30000UL;
+	status = dsu_crc32_cal((uint32_t)data, length, crc);
+	FLASHER_DSU_ERRATA_REG |= 0x20000UL;
+
+	return (status == STATUS_OK) ? FLASHER_OK : FLASHER_ERR_NVM;
+}
+
+
+/**************************************************************************//**
+* @fn		static enum FlasherResult Flasher_CrcFlashRaw(void *context, uint32_t address, uint32_t length, uint32_t *crc)
+* @brief	Runs the DSU CRC32 over a flash range, without seeding or complementing
+*****************************************************************************/
+static enum FlasherResult Flasher_CrcFlashRaw(void *context, uint32_t address, uint32_t length, uint32_t *crc)
+{
+	(void)context;
+
+	return (dsu_crc32_cal(address, length, crc) == STATUS_OK) ? FLASHER_OK : FLASHER_ERR_NVM;
+}
+
+
+/**************************************************************************//**
+* @fn		static const uint8_t *Flasher_Flash(void *context, uint32_t address)
+* @brief	The flash is memory mapped from address 0
+*****************************************************************************/
+static const uint8_t *Flasher_Flash(void *context, uint32_t address)
+{
+	(void)context;
+
+	return (const uint8_t *)address;
+}
+
+
+/**************************************************************************//**
+* @fn		static uint32_t Flasher_TimeUs(void *context)
+* @brief	Time base of the statistics: the Systick, in us
+*****************************************************************************/
+static uint32_t Flasher_TimeUs(void *context)
+{
+	(void)context;
+
+	return GetSystickUs();
+}
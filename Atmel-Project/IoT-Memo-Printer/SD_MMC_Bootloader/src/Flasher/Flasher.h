@@ -0,0 +1,38 @@
+/**************************************************************************//**
+* @file      Flasher.h
+* @brief     Pipelined SD card to NVM flashing engine used by the bootloader
+* @details   Streams an application binary from an open FatFs file into the NVM one row at a time.
+*			 Two row buffers are used so that the next row is read from the SD card while the
+*			 NVM controller erases the current row. Completion of every NVM operation is detected
+*			 with the NVM ready flag instead of fixed delays. Rows that did not change are skipped. The whole image is verified with one
+*			 CRC32 comparison once it is programmed. LZ compressed images are decompressed on the fly and
+*			 delta patches are applied in place over the installed image.
+*			 The engine itself lives in FlasherCore.c; this file plugs FatFs, the NVM controller, the DSU
+*			 and the Systick into it.
+* @author
+* @date      2026-10-17
+
+******************************************************************************/
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+* Includes
+******************************************************************************/
+#include <asf.h>
+#include "FlasherCore.h"
+
+/******************************************************************************
+* Global Function Declaration
+******************************************************************************/
+enum status_code Flasher_ProgramFromFile(FIL *file, uint32_t fileOffset, uint32_t startAddress, struct FlasherStats *stats);
+void Flasher_PrintStats(const struct FlasherStats *stats);
+enum status_code Flasher_CrcFlash(uint32_t address, uint32_t length, uint32_t *crc);
+enum status_code Flasher_CrcFile(FIL *file, uint32_t offset, uint32_t length, uint32_t *crc);
+
+#ifdef __cplusplus
+}
+#endif
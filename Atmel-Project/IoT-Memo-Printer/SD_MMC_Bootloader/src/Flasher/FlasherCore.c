@@ -0,0 +1,824 @@
+/**************************************************************************//**
+* @file      FlasherCore.c
+* @brief     Hardware independent part of the flashing engine
+* @details   The image is programmed one row at a time using two row buffers. While the NVM controller
+*			 erases row N, the CPU reads row N+1 from the SD card into the second buffer. Row N is then
+*			 programmed page by page, waiting on the NVM between pages. Rows whose flash content
+*			 already matches the SD card data (same CRC32) are skipped. A CRC32 of the image is
+*			 chained across the row buffers while the file streams in, and is checked against a single
+*			 CRC32 pass over the programmed flash range once the last row is written.
+*			 Delta patches are applied in place: each new row is rebuilt in RAM from the installed image
+*			 and the patch records, then written over the same row.
+*			 Progress is kept in the journal (FlasherJournal.h) before rows are erased, so a run cut by a
+*			 power loss resumes from the last recorded row on the next boot. Each row is verified right
+*			 after it is programmed, so every row the journal covers is known good.
+* @author
+* @date      2026-10-17
+
+******************************************************************************/
+
+
+/******************************************************************************
+* Includes
+******************************************************************************/
+#include <string.h>
+#include "FlasherCore.h"
+#include "FlasherJournal.h"
+#include "Lz/LzDecoder.h"
+#include "Delta/DeltaPatcher.h"
+
+/******************************************************************************
+* Defines
+******************************************************************************/
+#define FLASHER_HEADER_PROBE_SIZE	DELTA_HEADER_SIZE	///< Bytes read to detect the image format. Largest of the supported headers
+#define FLASHER_CRC_POLYNOMIAL		0xEDB88320UL		///< Reflected CRC32 polynomial, same as the DSU
+
+/******************************************************************************
+* Variables
+******************************************************************************/
+static uint32_t rowWords[2][FLASHER_ROW_SIZE / 4];	///< Double buffer. One row is programmed while the other is filled from the SD card. Words keep it aligned for the DSU
+static uint8_t *const rowBuffer[2] = { (uint8_t *)rowWords[0], (uint8_t *)rowWords[1] };
+static struct LzDecoder lzDecoder;		///< Streaming decompressor used when the file is an LZ image
+static struct DeltaPatcher deltaPatcher;	///< Rebuilds rows when the file is a delta patch
+static enum FlasherImageType imageType = FLASHER_IMAGE_RAW;	///< Format of the file being programmed
+static struct FlasherJournal journal;	///< Progress of the current update, and of an interrupted one
+
+/******************************************************************************
+* Forward Declarations
+******************************************************************************/
+static enum FlasherResult FlasherCore_RowIsUnchanged(const struct FlasherHal *hal, uint32_t rowAddress, const uint8_t *buffer, bool *unchanged);
+static enum FlasherResult FlasherCore_ProgramRow(const struct FlasherHal *hal, uint32_t rowAddress, const uint8_t *buffer, uint32_t numBytes);
+static enum FlasherResult FlasherCore_WriteRow(const struct FlasherHal *hal, uint32_t rowAddress, const uint8_t *buffer, uint32_t numBytes, struct FlasherStats *stats);
+static enum FlasherResult FlasherCore_StreamImage(const struct FlasherHal *hal, uint32_t fileOffset, uint32_t imageSize, uint32_t startAddress, struct FlasherStats *stats);
+static enum FlasherResult FlasherCore_ResumeStream(const struct FlasherHal *hal, uint32_t fileOffset, uint32_t imageSize, uint32_t startAddress, uint32_t *rows, uint32_t *imageCrc, struct FlasherStats *stats);
+static enum FlasherResult FlasherCore_RestoreRow(const struct FlasherHal *hal, uint32_t rowAddress, uint8_t *buffer);
+static enum FlasherResult FlasherCore_PatchImage(const struct FlasherHal *hal, const struct DeltaHeader *header, uint32_t startAddress, struct FlasherStats *stats);
+static enum FlasherResult FlasherCore_OpenImage(const struct FlasherHal *hal, uint32_t fileOffset, uint32_t *imageSize, struct DeltaHeader *deltaHeader);
+static size_t FlasherCore_FileFill(void *context, uint8_t *buffer, size_t length);
+static enum FlasherResult FlasherCore_ReadRow(const struct FlasherHal *hal, uint8_t *buffer, uint32_t *numBytesRead);
+static uint32_t FlasherCore_CrcBytes(uint32_t crc, const uint8_t *data, uint32_t length);
+
+/******************************************************************************
+* Global Functions
+******************************************************************************/
+
+/**************************************************************************//**
+* @fn		enum FlasherResult FlasherCore_Program(const struct FlasherHal *hal, uint32_t fileOffset, uint32_t startAddress, struct FlasherStats *stats)
+* @brief	Programs the content of the image file into the NVM, starting at startAddress
+* @details	The image starts at fileOffset and runs to the end of the file, so a stamped update file
+*			(see Image/ImageFormat.h) is programmed by passing the size of its header. The format is
+*			detected from the start of the image. Files that begin with an LZ container
+*			header (see Lz/LzFormat.h) are decompressed on the fly, delta patches (see Delta/DeltaFormat.h)
+*			are applied over the installed image, any other file is programmed as is. The last row is
+*			padded with the erased value (0xFF). Rows that already hold the new content are left untouched.
+*			The image is verified once, after the last row, against a CRC32 of the whole range.
+*			If the journal holds the record of an interrupted run of the same file, the rows it covers
+*			are not programmed again. The journal is cleared once the image is verified, or found wrong.
+* @param[in]	hal				Hardware access
+* @param[in]	fileOffset		Offset of the image in the file, in bytes. 0 for a plain binary
+* @param[in]	startAddress	NVM address of the first row to program. Must be aligned to a row
+* @param[out]	stats			Filled with statistics of the run. Valid even if the function fails
+* @return	FLASHER_OK if the whole file was programmed and verified. FLASHER_ERR_BAD_ADDRESS if the
+*			start address is not row aligned or the image does not fit in the NVM, FLASHER_ERR_IO if the
+*			file could not be read, FLASHER_ERR_BAD_FORMAT if the file header is inconsistent,
+*			FLASHER_ERR_BAD_BASE if a delta patch does not match the installed image (nothing is erased
+*			then), FLASHER_ERR_BAD_DATA if an interrupted patch cannot be resumed, FLASHER_ERR_NVM if the
+*			NVM reported an error or the programmed image does not match.
+*****************************************************************************/
+enum FlasherResult FlasherCore_Program(const struct FlasherHal *hal, uint32_t fileOffset, uint32_t startAddress, struct FlasherStats *stats)
+{
+	enum FlasherResult result;
+	uint32_t startUs = hal->timeUs(hal->context);
+	uint32_t imageSize = 0;
+	uint32_t fileSize = hal->size(hal->context);
+	uint32_t fileCrc = 0;
+	struct DeltaHeader deltaHeader;
+
+	memset(stats, 0, sizeof(struct FlasherStats));
+
+	//The first row of the file tells this update apart from the one a journal record may belong to
+	if (hal->journalAddress != 0 && fileOffset < fileSize)
+	{
+		uint32_t length = fileSize - fileOffset;
+		result = FlasherCore_CrcFile(hal, fileOffset, (length < FLASHER_ROW_SIZE) ? length : FLASHER_ROW_SIZE, &fileCrc);
+		if (result != FLASHER_OK)
+		{
+			return result;
+		}
+	}
+	FlasherJournal_Open(hal, &journal, fileCrc, fileSize, startAddress);
+
+	result = FlasherCore_OpenImage(hal, fileOffset, &imageSize, &deltaHeader);
+	stats->imageType = imageType;
+	if (result != FLASHER_OK)
+	{
+		return result;
+	}
+
+	if ((startAddress & (FLASHER_ROW_SIZE - 1)) != 0 || (startAddress + imageSize) > hal->flashSize)
+	{
+		return FLASHER_ERR_BAD_ADDRESS;
+	}
+
+	if (imageType == FLASHER_IMAGE_DELTA)
+	{
+		result = FlasherCore_PatchImage(hal, &deltaHeader, startAddress, stats);
+	}
+	else
+	{
+		result = FlasherCore_StreamImage(hal, fileOffset, imageSize, startAddress, stats);
+	}
+
+	//A wrong image also ends the record, so the next attempt starts over instead of trusting it again
+	if (result == FLASHER_OK || stats->crcErrors > 0)
+	{
+		enum FlasherResult clearResult = FlasherJournal_Clear(hal, &journal);
+		result = (result == FLASHER_OK) ? clearResult : result;
+	}
+
+	stats->elapsedMs = (hal->timeUs(hal->context) - startUs) / 1000UL;
+	return result;
+}
+
+
+/**************************************************************************//**
+* @fn		enum FlasherResult FlasherCore_CrcFlash(const struct FlasherHal *hal, uint32_t address, uint32_t length, uint32_t *crc)
+* @brief	Calculates the usual (zlib) CRC32 of a flash range
+* @param[in]	hal		Hardware access
+* @param[in]	address	Word aligned flash address
+* @param[in]	length	Length of the range, in bytes. Must be a multiple of 4
+* @param[out]	crc		CRC32 of the range
+* @return	Result of the crcFlash callback
+*****************************************************************************/
+enum FlasherResult FlasherCore_CrcFlash(const struct FlasherHal *hal, uint32_t address, uint32_t length, uint32_t *crc)
+{
+	uint32_t value = FLASHER_CRC_SEED;
+	enum FlasherResult result = hal->crcFlash(hal->context, address, length, &value);
+
+	*crc = ~value;
+	return result;
+}
+
+
+/**************************************************************************//**
+* @fn		enum FlasherResult FlasherCore_CrcFile(const struct FlasherHal *hal, uint32_t offset, uint32_t length, uint32_t *crc)
+* @brief	Calculates the usual (zlib) CRC32 of a range of the image file
+* @details	The file is read one row at a time into a row buffer. The crcRam callback handles the whole
+*			words and a software CRC32 the last 1 to 3 bytes, if any. Nothing is written to the NVM.
+* @param[in]	hal		Hardware access. The read position of the file is moved
+* @param[in]	offset	Offset of the first byte, in bytes
+* @param[in]	length	Number of bytes to cover
+* @param[out]	crc		CRC32 of the range
+* @return	FLASHER_OK, FLASHER_ERR_IO if the file could not be read or is shorter than offset + length
+*****************************************************************************/
+enum FlasherResult FlasherCore_CrcFile(const struct FlasherHal *hal, uint32_t offset, uint32_t length, uint32_t *crc)
+{
+	enum FlasherResult result = FLASHER_OK;
+	uint32_t value = FLASHER_CRC_SEED;
+	uint32_t chunk = 0;
+	uint32_t tail = 0;
+
+	if (hal->seek(hal->context, offset) != FLASHER_OK)
+	{
+		return FLASHER_ERR_IO;
+	}
+
+	while (length > 0 && result == FLASHER_OK)
+	{
+		uint32_t numBytesRead = 0;
+
+		chunk = (length < FLASHER_ROW_SIZE) ? length : FLASHER_ROW_SIZE;
+
+		if (hal->read(hal->context, rowBuffer[0], chunk, &numBytesRead) != FLASHER_OK || numBytesRead != chunk)
+		{
+			return FLASHER_ERR_IO;
+		}
+
+		//Only the last chunk can be shorter than a row, so only it can leave bytes the DSU can not take
+		tail = chunk & 3U;
+		if (chunk - tail > 0)
+		{
+			result = hal->crcRam(hal->context, rowBuffer[0], chunk - tail, &value);
+		}
+		length -= chunk;
+	}
+
+	if (result == FLASHER_OK && tail > 0)
+	{
+		value = FlasherCore_CrcBytes(value, &rowBuffer[0][chunk - tail], tail);
+	}
+	*crc = ~value;
+
+	return result;
+}
+
+
+/******************************************************************************
+* Static Functions
+******************************************************************************/
+
+/**************************************************************************//**
+* @fn		static enum FlasherResult FlasherCore_StreamImage(const struct FlasherHal *hal, uint32_t fileOffset, uint32_t imageSize, uint32_t startAddress, struct FlasherStats *stats)
+* @brief	Programs a raw or LZ image, reading the next row while the current one is erased
+* @details	Starts after the rows the journal covers. A DONE entry is recorded every
+*			FLASHER_JOURNAL_INTERVAL rows, before the next row is erased; an interrupted run redoes at
+*			most that many rows, and the ones it finds unchanged are skipped.
+* @param[in]	hal				Hardware access. The file is prepared by FlasherCore_OpenImage
+* @param[in]	fileOffset		Offset of the image in the file, in bytes
+* @param[in]	imageSize		Size of the image once in flash, in bytes
+* @param[in]	startAddress	NVM address of the first row
+* @param[in,out]	stats		Statistics of the run
+* @return	See FlasherCore_Program
+*****************************************************************************/
+static enum FlasherResult FlasherCore_StreamImage(const struct FlasherHal *hal, uint32_t fileOffset, uint32_t imageSize, uint32_t startAddress, struct FlasherStats *stats)
+{
+	enum FlasherResult result = FLASHER_OK;
+	uint32_t rowCount = journal.rowsDone;
+	uint8_t current = 0;
+	uint32_t rowBytes = 0;
+	uint32_t nextBytes = 0;
+	uint32_t imageCrc = FLASHER_CRC_SEED;
+	uint32_t startUs = hal->timeUs(hal->context);
+
+	if (rowCount > 0)
+	{
+		result = FlasherCore_ResumeStream(hal, fileOffset, imageSize, startAddress, &rowCount, &imageCrc, stats);
+		if (result != FLASHER_OK)
+		{
+			return result;
+		}
+	}
+	uint32_t rowAddress = startAddress + rowCount * FLASHER_ROW_SIZE;
+
+	//Prime the pipeline with the first row
+	if (FlasherCore_ReadRow(hal, rowBuffer[current], &rowBytes) != FLASHER_OK)
+	{
+		return FLASHER_ERR_IO;
+	}
+	stats->readUs += hal->timeUs(hal->context) - startUs;
+
+	while (rowBytes > 0)
+	{
+		//Rows that already hold the new content are neither erased nor written
+		bool rowUnchanged = false;
+		startUs = hal->timeUs(hal->context);
+		result = FlasherCore_RowIsUnchanged(hal, rowAddress, rowBuffer[current], &rowUnchanged);
+		stats->verifyUs += hal->timeUs(hal->context) - startUs;
+		if (result != FLASHER_OK)
+		{
+			break;
+		}
+
+		if (!rowUnchanged)
+		{
+			if (rowCount >= journal.rowsDone + FLASHER_JOURNAL_INTERVAL)
+			{
+				result = FlasherJournal_Record(hal, &journal, rowCount);
+				if (result != FLASHER_OK)
+				{
+					break;
+				}
+			}
+
+			result = hal->startErase(hal->context, rowAddress);
+			if (result != FLASHER_OK)
+			{
+				break;
+			}
+		}
+
+		//Fetch the next row from the SD card while the NVM controller erases the current one
+		nextBytes = 0;
+		startUs = hal->timeUs(hal->context);
+		if (rowBytes == FLASHER_ROW_SIZE && FlasherCore_ReadRow(hal, rowBuffer[current ^ 1], &nextBytes) != FLASHER_OK)
+		{
+			hal->waitReady(hal->context);
+			result = FLASHER_ERR_IO;
+			break;
+		}
+		stats->readUs += hal->timeUs(hal->context) - startUs;
+
+		if (rowUnchanged)
+		{
+			stats->rowsSkipped++;
+		}
+		else
+		{
+			startUs = hal->timeUs(hal->context);
+			result = hal->waitReady(hal->context);
+			stats->eraseUs += hal->timeUs(hal->context) - startUs;
+			if (result == FLASHER_OK)
+			{
+				result = FlasherCore_WriteRow(hal, rowAddress, rowBuffer[current], rowBytes, stats);
+			}
+			if (result != FLASHER_OK)
+			{
+				break;
+			}
+		}
+
+		//Chain the image CRC over the data read from the SD card. The padding matches the erased value, so whole rows are used
+		startUs = hal->timeUs(hal->context);
+		result = hal->crcRam(hal->context, rowBuffer[current], FLASHER_ROW_SIZE, &imageCrc);
+		stats->verifyUs += hal->timeUs(hal->context) - startUs;
+		if (result != FLASHER_OK)
+		{
+			break;
+		}
+
+		stats->bytesWritten += rowBytes;
+		rowAddress += FLASHER_ROW_SIZE;
+		rowCount++;
+		current ^= 1;
+		rowBytes = nextBytes;
+	}
+
+	//Single pass over the whole image range, skipped and resumed rows included
+	if (result == FLASHER_OK && rowCount > 0)
+	{
+		stats->imageCrc = ~imageCrc;
+		startUs = hal->timeUs(hal->context);
+		result = FlasherCore_CrcFlash(hal, startAddress, rowCount * FLASHER_ROW_SIZE, &stats->flashCrc);
+		stats->verifyUs += hal->timeUs(hal->context) - startUs;
+		if (result != FLASHER_OK || stats->flashCrc != stats->imageCrc)
+		{
+			stats->crcErrors++;
+			result = FLASHER_ERR_NVM;
+		}
+	}
+
+	return result;
+}
+
+
+/**************************************************************************//**
+* @fn		static enum FlasherResult FlasherCore_ResumeStream(const struct FlasherHal *hal, uint32_t fileOffset, uint32_t imageSize, uint32_t startAddress, uint32_t *rows, uint32_t *imageCrc, struct FlasherStats *stats)
+* @brief	Moves a raw or LZ image past the rows an interrupted run already programmed and verified
+* @details	A raw file is simply moved forward, and the image CRC32 of those rows is taken from the
+*			flash. An LZ payload has to be decompressed from the start; the rows are only run through
+*			the image CRC32.
+* @param[in]	hal				Hardware access
+* @param[in]	fileOffset		Offset of the image in the file, in bytes
+* @param[in]	imageSize		Size of the image once in flash, in bytes
+* @param[in]	startAddress	NVM address of the first row
+* @param[in,out]	rows		Rows done according to the journal. Limited to the rows of the image
+* @param[in,out]	imageCrc	Image CRC32 state, chained over the rows
+* @param[in,out]	stats		Statistics of the run
+* @return	FLASHER_OK, FLASHER_ERR_IO if the file could not be read
+*****************************************************************************/
+static enum FlasherResult FlasherCore_ResumeStream(const struct FlasherHal *hal, uint32_t fileOffset, uint32_t imageSize, uint32_t startAddress, uint32_t *rows, uint32_t *imageCrc, struct FlasherStats *stats)
+{
+	enum FlasherResult result = FLASHER_OK;
+	uint32_t imageRows = (imageSize + FLASHER_ROW_SIZE - 1) / FLASHER_ROW_SIZE;
+	uint32_t startUs = hal->timeUs(hal->context);
+
+	*rows = (*rows < imageRows) ? *rows : imageRows;
+
+	if (imageType == FLASHER_IMAGE_LZ)
+	{
+		for (uint32_t row = 0; row < *rows && result == FLASHER_OK; row++)
+		{
+			uint32_t rowBytes = 0;
+			result = FlasherCore_ReadRow(hal, rowBuffer[0], &rowBytes);
+			if (result == FLASHER_OK)
+			{
+				result = hal->crcRam(hal->context, rowBuffer[0], FLASHER_ROW_SIZE, imageCrc);
+			}
+			stats->bytesWritten += rowBytes;
+		}
+	}
+	else
+	{
+		uint32_t bytes = *rows * FLASHER_ROW_SIZE;
+		bytes = (bytes < imageSize) ? bytes : imageSize;
+		result = hal->seek(hal->context, fileOffset + bytes);
+		if (result == FLASHER_OK)
+		{
+			result = hal->crcFlash(hal->context, startAddress, *rows * FLASHER_ROW_SIZE, imageCrc);
+		}
+		stats->bytesWritten += bytes;
+	}
+
+	stats->rowsResumed = *rows;
+	stats->readUs += hal->timeUs(hal->context) - startUs;
+	return result;
+}
+
+
+/**************************************************************************//**
+* @fn		static enum FlasherResult FlasherCore_PatchImage(const struct FlasherHal *hal, const struct DeltaHeader *header, uint32_t startAddress, struct FlasherStats *stats)
+* @brief	Applies a delta patch over the installed image, in place
+* @details	The CRC32 of the installed image must match the base CRC32 of the patch before any row is
+*			erased. If the flash already holds the new image (patch applied, but the flag was not
+*			removed) nothing is written. Each row is rebuilt in RAM while the installed row is still
+*			readable, then written back. The patch records are read from the SD card 64 bytes at a time.
+*			Every row is recorded in the journal before it is erased, and a row rebuilt from its own
+*			installed content is first copied to the backup row. An interrupted patch no longer matches
+*			the base CRC32; it resumes from the journal instead, the rows before it are decoded and dropped.
+* @param[in]	hal				Hardware access. The file is positioned on the first record
+* @param[in]	header			Decoded patch header
+* @param[in]	startAddress	NVM address of the installed image
+* @param[in,out]	stats		Statistics of the run
+* @return	See FlasherCore_Program
+*****************************************************************************/
+static enum FlasherResult FlasherCore_PatchImage(const struct FlasherHal *hal, const struct DeltaHeader *header, uint32_t startAddress, struct FlasherStats *stats)
+{
+	enum FlasherResult result;
+	uint32_t baseRows = DeltaFormat_Rows(header->baseSize);
+	uint32_t newRows = DeltaFormat_Rows(header->newSize);
+	uint32_t crc = 0;
+	uint32_t rowIndex = 0;
+	uint32_t rowCount = 0;
+	uint32_t resumeRows = journal.rowsDone;
+	bool resume = journal.activeRow != 0;
+	int32_t rowBytes;
+	uint32_t startUs = hal->timeUs(hal->context);
+
+	if (startAddress + baseRows * FLASHER_ROW_SIZE > hal->flashSize)
+	{
+		return FLASHER_ERR_BAD_ADDRESS;
+	}
+
+	stats->imageCrc = header->newCrc;
+	result = FlasherCore_CrcFlash(hal, startAddress, newRows * FLASHER_ROW_SIZE, &stats->flashCrc);
+	if (result == FLASHER_OK && stats->flashCrc == header->newCrc)
+	{
+		stats->rowsSkipped = newRows;
+		stats->verifyUs += hal->timeUs(hal->context) - startUs;
+		return FLASHER_OK;
+	}
+
+	//Base image identity, checked before anything is erased
+	if (!resume)
+	{
+		result = FlasherCore_CrcFlash(hal, startAddress, baseRows * FLASHER_ROW_SIZE, &crc);
+		if (result != FLASHER_OK || crc != header->baseCrc)
+		{
+			stats->verifyUs += hal->timeUs(hal->context) - startUs;
+			return FLASHER_ERR_BAD_BASE;
+		}
+	}
+	stats->verifyUs += hal->timeUs(hal->context) - startUs;
+
+	DeltaPatcher_Init(&deltaPatcher, header, hal->flash(hal->context, startAddress), FlasherCore_FileFill, (void *)hal);
+	startUs = hal->timeUs(hal->context);
+	while ((rowBytes = DeltaPatcher_NextRow(&deltaPatcher, rowBuffer[0], &rowIndex)) > 0)
+	{
+		uint32_t rowAddress = startAddress + rowIndex * FLASHER_ROW_SIZE;
+		bool rowUnchanged = false;
+
+		//Rows the journal covers were rebuilt from an installed image that is gone now: drop them
+		if (resume && rowCount < resumeRows)
+		{
+			stats->rowsResumed++;
+			stats->bytesWritten += (uint32_t)rowBytes;
+			rowCount++;
+			continue;
+		}
+
+		//The row the interrupted run was writing can not be rebuilt if it read its own installed content
+		if (resume && rowCount == resumeRows && journal.backupValid)
+		{
+			result = FlasherCore_RestoreRow(hal, rowAddress, rowBuffer[0]);
+			if (result != FLASHER_OK)
+			{
+				return result;
+			}
+		}
+
+		stats->readUs += hal->timeUs(hal->context) - startUs;
+		startUs = hal->timeUs(hal->context);
+		result = FlasherCore_RowIsUnchanged(hal, rowAddress, rowBuffer[0], &rowUnchanged);
+		stats->verifyUs += hal->timeUs(hal->context) - startUs;
+		if (result != FLASHER_OK)
+		{
+			return result;
+		}
+
+		if (rowUnchanged)
+		{
+			stats->rowsSkipped++;
+		}
+		else
+		{
+			startUs = hal->timeUs(hal->context);
+			if (journal.activeRow == 0 || rowCount > journal.rowsDone)
+			{
+				result = deltaPatcher.ownRow ? FlasherJournal_SaveBackup(hal, &journal, rowCount, rowBuffer[0]) : FlasherJournal_Record(hal, &journal, rowCount);
+			}
+			stats->programUs += hal->timeUs(hal->context) - startUs;
+			startUs = hal->timeUs(hal->context);
+			if (result == FLASHER_OK)
+			{
+				result = hal->startErase(hal->context, rowAddress);
+			}
+			if (result == FLASHER_OK)
+			{
+				result = hal->waitReady(hal->context);
+			}
+			stats->eraseUs += hal->timeUs(hal->context) - startUs;
+			if (result == FLASHER_OK)
+			{
+				result = FlasherCore_WriteRow(hal, rowAddress, rowBuffer[0], (uint32_t)rowBytes, stats);
+			}
+			if (result != FLASHER_OK)
+			{
+				return result;
+			}
+		}
+		stats->bytesWritten += (uint32_t)rowBytes;
+		rowCount++;
+		startUs = hal->timeUs(hal->context);
+	}
+
+	if (rowBytes < 0)
+	{
+		return FLASHER_ERR_IO;
+	}
+
+	startUs = hal->timeUs(hal->context);
+	result = FlasherCore_CrcFlash(hal, startAddress, newRows * FLASHER_ROW_SIZE, &stats->flashCrc);
+	stats->verifyUs += hal->timeUs(hal->context) - startUs;
+	if (result != FLASHER_OK || stats->flashCrc != stats->imageCrc)
+	{
+		stats->crcErrors++;
+		result = FLASHER_ERR_NVM;
+	}
+
+	return result;
+}
+
+
+/**************************************************************************//**
+* @fn		static enum FlasherResult FlasherCore_RestoreRow(const struct FlasherHal *hal, uint32_t rowAddress, uint8_t *buffer)
+* @brief	Loads the new content of the row an interrupted delta patch was writing
+* @details	The content is in the backup row, or already in the row itself if the backup row was
+*			reused after the row was written. The CRC32 of the journal entry tells which.
+* @param[in]	hal			Hardware access
+* @param[in]	rowAddress	Address of the row
+* @param[out]	buffer		Row buffer, FLASHER_ROW_SIZE bytes long
+* @return	FLASHER_OK, FLASHER_ERR_BAD_DATA if neither row holds the content
+*****************************************************************************/
+static enum FlasherResult FlasherCore_RestoreRow(const struct FlasherHal *hal, uint32_t rowAddress, uint8_t *buffer)
+{
+	uint32_t sources[2] = { FlasherJournal_BackupAddress(&journal), rowAddress };
+
+	for (uint8_t i = 0; i < 2; i++)
+	{
+		uint32_t crc = FLASHER_CRC_SEED;
+		if (hal->crcFlash(hal->context, sources[i], FLASHER_ROW_SIZE, &crc) == FLASHER_OK && crc == journal.backupCrc)
+		{
+			memcpy(buffer, hal->flash(hal->context, sources[i]), FLASHER_ROW_SIZE);
+			return FLASHER_OK;
+		}
+	}
+
+	return FLASHER_ERR_BAD_DATA;
+}
+
+
+/**************************************************************************//**
+* @fn		static enum FlasherResult FlasherCore_RowIsUnchanged(const struct FlasherHal *hal, uint32_t rowAddress, const uint8_t *buffer, bool *unchanged)
+* @brief	Checks if a flash row already holds the content of a row buffer
+* @details	Compares the CRC32 of the flash row against the CRC32 of the buffer.
+* @param[in]	hal			Hardware access
+* @param[in]	rowAddress	Address of the flash row
+* @param[in]	buffer		Row data, FLASHER_ROW_SIZE bytes long
+* @param[out]	unchanged	True if both CRCs match
+* @return	FLASHER_OK if both CRCs could be calculated, error from the CRC callbacks otherwise
+*****************************************************************************/
+static enum FlasherResult FlasherCore_RowIsUnchanged(const struct FlasherHal *hal, uint32_t rowAddress, const uint8_t *buffer, bool *unchanged)
+{
+	uint32_t crcBuffer = 0;
+	uint32_t crcFlash = 0;
+	enum FlasherResult result;
+
+	result = hal->crcRam(hal->context, buffer, FLASHER_ROW_SIZE, &crcBuffer);
+	if (result == FLASHER_OK)
+	{
+		result = hal->crcFlash(hal->context, rowAddress, FLASHER_ROW_SIZE, &crcFlash);
+	}
+
+	*unchanged = (result == FLASHER_OK) && (crcBuffer == crcFlash);
+	return result;
+}
+
+
+/**************************************************************************//**
+* @fn		static enum FlasherResult FlasherCore_WriteRow(const struct FlasherHal *hal, uint32_t rowAddress, const uint8_t *buffer, uint32_t numBytes, struct FlasherStats *stats)
+* @brief	Programs an erased row and checks it against the row buffer
+* @param[in]	hal			Hardware access
+* @param[in]	rowAddress	Address of the row, erased
+* @param[in]	buffer		Row data, FLASHER_ROW_SIZE bytes long
+* @param[in]	numBytes	Number of valid bytes in buffer
+* @param[in,out]	stats	Statistics of the run
+* @return	FLASHER_OK, FLASHER_ERR_NVM if the NVM reported an error or the row does not read back
+*****************************************************************************/
+static enum FlasherResult FlasherCore_WriteRow(const struct FlasherHal *hal, uint32_t rowAddress, const uint8_t *buffer, uint32_t numBytes, struct FlasherStats *stats)
+{
+	enum FlasherResult result;
+	bool written = false;
+	uint32_t startUs = hal->timeUs(hal->context);
+
+	result = FlasherCore_ProgramRow(hal, rowAddress, buffer, numBytes);
+	stats->programUs += hal->timeUs(hal->context) - startUs;
+	if (result != FLASHER_OK)
+	{
+		return result;
+	}
+
+	startUs = hal->timeUs(hal->context);
+	result = FlasherCore_RowIsUnchanged(hal, rowAddress, buffer, &written);
+	stats->verifyUs += hal->timeUs(hal->context) - startUs;
+	if (result == FLASHER_OK && !written)
+	{
+		stats->crcErrors++;
+		result = FLASHER_ERR_NVM;
+	}
+	if (result == FLASHER_OK)
+	{
+		stats->rowsWritten++;
+	}
+
+	return result;
+}
+
+
+/**************************************************************************//**
+* @fn		static enum FlasherResult FlasherCore_ProgramRow(const struct FlasherHal *hal, uint32_t rowAddress, const uint8_t *buffer, uint32_t numBytes)
+* @brief	Programs the pages of an erased row that hold image data
+* @details	Pages past numBytes are left erased. Each writePage call starts a page write; the next page
+*			waits for the NVM to be ready.
+* @param[in]	hal			Hardware access
+* @param[in]	rowAddress	Address of the row to program
+* @param[in]	buffer		Row data, FLASHER_ROW_SIZE bytes long
+* @param[in]	numBytes	Number of valid bytes in buffer
+* @return	FLASHER_OK on success, error reported by the NVM otherwise
+*****************************************************************************/
+static enum FlasherResult FlasherCore_ProgramRow(const struct FlasherHal *hal, uint32_t rowAddress, const uint8_t *buffer, uint32_t numBytes)
+{
+	enum FlasherResult result = FLASHER_OK;
+	uint32_t pages = (numBytes + FLASHER_PAGE_SIZE - 1) / FLASHER_PAGE_SIZE;
+
+	for (uint32_t pg = 0; pg < pages; pg++)
+	{
+		result = hal->waitReady(hal->context);
+		if (result != FLASHER_OK)
+		{
+			break;
+		}
+
+		result = hal->writePage(hal->context, rowAddress + pg * FLASHER_PAGE_SIZE, &buffer[pg * FLASHER_PAGE_SIZE]);
+		if (result != FLASHER_OK)
+		{
+			break;
+		}
+	}
+
+	if (result == FLASHER_OK)
+	{
+		result = hal->waitReady(hal->context);
+	}
+
+	return result;
+}
+
+
+/**************************************************************************//**
+* @fn		static enum FlasherResult FlasherCore_OpenImage(const struct FlasherHal *hal, uint32_t fileOffset, uint32_t *imageSize, struct DeltaHeader *deltaHeader)
+* @brief	Detects the image format and prepares the file for reading
+* @details	An LZ container header sets the decompressor up to read the payload that follows. A delta
+*			patch header is returned in deltaHeader and the file is left on the first record. Otherwise
+*			the file is rewound to fileOffset and read as a raw binary. Sets imageType.
+* @param[in]	hal			Hardware access
+* @param[in]	fileOffset	Offset of the image in the file, in bytes
+* @param[out]	imageSize	Size of the image once in flash, in bytes
+* @param[out]	deltaHeader	Patch header, valid if imageType is FLASHER_IMAGE_DELTA
+* @return	FLASHER_OK, FLASHER_ERR_IO if the file could not be read, FLASHER_ERR_BAD_FORMAT if the header
+*			does not match the file size
+*****************************************************************************/
+static enum FlasherResult FlasherCore_OpenImage(const struct FlasherHal *hal, uint32_t fileOffset, uint32_t *imageSize, struct DeltaHeader *deltaHeader)
+{
+	uint8_t header[FLASHER_HEADER_PROBE_SIZE];
+	struct LzHeader lzHeader;
+	uint32_t numBytesRead = 0;
+	uint32_t fileSize = hal->size(hal->context);
+
+	imageType = FLASHER_IMAGE_RAW;
+	if (fileOffset > fileSize)
+	{
+		return FLASHER_ERR_BAD_FORMAT;
+	}
+	*imageSize = fileSize - fileOffset;
+
+	if (hal->seek(hal->context, fileOffset) != FLASHER_OK || hal->read(hal->context, header, FLASHER_HEADER_PROBE_SIZE, &numBytesRead) != FLASHER_OK)
+	{
+		return FLASHER_ERR_IO;
+	}
+
+	if (numBytesRead >= LZ_HEADER_SIZE && LzFormat_ParseHeader(header, &lzHeader) == 0)
+	{
+		imageType = FLASHER_IMAGE_LZ;
+		if (lzHeader.packedSize != *imageSize - LZ_HEADER_SIZE)
+		{
+			return FLASHER_ERR_BAD_FORMAT;
+		}
+		if (hal->seek(hal->context, fileOffset + LZ_HEADER_SIZE) != FLASHER_OK)
+		{
+			return FLASHER_ERR_IO;
+		}
+		LzDecoder_Init(&lzDecoder, lzHeader.rawSize, FlasherCore_FileFill, (void *)hal);
+		*imageSize = lzHeader.rawSize;
+		return FLASHER_OK;
+	}
+
+	if (numBytesRead >= DELTA_HEADER_SIZE && DeltaFormat_ParseHeader(header, deltaHeader) == 0)
+	{
+		imageType = FLASHER_IMAGE_DELTA;
+		if (deltaHeader->recordsSize != *imageSize - DELTA_HEADER_SIZE)
+		{
+			return FLASHER_ERR_BAD_FORMAT;
+		}
+		//The file is already positioned on the first record
+		*imageSize = deltaHeader->newSize;
+		return FLASHER_OK;
+	}
+
+	return hal->seek(hal->context, fileOffset);
+}
+
+
+/**************************************************************************//**
+* @fn		static size_t FlasherCore_FileFill(void *context, uint8_t *buffer, size_t length)
+* @brief	Fill callback of the LZ decoder and the delta patcher. Reads bytes from the image file
+* @param[in]	context	struct FlasherHal of the run
+* @param[out]	buffer	Destination of the bytes
+* @param[in]	length	Number of bytes requested
+* @return	Number of bytes read. 0 at the end of the file or on a read error
+*****************************************************************************/
+static size_t FlasherCore_FileFill(void *context, uint8_t *buffer, size_t length)
+{
+	const struct FlasherHal *hal = (const struct FlasherHal *)context;
+	uint32_t numBytesRead = 0;
+
+	if (hal->read(hal->context, buffer, (uint32_t)length, &numBytesRead) != FLASHER_OK)
+	{
+		return 0;
+	}
+	return numBytesRead;
+}
+
+
+/**************************************************************************//**
+* @fn		static enum FlasherResult FlasherCore_ReadRow(const struct FlasherHal *hal, uint8_t *buffer, uint32_t *numBytesRead)
+* @brief	Reads up to one row of the image. A short read is padded with the erased value
+* @details	LZ images are decompressed straight into the row buffer; raw images are read as they are.
+* @param[in]	hal				Hardware access
+* @param[out]	buffer			Row buffer, FLASHER_ROW_SIZE bytes long
+* @param[out]	numBytesRead	Number of image bytes placed in buffer. 0 at the end of the image
+* @return	Result of the read callback. FLASHER_ERR_IO if the compressed payload is corrupt or truncated
+*****************************************************************************/
+static enum FlasherResult FlasherCore_ReadRow(const struct FlasherHal *hal, uint8_t *buffer, uint32_t *numBytesRead)
+{
+	enum FlasherResult result = FLASHER_OK;
+
+	if (imageType == FLASHER_IMAGE_LZ)
+	{
+		int32_t decoded = LzDecoder_Read(&lzDecoder, buffer, FLASHER_ROW_SIZE);
+		*numBytesRead = (decoded < 0) ? 0 : (uint32_t)decoded;
+		result = (decoded < 0) ? FLASHER_ERR_IO : FLASHER_OK;
+	}
+	else
+	{
+		result = hal->read(hal->context, buffer, FLASHER_ROW_SIZE, numBytesRead);
+	}
+
+	if (result == FLASHER_OK && *numBytesRead < FLASHER_ROW_SIZE)
+	{
+		memset(&buffer[*numBytesRead], FLASHER_ERASED_BYTE, FLASHER_ROW_SIZE - *numBytesRead);
+	}
+
+	return result;
+}
+
+
+/**************************************************************************//**
+* @fn		static uint32_t FlasherCore_CrcBytes(uint32_t crc, const uint8_t *data, uint32_t length)
+* @brief	Continues a CRC32 in software, for the bytes the word based callbacks can not take
+* @param[in]	crc		CRC32 state, not complemented (same convention as the DSU)
+* @param[in]	data	Bytes to add
+* @param[in]	length	Number of bytes
+* @return	New CRC32 state, not complemented
+*****************************************************************************/
+static uint32_t FlasherCore_CrcBytes(uint32_t crc, const uint8_t *data, uint32_t length)
+{
+	while (length-- > 0)
+	{
+		crc ^= *data++;
+		for (uint8_t bit = 0; bit < 8; bit++)
+		{
+			crc = (crc >> 1) ^ (FLASHER_CRC_POLYNOMIAL & (0U - (crc & 1U)));
+		}
+	}
+	return crc;
+}
@@ -0,0 +1,110 @@
+/**************************************************************************//**
+* @file      FlasherCore.h
+* @brief     Hardware independent part of the flashing engine
+* @details   Holds the row pipeline, the skip-unchanged check, the LZ and delta paths and the final CRC32
+*			 check. Every access to the NVM, the image file, the CRC32 unit and the time base goes through
+*			 struct FlasherHal. Flasher.c fills it with FatFs, the NVM controller and the DSU; the host
+*			 simulator (Tools/bootsim.c) fills it with a simulated NVM array and a plain file.
+*			 Plain C only, no ASF.
+* @author
+* @date      2026-10-17
+
+******************************************************************************/
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+* Includes
+******************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/******************************************************************************
+* Defines
+******************************************************************************/
+#define FLASHER_ROW_SIZE		256		///< Size of one NVM row (erase unit), in bytes. NVMCTRL_ROW_SIZE on the SAMD21
+#define FLASHER_PAGE_SIZE		64		///< Size of one NVM page (write unit), in bytes. NVMCTRL_PAGE_SIZE on the SAMD21
+#define FLASHER_ROW_PAGES		(FLASHER_ROW_SIZE / FLASHER_PAGE_SIZE)	///< Number of pages on one NVM row
+#define FLASHER_ERASED_BYTE		0xFF	///< Value of an erased NVM byte. Used to pad the last row of an image
+#define FLASHER_CRC_SEED		0xFFFFFFFFUL	///< Seed of the CRC32. With the result complemented it gives the usual (zlib) CRC32
+
+/******************************************************************************
+* Structures and Enumerations
+******************************************************************************/
+/// Result of the core and of the HAL callbacks. Flasher.c maps it onto enum status_code
+enum FlasherResult {
+	FLASHER_OK = 0,				///< Success
+	FLASHER_ERR_IO,				///< The image file could not be read
+	FLASHER_ERR_BAD_FORMAT,		///< The image header does not match the file
+	FLASHER_ERR_BAD_ADDRESS,	///< Start address not row aligned, or the image does not fit in the NVM
+	FLASHER_ERR_BAD_DATA,		///< An interrupted delta patch cannot be resumed: the journal backup is lost
+	FLASHER_ERR_BAD_BASE,		///< A delta patch was made against another image. Nothing was erased
+	FLASHER_ERR_BUSY,			///< The NVM controller was busy when a command was issued
+	FLASHER_ERR_NVM,			///< The NVM reported an error, or the programmed image does not match
+};
+
+/// Format of the file being programmed. Detected from its first bytes
+enum FlasherImageType {
+	FLASHER_IMAGE_RAW = 0,	///< Plain binary, programmed as is
+	FLASHER_IMAGE_LZ,		///< LZ compressed image, see Lz/LzFormat.h
+	FLASHER_IMAGE_DELTA,	///< Delta patch against the installed image, see Delta/DeltaFormat.h
+};
+
+/// Statistics of one flashing run. Filled by FlasherCore_Program
+struct FlasherStats {
+	uint32_t rowsWritten;	///< Number of rows erased and programmed
+	uint32_t rowsSkipped;	///< Number of rows left untouched because the flash already held the same data
+	uint32_t bytesWritten;	///< Number of image bytes (decompressed) read from the SD card and programmed
+	uint32_t crcErrors;		///< Number of verification failures (0 or 1, the image is verified as a whole)
+	uint32_t imageCrc;		///< Expected CRC32 of the image, padded to whole rows
+	uint32_t flashCrc;		///< CRC32 of the programmed flash range
+	uint32_t elapsedMs;		///< Time spent flashing, in ms
+	uint32_t readUs;		///< Time spent reading the SD card and decompressing or patching rows, in us
+	uint32_t eraseUs;		///< Time spent waiting on row erases not hidden behind the SD card reads, in us
+	uint32_t programUs;		///< Time spent programming pages, in us
+	uint32_t verifyUs;		///< Time spent on CRC32 checks (unchanged rows and the final image check), in us
+	uint32_t rowsResumed;	///< Number of rows not redone because the journal of an interrupted run covered them
+	enum FlasherImageType imageType;	///< Format of the file
+};
+
+/// Hardware access used by the core. Every callback gets context as its first argument
+struct FlasherHal {
+	void *context;			///< Image file on target, simulator state on the host
+	uint32_t flashSize;		///< Size of the NVM, in bytes
+	uint32_t journalAddress;	///< First of FLASHER_JOURNAL_ROWS reserved rows for the progress journal (FlasherJournal.h). 0 to disable it
+	/// Reads up to length bytes from the current position of the image file. A short read means end of file
+	enum FlasherResult (*read)(void *context, uint8_t *buffer, uint32_t length, uint32_t *numBytesRead);
+	/// Moves the read position of the image file
+	enum FlasherResult (*seek)(void *context, uint32_t offset);
+	/// Size of the image file, in bytes
+	uint32_t (*size)(void *context);
+	/// Issues a row erase and returns without waiting for it. FLASHER_ERR_BUSY if the NVM is busy
+	enum FlasherResult (*startErase)(void *context, uint32_t rowAddress);
+	/// Waits until the NVM is ready. FLASHER_ERR_NVM if the last operation failed
+	enum FlasherResult (*waitReady)(void *context);
+	/// Loads one page and starts its write, without waiting. The NVM must be ready
+	enum FlasherResult (*writePage)(void *context, uint32_t address, const uint8_t *data);
+	/// Continues a CRC32 over a word aligned RAM buffer. Seed in, state out, not complemented. length is a multiple of 4
+	enum FlasherResult (*crcRam)(void *context, const uint8_t *data, uint32_t length, uint32_t *crc);
+	/// Same as crcRam, over a flash range
+	enum FlasherResult (*crcFlash)(void *context, uint32_t address, uint32_t length, uint32_t *crc);
+	/// Readable view of the flash at address. Base image of the delta patches
+	const uint8_t *(*flash)(void *context, uint32_t address);
+	/// Free running time base, in us
+	uint32_t (*timeUs)(void *context);
+};
+
+/******************************************************************************
+* Global Function Declaration
+******************************************************************************/
+enum FlasherResult FlasherCore_Program(const struct FlasherHal *hal, uint32_t fileOffset, uint32_t startAddress, struct FlasherStats *stats);
+enum FlasherResult FlasherCore_CrcFlash(const struct FlasherHal *hal, uint32_t address, uint32_t length, uint32_t *crc);
+enum FlasherResult FlasherCore_CrcFile(const struct FlasherHal *hal, uint32_t offset, uint32_t length, uint32_t *crc);
+
+#ifdef __cplusplus
+}
+#endif
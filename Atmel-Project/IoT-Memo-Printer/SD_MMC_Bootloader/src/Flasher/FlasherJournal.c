@@ -0,0 +1,404 @@
+/**************************************************************************//**
+* @file      FlasherJournal.c
+* @brief     Progress journal of the flashing engine, kept in reserved NVM rows
+* @details   Every write goes through the struct FlasherHal callbacks and waits for the NVM before
+*			 returning, so the journal is up to date before the caller erases the next image row.
+*			 The header and slots are checked word by word against their complements (the header with
+*			 the complement of the sum of its words), so a write torn by a power loss reads as invalid.
+* @author
+* @date      2026-10-17
+
+******************************************************************************/
+
+
+/******************************************************************************
+* Includes
+******************************************************************************/
+#include <string.h>
+#include "FlasherJournal.h"
+
+/******************************************************************************
+* Defines
+******************************************************************************/
+#define FLASHER_JOURNAL_HEADER_WORDS	7		///< magic, sequence, fileCrc, fileSize, startAddress, rowsDone, check
+#define FLASHER_JOURNAL_SLOTS_PER_PAGE	(FLASHER_PAGE_SIZE / FLASHER_JOURNAL_SLOT_SIZE)
+#define FLASHER_JOURNAL_COUNT_MASK		0x00FFFFFFUL	///< Row count bits of an entry word
+#define FLASHER_JOURNAL_ERASED_WORD		0xFFFFFFFFUL
+
+/******************************************************************************
+* Forward Declarations
+******************************************************************************/
+static uint32_t FlasherJournal_ReadWord(const uint8_t *data);
+static void FlasherJournal_WriteWord(uint8_t *data, uint32_t value);
+static bool FlasherJournal_ReadHeader(const struct FlasherHal *hal, uint32_t row, uint32_t *words);
+static enum FlasherResult FlasherJournal_EraseRow(const struct FlasherHal *hal, uint32_t row);
+static enum FlasherResult FlasherJournal_WritePage(const struct FlasherHal *hal, uint32_t address, const uint8_t *page);
+static enum FlasherResult FlasherJournal_Start(const struct FlasherHal *hal, struct FlasherJournal *journal, uint32_t rowsDone);
+static enum FlasherResult FlasherJournal_Append(const struct FlasherHal *hal, struct FlasherJournal *journal, uint32_t entry, uint32_t crc);
+
+/******************************************************************************
+* Global Functions
+******************************************************************************/
+
+/**************************************************************************//**
+* @fn		void FlasherJournal_Open(const struct FlasherHal *hal, struct FlasherJournal *journal, uint32_t fileCrc, uint32_t fileSize, uint32_t startAddress)
+* @brief	Reads the journal rows and looks for a record of the given update
+* @details	Nothing is written. If the newest valid record belongs to this update, activeRow is set and
+*			rowsDone tells where to resume; otherwise rowsDone is 0 and a record is started by the first
+*			FlasherJournal_Record() or FlasherJournal_SaveBackup().
+* @param[in]	hal				Hardware access. Journaling is disabled if hal->journalAddress is 0
+* @param[out]	journal			Journal state
+* @param[in]	fileCrc			CRC32 of the first row of the update file
+* @param[in]	fileSize		Size of the update file, in bytes
+* @param[in]	startAddress	NVM address the image is programmed at
+*****************************************************************************/
+void FlasherJournal_Open(const struct FlasherHal *hal, struct FlasherJournal *journal, uint32_t fileCrc, uint32_t fileSize, uint32_t startAddress)
+{
+	uint32_t words[FLASHER_JOURNAL_HEADER_WORDS];
+
+	memset(journal, 0, sizeof(struct FlasherJournal));
+	journal->address = hal->journalAddress;
+	journal->fileCrc = fileCrc;
+	journal->fileSize = fileSize;
+	journal->startAddress = startAddress;
+	if (journal->address == 0)
+	{
+		return;
+	}
+
+	for (uint32_t row = journal->address; row < journal->address + 2 * FLASHER_ROW_SIZE; row += FLASHER_ROW_SIZE)
+	{
+		if (FlasherJournal_ReadHeader(hal, row, words) && (journal->latestRow == 0 || words[1] > journal->sequence))
+		{
+			journal->latestRow = row;
+			journal->sequence = words[1];
+		}
+	}
+
+	if (journal->latestRow == 0 || !FlasherJournal_ReadHeader(hal, journal->latestRow, words) ||
+		words[2] != fileCrc || words[3] != fileSize || words[4] != startAddress)
+	{
+		return;
+	}
+
+	journal->activeRow = journal->latestRow;
+	journal->rowsDone = words[5];
+	for (uint32_t slot = 0; slot < FLASHER_JOURNAL_SLOTS; slot++)
+	{
+		const uint8_t *data = hal->flash(hal->context, journal->activeRow + FLASHER_PAGE_SIZE + slot * FLASHER_JOURNAL_SLOT_SIZE);
+		uint32_t entry = FlasherJournal_ReadWord(&data[0]);
+		uint32_t crc = FlasherJournal_ReadWord(&data[8]);
+		uint32_t count = entry & FLASHER_JOURNAL_COUNT_MASK;
+
+		if (entry == FLASHER_JOURNAL_ERASED_WORD && FlasherJournal_ReadWord(&data[4]) == FLASHER_JOURNAL_ERASED_WORD)
+		{
+			continue;
+		}
+
+		//Slots are appended in order, even torn ones can not be written again
+		journal->nextSlot = slot + 1;
+		if (FlasherJournal_ReadWord(&data[4]) != ~entry || FlasherJournal_ReadWord(&data[12]) != ~crc || count < journal->rowsDone)
+		{
+			continue;
+		}
+
+		if ((entry >> 24) == FLASHER_JOURNAL_DONE)
+		{
+			journal->rowsDone = count;
+			journal->backupValid = false;
+		}
+		else if ((entry >> 24) == FLASHER_JOURNAL_BACKUP)
+		{
+			journal->rowsDone = count;
+			journal->backupCrc = crc;
+			journal->backupValid = true;
+		}
+	}
+}
+
+
+/**************************************************************************//**
+* @fn		enum FlasherResult FlasherJournal_Record(const struct FlasherHal *hal, struct FlasherJournal *journal, uint32_t rowsDone)
+* @brief	Records that the first rowsDone rows are programmed and verified
+* @details	Starts a record if there is none or the current one is full. Call with the NVM idle.
+* @param[in]	hal			Hardware access
+* @param[in,out]	journal	Journal state
+* @param[in]	rowsDone	Rows done, in processing order
+* @return	FLASHER_OK, or the error of the NVM write. FLASHER_OK without writing if journaling is disabled
+*****************************************************************************/
+enum FlasherResult FlasherJournal_Record(const struct FlasherHal *hal, struct FlasherJournal *journal, uint32_t rowsDone)
+{
+	enum FlasherResult result;
+
+	if (journal->address == 0)
+	{
+		return FLASHER_OK;
+	}
+	if (journal->activeRow == 0 || journal->nextSlot >= FLASHER_JOURNAL_SLOTS)
+	{
+		return FlasherJournal_Start(hal, journal, rowsDone);
+	}
+
+	result = FlasherJournal_Append(hal, journal, ((uint32_t)FLASHER_JOURNAL_DONE << 24) | rowsDone, 0);
+	if (result == FLASHER_OK)
+	{
+		journal->rowsDone = rowsDone;
+		journal->backupValid = false;
+	}
+	return result;
+}
+
+
+/**************************************************************************//**
+* @fn		enum FlasherResult FlasherJournal_SaveBackup(const struct FlasherHal *hal, struct FlasherJournal *journal, uint32_t rowsDone, const uint8_t *row)
+* @brief	Copies the new content of a row to the backup row, then records it
+* @details	Call before erasing the row whose new content can not be rebuilt once it is erased.
+*			Call with the NVM idle. Costs one row erase and FLASHER_ROW_PAGES + 1 page writes.
+* @param[in]	hal			Hardware access
+* @param[in,out]	journal	Journal state
+* @param[in]	rowsDone	Rows done, in processing order. The row saved is the next one
+* @param[in]	row			New content of the row, FLASHER_ROW_SIZE bytes long, word aligned
+* @return	FLASHER_OK, or the error of the NVM. FLASHER_OK without writing if journaling is disabled
+*****************************************************************************/
+enum FlasherResult FlasherJournal_SaveBackup(const struct FlasherHal *hal, struct FlasherJournal *journal, uint32_t rowsDone, const uint8_t *row)
+{
+	enum FlasherResult result;
+	uint32_t backup = FlasherJournal_BackupAddress(journal);
+	uint32_t crc = FLASHER_CRC_SEED;
+
+	if (journal->address == 0)
+	{
+		return FLASHER_OK;
+	}
+
+	result = hal->crcRam(hal->context, row, FLASHER_ROW_SIZE, &crc);
+	if (result == FLASHER_OK)
+	{
+		result = FlasherJournal_EraseRow(hal, backup);
+	}
+	for (uint32_t pg = 0; pg < FLASHER_ROW_PAGES && result == FLASHER_OK; pg++)
+	{
+		result = FlasherJournal_WritePage(hal, backup + pg * FLASHER_PAGE_SIZE, &row[pg * FLASHER_PAGE_SIZE]);
+	}
+
+	if (result == FLASHER_OK && (journal->activeRow == 0 || journal->nextSlot >= FLASHER_JOURNAL_SLOTS))
+	{
+		result = FlasherJournal_Start(hal, journal, rowsDone);
+	}
+	if (result == FLASHER_OK)
+	{
+		result = FlasherJournal_Append(hal, journal, ((uint32_t)FLASHER_JOURNAL_BACKUP << 24) | rowsDone, crc);
+	}
+	if (result == FLASHER_OK)
+	{
+		journal->rowsDone = rowsDone;
+		journal->backupCrc = crc;
+		journal->backupValid = true;
+	}
+	return result;
+}
+
+
+/**************************************************************************//**
+* @fn		uint32_t FlasherJournal_BackupAddress(const struct FlasherJournal *journal)
+* @brief	Returns the address of the backup row
+* @param[in]	journal	Journal state
+* @return	NVM address of the backup row. Only meaningful if journaling is enabled
+*****************************************************************************/
+uint32_t FlasherJournal_BackupAddress(const struct FlasherJournal *journal)
+{
+	return journal->address + 2 * FLASHER_ROW_SIZE;
+}
+
+
+/**************************************************************************//**
+* @fn		enum FlasherResult FlasherJournal_Clear(const struct FlasherHal *hal, struct FlasherJournal *journal)
+* @brief	Erases the journal rows that are not erased yet. Call once the update is verified
+* @param[in]	hal			Hardware access
+* @param[in,out]	journal	Journal state
+* @return	FLASHER_OK, or the error of the NVM. FLASHER_OK without writing if journaling is disabled
+*****************************************************************************/
+enum FlasherResult FlasherJournal_Clear(const struct FlasherHal *hal, struct FlasherJournal *journal)
+{
+	enum FlasherResult result = FLASHER_OK;
+
+	if (journal->address == 0)
+	{
+		return FLASHER_OK;
+	}
+
+	for (uint32_t row = journal->address; row < journal->address + 2 * FLASHER_ROW_SIZE && result == FLASHER_OK; row += FLASHER_ROW_SIZE)
+	{
+		const uint8_t *data = hal->flash(hal->context, row);
+		for (uint32_t i = 0; i < FLASHER_ROW_SIZE; i++)
+		{
+			if (data[i] != FLASHER_ERASED_BYTE)
+			{
+				result = FlasherJournal_EraseRow(hal, row);
+				break;
+			}
+		}
+	}
+
+	journal->activeRow = 0;
+	journal->latestRow = 0;
+	journal->nextSlot = 0;
+	journal->rowsDone = 0;
+	journal->backupValid = false;
+	return result;
+}
+
+
+/******************************************************************************
+* Static Functions
+******************************************************************************/
+
+/**************************************************************************//**
+* @fn		static uint32_t FlasherJournal_ReadWord(const uint8_t *data)
+* @brief	Reads a little endian word, without alignment requirements
+*****************************************************************************/
+static uint32_t FlasherJournal_ReadWord(const uint8_t *data)
+{
+	return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+
+/**************************************************************************//**
+* @fn		static void FlasherJournal_WriteWord(uint8_t *data, uint32_t value)
+* @brief	Writes a little endian word, without alignment requirements
+*****************************************************************************/
+static void FlasherJournal_WriteWord(uint8_t *data, uint32_t value)
+{
+	data[0] = (uint8_t)value;
+	data[1] = (uint8_t)(value >> 8);
+	data[2] = (uint8_t)(value >> 16);
+	data[3] = (uint8_t)(value >> 24);
+}
+
+
+/**************************************************************************//**
+* @fn		static bool FlasherJournal_ReadHeader(const struct FlasherHal *hal, uint32_t row, uint32_t *words)
+* @brief	Reads and checks the header of a journal row
+* @param[in]	hal		Hardware access
+* @param[in]	row		Address of the journal row
+* @param[out]	words	FLASHER_JOURNAL_HEADER_WORDS header words
+* @return	True if the magic and the check word match
+*****************************************************************************/
+static bool FlasherJournal_ReadHeader(const struct FlasherHal *hal, uint32_t row, uint32_t *words)
+{
+	const uint8_t *data = hal->flash(hal->context, row);
+	uint32_t sum = 0;
+
+	for (uint32_t i = 0; i < FLASHER_JOURNAL_HEADER_WORDS; i++)
+	{
+		words[i] = FlasherJournal_ReadWord(&data[i * 4]);
+	}
+	for (uint32_t i = 0; i < FLASHER_JOURNAL_HEADER_WORDS - 1; i++)
+	{
+		sum += words[i];
+	}
+
+	return words[0] == FLASHER_JOURNAL_MAGIC && words[FLASHER_JOURNAL_HEADER_WORDS - 1] == ~sum;
+}
+
+
+/**************************************************************************//**
+* @fn		static enum FlasherResult FlasherJournal_EraseRow(const struct FlasherHal *hal, uint32_t row)
+* @brief	Erases a reserved row and waits for the NVM
+*****************************************************************************/
+static enum FlasherResult FlasherJournal_EraseRow(const struct FlasherHal *hal, uint32_t row)
+{
+	enum FlasherResult result = hal->startErase(hal->context, row);
+
+	return (result == FLASHER_OK) ? hal->waitReady(hal->context) : result;
+}
+
+
+/**************************************************************************//**
+* @fn		static enum FlasherResult FlasherJournal_WritePage(const struct FlasherHal *hal, uint32_t address, const uint8_t *page)
+* @brief	Writes one page of a reserved row and waits for the NVM
+*****************************************************************************/
+static enum FlasherResult FlasherJournal_WritePage(const struct FlasherHal *hal, uint32_t address, const uint8_t *page)
+{
+	enum FlasherResult result = hal->writePage(hal->context, address, page);
+
+	return (result == FLASHER_OK) ? hal->waitReady(hal->context) : result;
+}
+
+
+/**************************************************************************//**
+* @fn		static enum FlasherResult FlasherJournal_Start(const struct FlasherHal *hal, struct FlasherJournal *journal, uint32_t rowsDone)
+* @brief	Starts a new record of the update in the journal row that does not hold the newest record
+* @details	The newest record stays valid until the new header is written, so there is always one to
+*			resume from.
+* @param[in]	hal			Hardware access
+* @param[in,out]	journal	Journal state
+* @param[in]	rowsDone	Rows done, stored in the header
+* @return	FLASHER_OK, or the error of the NVM
+*****************************************************************************/
+static enum FlasherResult FlasherJournal_Start(const struct FlasherHal *hal, struct FlasherJournal *journal, uint32_t rowsDone)
+{
+	uint32_t row = (journal->latestRow == journal->address) ? journal->address + FLASHER_ROW_SIZE : journal->address;
+	uint32_t page[FLASHER_PAGE_SIZE / 4];
+	uint8_t *data = (uint8_t *)page;
+	uint32_t words[FLASHER_JOURNAL_HEADER_WORDS] = { FLASHER_JOURNAL_MAGIC, journal->sequence + 1, journal->fileCrc, journal->fileSize, journal->startAddress, rowsDone, 0 };
+	enum FlasherResult result;
+
+	for (uint32_t i = 0; i < FLASHER_JOURNAL_HEADER_WORDS - 1; i++)
+	{
+		words[FLASHER_JOURNAL_HEADER_WORDS - 1] += words[i];
+	}
+	words[FLASHER_JOURNAL_HEADER_WORDS - 1] = ~words[FLASHER_JOURNAL_HEADER_WORDS - 1];
+
+	memset(page, FLASHER_ERASED_BYTE, sizeof(page));
+	for (uint32_t i = 0; i < FLASHER_JOURNAL_HEADER_WORDS; i++)
+	{
+		FlasherJournal_WriteWord(&data[i * 4], words[i]);
+	}
+
+	result = FlasherJournal_EraseRow(hal, row);
+	if (result == FLASHER_OK)
+	{
+		result = FlasherJournal_WritePage(hal, row, data);
+	}
+	if (result == FLASHER_OK)
+	{
+		journal->activeRow = row;
+		journal->latestRow = row;
+		journal->sequence++;
+		journal->nextSlot = 0;
+		journal->rowsDone = rowsDone;
+		journal->backupValid = false;
+	}
+	return result;
+}
+
+
+/**************************************************************************//**
+* @fn		static enum FlasherResult FlasherJournal_Append(const struct FlasherHal *hal, struct FlasherJournal *journal, uint32_t entry, uint32_t crc)
+* @brief	Writes the next free slot of the active record
+* @details	The page is written with every other byte left erased, so the slots already in it keep
+*			their value.
+* @param[in]	hal			Hardware access
+* @param[in,out]	journal	Journal state. There must be an active record with a free slot
+* @param[in]	entry		Entry word
+* @param[in]	crc			CRC32 word
+* @return	FLASHER_OK, or the error of the NVM
+*****************************************************************************/
+static enum FlasherResult FlasherJournal_Append(const struct FlasherHal *hal, struct FlasherJournal *journal, uint32_t entry, uint32_t crc)
+{
+	uint32_t page[FLASHER_PAGE_SIZE / 4];
+	uint8_t *data = (uint8_t *)page;
+	uint32_t slot = journal->nextSlot;
+	uint32_t offset = (slot % FLASHER_JOURNAL_SLOTS_PER_PAGE) * FLASHER_JOURNAL_SLOT_SIZE;
+	uint32_t pageAddress = journal->activeRow + FLASHER_PAGE_SIZE * (1 + slot / FLASHER_JOURNAL_SLOTS_PER_PAGE);
+
+	memset(page, FLASHER_ERASED_BYTE, sizeof(page));
+	FlasherJournal_WriteWord(&data[offset], entry);
+	FlasherJournal_WriteWord(&data[offset + 4], ~entry);
+	FlasherJournal_WriteWord(&data[offset + 8], crc);
+	FlasherJournal_WriteWord(&data[offset + 12], ~crc);
+
+	journal->nextSlot++;
+	return FlasherJournal_WritePage(hal, pageAddress, data);
+}
@@ -0,0 +1,83 @@
+/**************************************************************************//**
+* @file      FlasherJournal.h
+* @brief     Progress journal of the flashing engine, kept in reserved NVM rows
+* @details   Lets an update interrupted by a power loss resume where it stopped instead of starting over.
+*			 Three rows are reserved (FlasherHal.journalAddress): two journal rows used in turn, and a
+*			 backup row.
+*
+*			 A journal row holds one record: a header page naming the update (CRC32 of the first row of the
+*			 file, file size, start address) with a sequence number, followed by FLASHER_JOURNAL_SLOTS
+*			 slots of 16 bytes (entry word and row CRC32, each followed by its complement). Slots are
+*			 appended by programming their page again: the SAMD21 main array has no ECC, so more bits of
+*			 a programmed page can be cleared.
+*			 When the slots run out the record moves to the other journal row with a higher sequence
+*			 number, so a valid record exists at every point of the update. A slot or header torn by a
+*			 power loss fails its check and is ignored.
+*
+*			 Entries count rows in processing order:
+*				DONE n		the first n rows are programmed and verified
+*				BACKUP n	same, and the new content of row n, with the CRC32 given in the slot, is in the
+*							backup row. Written before row n is erased when a delta patch needs the old
+*							content of row n to rebuild it. Once row n is written the backup row may be
+*							reused: the CRC32 then tells which of the two rows still holds that content
+*			 Plain C only, no ASF.
+* @author
+* @date      2026-10-17
+
+******************************************************************************/
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+* Includes
+******************************************************************************/
+#include "FlasherCore.h"
+
+/******************************************************************************
+* Defines
+******************************************************************************/
+#define FLASHER_JOURNAL_ROWS		3			///< Reserved rows: two journal rows, then the backup row
+#define FLASHER_JOURNAL_MAGIC		0x4C4E4A46UL	///< "FJNL" read as a little endian word
+#define FLASHER_JOURNAL_SLOT_SIZE	16			///< Entry word, CRC32 word and their complements
+#define FLASHER_JOURNAL_SLOTS		((FLASHER_ROW_SIZE - FLASHER_PAGE_SIZE) / FLASHER_JOURNAL_SLOT_SIZE)	///< Slots after the header page
+#define FLASHER_JOURNAL_INTERVAL	8			///< Rows between DONE entries of raw and LZ images. Rows past the last entry are redone
+
+/******************************************************************************
+* Structures and Enumerations
+******************************************************************************/
+/// Entry types, in the top byte of the entry word. The low 24 bits hold the row count
+enum FlasherJournalEntry {
+	FLASHER_JOURNAL_DONE = 1,	///< Rows done
+	FLASHER_JOURNAL_BACKUP = 2,	///< Rows done, and the backup row holds the next one
+};
+
+/// RAM copy of the journal
+struct FlasherJournal {
+	uint32_t address;		///< First reserved row. 0 when journaling is disabled
+	uint32_t activeRow;		///< Journal row holding the record of this update. 0 if there is none yet
+	uint32_t latestRow;		///< Journal row holding the newest valid record, of any update. 0 if there is none
+	uint32_t sequence;		///< Sequence number of the newest valid record
+	uint32_t nextSlot;		///< First free slot of the active record
+	uint32_t fileCrc;		///< Identity of the update: CRC32 of the first row of the file
+	uint32_t fileSize;		///< Identity of the update: size of the file
+	uint32_t startAddress;	///< Identity of the update: NVM address of the image
+	uint32_t rowsDone;		///< Rows, in processing order, known to be programmed and verified
+	uint32_t backupCrc;		///< CRC32 (DSU convention, not complemented) of the new content of row rowsDone
+	bool backupValid;		///< The last entry is BACKUP: backupCrc is valid
+};
+
+/******************************************************************************
+* Global Function Declaration
+******************************************************************************/
+void FlasherJournal_Open(const struct FlasherHal *hal, struct FlasherJournal *journal, uint32_t fileCrc, uint32_t fileSize, uint32_t startAddress);
+enum FlasherResult FlasherJournal_Record(const struct FlasherHal *hal, struct FlasherJournal *journal, uint32_t rowsDone);
+enum FlasherResult FlasherJournal_SaveBackup(const struct FlasherHal *hal, struct FlasherJournal *journal, uint32_t rowsDone, const uint8_t *row);
+uint32_t FlasherJournal_BackupAddress(const struct FlasherJournal *journal);
+enum FlasherResult FlasherJournal_Clear(const struct FlasherHal *hal, struct FlasherJournal *journal);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,130 @@
+/**************************************************************************//**
+* @file      ImageCheck.c
+* @brief     Validation of stamped update files before anything is erased
+* @details   All checks only read the SD card and the flash. The payload CRC32 is calculated over the
+*			 file as stored, so a corrupt LZ container or delta patch is caught before the first erase.
+* @author
+* @date      2026-10-17
+
+******************************************************************************/
+
+
+/******************************************************************************
+* Includes
+******************************************************************************/
+#include "ImageCheck.h"
+#include "Flasher/Flasher.h"
+#include "BootInfo/BootInfo.h"
+
+/******************************************************************************
+* Global Functions
+******************************************************************************/
+
+/**************************************************************************//**
+* @fn		enum status_code Image_ReadHeader(FIL *file, struct ImageHeader *header)
+* @brief	Reads and checks the image header at the start of an update file
+* @param[in]	file	FatFs file object opened for reading. Its read pointer is moved
+* @param[out]	header	Decoded header. Valid if the function returns STATUS_OK
+* @return	STATUS_OK if the header is valid and matches the file size. STATUS_ERR_NOT_FOUND if the file
+*			does not start with a header (plain binary), STATUS_ERR_BAD_FORMAT if the header is corrupt or
+*			the payload length does not match the file, STATUS_ERR_IO if the file could not be read
+*****************************************************************************/
+enum status_code Image_ReadHeader(FIL *file, struct ImageHeader *header)
+{
+	uint8_t data[IMAGE_HEADER_SIZE];
+	UINT numBytesRead = 0;
+
+	if (f_lseek(file, 0) != FR_OK || f_read(file, data, IMAGE_HEADER_SIZE, &numBytesRead) != FR_OK)
+	{
+		return STATUS_ERR_IO;
+	}
+
+	if (numBytesRead < IMAGE_HEADER_SIZE || ImageFormat_ReadU32(data) != IMAGE_MAGIC)
+	{
+		return STATUS_ERR_NOT_FOUND;
+	}
+
+	if (ImageFormat_ParseHeader(data, header) != 0 || Image_HeaderCrc(data) != header->headerCrc)
+	{
+		return STATUS_ERR_BAD_FORMAT;
+	}
+
+	if (header->payloadLength != f_size(file) - IMAGE_HEADER_SIZE || header->imageSize == 0)
+	{
+		return STATUS_ERR_BAD_FORMAT;
+	}
+
+	return STATUS_OK;
+}
+
+
+/**************************************************************************//**
+* @fn		enum status_code Image_CheckPayload(FIL *file, const struct ImageHeader *header, uint32_t loadAddress)
+* @brief	Checks that an update can be programmed at loadAddress and that its payload is intact
+* @param[in]	file		Update file, header included
+* @param[in]	header		Header returned by Image_ReadHeader
+* @param[in]	loadAddress	Address the bootloader programs the application at
+* @return	STATUS_OK, STATUS_ERR_BAD_ADDRESS if the image is linked elsewhere or does not fit in the NVM,
+*			STATUS_ERR_BAD_DATA if the payload CRC32 does not match, STATUS_ERR_IO if the file could not be read
+*****************************************************************************/
+enum status_code Image_CheckPayload(FIL *file, const struct ImageHeader *header, uint32_t loadAddress)
+{
+	enum status_code status;
+	uint32_t crc = 0;
+
+	if (header->loadAddress != loadAddress || header->imageSize > FLASH_SIZE - loadAddress)
+	{
+		return STATUS_ERR_BAD_ADDRESS;
+	}
+
+	status = Flasher_CrcFile(file, IMAGE_HEADER_SIZE, header->payloadLength, &crc);
+	if (status != STATUS_OK)
+	{
+		return status;
+	}
+
+	return (crc == header->payloadCrc) ? STATUS_OK : STATUS_ERR_BAD_DATA;
+}
+
+
+/**************************************************************************//**
+* @fn		bool Image_IsInstalled(const struct ImageHeader *header)
+* @brief	Tells whether the image described by header is already installed and intact
+* @details	The installed record (BootInfo) must have the same version and image CRC32, and the flash
+*			must still hold that image. Headers with IMAGE_FLAG_FORCE are never reported as installed.
+* @param[in]	header	Header of the update file
+* @return	True if flashing the update would not change anything
+*****************************************************************************/
+bool Image_IsInstalled(const struct ImageHeader *header)
+{
+	struct ImageHeader installed;
+	uint32_t rows = (header->imageSize + FLASHER_ROW_SIZE - 1) / FLASHER_ROW_SIZE;
+	uint32_t crc = 0;
+
+	if ((header->flags & IMAGE_FLAG_FORCE) != 0 || !BootInfo_GetInstalled(&installed))
+	{
+		return false;
+	}
+
+	if (installed.version != header->version || installed.imageCrc != header->imageCrc || installed.imageSize != header->imageSize)
+	{
+		return false;
+	}
+
+	return (Flasher_CrcFlash(header->loadAddress, rows * FLASHER_ROW_SIZE, &crc) == STATUS_OK) && (crc == header->imageCrc);
+}
+
+
+/**************************************************************************//**
+* @fn		uint32_t Image_HeaderCrc(const uint8_t *data)
+* @brief	Calculates the CRC32 that protects an encoded image header
+* @param[in]	data	Encoded header, at least IMAGE_HEADER_CRC_OFFSET bytes long
+* @return	CRC32 of the first IMAGE_HEADER_CRC_OFFSET bytes
+*****************************************************************************/
+uint32_t Image_HeaderCrc(const uint8_t *data)
+{
+	crc32_t crc = 0;
+
+	crc32_calculate(data, IMAGE_HEADER_CRC_OFFSET, &crc);
+	return crc;
+}
@@ -0,0 +1,32 @@
+/**************************************************************************//**
+* @file      ImageCheck.h
+* @brief     Validation of stamped update files before anything is erased
+* @details   Reads the image header (Image/ImageFormat.h) of an update file on the SD card, checks it and
+*			 the payload CRC32, and tells whether the same image is already installed.
+* @author
+* @date      2026-10-17
+
+******************************************************************************/
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+* Includes
+******************************************************************************/
+#include <asf.h>
+#include "Image/ImageFormat.h"
+
+/******************************************************************************
+* Global Function Declaration
+******************************************************************************/
+enum status_code Image_ReadHeader(FIL *file, struct ImageHeader *header);
+enum status_code Image_CheckPayload(FIL *file, const struct ImageHeader *header, uint32_t loadAddress);
+bool Image_IsInstalled(const struct ImageHeader *header);
+uint32_t Image_HeaderCrc(const uint8_t *data);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,115 @@
+/**************************************************************************//**
+* @file      ImageFormat.h
+* @brief     Layout of the firmware image header stamped on update files
+* @details   Shared between the bootloader and the host tools (Tools/fwstamp.c). Plain C only, no ASF.
+*
+*			 An update file is a 36 byte header followed by the payload. The payload is a raw binary, an
+*			 LZ container (Lz/LzFormat.h) or a delta patch (Delta/DeltaFormat.h). All fields are little endian.
+*				offset 0	magic			IMAGE_MAGIC ("FWH1")
+*				offset 4	headerSize		IMAGE_HEADER_SIZE. Lets later versions grow the header
+*				offset 6	flags			IMAGE_FLAG_*
+*				offset 8	version			Firmware version. Compared with the installed version
+*				offset 12	payloadLength	Size of the payload that follows the header, in bytes
+*				offset 16	loadAddress		Flash address the image is linked at
+*				offset 20	imageSize		Size of the image once in flash, in bytes
+*				offset 24	payloadCrc		CRC32 of the payload bytes as stored in the file
+*				offset 28	imageCrc		CRC32 of the image once in flash, padded with 0xFF to whole rows
+*				offset 32	headerCrc		CRC32 of bytes 0 to 31
+*
+*			 CRC32 is the usual IEEE 802.3 / zlib CRC (see Delta/DeltaFormat.h).
+* @author
+* @date      2026-10-17
+
+******************************************************************************/
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+* Includes
+******************************************************************************/
+#include <stdint.h>
+
+/******************************************************************************
+* Defines
+******************************************************************************/
+#define IMAGE_MAGIC				0x31485746UL	///< "FWH1" read as a little endian word
+#define IMAGE_HEADER_SIZE		36				///< Size of the header, in bytes
+#define IMAGE_HEADER_CRC_OFFSET	32				///< The header CRC covers the bytes before this offset
+
+#define IMAGE_FLAG_FORCE		0x0001			///< Flash even if the installed version matches
+
+/******************************************************************************
+* Structures and Enumerations
+******************************************************************************/
+/// Decoded image header
+struct ImageHeader {
+	uint32_t magic;			///< Must be IMAGE_MAGIC
+	uint16_t headerSize;	///< Must be IMAGE_HEADER_SIZE
+	uint16_t flags;			///< IMAGE_FLAG_*
+	uint32_t version;		///< Firmware version
+	uint32_t payloadLength;	///< Size of the payload, in bytes
+	uint32_t loadAddress;	///< Flash address the image is linked at
+	uint32_t imageSize;		///< Size of the image once in flash, in bytes
+	uint32_t payloadCrc;	///< CRC32 of the payload as stored in the file
+	uint32_t imageCrc;		///< CRC32 of the image once in flash, padded to whole rows
+	uint32_t headerCrc;		///< CRC32 of the first IMAGE_HEADER_CRC_OFFSET bytes
+};
+
+/******************************************************************************
+* Inline Functions
+******************************************************************************/
+/// Reads a little endian 32 bit word from a byte buffer
+static inline uint32_t ImageFormat_ReadU32(const uint8_t *data)
+{
+	return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+/// Writes a little endian 32 bit word into a byte buffer
+static inline void ImageFormat_WriteU32(uint8_t *data, uint32_t value)
+{
+	data[0] = (uint8_t)value;
+	data[1] = (uint8_t)(value >> 8);
+	data[2] = (uint8_t)(value >> 16);
+	data[3] = (uint8_t)(value >> 24);
+}
+
+/// Decodes a header. Returns 0 if magic and size match, -1 otherwise. The header CRC is not checked
+static inline int ImageFormat_ParseHeader(const uint8_t *data, struct ImageHeader *header)
+{
+	header->magic = ImageFormat_ReadU32(&data[0]);
+	header->headerSize = (uint16_t)(data[4] | (data[5] << 8));
+	header->flags = (uint16_t)(data[6] | (data[7] << 8));
+	header->version = ImageFormat_ReadU32(&data[8]);
+	header->payloadLength = ImageFormat_ReadU32(&data[12]);
+	header->loadAddress = ImageFormat_ReadU32(&data[16]);
+	header->imageSize = ImageFormat_ReadU32(&data[20]);
+	header->payloadCrc = ImageFormat_ReadU32(&data[24]);
+	header->imageCrc = ImageFormat_ReadU32(&data[28]);
+	header->headerCrc = ImageFormat_ReadU32(&data[32]);
+
+	return (header->magic == IMAGE_MAGIC && header->headerSize == IMAGE_HEADER_SIZE) ? 0 : -1;
+}
+
+/// Encodes a header into IMAGE_HEADER_SIZE bytes. headerCrc is written as given
+static inline void ImageFormat_WriteHeader(uint8_t *data, const struct ImageHeader *header)
+{
+	ImageFormat_WriteU32(&data[0], IMAGE_MAGIC);
+	data[4] = (uint8_t)IMAGE_HEADER_SIZE;
+	data[5] = 0;
+	data[6] = (uint8_t)header->flags;
+	data[7] = (uint8_t)(header->flags >> 8);
+	ImageFormat_WriteU32(&data[8], header->version);
+	ImageFormat_WriteU32(&data[12], header->payloadLength);
+	ImageFormat_WriteU32(&data[16], header->loadAddress);
+	ImageFormat_WriteU32(&data[20], header->imageSize);
+	ImageFormat_WriteU32(&data[24], header->payloadCrc);
+	ImageFormat_WriteU32(&data[28], header->imageCrc);
+	ImageFormat_WriteU32(&data[32], header->headerCrc);
+}
+
+#ifdef __cplusplus
+}
+#endif
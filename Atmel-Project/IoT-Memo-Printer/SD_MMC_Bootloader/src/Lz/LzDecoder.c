@@ -0,0 +1,188 @@
+/**************************************************************************//**
+* @file      LzDecoder.c
+* @brief     Streaming decompressor for LZ compressed firmware images
+* @details   See LzFormat.h for the payload layout. The decoder is resumable at any byte: a match that
+*			 does not fit in the caller's buffer is finished on the next call.
+* @author
+* @date      2026-10-17
+
+******************************************************************************/
+
+
+/******************************************************************************
+* Includes
+******************************************************************************/
+#include <string.h>
+#include "LzDecoder.h"
+
+/******************************************************************************
+* Defines
+******************************************************************************/
+#define LZ_WINDOW_MASK		(LZ_WINDOW_SIZE - 1)	///< Wraps window positions
+
+/******************************************************************************
+* Forward Declarations
+******************************************************************************/
+static bool LzDecoder_NextByte(struct LzDecoder *decoder, uint8_t *value);
+
+/******************************************************************************
+* Global Functions
+******************************************************************************/
+
+/**************************************************************************//**
+* @fn		void LzDecoder_Init(struct LzDecoder *decoder, uint32_t rawSize, LzFillFn fill, void *context)
+* @brief	Prepares a decoder for a new payload
+* @param[out]	decoder	Decoder to initialize
+* @param[in]	rawSize	Size of the decompressed image, from the container header
+* @param[in]	fill	Callback that provides the compressed payload, starting right after the header
+* @param[in]	context	Passed to fill
+*****************************************************************************/
+void LzDecoder_Init(struct LzDecoder *decoder, uint32_t rawSize, LzFillFn fill, void *context)
+{
+	decoder->fill = fill;
+	decoder->context = context;
+	decoder->remaining = rawSize;
+	decoder->produced = 0;
+	decoder->inputPos = 0;
+	decoder->inputLen = 0;
+	decoder->windowPos = 0;
+	decoder->matchDistance = 0;
+	decoder->matchRemaining = 0;
+	decoder->flags = 0;
+	decoder->flagCount = 0;
+	decoder->error = false;
+}
+
+
+/**************************************************************************//**
+* @fn		int32_t LzDecoder_Read(struct LzDecoder *decoder, uint8_t *buffer, uint32_t length)
+* @brief	Decodes up to length bytes into buffer
+* @param[in,out]	decoder	Decoder initialized with LzDecoder_Init
+* @param[out]	buffer	Destination of the decoded bytes
+* @param[in]	length	Size of buffer
+* @return	Number of bytes decoded. Less than length only at the end of the image, 0 once it is done.
+*			LZ_DECODER_ERROR if the payload is corrupt or ends early.
+*****************************************************************************/
+int32_t LzDecoder_Read(struct LzDecoder *decoder, uint8_t *buffer, uint32_t length)
+{
+	uint32_t count = 0;
+
+	if (decoder->error)
+	{
+		return LZ_DECODER_ERROR;
+	}
+
+	if (length > decoder->remaining)
+	{
+		length = decoder->remaining;
+	}
+
+	while (count < length)
+	{
+		uint8_t value;
+
+		if (decoder->matchRemaining == 0)
+		{
+			uint8_t token;
+
+			if (decoder->flagCount == 0)
+			{
+				if (!LzDecoder_NextByte(decoder, &decoder->flags))
+				{
+					break;
+				}
+				decoder->flagCount = 8;
+			}
+
+			bool isLiteral = (decoder->flags & 0x01) != 0;
+			decoder->flags >>= 1;
+			decoder->flagCount--;
+
+			if (!LzDecoder_NextByte(decoder, &token))
+			{
+				break;
+			}
+
+			if (isLiteral)
+			{
+				buffer[count++] = token;
+				decoder->window[decoder->windowPos] = token;
+				decoder->windowPos = (decoder->windowPos + 1) & LZ_WINDOW_MASK;
+				continue;
+			}
+
+			uint8_t high;
+			if (!LzDecoder_NextByte(decoder, &high))
+			{
+				break;
+			}
+
+			uint16_t code = (uint16_t)token | ((uint16_t)high << 8);
+			uint16_t lengthField = code >> LZ_WINDOW_BITS;
+			decoder->matchDistance = (code & LZ_WINDOW_MASK) + 1;
+			decoder->matchRemaining = lengthField + LZ_MIN_MATCH;
+
+			if (lengthField == LZ_LENGTH_EXTENDED)
+			{
+				uint8_t extra;
+				if (!LzDecoder_NextByte(decoder, &extra))
+				{
+					break;
+				}
+				decoder->matchRemaining += extra;
+			}
+
+			if (decoder->matchDistance > decoder->produced + count)
+			{
+				decoder->error = true;
+				break;
+			}
+		}
+
+		//Copy one byte of the current match. Overlapping matches (distance < length) repeat the pattern
+		value = decoder->window[(decoder->windowPos - decoder->matchDistance) & LZ_WINDOW_MASK];
+		buffer[count++] = value;
+		decoder->window[decoder->windowPos] = value;
+		decoder->windowPos = (decoder->windowPos + 1) & LZ_WINDOW_MASK;
+		decoder->matchRemaining--;
+	}
+
+	decoder->produced += count;
+	decoder->remaining -= count;
+
+	if (count < length)
+	{
+		decoder->error = true;
+		return LZ_DECODER_ERROR;
+	}
+
+	return (int32_t)count;
+}
+
+
+/******************************************************************************
+* Static Functions
+******************************************************************************/
+
+/**************************************************************************//**
+* @fn		static bool LzDecoder_NextByte(struct LzDecoder *decoder, uint8_t *value)
+* @brief	Returns the next compressed byte, refilling the input buffer when it runs empty
+* @param[in,out]	decoder	Decoder state
+* @param[out]	value	Next compressed byte
+* @return	False if the fill callback has no more data
+*****************************************************************************/
+static bool LzDecoder_NextByte(struct LzDecoder *decoder, uint8_t *value)
+{
+	if (decoder->inputPos >= decoder->inputLen)
+	{
+		decoder->inputLen = (uint16_t)decoder->fill(decoder->context, decoder->input, LZ_INPUT_BUFFER_SIZE);
+		decoder->inputPos = 0;
+		if (decoder->inputLen == 0)
+		{
+			return false;
+		}
+	}
+
+	*value = decoder->input[decoder->inputPos++];
+	return true;
+}
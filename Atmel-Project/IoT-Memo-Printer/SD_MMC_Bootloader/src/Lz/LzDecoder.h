@@ -0,0 +1,64 @@
+/**************************************************************************//**
+* @file      LzDecoder.h
+* @brief     Streaming decompressor for LZ compressed firmware images
+* @details   Decodes the payload described in LzFormat.h in arbitrary sized chunks, so the output can be
+*			 fed row by row into the NVM. The whole state, including the 2 KB history window and a small
+*			 input buffer, lives in struct LzDecoder. Compressed data is pulled through a fill callback.
+*			 Plain C only, no ASF, so the same file is used by the host tools.
+* @author
+* @date      2026-10-17
+
+******************************************************************************/
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+* Includes
+******************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "LzFormat.h"
+
+/******************************************************************************
+* Defines
+******************************************************************************/
+#define LZ_INPUT_BUFFER_SIZE	64		///< Compressed bytes requested from the fill callback at a time
+#define LZ_DECODER_ERROR		(-1)	///< Returned by LzDecoder_Read on corrupt or truncated input
+
+/******************************************************************************
+* Structures and Enumerations
+******************************************************************************/
+/// Fill callback. Copies up to length compressed bytes into buffer and returns how many were copied. 0 means end of input or error
+typedef size_t (*LzFillFn)(void *context, uint8_t *buffer, size_t length);
+
+/// Decoder state. Keep it static, it is slightly over LZ_WINDOW_SIZE bytes
+struct LzDecoder {
+	uint8_t window[LZ_WINDOW_SIZE];			///< History of the last LZ_WINDOW_SIZE decoded bytes
+	uint8_t input[LZ_INPUT_BUFFER_SIZE];	///< Compressed bytes not yet consumed
+	LzFillFn fill;							///< Callback used to refill input
+	void *context;							///< Passed to fill
+	uint32_t remaining;						///< Decoded bytes still to produce
+	uint32_t produced;						///< Decoded bytes produced so far. Used to reject distances before the start
+	uint16_t inputPos;						///< Next byte to consume in input
+	uint16_t inputLen;						///< Number of valid bytes in input
+	uint16_t windowPos;						///< Next byte to write in window
+	uint16_t matchDistance;					///< Distance of the match being copied
+	uint16_t matchRemaining;				///< Bytes left to copy from the current match
+	uint8_t flags;							///< Current flag byte, shifted as tokens are consumed
+	uint8_t flagCount;						///< Tokens left in the current flag byte
+	bool error;								///< Set once corrupt or truncated input was found
+};
+
+/******************************************************************************
+* Global Function Declaration
+******************************************************************************/
+void LzDecoder_Init(struct LzDecoder *decoder, uint32_t rawSize, LzFillFn fill, void *context);
+int32_t LzDecoder_Read(struct LzDecoder *decoder, uint8_t *buffer, uint32_t length);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,102 @@
+/**************************************************************************//**
+* @file      LzFormat.h
+* @brief     Layout of the LZ compressed firmware image container
+* @details   Shared between the bootloader and the host tools (Tools/lzpack.c). Plain C only, no ASF.
+*
+*			 Container: a 16 byte header followed by the compressed payload. All fields are little endian.
+*				offset 0	magic		LZ_MAGIC ("LZI1")
+*				offset 4	rawSize		Size of the decompressed image, in bytes
+*				offset 8	packedSize	Size of the payload that follows the header, in bytes
+*				offset 12	windowBits	log2 of the window size used by the packer. Must be <= LZ_WINDOW_BITS
+*				offset 13	reserved	3 bytes, written as 0
+*
+*			 Payload: groups of one flag byte followed by up to 8 tokens. Bit 0 of the flag byte describes
+*			 the first token. A set bit is a literal byte. A cleared bit is a match encoded in two bytes
+*			 (little endian): bits 0-10 hold distance - 1 and bits 11-15 hold length - LZ_MIN_MATCH. A length
+*			 field of LZ_LENGTH_EXTENDED is followed by one more byte that is added to the length.
+*			 The payload ends when rawSize bytes have been produced.
+*
+*			 The magic can not be mistaken for a raw image: the first word of a raw image is the initial
+*			 stack pointer, which always points to RAM (0x2000xxxx).
+* @author
+* @date      2026-10-17
+
+******************************************************************************/
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+* Includes
+******************************************************************************/
+#include <stdint.h>
+
+/******************************************************************************
+* Defines
+******************************************************************************/
+#define LZ_MAGIC				0x31495A4CUL	///< "LZI1" read as a little endian word
+#define LZ_HEADER_SIZE			16				///< Size of the container header, in bytes
+#define LZ_WINDOW_BITS			11				///< log2 of the largest window the bootloader supports
+#define LZ_WINDOW_SIZE			(1U << LZ_WINDOW_BITS)	///< 2 KB window. Also the largest match distance
+#define LZ_MIN_MATCH			3				///< Shortest match worth encoding (a match costs 2 bytes and a flag bit)
+#define LZ_LENGTH_BITS			5				///< Bits of the match length field
+#define LZ_LENGTH_EXTENDED		((1U << LZ_LENGTH_BITS) - 1)	///< Length field value followed by an extra length byte
+#define LZ_MAX_MATCH			(LZ_MIN_MATCH + LZ_LENGTH_EXTENDED + 255)	///< Longest match that can be encoded
+
+/******************************************************************************
+* Structures and Enumerations
+******************************************************************************/
+/// Decoded container header
+struct LzHeader {
+	uint32_t magic;			///< Must be LZ_MAGIC
+	uint32_t rawSize;		///< Size of the decompressed image, in bytes
+	uint32_t packedSize;	///< Size of the compressed payload, in bytes
+	uint8_t windowBits;		///< log2 of the window size used by the packer
+};
+
+/******************************************************************************
+* Inline Functions
+******************************************************************************/
+/// Reads a little endian 32 bit word from a byte buffer
+static inline uint32_t LzFormat_ReadU32(const uint8_t *data)
+{
+	return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+/// Writes a little endian 32 bit word into a byte buffer
+static inline void LzFormat_WriteU32(uint8_t *data, uint32_t value)
+{
+	data[0] = (uint8_t)value;
+	data[1] = (uint8_t)(value >> 8);
+	data[2] = (uint8_t)(value >> 16);
+	data[3] = (uint8_t)(value >> 24);
+}
+
+/// Decodes a container header. Returns 0 if the header is valid and supported, -1 otherwise
+static inline int LzFormat_ParseHeader(const uint8_t *data, struct LzHeader *header)
+{
+	header->magic = LzFormat_ReadU32(&data[0]);
+	header->rawSize = LzFormat_ReadU32(&data[4]);
+	header->packedSize = LzFormat_ReadU32(&data[8]);
+	header->windowBits = data[12];
+
+	return (header->magic == LZ_MAGIC && header->windowBits <= LZ_WINDOW_BITS) ? 0 : -1;
+}
+
+/// Encodes a container header into LZ_HEADER_SIZE bytes
+static inline void LzFormat_WriteHeader(uint8_t *data, const struct LzHeader *header)
+{
+	LzFormat_WriteU32(&data[0], LZ_MAGIC);
+	LzFormat_WriteU32(&data[4], header->rawSize);
+	LzFormat_WriteU32(&data[8], header->packedSize);
+	data[12] = header->windowBits;
+	data[13] = 0;
+	data[14] = 0;
+	data[15] = 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -29,17 +29,17 @@
 /******************************************************************************
 * Defines
 ******************************************************************************/
-#define RX_BUFFER_SIZE 1024	///<Size of character buffer for RX, in bytes
-#define TX_BUFFER_SIZE 1024	///<Size of character buffers for TX, in bytes
+#define RX_BUFFER_SIZE 1024	///<Size of character buffer for RX, in bytes. Power of two (circular_buffer.h)
+#define TX_BUFFER_SIZE 1024	///<Size of character buffers for TX, in bytes. Power of two (circular_buffer.h)
 
 /******************************************************************************
 * Structures and Enumerations
 ******************************************************************************/
-cbuf_handle_t cbufRx;	///<Circular buffer handler for receiving characters from the Serial Interface
-cbuf_handle_t cbufTx;	///<Circular buffer handler for transmitting characters from the Serial Interface
+circular_buf_t cbufRx;	///<Circular buffer for receiving characters from the Serial Interface. Producer: read callback, consumer: main loop
+circular_buf_t cbufTx;	///<Circular buffer for transmitting characters from the Serial Interface. Producer: main loop, consumer: whoever starts the next write job
 
 char latestRx;	///< Holds the latest character that was received
-char latestTx;	///< Holds the latest character to be transmitted.
+volatile size_t txInFlight;	///< Bytes of cbufTx handed to the current write job. They stay in the ring until it completes
 
 /******************************************************************************
 *  Callback Declaration
@@ -52,6 +52,7 @@ void usart_read_callback(struct usart_module *const usart_module);	//Callback fo
 ******************************************************************************/
 static void configure_usart(void);
 static void configure_usart_callbacks(void);
+static void start_usart_write(void);
 
 /******************************************************************************
 * Global Local Variables
@@ -80,8 +81,8 @@ void InitializeSerialConsole()
 {
 
 	//Initialize circular buffers for RX and TX
-	cbufRx = circular_buf_init((uint8_t*)rxCharacterBuffer, RX_BUFFER_SIZE);
-	cbufTx = circular_buf_init((uint8_t*)txCharacterBuffer, TX_BUFFER_SIZE);
+	circular_buf_init(&cbufRx, (uint8_t*)rxCharacterBuffer, RX_BUFFER_SIZE);
+	circular_buf_init(&cbufTx, (uint8_t*)txCharacterBuffer, TX_BUFFER_SIZE);
 
 	//Configure USART and Callbacks
 	configure_usart();
@@ -101,22 +102,19 @@ void DeinitializeSerialConsole()
 /**************************************************************************//**
 * @fn			void SerialConsoleWriteString(char * string)
 * @brief		Writes a string to be written to the uart. Copies the string to a ring buffer that is used to hold the text send to the uart
-* @details		Uses the ringbuffer 'cbufTx', which in turn uses the array 'txCharacterBuffer'
+* @details		Uses the ringbuffer 'cbufTx', which in turn uses the array 'txCharacterBuffer'. Characters that do not fit
+*				in the ring are dropped.
 * @note			Use to send a string of characters to the user via UART
 *****************************************************************************/
 void SerialConsoleWriteString(char * string)
 {
 	if(string != NULL)
 	{
-		for (size_t iter = 0; iter < strlen(string); iter++)
-		{
-			circular_buf_put(cbufTx, string[iter]);
-		}
+		circular_buf_put_n(&cbufTx, (const uint8_t*) string, strlen(string));
 		
 		if(usart_get_job_status(&usart_instance, USART_TRANSCEIVER_TX) == STATUS_OK)
 		{
-			circular_buf_get(cbufTx, (uint8_t*) &latestTx); //Perform only if the SERCOM TX is free (not busy)
-			usart_write_buffer_job(&usart_instance, (uint8_t*) &latestTx, 1);
+			start_usart_write(); //Perform only if the SERCOM TX is free (not busy)
 		}
 	}
 }
@@ -135,7 +133,7 @@ void SerialConsoleWriteString(char * string)
 int SerialConsoleReadCharacter(uint8_t *rxChar)
 {
 
-	return circular_buf_get(cbufRx, (uint8_t*) rxChar);
+	return circular_buf_get(&cbufRx, (uint8_t*) rxChar);
 
 }
 
@@ -236,6 +234,25 @@ static void configure_usart_callbacks(void)
 }
 
 
+/**************************************************************************//**
+* @fn			static void start_usart_write(void)
+* @brief		Starts a write job over the contiguous span at the start of cbufTx, if there is one
+* @details		The span is sent in place and released by the write callback once the job completes.
+* @note			Call only when the SERCOM TX is free
+*****************************************************************************/
+static void start_usart_write(void)
+{
+	const uint8_t *span;
+	size_t length = circular_buf_peek(&cbufTx, &span);
+
+	txInFlight = length;
+	if(length > 0)
+	{
+		usart_write_buffer_job(&usart_instance, (uint8_t*) span, (uint16_t) length);
+	}
+}
+
+
 
 
 
@@ -251,16 +268,8 @@ static void configure_usart_callbacks(void)
 *****************************************************************************/
 void usart_read_callback(struct usart_module *const usart_module)
 {
-	//Order Echo
-	SerialConsoleWriteString(&latestRx);
-	if(latestRx == 0x08)
-	{
-	char a[3];
-	a[0] = 0x20;
-	a[1]= 0x08;
-	SerialConsoleWriteString(&a);
-	}
-	circular_buf_put(cbufRx, (uint8_t) latestRx); //Add the latest read character into the RX circular Buffer
+	//No echo from here: the bootloader has no console reader, and writing from the ISR would make it a second TX producer
+	circular_buf_put(&cbufRx, (uint8_t) latestRx); //Add the latest read character into the RX circular Buffer
 
 	usart_read_buffer_job(&usart_instance, (uint8_t*) &latestRx, 1);	//Order the MCU to keep reading
 }
@@ -273,9 +282,6 @@ void usart_read_callback(struct usart_module *const usart_module)
 *****************************************************************************/
 void usart_write_callback(struct usart_module *const usart_module)
 {
-	if(circular_buf_get(cbufTx, (uint8_t*) &latestTx) != -1) //Only continue if there are more characters to send
-	{
-		usart_write_buffer_job(&usart_instance, (uint8_t*) &latestTx, 1);
-	}
-	
+	circular_buf_consume(&cbufTx, txInFlight); //Release the span that was just sent
+	start_usart_write(); //Only continues if there are more characters to send
 }
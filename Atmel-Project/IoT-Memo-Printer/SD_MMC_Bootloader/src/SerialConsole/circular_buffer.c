@@ -1,177 +1,180 @@
-
 /**************************************************************************//**
-* @file        circular_buffer library
+* @file        circular_buffer.c
 * @ingroup 	   Serial Console
-* @brief       This library for a circular buffer is taken from https://github.com/embeddedartistry/embedded-resources/blob/master/examples/c/circular_buffer/circular_buffer.c
-*				Author: Phillips Johnston
-* @details     Please refer to the github code above and to "https://embeddedartistry.com/blog/2017/4/6/circular-buffers-in-cc" for more information
+* @brief       Single producer, single consumer byte ring used by the serial console
+* @details     See circular_buffer.h. Replaces the malloc'ed, modulo indexed ring taken from
+*				https://github.com/embeddedartistry/embedded-resources (Phillips Johnston), whose put moved the
+*				tail when full and so could not be shared by an ISR and a task without a lock.
 *
-*				See "https://github.com/embeddedartistry/embedded-resources/blob/master/examples/c/circular_buffer_test.c" for examples on how to use the buffer
+*				Indexes are published with the GCC __atomic builtins. On the Cortex-M0+ an aligned word load or
+*				store is atomic and these compile to a plain ldr/str next to a dmb; on a host they give the
+*				ordering a second thread needs (see Tools/ringbench.c).
 *
 * @copyright
-* @author		Phillips Johnston
-* @date        Aug 6, 2018
-* @version		0.1
+* @author
+* @date        2026-10-17
+* @version		0.2
 *****************************************************************************/
 
 
- #include <stdlib.h>
- #include <stdint.h>
- #include <stddef.h>
- #include <stdbool.h>
- #include <assert.h>
-
- #include "circular_buffer.h"
-
-
- // The definition of our circular buffer structure is hidden from the user
- struct circular_buf_t {
-	 uint8_t * buffer;
-	 size_t head;
-	 size_t tail;
-	 size_t max; //of the buffer
-	 bool full;
- };
-
- #pragma mark - Private Functions -
-
- static void advance_pointer(cbuf_handle_t cbuf)
- {
-	 //assert(cbuf);
-
-	 if(cbuf->full)
-	 {
-		 cbuf->tail = (cbuf->tail + 1) % cbuf->max;
-	 }
-
-	 cbuf->head = (cbuf->head + 1) % cbuf->max;
-
-	 // We mark full because we will advance tail on the next time around
-	 cbuf->full = (cbuf->head == cbuf->tail);
- }
-
- static void retreat_pointer(cbuf_handle_t cbuf)
- {
-	 //assert(cbuf);
-
-	 cbuf->full = false;
-	 cbuf->tail = (cbuf->tail + 1) % cbuf->max;
- }
-
- #pragma mark - APIs -
-
- cbuf_handle_t circular_buf_init(uint8_t* buffer, size_t size)
- {
-	// assert(buffer && size);
-
-	 cbuf_handle_t cbuf = malloc(sizeof(circular_buf_t));
-	 //assert(cbuf);
-
-	 cbuf->buffer = buffer;
-	 cbuf->max = size;
-	 circular_buf_reset(cbuf);
-
-	// assert(circular_buf_empty(cbuf));
-
-	 return cbuf;
- }
-
- void circular_buf_free(cbuf_handle_t cbuf)
- {
-	// assert(cbuf);
-	 free(cbuf);
- }
-
- void circular_buf_reset(cbuf_handle_t cbuf)
- {
-	// assert(cbuf);
-
-	 cbuf->head = 0;
-	 cbuf->tail = 0;
-	 cbuf->full = false;
- }
-
- size_t circular_buf_size(cbuf_handle_t cbuf)
- {
-	// assert(cbuf);
-
-	 size_t size = cbuf->max;
-
-	 if(!cbuf->full)
-	 {
-		 if(cbuf->head >= cbuf->tail)
-		 {
-			 size = (cbuf->head - cbuf->tail);
-		 }
-		 else
-		 {
-			 size = (cbuf->max + cbuf->head - cbuf->tail);
-		 }
-
-	 }
-
-	 return size;
- }
-
- size_t circular_buf_capacity(cbuf_handle_t cbuf)
- {
-	 //assert(cbuf);
-
-	 return cbuf->max;
- }
-
- void circular_buf_put(cbuf_handle_t cbuf, uint8_t data)
- {
-	 //assert(cbuf && cbuf->buffer);
-
-	 cbuf->buffer[cbuf->head] = data;
-
-	 advance_pointer(cbuf);
- }
-
- int circular_buf_put2(cbuf_handle_t cbuf, uint8_t data)
- {
-	 int r = -1;
-
-	 //assert(cbuf && cbuf->buffer);
-
-	 if(!circular_buf_full(cbuf))
-	 {
-		 cbuf->buffer[cbuf->head] = data;
-		 advance_pointer(cbuf);
-		 r = 0;
-	 }
-
-	 return r;
- }
-
- int circular_buf_get(cbuf_handle_t cbuf, uint8_t * data)
- {
-	 //assert(cbuf && data && cbuf->buffer);
-	 
-	 int r = -1;
-
-	 if(!circular_buf_empty(cbuf))
-	 {
-		 *data = cbuf->buffer[cbuf->tail];
-		 retreat_pointer(cbuf);
-
-		 r = 0;
-	 }
-
-	 return r;
- }
-
- bool circular_buf_empty(cbuf_handle_t cbuf)
- {
-	 //assert(cbuf);
-
-	 return (!cbuf->full && (cbuf->head == cbuf->tail));
- }
-
- bool circular_buf_full(cbuf_handle_t cbuf)
- {
-	// assert(cbuf);
-
-	 return cbuf->full;
- }
\ No newline at end of file
+#include <string.h>
+
+#include "circular_buffer.h"
+
+
+/// Reads the index written by the other side. Later reads of the data are not moved before it
+#define CBUF_LOAD_ACQUIRE(index)			__atomic_load_n(&(index), __ATOMIC_ACQUIRE)
+/// Publishes this side's index. Earlier accesses to the data are not moved after it
+#define CBUF_STORE_RELEASE(index, value)	__atomic_store_n(&(index), (value), __ATOMIC_RELEASE)
+/// Reads this side's own index. Only this side writes it, so no ordering is needed
+#define CBUF_LOAD_OWN(index)				__atomic_load_n(&(index), __ATOMIC_RELAXED)
+
+
+void circular_buf_init(cbuf_handle_t cbuf, uint8_t* buffer, size_t size)
+{
+	size_t capacity = 1;
+
+	while(capacity <= size / 2)
+	{
+		capacity *= 2;
+	}
+
+	cbuf->buffer = buffer;
+	cbuf->mask = capacity - 1;
+	circular_buf_reset(cbuf);
+}
+
+void circular_buf_reset(cbuf_handle_t cbuf)
+{
+	CBUF_STORE_RELEASE(cbuf->head, 0);
+	CBUF_STORE_RELEASE(cbuf->tail, 0);
+}
+
+int circular_buf_put(cbuf_handle_t cbuf, uint8_t data)
+{
+	size_t head = CBUF_LOAD_OWN(cbuf->head);
+
+	if(head - CBUF_LOAD_ACQUIRE(cbuf->tail) > cbuf->mask)
+	{
+		return -1;
+	}
+
+	cbuf->buffer[head & cbuf->mask] = data;
+	CBUF_STORE_RELEASE(cbuf->head, head + 1);
+	return 0;
+}
+
+size_t circular_buf_put_n(cbuf_handle_t cbuf, const uint8_t *data, size_t len)
+{
+	size_t head = CBUF_LOAD_OWN(cbuf->head);
+	size_t space = cbuf->mask + 1 - (head - CBUF_LOAD_ACQUIRE(cbuf->tail));
+	size_t offset = head & cbuf->mask;
+	size_t first;
+
+	if(len > space)
+	{
+		len = space;
+	}
+
+	//Copy up to the end of the storage, then wrap to its start
+	first = cbuf->mask + 1 - offset;
+	if(first > len)
+	{
+		first = len;
+	}
+	memcpy(&cbuf->buffer[offset], data, first);
+	memcpy(cbuf->buffer, &data[first], len - first);
+
+	CBUF_STORE_RELEASE(cbuf->head, head + len);
+	return len;
+}
+
+size_t circular_buf_reserve(cbuf_handle_t cbuf, uint8_t **span)
+{
+	size_t head = CBUF_LOAD_OWN(cbuf->head);
+	size_t space = cbuf->mask + 1 - (head - CBUF_LOAD_ACQUIRE(cbuf->tail));
+	size_t offset = head & cbuf->mask;
+
+	*span = &cbuf->buffer[offset];
+	return (space < cbuf->mask + 1 - offset) ? space : cbuf->mask + 1 - offset;
+}
+
+void circular_buf_commit(cbuf_handle_t cbuf, size_t len)
+{
+	CBUF_STORE_RELEASE(cbuf->head, CBUF_LOAD_OWN(cbuf->head) + len);
+}
+
+int circular_buf_get(cbuf_handle_t cbuf, uint8_t * data)
+{
+	size_t tail = CBUF_LOAD_OWN(cbuf->tail);
+
+	if(CBUF_LOAD_ACQUIRE(cbuf->head) == tail)
+	{
+		return -1;
+	}
+
+	*data = cbuf->buffer[tail & cbuf->mask];
+	CBUF_STORE_RELEASE(cbuf->tail, tail + 1);
+	return 0;
+}
+
+size_t circular_buf_get_n(cbuf_handle_t cbuf, uint8_t *data, size_t len)
+{
+	size_t tail = CBUF_LOAD_OWN(cbuf->tail);
+	size_t used = CBUF_LOAD_ACQUIRE(cbuf->head) - tail;
+	size_t offset = tail & cbuf->mask;
+	size_t first;
+
+	if(len > used)
+	{
+		len = used;
+	}
+
+	first = cbuf->mask + 1 - offset;
+	if(first > len)
+	{
+		first = len;
+	}
+	memcpy(data, &cbuf->buffer[offset], first);
+	memcpy(&data[first], cbuf->buffer, len - first);
+
+	CBUF_STORE_RELEASE(cbuf->tail, tail + len);
+	return len;
+}
+
+size_t circular_buf_peek(cbuf_handle_t cbuf, const uint8_t **span)
+{
+	size_t tail = CBUF_LOAD_OWN(cbuf->tail);
+	size_t used = CBUF_LOAD_ACQUIRE(cbuf->head) - tail;
+	size_t offset = tail & cbuf->mask;
+
+	*span = &cbuf->buffer[offset];
+	return (used < cbuf->mask + 1 - offset) ? used : cbuf->mask + 1 - offset;
+}
+
+void circular_buf_consume(cbuf_handle_t cbuf, size_t len)
+{
+	CBUF_STORE_RELEASE(cbuf->tail, CBUF_LOAD_OWN(cbuf->tail) + len);
+}
+
+bool circular_buf_empty(cbuf_handle_t cbuf)
+{
+	return CBUF_LOAD_ACQUIRE(cbuf->head) == CBUF_LOAD_ACQUIRE(cbuf->tail);
+}
+
+bool circular_buf_full(cbuf_handle_t cbuf)
+{
+	return circular_buf_size(cbuf) > cbuf->mask;
+}
+
+size_t circular_buf_capacity(cbuf_handle_t cbuf)
+{
+	return cbuf->mask + 1;
+}
+
+size_t circular_buf_size(cbuf_handle_t cbuf)
+{
+	size_t tail = CBUF_LOAD_ACQUIRE(cbuf->tail);
+
+	return CBUF_LOAD_ACQUIRE(cbuf->head) - tail;
+}
@@ -1,78 +1,96 @@
 /**************************************************************************//**
-* @file        circular_buffer library
+* @file        circular_buffer.h
 * @ingroup 	   Serial Console
-* @brief       This library for a circular buffer is taken from https://github.com/embeddedartistry/embedded-resources/blob/master/examples/c/circular_buffer/circular_buffer.c
-*				Author: Phillips Johnston
-* @details     Please refer to the github code above and to "https://embeddedartistry.com/blog/2017/4/6/circular-buffers-in-cc" for more information
+* @brief       Single producer, single consumer byte ring used by the serial console
+* @details     One context (a task, or an ISR) puts bytes and one context gets them, without locks.
+*				Each side writes only its own index: the producer the head, the consumer the tail. Both indexes
+*				run freely and are masked on access, so the capacity must be a power of two and the whole
+*				storage buffer is usable. An index is published with release ordering after the data it covers
+*				has been copied, and the other side's index is read with acquire ordering, so the ring is safe
+*				between a task and an ISR and between two threads on a host.
 *
+*				Besides the byte calls, the ring moves blocks (circular_buf_put_n, circular_buf_get_n) and
+*				exposes its contiguous spans so a driver can work in place: circular_buf_peek / circular_buf_consume
+*				on the consumer side, circular_buf_reserve / circular_buf_commit on the producer side.
 *
+*				The ring never overwrites unread data: puts on a full ring are rejected. Several producers (or
+*				several consumers) must serialize among themselves.
+*
+*				The handle is a plain structure, allocated by the caller (statically).
 *
 * @copyright
-* @author		Phillips Johnston
-* @date        Aug 6, 2018
-* @version		0.1
+* @author
+* @date        2026-10-17
+* @version		0.2
 *****************************************************************************/
 
 
 #ifndef CIRCULAR_BUFFER_H_
 #define CIRCULAR_BUFFER_H_
 
-/// Opaque circular buffer structure
-typedef struct circular_buf_t circular_buf_t;
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/// Ring state. Fields are private to circular_buffer.c
+typedef struct circular_buf_t {
+	uint8_t *buffer;	///< Storage, capacity bytes
+	size_t mask;		///< Capacity - 1. The capacity is a power of two
+	size_t head;		///< Free running write index. Written by the producer only
+	size_t tail;		///< Free running read index. Written by the consumer only
+} circular_buf_t;
 
 /// Handle type, the way users interact with the API
 typedef circular_buf_t* cbuf_handle_t;
 
-/// Pass in a storage buffer and size, returns a circular buffer handle
-/// Requires: buffer is not NULL, size > 0
-/// Ensures: cbuf has been created and is returned in an empty state
-cbuf_handle_t circular_buf_init(uint8_t* buffer, size_t size);
-
-/// Free a circular buffer structure
-/// Requires: cbuf is valid and created by circular_buf_init
-/// Does not free data buffer; owner is responsible for that
-void circular_buf_free(cbuf_handle_t cbuf);
+/// Sets up cbuf over a storage buffer, in an empty state
+/// Requires: buffer is not NULL, size > 0. If size is not a power of two, only the largest power of two below it is used
+void circular_buf_init(cbuf_handle_t cbuf, uint8_t* buffer, size_t size);
 
 /// Reset the circular buffer to empty, head == tail. Data not cleared
-/// Requires: cbuf is valid and created by circular_buf_init
+/// Requires: neither side is using the buffer
 void circular_buf_reset(cbuf_handle_t cbuf);
 
-/// Put version 1 continues to add data if the buffer is full
-/// Old data is overwritten
-/// Requires: cbuf is valid and created by circular_buf_init
-void circular_buf_put(cbuf_handle_t cbuf, uint8_t data);
+/// Producer: adds one byte
+/// Returns 0 on success, -1 if the buffer is full
+int circular_buf_put(cbuf_handle_t cbuf, uint8_t data);
+
+/// Producer: adds up to len bytes
+/// Returns the number of bytes added, less than len if the buffer filled up
+size_t circular_buf_put_n(cbuf_handle_t cbuf, const uint8_t *data, size_t len);
+
+/// Producer: returns the contiguous free span starting at the head in *span, and its length
+/// The bytes written there become readable on circular_buf_commit
+size_t circular_buf_reserve(cbuf_handle_t cbuf, uint8_t **span);
 
-/// Put Version 2 rejects new data if the buffer is full
-/// Requires: cbuf is valid and created by circular_buf_init
-/// Returns 0 on success, -1 if buffer is full
-int circular_buf_put2(cbuf_handle_t cbuf, uint8_t data);
+/// Producer: publishes len bytes written into the span given by circular_buf_reserve
+void circular_buf_commit(cbuf_handle_t cbuf, size_t len);
 
-/// Retrieve a value from the buffer
-/// Requires: cbuf is valid and created by circular_buf_init
+/// Consumer: retrieves one byte
 /// Returns 0 on success, -1 if the buffer is empty
 int circular_buf_get(cbuf_handle_t cbuf, uint8_t * data);
 
-/// CHecks if the buffer is empty
-/// Requires: cbuf is valid and created by circular_buf_init
+/// Consumer: retrieves up to len bytes
+/// Returns the number of bytes retrieved
+size_t circular_buf_get_n(cbuf_handle_t cbuf, uint8_t *data, size_t len);
+
+/// Consumer: returns the contiguous readable span starting at the tail in *span, and its length
+/// The bytes stay in the buffer until circular_buf_consume
+size_t circular_buf_peek(cbuf_handle_t cbuf, const uint8_t **span);
+
+/// Consumer: releases len bytes read through circular_buf_peek
+void circular_buf_consume(cbuf_handle_t cbuf, size_t len);
+
 /// Returns true if the buffer is empty
 bool circular_buf_empty(cbuf_handle_t cbuf);
 
-/// Checks if the buffer is full
-/// Requires: cbuf is valid and created by circular_buf_init
 /// Returns true if the buffer is full
 bool circular_buf_full(cbuf_handle_t cbuf);
 
-/// Check the capacity of the buffer
-/// Requires: cbuf is valid and created by circular_buf_init
 /// Returns the maximum capacity of the buffer
 size_t circular_buf_capacity(cbuf_handle_t cbuf);
 
-/// Check the number of elements stored in the buffer
-/// Requires: cbuf is valid and created by circular_buf_init
-/// Returns the current number of elements in the buffer
+/// Returns the current number of bytes stored in the buffer
 size_t circular_buf_size(cbuf_handle_t cbuf);
 
-//TODO: int circular_buf_get_range(circular_buf_t cbuf, uint8_t *data, size_t len);
-//TODO: int circular_buf_put_range(circular_buf_t cbuf, uint8_t * data, size_t len);
-
-#endif //CIRCULAR_BUFFER_H_
\ No newline at end of file
+#endif //CIRCULAR_BUFFER_H_
@@ -21,7 +21,7 @@
 /******************************************************************************
 * Variables
 ******************************************************************************/
-static uint32_t ul_tickcount=0 ;	///< Global state variable for tick count
+static volatile uint32_t ul_tickcount=0 ;	///< Global state variable for tick count
 
 /******************************************************************************
 * Forward Declarations
@@ -47,7 +47,7 @@ void InitSystick(void)
 
 	// Configure SysTick to trigger every millisecond using the CPU Clock
 	SysTick->CTRL = 0;					// Disable SysTick
-	SysTick->LOAD = 999UL;				// Set reload register for 1mS interrupts
+	SysTick->LOAD = (system_cpu_clock_get_hz() / 1000UL) - 1UL;	// Set reload register for 1mS interrupts
 	NVIC_SetPriority(SysTick_IRQn, 3);	// Set interrupt priority to least urgency
 	SysTick->VAL = 0;					// Reset the SysTick counter value
 	SysTick->CTRL = 0x00000007;			// Enable SysTick, Enable SysTick Exceptions, Use CPU Clock
@@ -56,6 +56,19 @@ void InitSystick(void)
 }
 
 
+/**************************************************************************//**
+* @fn		void DeinitSystick(void)
+* @brief	Stops the Systick timer and clears any pending Systick exception.
+
+* @note		Must be called before jumping to the main application, which installs its own Systick handler.
+*****************************************************************************/
+void DeinitSystick(void)
+{
+	SysTick->CTRL = 0;						// Disable SysTick and its exception
+	SCB->ICSR = SCB_ICSR_PENDSTCLR_Msk;		// Clear a SysTick exception that may be pending
+}
+
+
 /**************************************************************************//**
 * @fn		uint32_t GetSystick(void)
 * @brief	Initializes the Systick timer. Useful to measure lengths of time.
@@ -69,6 +82,30 @@ uint32_t GetSystick(void)
 }
 
 
+/**************************************************************************//**
+* @fn		uint32_t GetSystickUs(void)
+* @brief	Returns the time since InitSystick() in microseconds, using the current SysTick count
+* @details	The tick count is read again after the counter value, so a tick that fires in between is
+*			not missed. Wraps around after about 71 minutes: only use it to measure short intervals.
+* @return	Time since InitSystick(), in us
+*****************************************************************************/
+uint32_t GetSystickUs(void)
+{
+	uint32_t ticks;
+	uint32_t value;
+	uint32_t reload;
+
+	do
+	{
+		ticks = ul_tickcount;
+		value = SysTick->VAL;
+		reload = SysTick->LOAD;
+	} while (ticks != ul_tickcount);
+
+	return (ticks * 1000UL) + (((reload - value) * 1000UL) / (reload + 1UL));
+}
+
+
 /******************************************************************************
 * Callback Functions
 ******************************************************************************/
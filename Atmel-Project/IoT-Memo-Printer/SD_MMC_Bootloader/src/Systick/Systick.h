@@ -29,7 +29,9 @@ extern "C" {
 * Global Function Declaration
 ******************************************************************************/
 void InitSystick(void);
+void DeinitSystick(void);
 uint32_t GetSystick(void);
+uint32_t GetSystickUs(void);
 
 #ifdef __cplusplus
 }
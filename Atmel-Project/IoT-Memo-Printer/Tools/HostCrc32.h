@@ -0,0 +1,54 @@
+/**************************************************************************//**
+* @file      HostCrc32.h
+* @brief     CRC32 used by the host tools
+* @details   IEEE 802.3 / zlib CRC32 (reflected polynomial 0xEDB88320). Matches the bootloader's DSU CRC32
+*			 seeded with 0xFFFFFFFF and complemented. Start with crc = 0 and chain calls by passing the
+*			 previous result.
+* @author
+* @date      2026-10-17
+
+******************************************************************************/
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+* Includes
+******************************************************************************/
+#include <stdint.h>
+#include <stddef.h>
+
+/******************************************************************************
+* Inline Functions
+******************************************************************************/
+/// Continues a CRC32 over length bytes of data
+static inline uint32_t HostCrc32_Update(uint32_t crc, const uint8_t *data, size_t length)
+{
+	crc = ~crc;
+	while (length-- > 0)
+	{
+		crc ^= *data++;
+		for (int bit = 0; bit < 8; bit++)
+		{
+			crc = (crc >> 1) ^ (0xEDB88320UL & (0U - (crc & 1U)));
+		}
+	}
+	return ~crc;
+}
+
+/// Continues a CRC32 over count bytes of 0xFF (erased flash padding)
+static inline uint32_t HostCrc32_Pad(uint32_t crc, size_t count)
+{
+	const uint8_t erased = 0xFF;
+	while (count-- > 0)
+	{
+		crc = HostCrc32_Update(crc, &erased, 1);
+	}
+	return crc;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,256 @@
+/**************************************************************************//**
+* @file      LzEncoder.c
+* @brief     Host side compressor for the LZ firmware image container
+* @details   Greedy LZSS with hash chains over 3 byte prefixes and one step of lazy matching.
+*			 Firmware images are a few hundred KB at most, so the whole input is kept in memory.
+* @author
+* @date      2026-10-17
+
+******************************************************************************/
+
+
+/******************************************************************************
+* Includes
+******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include "LzEncoder.h"
+
+/******************************************************************************
+* Defines
+******************************************************************************/
+#define HASH_BITS		13
+#define HASH_SIZE		(1U << HASH_BITS)
+#define NO_POSITION		(-1)
+
+/******************************************************************************
+* Structures and Enumerations
+******************************************************************************/
+/// Match finder state
+struct Matcher {
+	const uint8_t *input;
+	size_t inputLen;
+	int32_t head[HASH_SIZE];	///< Last position seen for each hash
+	int32_t *prev;				///< Previous position with the same hash, per input position
+	unsigned maxChain;
+};
+
+/// Output writer. Tracks the pending flag byte
+struct Writer {
+	uint8_t *output;
+	size_t outputLen;
+	size_t pos;
+	size_t flagPos;
+	unsigned flagCount;
+	int overflow;
+};
+
+/******************************************************************************
+* Static Functions
+******************************************************************************/
+static uint32_t Hash3(const uint8_t *p)
+{
+	uint32_t v = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+	return (v * 2654435761U) >> (32 - HASH_BITS);
+}
+
+static void Matcher_Insert(struct Matcher *m, size_t pos)
+{
+	if (pos + LZ_MIN_MATCH <= m->inputLen)
+	{
+		uint32_t h = Hash3(&m->input[pos]);
+		m->prev[pos] = m->head[h];
+		m->head[h] = (int32_t)pos;
+	}
+}
+
+/// Finds the longest match for pos. Returns its length (0 if none) and sets *distance
+static size_t Matcher_Find(const struct Matcher *m, size_t pos, size_t *distance)
+{
+	size_t best = 0;
+	size_t maxLen = m->inputLen - pos;
+	unsigned chain = m->maxChain;
+
+	if (maxLen > LZ_MAX_MATCH)
+	{
+		maxLen = LZ_MAX_MATCH;
+	}
+	if (maxLen < LZ_MIN_MATCH)
+	{
+		return 0;
+	}
+
+	int32_t candidate = m->head[Hash3(&m->input[pos])];
+	while (candidate != NO_POSITION && chain-- > 0)
+	{
+		size_t dist = pos - (size_t)candidate;
+		if (dist > LZ_WINDOW_SIZE)
+		{
+			break;
+		}
+
+		const uint8_t *a = &m->input[candidate];
+		const uint8_t *b = &m->input[pos];
+		if (a[best] == b[best])
+		{
+			size_t len = 0;
+			while (len < maxLen && a[len] == b[len])
+			{
+				len++;
+			}
+			if (len > best)
+			{
+				best = len;
+				*distance = dist;
+				if (len == maxLen)
+				{
+					break;
+				}
+			}
+		}
+		candidate = m->prev[candidate];
+	}
+
+	return (best >= LZ_MIN_MATCH) ? best : 0;
+}
+
+static void Writer_Byte(struct Writer *w, uint8_t value)
+{
+	if (w->pos < w->outputLen)
+	{
+		w->output[w->pos] = value;
+	}
+	else
+	{
+		w->overflow = 1;
+	}
+	w->pos++;
+}
+
+/// Reserves a new flag byte every 8 tokens and sets the bit of the token being written
+static void Writer_Token(struct Writer *w, int isLiteral)
+{
+	if (w->flagCount == 0)
+	{
+		w->flagPos = w->pos;
+		Writer_Byte(w, 0);
+		w->flagCount = 8;
+	}
+	if (isLiteral && w->flagPos < w->outputLen)
+	{
+		w->output[w->flagPos] |= (uint8_t)(1U << (8 - w->flagCount));
+	}
+	w->flagCount--;
+}
+
+static void Writer_Literal(struct Writer *w, uint8_t value)
+{
+	Writer_Token(w, 1);
+	Writer_Byte(w, value);
+}
+
+static void Writer_Match(struct Writer *w, size_t length, size_t distance)
+{
+	size_t lengthField = length - LZ_MIN_MATCH;
+	size_t extra = 0;
+
+	if (lengthField >= LZ_LENGTH_EXTENDED)
+	{
+		extra = lengthField - LZ_LENGTH_EXTENDED;
+		lengthField = LZ_LENGTH_EXTENDED;
+	}
+
+	uint16_t code = (uint16_t)((distance - 1) | (lengthField << LZ_WINDOW_BITS));
+	Writer_Token(w, 0);
+	Writer_Byte(w, (uint8_t)code);
+	Writer_Byte(w, (uint8_t)(code >> 8));
+	if (lengthField == LZ_LENGTH_EXTENDED)
+	{
+		Writer_Byte(w, (uint8_t)extra);
+	}
+}
+
+/******************************************************************************
+* Global Functions
+******************************************************************************/
+
+/**************************************************************************//**
+* @fn		size_t LzEncoder_Compress(const uint8_t *input, size_t inputLen, uint8_t *output, size_t outputLen, unsigned maxChain)
+* @brief	Compresses input into an LZ payload (without the container header)
+* @param[in]	input		Data to compress
+* @param[in]	inputLen	Size of input
+* @param[out]	output		Destination of the payload. LZ_ENCODER_BOUND(inputLen) bytes is always enough
+* @param[in]	outputLen	Size of output
+* @param[in]	maxChain	Positions tried per match search. Higher is slower and compresses better
+* @return	Size of the payload, or 0 if output is too small or memory could not be allocated
+*****************************************************************************/
+size_t LzEncoder_Compress(const uint8_t *input, size_t inputLen, uint8_t *output, size_t outputLen, unsigned maxChain)
+{
+	struct Matcher m;
+	struct Writer w = { output, outputLen, 0, 0, 0, 0 };
+	size_t pos = 0;
+
+	m.input = input;
+	m.inputLen = inputLen;
+	m.maxChain = (maxChain == 0) ? 1 : maxChain;
+	m.prev = malloc((inputLen + 1) * sizeof(int32_t));
+	if (m.prev == NULL)
+	{
+		return 0;
+	}
+	for (size_t i = 0; i < HASH_SIZE; i++)
+	{
+		m.head[i] = NO_POSITION;
+	}
+
+	while (pos < inputLen)
+	{
+		size_t distance = 0;
+		size_t length = Matcher_Find(&m, pos, &distance);
+
+		//Lazy step: emit a literal if the match starting at the next byte is longer
+		if (length > 0 && length < LZ_MAX_MATCH && pos + 1 < inputLen)
+		{
+			size_t nextDistance = 0;
+			Matcher_Insert(&m, pos);
+			size_t nextLength = Matcher_Find(&m, pos + 1, &nextDistance);
+			if (nextLength > length + 1)
+			{
+				Writer_Literal(&w, input[pos]);
+				pos++;
+				length = nextLength;
+				distance = nextDistance;
+			}
+			else
+			{
+				//pos is already in the hash chains
+				Writer_Match(&w, length, distance);
+				for (size_t i = 1; i < length; i++)
+				{
+					Matcher_Insert(&m, pos + i);
+				}
+				pos += length;
+				continue;
+			}
+		}
+
+		if (length == 0)
+		{
+			Writer_Literal(&w, input[pos]);
+			Matcher_Insert(&m, pos);
+			pos++;
+		}
+		else
+		{
+			Writer_Match(&w, length, distance);
+			for (size_t i = 0; i < length; i++)
+			{
+				Matcher_Insert(&m, pos + i);
+			}
+			pos += length;
+		}
+	}
+
+	free(m.prev);
+	return w.overflow ? 0 : w.pos;
+}
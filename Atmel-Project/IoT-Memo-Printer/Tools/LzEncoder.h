@@ -0,0 +1,37 @@
+/**************************************************************************//**
+* @file      LzEncoder.h
+* @brief     Host side compressor for the LZ firmware image container
+* @details   Produces the payload described in SD_MMC_Bootloader/src/Lz/LzFormat.h. Used by lzpack and lzbench.
+* @author
+* @date      2026-10-17
+
+******************************************************************************/
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+* Includes
+******************************************************************************/
+#include <stdint.h>
+#include <stddef.h>
+#include "../SD_MMC_Bootloader/src/Lz/LzFormat.h"
+
+/******************************************************************************
+* Defines
+******************************************************************************/
+#define LZ_ENCODER_MAX_CHAIN	256		///< Default number of earlier positions tried per match search
+
+/// Worst case payload size for an input of n bytes (all literals: one flag byte per 8 literals)
+#define LZ_ENCODER_BOUND(n)		((n) + ((n) + 7) / 8)
+
+/******************************************************************************
+* Global Function Declaration
+******************************************************************************/
+size_t LzEncoder_Compress(const uint8_t *input, size_t inputLen, uint8_t *output, size_t outputLen, unsigned maxChain);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,763 @@
+/**************************************************************************//**
+* @file      benchhost.c
+* @brief     Runs the benchmark kernels of the main firmware ("bench" CLI command) on Linux
+* @details   Builds the runner (Bench/Bench.c) and the portable kernels (Bench/BenchKernels.c and
+*			 Bench/BenchProtocolKernels.c) of the firmware unchanged, with the modules they time: the console
+*			 ring, the ASF software CRC32, FatFs, the stream writer, the HTTP client, pahomqtt MQTTPacket, and
+*			 the heap and memory pools (Memory/).
+*			 The platform is replaced by:
+*				timer		CLOCK_MONOTONIC in ns. The samples are 32 bit differences, so one call of a
+*							kernel must stay under 4 s
+*				sd			FatFs over a 256 kB RAM disk, formatted at start up
+*				network		host/HostStubs.c: sockets that never open, a software timer that never fires
+*				FreeRTOS	host/FreeRTOS.h and host/task.h: one thread, so no locking. The heap is 16 kB
+*				i2c.imu		stub: copies the register value, so it only times the call
+*				spi.winc	stub: copies the transfer one byte at a time, as the polled SPI loop does
+*				crc32.dsu	stub: bitwise CRC32 with the seed and result of the DSU
+*
+*			 The table has the layout of "bench" on target, so the two can be compared. Stub rows say
+*			 nothing about the hardware; they are there so every name the firmware lists also runs here.
+*
+*			 -t checks the modules against reference values: ring contents, CRC check values, file contents,
+*			 stream writer byte order, HTTP responses split at several receive sizes, MQTT packets, heap
+*			 merging and pool bookkeeping, and that a bad free is caught.
+*
+*			 -w times every kernel and writes its fastest sample (ns per operation) to a baseline file. -c
+*			 times the kernels of a baseline file again and fails if one got slower by more than -r percent
+*			 (30 by default). The fastest sample is the least noisy one, but timings only compare on the same
+*			 machine: rewrite benchhost.baseline with "make baseline" where the checks run. The make targets
+*			 run benchhost without address space randomization, which otherwise moves the small kernels by
+*			 up to 60% from one run to the next.
+*
+*			 Usage:
+*				benchhost [-n samples] [kernel|all]				times the kernels, all by default
+*				benchhost [-n samples] -c benchhost.baseline	checks for regressions (make bench)
+*				benchhost [-n samples] -w benchhost.baseline	rewrites the baseline (make baseline)
+*				benchhost -l									lists the kernels
+*				benchhost -t									checks the modules (make check)
+*
+*			 Build (from this folder):
+*				make benchhost
+* @author
+* @date      2026-10-17
+
+******************************************************************************/
+
+
+/******************************************************************************
+* Includes
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <crc32.h>
+#include "Bench/Bench.h"
+#include "FreeRTOS.h"
+#include "Memory/Heap.h"
+#include "Memory/MemoryPool.h"
+#include "MQTTPacket/MQTTPacket.h"
+#include "iot/stream_writer.h"
+#include "ff.h"
+#include "diskio.h"
+#include "HostCrc32.h"
+
+/******************************************************************************
+* Defines
+******************************************************************************/
+#define RAM_DISK_SECTORS	512		///< 256 kB, room for BENCH_FILE_NAME
+#define SECTOR_SIZE			512
+#define STUB_SPI_BLOCK		512		///< Same transfer as spi.winc on target
+#define IMU_WHO_AM_I_VALUE	0x6C	///< LSM6DSO_ID
+#define DEFAULT_TOLERANCE	30		///< Percent a kernel may be slower than its baseline
+
+/******************************************************************************
+* Static Variables
+******************************************************************************/
+static uint8_t RamDisk[RAM_DISK_SECTORS * SECTOR_SIZE];
+static FATFS FileSystem;
+static volatile uint32_t StubSink;	///< Results of the stub kernels, kept so they are not optimized away
+static volatile uint8_t StubRegister = IMU_WHO_AM_I_VALUE;
+
+/******************************************************************************
+* Stub Kernels
+******************************************************************************/
+static int32_t StubI2cRun(void)
+{
+	StubSink = StubRegister;
+	return 0;
+}
+
+static int32_t StubSpiRun(void)
+{
+	volatile uint8_t *rx = &benchBuffer[STUB_SPI_BLOCK];
+
+	for (int i = 0; i < STUB_SPI_BLOCK; i++)
+	{
+		rx[i] = benchBuffer[i];
+	}
+	return 0;
+}
+
+static int32_t StubDsuRun(void)
+{
+	StubSink = ~HostCrc32_Update(0, benchBuffer, BENCH_BUFFER_SIZE);	// DSU: seed 0xFFFFFFFF, not complemented
+	return 0;
+}
+
+static const struct BenchKernel StubI2cKernel = {"i2c.imu", "stub: reads a variable", 1, 1, NULL, StubI2cRun, NULL};
+static const struct BenchKernel StubSpiKernel = {"spi.winc", "stub: byte loop copy of 512 bytes", 1, STUB_SPI_BLOCK, NULL, StubSpiRun, NULL};
+static const struct BenchKernel StubDsuKernel = {"crc32.dsu", "stub: bitwise CRC32 over 1 kB", 1, BENCH_BUFFER_SIZE, NULL, StubDsuRun, NULL};
+
+/******************************************************************************
+* RAM Disk
+******************************************************************************/
+DSTATUS disk_initialize(BYTE drive)
+{
+	return (drive == 0) ? 0 : STA_NOINIT;
+}
+
+DSTATUS disk_status(BYTE drive)
+{
+	return (drive == 0) ? 0 : STA_NOINIT;
+}
+
+DRESULT disk_read(BYTE drive, BYTE *buffer, DWORD sector, BYTE count)
+{
+	if (drive != 0 || sector + count > RAM_DISK_SECTORS)
+	{
+		return RES_PARERR;
+	}
+	memcpy(buffer, &RamDisk[sector * SECTOR_SIZE], count * SECTOR_SIZE);
+	return RES_OK;
+}
+
+DRESULT disk_write(BYTE drive, const BYTE *buffer, DWORD sector, BYTE count)
+{
+	if (drive != 0 || sector + count > RAM_DISK_SECTORS)
+	{
+		return RES_PARERR;
+	}
+	memcpy(&RamDisk[sector * SECTOR_SIZE], buffer, count * SECTOR_SIZE);
+	return RES_OK;
+}
+
+DRESULT disk_ioctl(BYTE drive, BYTE command, void *buffer)
+{
+	switch (command)
+	{
+	case GET_SECTOR_COUNT:
+		*(DWORD *)buffer = RAM_DISK_SECTORS;
+		break;
+	case GET_SECTOR_SIZE:
+		*(WORD *)buffer = SECTOR_SIZE;
+		break;
+	case GET_BLOCK_SIZE:
+		*(DWORD *)buffer = 1;
+		break;
+	default:
+		break;
+	}
+	return RES_OK;
+}
+
+DWORD get_fattime(void)
+{
+	return ((DWORD)(2026 - 1980) << 25) | (10UL << 21) | (17UL << 16);
+}
+
+/******************************************************************************
+* Platform Functions
+******************************************************************************/
+uint32_t BenchTimerGet(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+
+uint32_t BenchTimerHz(void)
+{
+	return 1000000000UL;
+}
+
+void BenchRegisterPlatformKernels(void)
+{
+	BenchRegister(&StubI2cKernel);
+	BenchRegister(&StubSpiKernel);
+	BenchRegister(&StubDsuKernel);
+}
+
+/******************************************************************************
+* Static Functions
+******************************************************************************/
+/// Same rows as CLI_Bench
+static void RunKernels(const struct BenchKernel *only, uint32_t samples)
+{
+	const struct BenchKernel *kernel;
+
+	printf("%lu counts/s, %lu samples. ns per operation:\n", (unsigned long)BenchTimerHz(), (unsigned long)samples);
+	printf("%-10s %9s %9s %9s %7s\n", "Kernel", "min", "median", "max", "kB/s");
+	for (uint32_t i = 0; (kernel = BenchGetKernel(i)) != NULL; i++)
+	{
+		struct BenchResult result;
+
+		if (only != NULL && kernel != only)
+		{
+			continue;
+		}
+		BenchRun(kernel, samples, &result);
+		if (result.samples == 0)
+		{
+			printf("%-10s error %ld\n", kernel->name, (long)result.error);
+			continue;
+		}
+		printf("%-10s %9lu %9lu %9lu %7lu", kernel->name, (unsigned long)BenchCountsToNs(result.min, kernel->operations),
+			   (unsigned long)BenchCountsToNs(result.median, kernel->operations),
+			   (unsigned long)BenchCountsToNs(result.max, kernel->operations),
+			   (unsigned long)BenchThroughputKBps(result.median, kernel->bytes));
+		if (result.error < 0)
+		{
+			printf("  error %ld after %lu samples", (long)result.error, (unsigned long)result.samples);
+		}
+		printf("\n");
+	}
+}
+
+/// Every kernel runs without error and its samples are ordered
+static int TestKernels(void)
+{
+	const struct BenchKernel *kernel;
+	struct BenchResult result;
+	int failed = 0;
+
+	for (uint32_t i = 0; (kernel = BenchGetKernel(i)) != NULL; i++)
+	{
+		BenchRun(kernel, 5, &result);
+		if (result.error != 0 || result.samples != 5 || result.min > result.median || result.median > result.max)
+		{
+			printf("FAIL %s: error %ld, %lu samples\n", kernel->name, (long)result.error, (unsigned long)result.samples);
+			failed = 1;
+		}
+	}
+	return failed;
+}
+
+/// The ring kernels move the data half of the buffer to the output half unchanged
+static int TestRing(void)
+{
+	static const char *const rings[] = {"ring.byte", "ring.bulk"};
+	struct BenchResult result;
+	int failed = 0;
+
+	for (int i = 0; i < BENCH_BUFFER_SIZE; i++)
+	{
+		benchBuffer[i] = (uint8_t)(i * 13 + 5);
+	}
+	for (int r = 0; r < 2; r++)
+	{
+		memset(&benchBuffer[768], 0, 256);
+		BenchRun(BenchFindKernel(rings[r], strlen(rings[r])), 3, &result);
+		if (memcmp(&benchBuffer[512], &benchBuffer[768], 256) != 0)
+		{
+			printf("FAIL %s does not move its data unchanged\n", rings[r]);
+			failed = 1;
+		}
+	}
+	return failed;
+}
+
+/// ASF crc32 against the check value and against HostCrc32, at every alignment
+static int TestCrc32(void)
+{
+	static const char check[12] __attribute__((aligned(4))) = "123456789";	// crc32.c reads whole aligned words
+	crc32_t crc;
+	int failed = 0;
+
+	crc32_calculate(check, 9, &crc);
+	if (crc != 0xCBF43926)
+	{
+		printf("FAIL ASF crc32 of \"123456789\" is %08lX, expected CBF43926\n", (unsigned long)crc);
+		failed = 1;
+	}
+	for (int offset = 0; offset < 4; offset++)
+	{
+		crc32_calculate(&benchBuffer[offset], 100 + offset, &crc);
+		if (crc != HostCrc32_Update(0, &benchBuffer[offset], 100 + offset))
+		{
+			printf("FAIL ASF crc32 differs from HostCrc32 at offset %d\n", offset);
+			failed = 1;
+		}
+	}
+	return failed;
+}
+
+/// The sd kernels read the file they wrote
+static int TestFatFs(void)
+{
+	struct BenchResult result;
+
+	BenchRun(BenchFindKernel("sd.seq", 6), 1, &result);
+	for (int i = 0; i < 512; i++)
+	{
+		if (result.error != 0 || benchBuffer[i] != (uint8_t)(i * 7))
+		{
+			printf("FAIL sd.seq read %02X at %d, expected %02X\n", benchBuffer[i], i, (uint8_t)(i * 7));
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static uint8_t WriterOutput[32];
+static size_t WriterLength;
+static size_t WriterLongestFlush;
+
+static int WriterCapture(void *module, char *buffer, size_t length)
+{
+	if (WriterLength + length <= sizeof(WriterOutput))
+	{
+		memcpy(&WriterOutput[WriterLength], buffer, length);
+	}
+	WriterLength += length;
+	WriterLongestFlush = (length > WriterLongestFlush) ? length : WriterLongestFlush;
+	return 0;
+}
+
+/// Byte order of each stream_writer call, through a buffer smaller than the output
+static int TestStreamWriter(void)
+{
+	static const uint8_t expected[] = {0x11, 0x22, 0x33, 0x55, 0x44, 0x66, 0x77, 0x88, 0x99, 0x0D, 0x0C, 0x0B, 0x0A, 'x', 'y', 'z'};
+	struct stream_writer writer;
+	char buffer[4];
+
+	WriterLength = 0;
+	WriterLongestFlush = 0;
+	stream_writer_init(&writer, buffer, sizeof(buffer), WriterCapture, NULL);
+	stream_writer_send_8(&writer, 0x11);
+	stream_writer_send_16BE(&writer, 0x2233);
+	stream_writer_send_16LE(&writer, 0x4455);
+	stream_writer_send_32BE(&writer, 0x66778899);
+	stream_writer_send_32LE(&writer, 0x0A0B0C0D);
+	stream_writer_send_buffer(&writer, "xyz", 3);
+	stream_writer_send_remain(&writer);
+	if (WriterLength != sizeof(expected) || memcmp(WriterOutput, expected, sizeof(expected)) != 0 || WriterLongestFlush > sizeof(buffer))
+	{
+		printf("FAIL stream_writer output differs\n");
+		return 1;
+	}
+	return 0;
+}
+
+/// Responses split at several receive sizes: small and large bodies, keep alive or not, error status
+static int TestHttp(void)
+{
+	static const size_t packets[] = {1, 13, 256, 512};
+	static char response[128 + 2000];
+	struct BenchHttpTotals totals;
+	uint32_t sum = 0;
+	int header;
+	int failed = 0;
+
+	header = snprintf(response, sizeof(response), "HTTP/1.1 200 OK\r\nContent-Length: 2000\r\nConnection: keep-alive\r\n\r\n");
+	for (int i = 0; i < 2000; i++)
+	{
+		response[header + i] = (char)(i * 31 + 7);
+		sum += (uint8_t)response[header + i];
+	}
+	for (size_t p = 0; p < sizeof(packets) / sizeof(packets[0]); p++)
+	{
+		if (BenchHttpParse(response, header + 2000, packets[p], &totals) != 0 || totals.responseCode != 200 || totals.bodyBytes != 2000 ||
+			totals.bodySum != sum || !totals.complete || totals.disconnected)
+		{
+			printf("FAIL http 2000 byte body in %zu byte packets: code %ld, %lu bytes\n", packets[p], (long)totals.responseCode,
+				   (unsigned long)totals.bodyBytes);
+			failed = 1;
+		}
+
+		static const char small[] = "HTTP/1.1 404 Not Found\r\nContent-Length: 5\r\n\r\nhello";
+		if (BenchHttpParse(small, sizeof(small) - 1, packets[p], &totals) != 0 || totals.responseCode != 404 || totals.bodyBytes != 5 ||
+			totals.chunks != 0 || !totals.complete)
+		{
+			printf("FAIL http 5 byte body in %zu byte packets: code %ld, %lu bytes\n", packets[p], (long)totals.responseCode,
+				   (unsigned long)totals.bodyBytes);
+			failed = 1;
+		}
+
+		static const char closing[] = "HTTP/1.0 200 OK\r\nContent-Length: 3\r\n\r\nabc";
+		if (BenchHttpParse(closing, sizeof(closing) - 1, packets[p], &totals) != 0 || totals.responseCode != 200 || totals.bodyBytes != 3 ||
+			!totals.disconnected)
+		{
+			printf("FAIL http/1.0 response in %zu byte packets is not followed by a disconnect\n", packets[p]);
+			failed = 1;
+		}
+	}
+	return failed;
+}
+
+/// PUBLISH round trip and the remaining length encoding at its boundaries
+static int TestMqtt(void)
+{
+	static const int lengths[] = {0, 127, 128, 16383, 16384, 2097151, 2097152};
+	static const int sizes[] = {1, 1, 2, 2, 3, 3, 4};
+	unsigned char buffer[300];
+	unsigned char payload[200];
+	MQTTString topic = MQTTString_initializer;
+	MQTTString parsedTopic;
+	unsigned char dup;
+	unsigned char retained;
+	unsigned short packetId;
+	unsigned char *parsedPayload;
+	int parsedLength;
+	int qos;
+	int length;
+	int failed = 0;
+
+	for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++)
+	{
+		int value = -1;
+
+		if (MQTTPacket_encode(buffer, lengths[i]) != sizes[i] || MQTTPacket_decodeBuf(buffer, &value) != sizes[i] || value != lengths[i])
+		{
+			printf("FAIL mqtt remaining length %d\n", lengths[i]);
+			failed = 1;
+		}
+	}
+
+	for (int i = 0; i < (int)sizeof(payload); i++)
+	{
+		payload[i] = (unsigned char)(i ^ 0x5A);
+	}
+	topic.cstring = "memo/printer";
+	length = MQTTSerialize_publish(buffer, sizeof(buffer), 0, 1, 1, 4242, topic, payload, sizeof(payload));
+	if (length != 1 + 2 + (2 + 12 + 2 + 200) || buffer[0] != 0x33 ||	// Remaining length 216 takes two bytes
+		MQTTDeserialize_publish(&dup, &qos, &retained, &packetId, &parsedTopic, &parsedPayload, &parsedLength, buffer, length) != 1 ||
+		dup != 0 || qos != 1 || retained != 1 || packetId != 4242 || parsedTopic.lenstring.len != 12 ||
+		memcmp(parsedTopic.lenstring.data, "memo/printer", 12) != 0 || parsedLength != sizeof(payload) || memcmp(parsedPayload, payload, sizeof(payload)) != 0)
+	{
+		printf("FAIL mqtt PUBLISH round trip\n");
+		failed = 1;
+	}
+	if (MQTTSerialize_publish(buffer, 100, 0, 1, 0, 1, topic, payload, sizeof(payload)) > 0)
+	{
+		printf("FAIL mqtt PUBLISH larger than the buffer was serialized\n");
+		failed = 1;
+	}
+	return failed;
+}
+
+/// Heap blocks are aligned and apart, freed blocks merge back into one, and bad frees are caught
+static int TestHeap(void)
+{
+	struct HeapStats before;
+	struct HeapStats stats;
+	uint8_t *blocks[3];
+	unsigned long asserts = HostAssertFailures;
+	int failed = 0;
+
+	HeapGetStats(&before);
+	blocks[0] = pvPortMalloc(100);
+	blocks[1] = pvPortMalloc(200);
+	blocks[2] = pvPortMalloc(300);
+	if (blocks[0] == NULL || blocks[1] == NULL || blocks[2] == NULL || ((uintptr_t)blocks[0] | (uintptr_t)blocks[1] | (uintptr_t)blocks[2]) % portBYTE_ALIGNMENT != 0 ||
+		blocks[0] + 100 > blocks[1] || blocks[1] + 200 > blocks[2])
+	{
+		printf("FAIL heap blocks misplaced\n");
+		return 1;
+	}
+	memset(blocks[0], 0xAA, 100);
+	memset(blocks[1], 0xBB, 200);
+	memset(blocks[2], 0xCC, 300);
+
+	// A hole between two blocks, then its lower neighbour, then the upper one: back to the free list of before
+	vPortFree(blocks[1]);
+	HeapGetStats(&stats);
+	if (stats.freeBlocks != before.freeBlocks + 1 || xPortGetMinimumEverFreeHeapSize() > stats.freeBytes - 200)
+	{
+		printf("FAIL heap hole: %lu free blocks\n", (unsigned long)stats.freeBlocks);
+		failed = 1;
+	}
+	vPortFree(blocks[0]);
+	vPortFree(blocks[2]);
+	HeapGetStats(&stats);
+	if (stats.freeBytes != before.freeBytes || stats.freeBlocks != before.freeBlocks || stats.largestFreeBlock != before.largestFreeBlock ||
+		stats.allocations != before.allocations + 3 || stats.frees != before.frees + 3)
+	{
+		printf("FAIL heap not merged: %lu free blocks, largest %lu\n", (unsigned long)stats.freeBlocks, (unsigned long)stats.largestFreeBlock);
+		failed = 1;
+	}
+
+	vPortFree(blocks[1]);
+	if (pvPortMalloc(configTOTAL_HEAP_SIZE) != NULL || pvPortMalloc(0) != NULL)
+	{
+		printf("FAIL heap served an impossible request\n");
+		failed = 1;
+	}
+	HeapGetStats(&stats);
+	if (HostAssertFailures == asserts || stats.frees != before.frees + 3 || stats.failures != before.failures + 2 || stats.freeBytes != before.freeBytes)
+	{
+		printf("FAIL heap double free or failure not caught\n");
+		failed = 1;
+	}
+	return failed;
+}
+
+/// A pool hands out each block once, counts what it could not serve, and takes back only its own blocks
+static int TestPool(void)
+{
+	static struct MemoryPool pool;
+	uint8_t *blocks[4];
+	uint8_t outside[32];
+	unsigned long asserts = HostAssertFailures;
+	int failed = 0;
+
+	if (!MemoryPoolCreate(&pool, "test", 20, 4) || pool.blockSize != 24)
+	{
+		printf("FAIL pool not created\n");
+		return 1;
+	}
+	for (int i = 0; i < 4; i++)
+	{
+		blocks[i] = (i & 1) ? MemoryPoolAllocFromISR(&pool) : MemoryPoolAlloc(&pool);
+		if (blocks[i] == NULL || (uintptr_t)blocks[i] % portBYTE_ALIGNMENT != 0 || (i > 0 && blocks[i] != blocks[i - 1] + pool.blockSize))
+		{
+			printf("FAIL pool block %d\n", i);
+			return 1;
+		}
+		memset(blocks[i], i, pool.blockSize);
+	}
+	if (MemoryPoolAlloc(&pool) != NULL || pool.used != 4 || pool.highWater != 4 || pool.failures != 1)
+	{
+		printf("FAIL pool served past its blocks\n");
+		failed = 1;
+	}
+
+	MemoryPoolFree(&pool, blocks[2]);
+	MemoryPoolFreeFromISR(&pool, blocks[0]);
+	MemoryPoolFree(&pool, outside);
+	MemoryPoolFree(&pool, blocks[1] + 1);
+	if (MemoryPoolAlloc(&pool) != blocks[0] || MemoryPoolAlloc(&pool) != blocks[2] || pool.used != 4 || HostAssertFailures != asserts + 2)
+	{
+		printf("FAIL pool free list\n");
+		failed = 1;
+	}
+	for (int i = 0; i < 4; i++)
+	{
+		MemoryPoolFree(&pool, blocks[i]);
+	}
+	if (pool.used != 0 || pool.highWater != 4)
+	{
+		printf("FAIL pool counters after free: %u used\n", pool.used);
+		failed = 1;
+	}
+
+	for (uint32_t i = 0; MemoryPoolGet(i) != &pool; i++)
+	{
+		if (MemoryPoolGet(i) == NULL)
+		{
+			printf("FAIL pool not listed\n");
+			return 1;
+		}
+	}
+	return failed;
+}
+
+static int SelfTest(void)
+{
+	int failed = TestKernels();
+
+	failed |= TestRing();
+	failed |= TestCrc32();
+	failed |= TestFatFs();
+	failed |= TestStreamWriter();
+	failed |= TestHttp();
+	failed |= TestMqtt();
+	failed |= TestHeap();
+	failed |= TestPool();
+	printf(failed ? "self test FAILED\n" : "self test passed\n");
+	return failed;
+}
+
+/// Fastest sample of a kernel, in ns per operation. Negative if the kernel failed
+static double FastestNs(const struct BenchKernel *kernel, uint32_t samples)
+{
+	struct BenchResult result;
+
+	BenchRun(kernel, samples, &result);
+	if (result.error < 0 || result.samples == 0)
+	{
+		return -1.0;
+	}
+	return result.min * 1e9 / BenchTimerHz() / (kernel->operations ? kernel->operations : 1);
+}
+
+/// Times every kernel and writes its fastest sample to the baseline file
+static int WriteBaseline(const char *path, uint32_t samples)
+{
+	const struct BenchKernel *kernel;
+	FILE *out = fopen(path, "w");
+
+	if (out == NULL)
+	{
+		fprintf(stderr, "cannot create %s\n", path);
+		return 1;
+	}
+	fprintf(out, "# benchhost baseline: kernel and fastest ns per operation over %lu samples\n", (unsigned long)samples);
+	for (uint32_t i = 0; (kernel = BenchGetKernel(i)) != NULL; i++)
+	{
+		double ns = FastestNs(kernel, samples);
+
+		if (ns >= 0)
+		{
+			fprintf(out, "%-10s %.2f\n", kernel->name, ns);
+		}
+	}
+	fclose(out);
+	printf("wrote %s\n", path);
+	return 0;
+}
+
+/// Times the kernels of the baseline file. Fails if one is slower than its baseline by more than tolerance percent
+static int CheckBaseline(const char *path, uint32_t samples, double tolerance)
+{
+	FILE *in = fopen(path, "r");
+	char line[128];
+	int regressions = 0;
+
+	if (in == NULL)
+	{
+		fprintf(stderr, "cannot open %s\n", path);
+		return 1;
+	}
+	printf("%-10s %10s %10s %8s\n", "Kernel", "baseline", "now", "change");
+	while (fgets(line, sizeof(line), in) != NULL)
+	{
+		const struct BenchKernel *kernel;
+		char name[32];
+		double baseline;
+		double ns;
+
+		if (line[0] == '#' || sscanf(line, "%31s %lf", name, &baseline) != 2)
+		{
+			continue;
+		}
+		if ((kernel = BenchFindKernel(name, strlen(name))) == NULL || (ns = FastestNs(kernel, samples)) < 0)
+		{
+			printf("%-10s %10.2f %10s  FAILED\n", name, baseline, "-");
+			regressions++;
+			continue;
+		}
+		// Retry a slow kernel once: a single run can lose the CPU for its whole duration
+		if (ns > baseline * (1 + tolerance / 100))
+		{
+			double again = FastestNs(kernel, samples);
+
+			ns = (again >= 0 && again < ns) ? again : ns;
+		}
+		printf("%-10s %10.2f %10.2f %+7.1f%%%s\n", name, baseline, ns, 100 * (ns - baseline) / baseline,
+			   (ns > baseline * (1 + tolerance / 100)) ? "  SLOWER" : "");
+		regressions += (ns > baseline * (1 + tolerance / 100));
+	}
+	fclose(in);
+	if (regressions)
+	{
+		printf("%d kernels slower than %s allows (%.0f%%)\n", regressions, path, tolerance);
+	}
+	else
+	{
+		printf("no regression against %s (%.0f%%)\n", path, tolerance);
+	}
+	return regressions ? 1 : 0;
+}
+
+/******************************************************************************
+* Global Functions
+******************************************************************************/
+int main(int argc, char **argv)
+{
+	const struct BenchKernel *only = NULL;
+	unsigned long samples = 0;
+	const char *name = NULL;
+	const char *writePath = NULL;
+	const char *checkPath = NULL;
+	double tolerance = DEFAULT_TOLERANCE;
+	FRESULT res;
+
+	MemoryPoolsInit();
+	BenchRegisterPortableKernels();
+	BenchRegisterPlatformKernels();
+	if ((res = f_mount(0, &FileSystem)) != FR_OK || (res = f_mkfs(0, 1, 0)) != FR_OK)
+	{
+		fprintf(stderr, "cannot format the RAM disk: %d\n", (int)res);
+		return 1;
+	}
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-t") == 0)
+		{
+			return SelfTest();
+		}
+		else if (strcmp(argv[i], "-l") == 0)
+		{
+			const struct BenchKernel *kernel;
+
+			for (uint32_t k = 0; (kernel = BenchGetKernel(k)) != NULL; k++)
+			{
+				printf("%-10s %s\n", kernel->name, kernel->description);
+			}
+			return 0;
+		}
+		else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+		{
+			samples = strtoul(argv[++i], NULL, 10);
+		}
+		else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc)
+		{
+			writePath = argv[++i];
+		}
+		else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+		{
+			checkPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+		{
+			tolerance = atof(argv[++i]);
+		}
+		else if (argv[i][0] != '-' && name == NULL)
+		{
+			name = argv[i];
+		}
+		else
+		{
+			samples = BENCH_MAX_SAMPLES + 1;
+			break;
+		}
+	}
+	if (samples == 0)
+	{
+		samples = (writePath != NULL || checkPath != NULL) ? BENCH_MAX_SAMPLES : BENCH_DEFAULT_SAMPLES;
+	}
+	if (name != NULL && strcmp(name, "all") != 0 && (only = BenchFindKernel(name, strlen(name))) == NULL)
+	{
+		samples = 0;
+	}
+	if (samples == 0 || samples > BENCH_MAX_SAMPLES || tolerance <= 0 || (writePath != NULL && checkPath != NULL))
+	{
+		fprintf(stderr, "usage: %s [-n 1..%d] [kernel|all]\n       %s [-n samples] -w|-c baseline [-r percent]\n       %s -l\n       %s -t\n", argv[0],
+				BENCH_MAX_SAMPLES, argv[0], argv[0], argv[0]);
+		return 2;
+	}
+
+	if (writePath != NULL)
+	{
+		return WriteBaseline(writePath, (uint32_t)samples);
+	}
+	if (checkPath != NULL)
+	{
+		return CheckBaseline(checkPath, (uint32_t)samples, tolerance);
+	}
+	RunKernels(only, (uint32_t)samples);
+	return 0;
+}
@@ -0,0 +1,519 @@
+/**************************************************************************//**
+* @file      bootsim.c
+* @brief     Runs the bootloader flashing engine on the host, against a simulated NVM and SD card
+* @details   FlasherCore.c is built as is and driven through a struct FlasherHal that simulates the
+*			 SAMD21 NVM (256 KB, 256 byte rows, 64 byte pages, bootloader rows locked, the progress journal
+*			 rows of FlasherJournal.h at the same address as BootInfo.h), an SD card holding
+*			 the update file, and the DSU CRC32 in software. Flash writes can only clear bits, so a page
+*			 written without an erase is caught by the final CRC32 check, and a command issued while the
+*			 NVM is busy fails like it does on target.
+*
+*			 Time is modelled, not measured: every row erase and page write keeps the NVM busy for a fixed
+*			 time, every 512 byte SD sector the file pointer enters costs a fixed time, and the CRC32
+*			 runs at a fixed rate. SD reads overlap with a pending erase, as they do on target, so the
+*			 report shows how much of the erase time the pipeline hides. Decompression and patching CPU
+*			 time is not modelled.
+*
+*			 Power loss: -p <n> cuts the power during the n-th NVM operation (erases and page writes,
+*			 counted from 1). An interrupted erase leaves the second half of the row unerased, an
+*			 interrupted page write programs the first half of the page. The bootloader then restarts
+*			 the way BootMain.c does: the update flag is still on the SD card, so the same file is
+*			 flashed again. -s sweeps every operation of the update and checks that each run ends with
+*			 the same application as an uninterrupted one. The exit code is non zero if any run does not.
+*			 The journal lets the boot after a power loss resume from the last recorded row; -n disables
+*			 it, to see what it costs and what it saves.
+*
+*			 Usage:
+*				bootsim [-b base.bin] [-a addr] [-p op | -s] [-n] [-e eraseUs] [-w pageUs] [-r sectorUs] [-v] <update.bin>
+*				bootsim "../Bootloader Test Binaries/TestA.bin"
+*				bootsim -b TestA.bin -s TestB.delta
+*
+*			 -b loads an installed image at the load address first (needed by delta patches and to see
+*			 unchanged rows skipped). The load address defaults to 0x12000, or is taken from the header of a
+*			 stamped image (fwstamp). Defaults of the timing model: 6000 us per row erase and 2500 us per
+*			 page write (SAMD21 datasheet maximums), 500 us per SD sector (SPI at 12 MHz plus command overhead).
+*
+*			 Build (from this folder):
+*				gcc -O2 -Wall -I../SD_MMC_Bootloader/src -o bootsim bootsim.c ../SD_MMC_Bootloader/src/Flasher/FlasherCore.c ../SD_MMC_Bootloader/src/Flasher/FlasherJournal.c ../SD_MMC_Bootloader/src/Lz/LzDecoder.c ../SD_MMC_Bootloader/src/Delta/DeltaPatcher.c
+* @author
+* @date      2026-10-17
+
+******************************************************************************/
+
+
+/******************************************************************************
+* Includes
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include "HostCrc32.h"
+#include "../SD_MMC_Bootloader/src/Flasher/FlasherCore.h"
+#include "../SD_MMC_Bootloader/src/Image/ImageFormat.h"
+
+/******************************************************************************
+* Defines
+******************************************************************************/
+#define SIM_FLASH_SIZE			0x40000UL	///< NVM of the ATSAMD21J18A
+#define SIM_LOCKED_SIZE			0x11B00UL	///< Bootloader rows, locked by BOOTPROT. Erases and writes below fail
+#define SIM_JOURNAL_ADDRESS		0x11B00UL	///< BOOTINFO_JOURNAL_ROW_ADDRESS
+#define SIM_DEFAULT_ADDRESS		0x12000UL	///< APP_START_ADDRESS of the bootloader
+#define SIM_SECTOR_SIZE			512			///< SD card block size
+#define SIM_MAX_BOOTS			4			///< Boots attempted before the update is declared stuck
+#define SIM_CRC_BYTES_PER_US	12			///< Modelled DSU throughput
+#define SIM_DEFAULT_ERASE_US	6000
+#define SIM_DEFAULT_PAGE_US		2500
+#define SIM_DEFAULT_SECTOR_US	500
+
+/******************************************************************************
+* Structures and Enumerations
+******************************************************************************/
+/// Operation counts, summed over all boots of a run
+struct SimCounters {
+	uint32_t erases;
+	uint32_t pageWrites;
+	uint32_t sectorReads;
+	uint32_t crcBytes;
+};
+
+/// Simulated target
+struct Sim {
+	uint8_t flash[SIM_FLASH_SIZE];
+	const uint8_t *file;		///< Update file on the SD card
+	uint32_t fileLen;
+	uint32_t filePos;
+	int32_t cachedSector;		///< Sector held by the FatFs window, -1 after a reboot
+	uint32_t nowUs;				///< Modelled time since the start of the current boot
+	uint32_t busyUntilUs;		///< End of the pending NVM operation
+	uint32_t eraseUs;
+	uint32_t pageUs;
+	uint32_t sectorUs;
+	uint32_t opCount;			///< NVM operations issued so far, all boots included
+	uint32_t failAtOp;			///< Operation interrupted by the power loss. 0 for none
+	uint32_t failAddress;
+	uint32_t journalAddress;	///< 0 with -n
+	jmp_buf powerLoss;
+	struct SimCounters counters;
+};
+
+/// Outcome of a run: every boot until the update flag is removed or SIM_MAX_BOOTS is reached
+struct SimRun {
+	enum FlasherResult result;	///< Result of the last boot
+	uint32_t boots;
+	uint32_t totalUs;			///< Modelled time over all boots
+	struct FlasherStats stats;	///< Statistics of the last boot
+};
+
+/******************************************************************************
+* Static Functions
+******************************************************************************/
+static uint8_t *ReadFile(const char *path, size_t *len)
+{
+	FILE *f = fopen(path, "rb");
+	uint8_t *data = NULL;
+	long size;
+
+	if (f == NULL)
+	{
+		return NULL;
+	}
+	if (fseek(f, 0, SEEK_END) == 0 && (size = ftell(f)) >= 0 && fseek(f, 0, SEEK_SET) == 0)
+	{
+		data = malloc((size_t)size + 1);
+		if (data != NULL && fread(data, 1, (size_t)size, f) != (size_t)size)
+		{
+			free(data);
+			data = NULL;
+		}
+		*len = (size_t)size;
+	}
+	fclose(f);
+	return data;
+}
+
+static const char *ResultName(enum FlasherResult result)
+{
+	static const char *const names[] = { "ok", "io error", "bad format", "bad address", "bad data", "bad base", "busy", "nvm error" };
+
+	return ((unsigned)result < sizeof(names) / sizeof(names[0])) ? names[result] : "?";
+}
+
+/// Power is cut during the operation about to be issued: leave the row or page half done and reboot
+static void PowerCheck(struct Sim *sim, uint32_t address, uint32_t length, const uint8_t *data)
+{
+	if (++sim->opCount != sim->failAtOp)
+	{
+		return;
+	}
+
+	sim->failAddress = address;
+	for (uint32_t i = 0; i < length / 2; i++)
+	{
+		if (data == NULL)
+		{
+			sim->flash[address + i] = FLASHER_ERASED_BYTE;
+		}
+		else
+		{
+			sim->flash[address + i] &= data[i];
+		}
+	}
+	longjmp(sim->powerLoss, 1);
+}
+
+static enum FlasherResult SimRead(void *context, uint8_t *buffer, uint32_t length, uint32_t *numBytesRead)
+{
+	struct Sim *sim = context;
+	uint32_t n = sim->fileLen - sim->filePos;
+
+	if (n > length)
+	{
+		n = length;
+	}
+	if (n > 0)
+	{
+		int32_t first = (int32_t)(sim->filePos / SIM_SECTOR_SIZE);
+		int32_t last = (int32_t)((sim->filePos + n - 1) / SIM_SECTOR_SIZE);
+		for (int32_t sector = first; sector <= last; sector++)
+		{
+			if (sector != sim->cachedSector)
+			{
+				sim->nowUs += sim->sectorUs;
+				sim->counters.sectorReads++;
+				sim->cachedSector = sector;
+			}
+		}
+		memcpy(buffer, &sim->file[sim->filePos], n);
+		sim->filePos += n;
+	}
+	*numBytesRead = n;
+	return FLASHER_OK;
+}
+
+static enum FlasherResult SimSeek(void *context, uint32_t offset)
+{
+	struct Sim *sim = context;
+
+	if (offset > sim->fileLen)
+	{
+		return FLASHER_ERR_IO;
+	}
+	sim->filePos = offset;
+	return FLASHER_OK;
+}
+
+static uint32_t SimSize(void *context)
+{
+	return ((struct Sim *)context)->fileLen;
+}
+
+static enum FlasherResult SimStartErase(void *context, uint32_t rowAddress)
+{
+	struct Sim *sim = context;
+
+	if (sim->nowUs < sim->busyUntilUs)
+	{
+		return FLASHER_ERR_BUSY;
+	}
+	if ((rowAddress & (FLASHER_ROW_SIZE - 1)) != 0 || rowAddress < SIM_LOCKED_SIZE || rowAddress >= SIM_FLASH_SIZE)
+	{
+		return FLASHER_ERR_NVM;
+	}
+
+	PowerCheck(sim, rowAddress, FLASHER_ROW_SIZE, NULL);
+	memset(&sim->flash[rowAddress], FLASHER_ERASED_BYTE, FLASHER_ROW_SIZE);
+	sim->counters.erases++;
+	sim->busyUntilUs = sim->nowUs + sim->eraseUs;
+	return FLASHER_OK;
+}
+
+static enum FlasherResult SimWaitReady(void *context)
+{
+	struct Sim *sim = context;
+
+	if (sim->nowUs < sim->busyUntilUs)
+	{
+		sim->nowUs = sim->busyUntilUs;
+	}
+	return FLASHER_OK;
+}
+
+static enum FlasherResult SimWritePage(void *context, uint32_t address, const uint8_t *data)
+{
+	struct Sim *sim = context;
+
+	if (sim->nowUs < sim->busyUntilUs)
+	{
+		return FLASHER_ERR_BUSY;
+	}
+	if ((address & (FLASHER_PAGE_SIZE - 1)) != 0 || address < SIM_LOCKED_SIZE || address >= SIM_FLASH_SIZE)
+	{
+		return FLASHER_ERR_NVM;
+	}
+
+	PowerCheck(sim, address, FLASHER_PAGE_SIZE, data);
+	for (uint32_t i = 0; i < FLASHER_PAGE_SIZE; i++)
+	{
+		sim->flash[address + i] &= data[i];
+	}
+	sim->counters.pageWrites++;
+	sim->busyUntilUs = sim->nowUs + sim->pageUs;
+	return FLASHER_OK;
+}
+
+/// DSU convention: the state is passed in and out without the final complement
+static enum FlasherResult SimCrc(struct Sim *sim, const uint8_t *data, uint32_t length, uint32_t *crc)
+{
+	if ((length & 3U) != 0)
+	{
+		return FLASHER_ERR_NVM;
+	}
+	*crc = ~HostCrc32_Update(~*crc, data, length);
+	sim->nowUs += length / SIM_CRC_BYTES_PER_US;
+	sim->counters.crcBytes += length;
+	return FLASHER_OK;
+}
+
+static enum FlasherResult SimCrcRam(void *context, const uint8_t *data, uint32_t length, uint32_t *crc)
+{
+	return SimCrc(context, data, length, crc);
+}
+
+static enum FlasherResult SimCrcFlash(void *context, uint32_t address, uint32_t length, uint32_t *crc)
+{
+	struct Sim *sim = context;
+
+	if (address + length > SIM_FLASH_SIZE)
+	{
+		return FLASHER_ERR_NVM;
+	}
+	return SimCrc(sim, &sim->flash[address], length, crc);
+}
+
+static const uint8_t *SimFlash(void *context, uint32_t address)
+{
+	return &((struct Sim *)context)->flash[address];
+}
+
+static uint32_t SimTimeUs(void *context)
+{
+	return ((struct Sim *)context)->nowUs;
+}
+
+/// Boots until the update goes through, is rejected, or SIM_MAX_BOOTS is reached. Same policy as BootMain.c
+static void RunUpdate(struct Sim *sim, uint32_t fileOffset, uint32_t address, bool verbose, struct SimRun *run)
+{
+	const struct FlasherHal hal = {
+		sim, SIM_FLASH_SIZE, sim->journalAddress, SimRead, SimSeek, SimSize, SimStartErase, SimWaitReady, SimWritePage,
+		SimCrcRam, SimCrcFlash, SimFlash, SimTimeUs
+	};
+	volatile uint32_t boot = 0;
+
+	memset(run, 0, sizeof(*run));
+	memset(&sim->counters, 0, sizeof(sim->counters));
+	sim->opCount = 0;
+
+	while (boot < SIM_MAX_BOOTS)
+	{
+		boot++;
+		sim->nowUs = 0;
+		sim->busyUntilUs = 0;
+		sim->cachedSector = -1;
+		sim->filePos = 0;
+
+		if (setjmp(sim->powerLoss) != 0)
+		{
+			run->totalUs += sim->nowUs;
+			if (verbose)
+			{
+				printf("Boot %u: power lost at %.1f ms, NVM op %u (0x%08X)\n", (unsigned)boot, sim->nowUs / 1000.0, (unsigned)sim->failAtOp, (unsigned)sim->failAddress);
+			}
+			continue;
+		}
+
+		run->result = FlasherCore_Program(&hal, fileOffset, address, &run->stats);
+		run->totalUs += sim->nowUs;
+		if (verbose)
+		{
+			printf("Boot %u: %s, %.1f ms\n", (unsigned)boot, ResultName(run->result), sim->nowUs / 1000.0);
+		}
+
+		//Flag file removed on success, bad files are rejected. Anything else resets and tries again
+		if (run->result == FLASHER_OK || run->result == FLASHER_ERR_BAD_FORMAT || run->result == FLASHER_ERR_BAD_ADDRESS || run->result == FLASHER_ERR_BAD_BASE)
+		{
+			break;
+		}
+	}
+	run->boots = boot;
+}
+
+static void PrintReport(const struct Sim *sim, const struct SimRun *run)
+{
+	static const char *const imageTypeNames[] = { "raw", "LZ", "delta" };
+	const struct FlasherStats *stats = &run->stats;
+
+	printf("Image: %s, %u bytes, rows written %u, skipped %u\n", imageTypeNames[stats->imageType], (unsigned)stats->bytesWritten,
+		(unsigned)stats->rowsWritten, (unsigned)stats->rowsSkipped);
+	printf("CRC image 0x%08X  CRC flash 0x%08X\n", (unsigned)stats->imageCrc, (unsigned)stats->flashCrc);
+	printf("NVM ops: %u row erases, %u page writes. SD: %u sectors. CRC32: %u bytes\n", (unsigned)sim->counters.erases,
+		(unsigned)sim->counters.pageWrites, (unsigned)sim->counters.sectorReads, (unsigned)sim->counters.crcBytes);
+	printf("Last boot (ms): total %.1f, read %.1f, erase wait %.1f, program %.1f, verify %.1f\n",
+		sim->nowUs / 1000.0, stats->readUs / 1000.0, stats->eraseUs / 1000.0, stats->programUs / 1000.0, stats->verifyUs / 1000.0);
+	printf("Erase time hidden behind reads: %.1f of %.1f ms\n", (stats->rowsWritten * sim->eraseUs - stats->eraseUs) / 1000.0,
+		(stats->rowsWritten * sim->eraseUs) / 1000.0);
+	if (stats->rowsResumed > 0)
+	{
+		printf("Resumed: %u rows covered by the journal\n", (unsigned)stats->rowsResumed);
+	}
+	printf("All boots: %u, %.1f ms\n", (unsigned)run->boots, run->totalUs / 1000.0);
+}
+
+/******************************************************************************
+* Global Functions
+******************************************************************************/
+int main(int argc, char **argv)
+{
+	static struct Sim sim;
+	static uint8_t initialFlash[SIM_FLASH_SIZE];
+	static uint8_t expectedFlash[SIM_FLASH_SIZE];
+	const char *basePath = NULL;
+	uint32_t address = SIM_DEFAULT_ADDRESS;
+	uint32_t failAtOp = 0;
+	uint32_t fileOffset = 0;
+	bool sweep = false;
+	bool verbose = false;
+	struct SimRun run;
+	struct ImageHeader header;
+	size_t fileLen = 0;
+	uint8_t *file;
+	int argi;
+
+	sim.eraseUs = SIM_DEFAULT_ERASE_US;
+	sim.pageUs = SIM_DEFAULT_PAGE_US;
+	sim.sectorUs = SIM_DEFAULT_SECTOR_US;
+	sim.journalAddress = SIM_JOURNAL_ADDRESS;
+
+	for (argi = 1; argi < argc - 1 && argv[argi][0] == '-'; argi++)
+	{
+		char option = argv[argi][1];
+
+		if (option == 's' || option == 'v' || option == 'n')
+		{
+			sweep |= option == 's';
+			verbose |= option == 'v';
+			sim.journalAddress = (option == 'n') ? 0 : sim.journalAddress;
+			continue;
+		}
+		if (argi + 1 >= argc - 1)
+		{
+			break;
+		}
+		argi++;
+		switch (option)
+		{
+			case 'b': basePath = argv[argi]; break;
+			case 'a': address = (uint32_t)strtoul(argv[argi], NULL, 0); break;
+			case 'p': failAtOp = (uint32_t)strtoul(argv[argi], NULL, 0); break;
+			case 'e': sim.eraseUs = (uint32_t)strtoul(argv[argi], NULL, 0); break;
+			case 'w': sim.pageUs = (uint32_t)strtoul(argv[argi], NULL, 0); break;
+			case 'r': sim.sectorUs = (uint32_t)strtoul(argv[argi], NULL, 0); break;
+			default: argi = argc; break;
+		}
+	}
+	if (argi != argc - 1)
+	{
+		fprintf(stderr, "usage: %s [-b base.bin] [-a addr] [-p op | -s] [-n] [-e eraseUs] [-w pageUs] [-r sectorUs] [-v] <update.bin>\n", argv[0]);
+		return 2;
+	}
+
+	file = ReadFile(argv[argi], &fileLen);
+	if (file == NULL)
+	{
+		fprintf(stderr, "could not read %s\n", argv[argi]);
+		return 2;
+	}
+	if (fileLen >= IMAGE_HEADER_SIZE && ImageFormat_ParseHeader(file, &header) == 0)
+	{
+		fileOffset = IMAGE_HEADER_SIZE;
+		address = header.loadAddress;
+		printf("Stamped image, version %u, load address 0x%08X\n", (unsigned)header.version, (unsigned)address);
+	}
+	sim.file = file;
+	sim.fileLen = (uint32_t)fileLen;
+
+	memset(initialFlash, FLASHER_ERASED_BYTE, sizeof(initialFlash));
+	if (basePath != NULL)
+	{
+		size_t baseLen = 0;
+		uint8_t *base = ReadFile(basePath, &baseLen);
+		if (base == NULL || address + baseLen > SIM_FLASH_SIZE)
+		{
+			fprintf(stderr, "could not load %s at 0x%08X\n", basePath, (unsigned)address);
+			return 2;
+		}
+		memcpy(&initialFlash[address], base, baseLen);
+		free(base);
+	}
+
+	//Reference run: no power loss. Its application is what every interrupted run must end with. The backup row is left as it is
+	memcpy(sim.flash, initialFlash, SIM_FLASH_SIZE);
+	sim.failAtOp = 0;
+	RunUpdate(&sim, fileOffset, address, false, &run);
+	memcpy(expectedFlash, sim.flash, SIM_FLASH_SIZE);
+	if (run.result != FLASHER_OK)
+	{
+		printf("Update failed without power loss: %s\n", ResultName(run.result));
+		return 1;
+	}
+	if (fileOffset != 0 && HostCrc32_Pad(HostCrc32_Update(0, &sim.flash[address], header.imageSize),
+		(FLASHER_ROW_SIZE - header.imageSize % FLASHER_ROW_SIZE) % FLASHER_ROW_SIZE) != header.imageCrc)
+	{
+		printf("Flash does not match the image CRC32 of the header\n");
+		return 1;
+	}
+
+	if (sweep)
+	{
+		uint32_t points = sim.opCount;
+		uint32_t failures = 0;
+		uint32_t worstUs = 0;
+		uint32_t worstBoots = 0;
+
+		for (uint32_t op = 1; op <= points; op++)
+		{
+			memcpy(sim.flash, initialFlash, SIM_FLASH_SIZE);
+			sim.failAtOp = op;
+			RunUpdate(&sim, fileOffset, address, verbose, &run);
+			if (run.result != FLASHER_OK || memcmp(&sim.flash[address], &expectedFlash[address], SIM_FLASH_SIZE - address) != 0)
+			{
+				if (failures < 10)
+				{
+					printf("Power loss at op %u (0x%08X): not recovered, %s after %u boots\n", (unsigned)op,
+						(unsigned)sim.failAddress, ResultName(run.result), (unsigned)run.boots);
+				}
+				failures++;
+			}
+			worstUs = (run.totalUs > worstUs) ? run.totalUs : worstUs;
+			worstBoots = (run.boots > worstBoots) ? run.boots : worstBoots;
+		}
+		printf("Sweep: %u power loss points, %u recovered, %u not recovered. Worst case %u boots, %.1f ms\n",
+			(unsigned)points, (unsigned)(points - failures), (unsigned)failures, (unsigned)worstBoots, worstUs / 1000.0);
+		free(file);
+		return (failures == 0) ? 0 : 1;
+	}
+
+	memcpy(sim.flash, initialFlash, SIM_FLASH_SIZE);
+	sim.failAtOp = failAtOp;
+	RunUpdate(&sim, fileOffset, address, true, &run);
+	PrintReport(&sim, &run);
+	free(file);
+
+	if (run.result != FLASHER_OK || memcmp(&sim.flash[address], &expectedFlash[address], SIM_FLASH_SIZE - address) != 0)
+	{
+		printf("FAILED: flash does not hold the image\n");
+		return 1;
+	}
+	printf("OK\n");
+	return 0;
+}
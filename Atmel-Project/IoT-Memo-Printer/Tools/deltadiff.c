@@ -0,0 +1,453 @@
+/**************************************************************************//**
+* @file      deltadiff.c
+* @brief     Builds (and applies) binary delta patches for in place updates by the bootloader
+* @details   Usage:
+*				deltadiff <base.bin> <new.bin> <patch.bin>		Build a patch that turns base into new
+*				deltadiff -a <base.bin> <patch.bin> <new.bin>	Apply a patch, using the bootloader's DeltaPatcher
+*
+*			 base.bin must be the raw image currently installed (the bootloader checks its CRC before
+*			 patching). Both row orders are tried and the smaller patch is kept. The patch is applied
+*			 once in memory before it is written, to check it rebuilds new.bin exactly.
+*
+*			 Build (from this folder):
+*				gcc -O2 -Wall -o deltadiff deltadiff.c ../SD_MMC_Bootloader/src/Delta/DeltaPatcher.c
+* @author
+* @date      2026-10-17
+
+******************************************************************************/
+
+
+/******************************************************************************
+* Includes
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "HostCrc32.h"
+#include "../SD_MMC_Bootloader/src/Delta/DeltaPatcher.h"
+
+/******************************************************************************
+* Defines
+******************************************************************************/
+#define MIN_COPY		(DELTA_COPY_OFFSET_SIZE + 2)	///< Shorter copies cost more than literals
+#define HASH_BITS		16
+#define HASH_SIZE		(1U << HASH_BITS)
+#define MAX_CHAIN		512
+#define NO_POSITION		(-1)
+
+/******************************************************************************
+* Structures and Enumerations
+******************************************************************************/
+struct Buffer {
+	uint8_t *data;
+	size_t len;
+	size_t cap;
+};
+
+struct BaseIndex {
+	const uint8_t *base;
+	size_t baseLen;			///< Readable base bytes (padded to whole rows)
+	int32_t head[HASH_SIZE];
+	int32_t *prev;
+};
+
+struct MemorySource {
+	const uint8_t *data;
+	size_t len;
+	size_t pos;
+};
+
+/******************************************************************************
+* Static Functions
+******************************************************************************/
+static uint8_t *ReadFile(const char *path, size_t *len)
+{
+	FILE *f = fopen(path, "rb");
+	uint8_t *data = NULL;
+	long size;
+
+	if (f == NULL)
+	{
+		return NULL;
+	}
+	if (fseek(f, 0, SEEK_END) == 0 && (size = ftell(f)) >= 0 && fseek(f, 0, SEEK_SET) == 0)
+	{
+		data = malloc((size_t)size + DELTA_ROW_SIZE);
+		if (data != NULL && fread(data, 1, (size_t)size, f) != (size_t)size)
+		{
+			free(data);
+			data = NULL;
+		}
+		*len = (size_t)size;
+	}
+	fclose(f);
+	return data;
+}
+
+static int WriteFile(const char *path, const uint8_t *data, size_t len)
+{
+	FILE *f = fopen(path, "wb");
+	int ok;
+
+	if (f == NULL)
+	{
+		return -1;
+	}
+	ok = fwrite(data, 1, len, f) == len;
+	ok &= fclose(f) == 0;
+	return ok ? 0 : -1;
+}
+
+static void Buffer_Put(struct Buffer *b, uint8_t value)
+{
+	if (b->len == b->cap)
+	{
+		b->cap = b->cap ? b->cap * 2 : 4096;
+		b->data = realloc(b->data, b->cap);
+		if (b->data == NULL)
+		{
+			fprintf(stderr, "out of memory\n");
+			exit(1);
+		}
+	}
+	b->data[b->len++] = value;
+}
+
+/// CRC32 of an image padded with 0xFF to whole rows, as the bootloader computes it over flash
+static uint32_t ImageCrc(const uint8_t *data, size_t len)
+{
+	uint32_t crc = HostCrc32_Update(0, data, len);
+	return HostCrc32_Pad(crc, DeltaFormat_Rows((uint32_t)len) * DELTA_ROW_SIZE - len);
+}
+
+static uint32_t Hash4(const uint8_t *p)
+{
+	uint32_t v = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+	return (v * 2654435761U) >> (32 - HASH_BITS);
+}
+
+static int BaseIndex_Build(struct BaseIndex *index, const uint8_t *base, size_t baseLen)
+{
+	index->base = base;
+	index->baseLen = baseLen;
+	index->prev = malloc((baseLen + 1) * sizeof(int32_t));
+	if (index->prev == NULL)
+	{
+		return -1;
+	}
+	for (size_t i = 0; i < HASH_SIZE; i++)
+	{
+		index->head[i] = NO_POSITION;
+	}
+	for (size_t pos = 0; pos + 4 <= baseLen; pos++)
+	{
+		uint32_t h = Hash4(&base[pos]);
+		index->prev[pos] = index->head[h];
+		index->head[h] = (int32_t)pos;
+	}
+	return 0;
+}
+
+/// Longest base match for data[0..maxLen) whose source lies in [lo, hi). Returns its length and sets *offset
+static size_t BaseIndex_Find(const struct BaseIndex *index, const uint8_t *data, size_t maxLen, size_t lo, size_t hi, size_t *offset)
+{
+	size_t best = 0;
+	unsigned chain = MAX_CHAIN;
+
+	if (maxLen < 4)
+	{
+		return 0;
+	}
+
+	for (int32_t cand = index->head[Hash4(data)]; cand != NO_POSITION && chain-- > 0; cand = index->prev[cand])
+	{
+		size_t c = (size_t)cand;
+		size_t limit = maxLen;
+
+		if (c < lo || c >= hi)
+		{
+			continue;
+		}
+		if (c + limit > hi)
+		{
+			limit = hi - c;
+		}
+
+		size_t len = 0;
+		while (len < limit && index->base[c + len] == data[len])
+		{
+			len++;
+		}
+		if (len > best)
+		{
+			best = len;
+			*offset = c;
+			if (len == maxLen)
+			{
+				break;
+			}
+		}
+	}
+	return best;
+}
+
+static void EmitLiterals(struct Buffer *out, const uint8_t *data, size_t len)
+{
+	while (len > 0)
+	{
+		size_t n = (len > DELTA_OP_MAX_LENGTH) ? DELTA_OP_MAX_LENGTH : len;
+		Buffer_Put(out, (uint8_t)(n - 1));
+		for (size_t i = 0; i < n; i++)
+		{
+			Buffer_Put(out, data[i]);
+		}
+		data += n;
+		len -= n;
+	}
+}
+
+static void EmitCopy(struct Buffer *out, size_t offset, size_t len)
+{
+	while (len > 0)
+	{
+		size_t n = (len > DELTA_OP_MAX_LENGTH) ? DELTA_OP_MAX_LENGTH : len;
+		Buffer_Put(out, (uint8_t)(DELTA_OP_COPY | (n - 1)));
+		Buffer_Put(out, (uint8_t)offset);
+		Buffer_Put(out, (uint8_t)(offset >> 8));
+		Buffer_Put(out, (uint8_t)(offset >> 16));
+		offset += n;
+		len -= n;
+	}
+}
+
+/// Encodes the records of every row of newImage in the given order
+static void BuildRecords(const struct BaseIndex *index, const uint8_t *newImage, size_t newLen, int descending, struct Buffer *out)
+{
+	uint32_t rows = DeltaFormat_Rows((uint32_t)newLen);
+
+	for (uint32_t n = 0; n < rows; n++)
+	{
+		uint32_t row = descending ? rows - 1 - n : n;
+		size_t rowStart = (size_t)row * DELTA_ROW_SIZE;
+		size_t rowEnd = rowStart + DELTA_ROW_SIZE;
+		size_t rowBytes = (newLen - rowStart < DELTA_ROW_SIZE) ? newLen - rowStart : DELTA_ROW_SIZE;
+		//Base bytes that are still intact while this row is built (see DeltaFormat.h)
+		size_t lo = descending ? 0 : rowStart;
+		size_t hi = descending ? rowEnd : index->baseLen;
+		size_t pos = 0;
+		size_t literalStart = 0;
+
+		if (hi > index->baseLen)
+		{
+			hi = index->baseLen;
+		}
+
+		while (pos < rowBytes)
+		{
+			size_t offset = 0;
+			size_t len = (lo < hi) ? BaseIndex_Find(index, &newImage[rowStart + pos], rowBytes - pos, lo, hi, &offset) : 0;
+
+			if (len >= MIN_COPY)
+			{
+				EmitLiterals(out, &newImage[rowStart + literalStart], pos - literalStart);
+				EmitCopy(out, offset, len);
+				pos += len;
+				literalStart = pos;
+			}
+			else
+			{
+				pos++;
+			}
+		}
+		EmitLiterals(out, &newImage[rowStart + literalStart], rowBytes - literalStart);
+	}
+}
+
+static size_t MemoryFill(void *context, uint8_t *buffer, size_t length)
+{
+	struct MemorySource *src = context;
+	size_t n = src->len - src->pos;
+
+	if (n > length)
+	{
+		n = length;
+	}
+	memcpy(buffer, &src->data[src->pos], n);
+	src->pos += n;
+	return n;
+}
+
+/// Applies a patch to a copy of base, in place and in the patch's row order, like the bootloader does
+static uint8_t *ApplyPatch(const uint8_t *base, size_t baseLen, const uint8_t *patch, size_t patchLen, size_t *newLen)
+{
+	static struct DeltaPatcher patcher;
+	struct DeltaHeader header;
+	struct MemorySource src;
+	uint8_t row[DELTA_ROW_SIZE];
+	uint32_t rowIndex;
+	int32_t n;
+
+	if (patchLen < DELTA_HEADER_SIZE || DeltaFormat_ParseHeader(patch, &header) != 0 || header.recordsSize != patchLen - DELTA_HEADER_SIZE)
+	{
+		fprintf(stderr, "not a delta patch\n");
+		return NULL;
+	}
+	if (header.baseSize != baseLen || header.baseCrc != ImageCrc(base, baseLen))
+	{
+		fprintf(stderr, "patch was not built against this base image\n");
+		return NULL;
+	}
+
+	size_t flashLen = (size_t)(DeltaFormat_Rows(header.baseSize) > DeltaFormat_Rows(header.newSize) ? DeltaFormat_Rows(header.baseSize) : DeltaFormat_Rows(header.newSize)) * DELTA_ROW_SIZE;
+	uint8_t *flash = malloc(flashLen);
+	if (flash == NULL)
+	{
+		return NULL;
+	}
+	memset(flash, 0xFF, flashLen);
+	memcpy(flash, base, baseLen);
+
+	src.data = &patch[DELTA_HEADER_SIZE];
+	src.len = header.recordsSize;
+	src.pos = 0;
+	DeltaPatcher_Init(&patcher, &header, flash, MemoryFill, &src);
+	while ((n = DeltaPatcher_NextRow(&patcher, row, &rowIndex)) > 0)
+	{
+		memcpy(&flash[(size_t)rowIndex * DELTA_ROW_SIZE], row, DELTA_ROW_SIZE);
+	}
+	if (n < 0 || ImageCrc(flash, header.newSize) != header.newCrc)
+	{
+		fprintf(stderr, "patch does not rebuild the new image\n");
+		free(flash);
+		return NULL;
+	}
+
+	*newLen = header.newSize;
+	return flash;
+}
+
+static int Diff(const char *basePath, const char *newPath, const char *patchPath)
+{
+	size_t baseLen = 0, newLen = 0;
+	uint8_t *base = ReadFile(basePath, &baseLen);
+	uint8_t *newImage = ReadFile(newPath, &newLen);
+	struct BaseIndex index;
+	struct Buffer records[2] = { { NULL, 0, 0 }, { NULL, 0, 0 } };
+	struct DeltaHeader header;
+	int ret = 1;
+
+	if (base == NULL || newImage == NULL)
+	{
+		fprintf(stderr, "could not read %s\n", base == NULL ? basePath : newPath);
+		goto end;
+	}
+	if (baseLen >= (1UL << (8 * DELTA_COPY_OFFSET_SIZE)))
+	{
+		fprintf(stderr, "base image too large\n");
+		goto end;
+	}
+
+	//Index the base as it sits in flash, padded with 0xFF to whole rows
+	size_t basePadded = (size_t)DeltaFormat_Rows((uint32_t)baseLen) * DELTA_ROW_SIZE;
+	memset(&base[baseLen], 0xFF, basePadded - baseLen);
+	if (BaseIndex_Build(&index, base, basePadded) != 0)
+	{
+		goto end;
+	}
+	BuildRecords(&index, newImage, newLen, 0, &records[0]);
+	BuildRecords(&index, newImage, newLen, 1, &records[1]);
+	free(index.prev);
+
+	int descending = records[1].len < records[0].len;
+	struct Buffer *chosen = &records[descending];
+
+	header.magic = DELTA_MAGIC;
+	header.baseSize = (uint32_t)baseLen;
+	header.baseCrc = ImageCrc(base, baseLen);
+	header.newSize = (uint32_t)newLen;
+	header.newCrc = ImageCrc(newImage, newLen);
+	header.recordsSize = (uint32_t)chosen->len;
+	header.flags = descending ? DELTA_FLAG_DESCENDING : 0;
+
+	uint8_t *patch = malloc(DELTA_HEADER_SIZE + chosen->len);
+	if (patch == NULL)
+	{
+		goto end;
+	}
+	DeltaFormat_WriteHeader(patch, &header);
+	memcpy(&patch[DELTA_HEADER_SIZE], chosen->data, chosen->len);
+
+	//Check the patch before it leaves this tool
+	size_t checkLen = 0;
+	uint8_t *check = ApplyPatch(base, baseLen, patch, DELTA_HEADER_SIZE + chosen->len, &checkLen);
+	if (check == NULL || checkLen != newLen || memcmp(check, newImage, newLen) != 0)
+	{
+		fprintf(stderr, "internal error: patch does not round trip\n");
+	}
+	else if (WriteFile(patchPath, patch, DELTA_HEADER_SIZE + chosen->len) != 0)
+	{
+		fprintf(stderr, "could not create %s\n", patchPath);
+	}
+	else
+	{
+		printf("base %zu bytes, new %zu bytes, patch %zu bytes (%.1f%% of new), %s rows (other order: %zu bytes)\n",
+			baseLen, newLen, DELTA_HEADER_SIZE + chosen->len,
+			newLen ? 100.0 * (double)(DELTA_HEADER_SIZE + chosen->len) / (double)newLen : 0.0,
+			descending ? "descending" : "ascending", DELTA_HEADER_SIZE + records[!descending].len);
+		ret = 0;
+	}
+	free(check);
+	free(patch);
+
+end:
+	free(records[0].data);
+	free(records[1].data);
+	free(base);
+	free(newImage);
+	return ret;
+}
+
+static int Apply(const char *basePath, const char *patchPath, const char *newPath)
+{
+	size_t baseLen = 0, patchLen = 0, newLen = 0;
+	uint8_t *base = ReadFile(basePath, &baseLen);
+	uint8_t *patch = ReadFile(patchPath, &patchLen);
+	uint8_t *newImage = NULL;
+	int ret = 1;
+
+	if (base == NULL || patch == NULL)
+	{
+		fprintf(stderr, "could not read %s\n", base == NULL ? basePath : patchPath);
+	}
+	else if ((newImage = ApplyPatch(base, baseLen, patch, patchLen, &newLen)) != NULL)
+	{
+		ret = WriteFile(newPath, newImage, newLen) == 0 ? 0 : 1;
+		if (ret != 0)
+		{
+			fprintf(stderr, "could not create %s\n", newPath);
+		}
+	}
+
+	free(base);
+	free(patch);
+	free(newImage);
+	return ret;
+}
+
+/******************************************************************************
+* Global Functions
+******************************************************************************/
+int main(int argc, char **argv)
+{
+	if (argc == 5 && strcmp(argv[1], "-a") == 0)
+	{
+		return Apply(argv[2], argv[3], argv[4]);
+	}
+	if (argc == 4)
+	{
+		return Diff(argv[1], argv[2], argv[3]);
+	}
+
+	fprintf(stderr, "usage: %s <base.bin> <new.bin> <patch.bin>\n       %s -a <base.bin> <patch.bin> <new.bin>\n", argv[0], argv[0]);
+	return 2;
+}
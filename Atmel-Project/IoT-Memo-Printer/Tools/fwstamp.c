@@ -0,0 +1,321 @@
+/**************************************************************************//**
+* @file      fwstamp.c
+* @brief     Stamps a firmware payload with the image header checked by the bootloader
+* @details   Usage:
+*				fwstamp [-f] -v <version> [-a <loadaddr>] <payload.bin> <output.bin>	Stamp a payload
+*				fwstamp -i <image.bin>													Print and verify a stamped image
+*
+*			 The payload is a raw binary, an LZ image (lzpack) or a delta patch (deltadiff). The image CRC32
+*			 is taken from the decompressed image or from the patch header, so the bootloader can tell
+*			 whether the same image is already installed. -f sets IMAGE_FLAG_FORCE: the image is flashed
+*			 even if that version is installed. The load address defaults to 0x12000.
+*
+*			 Build (from this folder):
+*				gcc -O2 -Wall -o fwstamp fwstamp.c ../SD_MMC_Bootloader/src/Lz/LzDecoder.c
+* @author
+* @date      2026-10-17
+
+******************************************************************************/
+
+
+/******************************************************************************
+* Includes
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "HostCrc32.h"
+#include "../SD_MMC_Bootloader/src/Image/ImageFormat.h"
+#include "../SD_MMC_Bootloader/src/Lz/LzDecoder.h"
+#include "../SD_MMC_Bootloader/src/Delta/DeltaFormat.h"
+
+/******************************************************************************
+* Defines
+******************************************************************************/
+#define FWSTAMP_DEFAULT_LOAD_ADDRESS	0x12000UL	///< APP_START_ADDRESS of the bootloader
+
+/******************************************************************************
+* Structures and Enumerations
+******************************************************************************/
+/// Memory source for the decoder fill callback
+struct MemorySource {
+	const uint8_t *data;
+	size_t len;
+	size_t pos;
+};
+
+/******************************************************************************
+* Static Functions
+******************************************************************************/
+static uint8_t *ReadFile(const char *path, size_t *len)
+{
+	FILE *f = fopen(path, "rb");
+	uint8_t *data = NULL;
+	long size;
+
+	if (f == NULL)
+	{
+		return NULL;
+	}
+	if (fseek(f, 0, SEEK_END) == 0 && (size = ftell(f)) >= 0 && fseek(f, 0, SEEK_SET) == 0)
+	{
+		data = malloc((size_t)size + 1);
+		if (data != NULL && fread(data, 1, (size_t)size, f) != (size_t)size)
+		{
+			free(data);
+			data = NULL;
+		}
+		*len = (size_t)size;
+	}
+	fclose(f);
+	return data;
+}
+
+static int WriteFile(const char *path, const uint8_t *data, size_t len)
+{
+	FILE *f = fopen(path, "wb");
+	int ok;
+
+	if (f == NULL)
+	{
+		return -1;
+	}
+	ok = fwrite(data, 1, len, f) == len;
+	ok &= fclose(f) == 0;
+	return ok ? 0 : -1;
+}
+
+static size_t MemoryFill(void *context, uint8_t *buffer, size_t length)
+{
+	struct MemorySource *src = context;
+	size_t n = src->len - src->pos;
+
+	if (n > length)
+	{
+		n = length;
+	}
+	memcpy(buffer, &src->data[src->pos], n);
+	src->pos += n;
+	return n;
+}
+
+/// Size and CRC32 of the image a payload puts in flash, padded with 0xFF to whole rows. Returns the payload type name or NULL if it is corrupt
+static const char *DescribePayload(const uint8_t *payload, size_t len, uint32_t *imageSize, uint32_t *imageCrc)
+{
+	struct LzHeader lzHeader;
+	struct DeltaHeader deltaHeader;
+
+	if (len >= LZ_HEADER_SIZE && LzFormat_ParseHeader(payload, &lzHeader) == 0)
+	{
+		static struct LzDecoder decoder;
+		struct MemorySource src = { &payload[LZ_HEADER_SIZE], len - LZ_HEADER_SIZE, 0 };
+		uint8_t row[DELTA_ROW_SIZE];
+		uint32_t crc = 0;
+		int32_t n;
+
+		if (lzHeader.packedSize != len - LZ_HEADER_SIZE)
+		{
+			return NULL;
+		}
+		LzDecoder_Init(&decoder, lzHeader.rawSize, MemoryFill, &src);
+		*imageSize = 0;
+		while ((n = LzDecoder_Read(&decoder, row, sizeof(row))) > 0)
+		{
+			crc = HostCrc32_Update(crc, row, (size_t)n);
+			*imageSize += (uint32_t)n;
+		}
+		if (n < 0 || *imageSize != lzHeader.rawSize)
+		{
+			return NULL;
+		}
+		*imageCrc = HostCrc32_Pad(crc, DeltaFormat_Rows(*imageSize) * DELTA_ROW_SIZE - *imageSize);
+		return "LZ";
+	}
+
+	if (len >= DELTA_HEADER_SIZE && DeltaFormat_ParseHeader(payload, &deltaHeader) == 0)
+	{
+		if (deltaHeader.recordsSize != len - DELTA_HEADER_SIZE)
+		{
+			return NULL;
+		}
+		*imageSize = deltaHeader.newSize;
+		*imageCrc = deltaHeader.newCrc;
+		return "delta";
+	}
+
+	*imageSize = (uint32_t)len;
+	*imageCrc = HostCrc32_Pad(HostCrc32_Update(0, payload, len), DeltaFormat_Rows((uint32_t)len) * DELTA_ROW_SIZE - len);
+	return "raw";
+}
+
+static void PrintHeader(const struct ImageHeader *header, const char *payloadType)
+{
+	printf("version      %lu%s\n", (unsigned long)header->version, (header->flags & IMAGE_FLAG_FORCE) ? " (forced)" : "");
+	printf("payload      %lu bytes, %s, CRC32 0x%08lX\n", (unsigned long)header->payloadLength, payloadType, (unsigned long)header->payloadCrc);
+	printf("image        %lu bytes at 0x%05lX, CRC32 0x%08lX\n", (unsigned long)header->imageSize, (unsigned long)header->loadAddress, (unsigned long)header->imageCrc);
+	printf("header CRC32 0x%08lX\n", (unsigned long)header->headerCrc);
+}
+
+static int Stamp(const char *payloadPath, const char *outPath, uint32_t version, uint32_t loadAddress, uint16_t flags)
+{
+	struct ImageHeader header;
+	const char *payloadType;
+	uint8_t *payload;
+	uint8_t *output;
+	size_t len = 0;
+	int ret;
+
+	payload = ReadFile(payloadPath, &len);
+	if (payload == NULL)
+	{
+		fprintf(stderr, "could not read %s\n", payloadPath);
+		return 1;
+	}
+
+	memset(&header, 0, sizeof(header));
+	payloadType = DescribePayload(payload, len, &header.imageSize, &header.imageCrc);
+	if (payloadType == NULL || header.imageSize == 0)
+	{
+		fprintf(stderr, "%s: corrupt or empty payload\n", payloadPath);
+		free(payload);
+		return 1;
+	}
+
+	output = malloc(IMAGE_HEADER_SIZE + len);
+	if (output == NULL)
+	{
+		free(payload);
+		return 1;
+	}
+	header.flags = flags;
+	header.version = version;
+	header.payloadLength = (uint32_t)len;
+	header.loadAddress = loadAddress;
+	header.payloadCrc = HostCrc32_Update(0, payload, len);
+	ImageFormat_WriteHeader(output, &header);
+	header.headerCrc = HostCrc32_Update(0, output, IMAGE_HEADER_CRC_OFFSET);
+	ImageFormat_WriteHeader(output, &header);
+	memcpy(&output[IMAGE_HEADER_SIZE], payload, len);
+
+	PrintHeader(&header, payloadType);
+	ret = WriteFile(outPath, output, IMAGE_HEADER_SIZE + len);
+	free(output);
+	free(payload);
+	if (ret != 0)
+	{
+		fprintf(stderr, "could not create %s\n", outPath);
+		return 1;
+	}
+	return 0;
+}
+
+static int Inspect(const char *path)
+{
+	struct ImageHeader header;
+	const char *payloadType;
+	uint32_t imageSize = 0;
+	uint32_t imageCrc = 0;
+	uint8_t *data;
+	size_t len = 0;
+	int errors = 0;
+
+	data = ReadFile(path, &len);
+	if (data == NULL)
+	{
+		fprintf(stderr, "could not read %s\n", path);
+		return 1;
+	}
+	if (len < IMAGE_HEADER_SIZE || ImageFormat_ParseHeader(data, &header) != 0)
+	{
+		fprintf(stderr, "%s: no image header\n", path);
+		free(data);
+		return 1;
+	}
+
+	payloadType = DescribePayload(&data[IMAGE_HEADER_SIZE], len - IMAGE_HEADER_SIZE, &imageSize, &imageCrc);
+	PrintHeader(&header, payloadType ? payloadType : "corrupt");
+
+	if (HostCrc32_Update(0, data, IMAGE_HEADER_CRC_OFFSET) != header.headerCrc)
+	{
+		fprintf(stderr, "header CRC32 mismatch\n");
+		errors++;
+	}
+	if (header.payloadLength != len - IMAGE_HEADER_SIZE)
+	{
+		fprintf(stderr, "payload length mismatch: file holds %zu bytes\n", len - IMAGE_HEADER_SIZE);
+		errors++;
+	}
+	else if (HostCrc32_Update(0, &data[IMAGE_HEADER_SIZE], header.payloadLength) != header.payloadCrc)
+	{
+		fprintf(stderr, "payload CRC32 mismatch\n");
+		errors++;
+	}
+	if (payloadType == NULL || imageSize != header.imageSize || imageCrc != header.imageCrc)
+	{
+		fprintf(stderr, "image size or CRC32 mismatch\n");
+		errors++;
+	}
+
+	free(data);
+	printf("%s\n", errors ? "INVALID" : "OK");
+	return errors ? 1 : 0;
+}
+
+static int ParseU32(const char *text, uint32_t *value)
+{
+	char *end;
+	unsigned long v = strtoul(text, &end, 0);
+
+	if (*text == '\0' || *end != '\0' || v > 0xFFFFFFFFUL)
+	{
+		return -1;
+	}
+	*value = (uint32_t)v;
+	return 0;
+}
+
+/******************************************************************************
+* Global Functions
+******************************************************************************/
+int main(int argc, char **argv)
+{
+	uint32_t version = 0;
+	uint32_t loadAddress = FWSTAMP_DEFAULT_LOAD_ADDRESS;
+	uint16_t flags = 0;
+	int haveVersion = 0;
+	int i;
+
+	if (argc == 3 && strcmp(argv[1], "-i") == 0)
+	{
+		return Inspect(argv[2]);
+	}
+
+	for (i = 1; i < argc - 2; i++)
+	{
+		if (strcmp(argv[i], "-f") == 0)
+		{
+			flags |= IMAGE_FLAG_FORCE;
+		}
+		else if (strcmp(argv[i], "-v") == 0 && i + 1 < argc - 2 && ParseU32(argv[i + 1], &version) == 0)
+		{
+			haveVersion = 1;
+			i++;
+		}
+		else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc - 2 && ParseU32(argv[i + 1], &loadAddress) == 0)
+		{
+			i++;
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	if (!haveVersion || i != argc - 2)
+	{
+		fprintf(stderr, "usage: %s [-f] -v <version> [-a <loadaddr>] <payload.bin> <output.bin>\n       %s -i <image.bin>\n", argv[0], argv[0]);
+		return 2;
+	}
+
+	return Stamp(argv[argc - 2], argv[argc - 1], version, loadAddress, flags);
+}
@@ -0,0 +1,50 @@
+/**************************************************************************//**
+* @file      FreeRTOS.h
+* @brief     Host stand-in for the FreeRTOS kernel header
+* @details   Enough of FreeRTOS for Memory/Heap.c and Memory/MemoryPool.c: the types, the heap size and
+*			 alignment of the port, and configASSERT, which counts in HostAssertFailures instead of halting so
+*			 the self test can check that a bad free is caught. Put this folder first on the include path.
+* @author
+* @date      2026-10-17
+
+******************************************************************************/
+
+#pragma once
+
+/******************************************************************************
+* Includes
+******************************************************************************/
+#include <stddef.h>
+#include <stdint.h>
+
+/******************************************************************************
+* Defines
+******************************************************************************/
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+#define pdFALSE						((BaseType_t)0)
+#define pdTRUE						((BaseType_t)1)
+
+#define configTOTAL_HEAP_SIZE		((size_t)16384)
+#define configUSE_MALLOC_FAILED_HOOK 0
+#define portBYTE_ALIGNMENT			8
+#define portBYTE_ALIGNMENT_MASK		(0x0007)
+
+#define configASSERT(x)				if ((x) == 0) { HostAssertFailures++; }
+#define traceMALLOC(pvAddress, uiSize)
+#define traceFREE(pvAddress, uiSize)
+
+/******************************************************************************
+* Global Variables
+******************************************************************************/
+extern unsigned long HostAssertFailures;	///< configASSERT failures, in host/HostStubs.c
+
+/******************************************************************************
+* Global Function Declarations
+******************************************************************************/
+void *pvPortMalloc(size_t xWantedSize);
+void vPortFree(void *pv);
+size_t xPortGetFreeHeapSize(void);
+size_t xPortGetMinimumEverFreeHeapSize(void);
+void vPortInitialiseBlocks(void);
@@ -0,0 +1,91 @@
+/**************************************************************************//**
+* @file      HostStubs.c
+* @brief     Host stand-ins for the WINC1500 socket API, the software timer and configASSERT
+* @details   Lets iot/http/http_client.c link on Linux. There is no network: sockets cannot be opened and
+*			 every transfer fails, so only the parser paths fed by the host tools run. The names are those of
+*			 the WINC1500 driver, which hides the libc functions of the same names from the firmware code.
+* @author
+* @date      2026-10-17
+
+******************************************************************************/
+
+
+/******************************************************************************
+* Includes
+******************************************************************************/
+#include "socket/include/socket.h"
+#include "driver/include/m2m_wifi.h"
+#include "iot/sw_timer.h"
+#include "FreeRTOS.h"
+
+/******************************************************************************
+* FreeRTOS
+******************************************************************************/
+unsigned long HostAssertFailures;
+
+/******************************************************************************
+* WINC1500 Socket API
+******************************************************************************/
+SOCKET socket(uint16 u16Domain, uint8 u8Type, uint8 u8Flags)
+{
+	return SOCK_ERR_INVALID;
+}
+
+sint8 connect(SOCKET sock, struct sockaddr *pstrAddr, uint8 u8AddrLen)
+{
+	return SOCK_ERR_INVALID;
+}
+
+sint16 recv(SOCKET sock, void *pvRecvBuf, uint16 u16BufLen, uint32 u32Timeoutmsec)
+{
+	return SOCK_ERR_INVALID;
+}
+
+sint16 send(SOCKET sock, void *pvSendBuffer, uint16 u16SendLength, uint16 u16Flags)
+{
+	return SOCK_ERR_INVALID;
+}
+
+sint8 close(SOCKET sock)
+{
+	return SOCK_ERR_NO_ERROR;
+}
+
+uint32 nmi_inet_addr(char *pcIpAddr)
+{
+	return 0;
+}
+
+sint8 gethostbyname(uint8 *pcHostName)
+{
+	return SOCK_ERR_INVALID;
+}
+
+sint8 m2m_wifi_handle_events(void *arg)
+{
+	return M2M_SUCCESS;
+}
+
+void nm_bsp_wait_for_event(uint32 u32TimeoutMsec)
+{
+}
+
+/******************************************************************************
+* Software Timer
+******************************************************************************/
+int sw_timer_register_callback(struct sw_timer_module *const module_inst, sw_timer_callback_t callback, void *context, uint32_t period)
+{
+	return -1;
+}
+
+void sw_timer_enable_callback(struct sw_timer_module *const module_inst, int timer_id, uint32_t delay)
+{
+}
+
+void sw_timer_disable_callback(struct sw_timer_module *const module_inst, int timer_id)
+{
+}
+
+void sw_timer_task(struct sw_timer_module *const module_inst)
+{
+}
@@ -0,0 +1,18 @@
+/**************************************************************************//**
+* @file      asf.h
+* @brief     Host stand-in for the ASF umbrella header
+* @details   The firmware modules built by the host tools include asf.h only for the standard types. Put this
+*			 folder first on the include path.
+* @author
+* @date      2026-10-17
+
+******************************************************************************/
+
+#pragma once
+
+/******************************************************************************
+* Includes
+******************************************************************************/
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
@@ -0,0 +1,19 @@
+/**************************************************************************//**
+* @file      compiler.h
+* @brief     Host stand-in for the ASF compiler.h
+* @details   The ASF header needs the device headers. The firmware sources built by the host tools only need
+*			 the standard types and the status codes from it. Put this folder first on the include path.
+* @author
+* @date      2026-10-17
+
+******************************************************************************/
+
+#pragma once
+
+/******************************************************************************
+* Includes
+******************************************************************************/
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <status_codes.h>
@@ -0,0 +1,25 @@
+/**************************************************************************//**
+* @file      task.h
+* @brief     Host stand-in for the FreeRTOS task header
+* @details   The host tools run one thread, so suspending the scheduler and critical sections do nothing.
+* @author
+* @date      2026-10-17
+
+******************************************************************************/
+
+#pragma once
+
+/******************************************************************************
+* Includes
+******************************************************************************/
+#include "FreeRTOS.h"
+
+/******************************************************************************
+* Defines
+******************************************************************************/
+#define vTaskSuspendAll()
+#define xTaskResumeAll()						pdFALSE
+#define taskENTER_CRITICAL()
+#define taskEXIT_CRITICAL()
+#define taskENTER_CRITICAL_FROM_ISR()			((UBaseType_t)0)
+#define taskEXIT_CRITICAL_FROM_ISR(uxSaved)	((void)(uxSaved))
@@ -0,0 +1,649 @@
+/**************************************************************************//**
+* @file      logdecode.c
+* @brief     Turns the binary log frames of the main firmware back into text
+* @details   With "logmode binary", LogMessage sends the flash address of its format string and the raw
+*			 arguments instead of the text (WINC1500_HTTP_DOWNLOADER/src/SerialConsole/LogFormat.h). This tool
+*			 reads the console stream, looks each address up in the loaded sections of the firmware ELF file
+*			 and formats the message on the host. Everything that is not a valid frame (CLI replies, echo, text
+*			 log messages) is passed through unchanged. Frames lost on a full TX buffer show up as gaps in the
+*			 sequence numbers and are reported inline.
+*
+*			 The ELF file must come from the same build as the running firmware.
+*
+*			 Usage:
+*				logdecode [-l] <firmware.elf> [capture.bin]		decodes the capture, or stdin
+*				stty -F /dev/ttyACM0 115200 raw && logdecode -l "ESE516 MAIN FW.elf" < /dev/ttyACM0
+*				logdecode -t									checks the encoder against vsnprintf
+*
+*			 -l prefixes every decoded message with its log level.
+*
+*			 Build (from this folder):
+*				gcc -O2 -Wall -o logdecode logdecode.c ../WINC1500_HTTP_DOWNLOADER/src/SerialConsole/LogEncoder.c
+* @author
+* @date      2026-10-17
+
+******************************************************************************/
+
+
+/******************************************************************************
+* Includes
+******************************************************************************/
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../WINC1500_HTTP_DOWNLOADER/src/SerialConsole/LogEncoder.h"
+
+/******************************************************************************
+* Defines
+******************************************************************************/
+#define SHT_PROGBITS	1
+#define SHF_ALLOC		2
+#define MAX_SECTIONS	64
+#define TEXT_MAX		1024	///< Longest decoded message
+
+/******************************************************************************
+* Structures and Enumerations
+******************************************************************************/
+/// Loaded section of the ELF file, where format strings can live
+struct Section {
+	uint32_t address;
+	uint32_t size;
+	const uint8_t *data;
+};
+
+struct Strings {
+	struct Section sections[MAX_SECTIONS];
+	int count;
+};
+
+/// Format strings of the self test, found by the low 32 bits of their host address
+struct TestStrings {
+	const char *const *formats;
+	int count;
+};
+
+typedef const char *(*LookupFunction)(const void *context, uint32_t id);
+
+static const char *const levelNames[] = {"INFO", "DEBUG", "WARN", "ERROR", "FATAL"};
+
+/******************************************************************************
+* Static Functions
+******************************************************************************/
+static uint8_t *ReadFile(const char *path, size_t *len)
+{
+	FILE *f = fopen(path, "rb");
+	uint8_t *data = NULL;
+	long size;
+
+	if (f == NULL)
+	{
+		return NULL;
+	}
+	if (fseek(f, 0, SEEK_END) == 0 && (size = ftell(f)) >= 0 && fseek(f, 0, SEEK_SET) == 0)
+	{
+		data = malloc((size_t)size + 1);
+		if (data != NULL && fread(data, 1, (size_t)size, f) != (size_t)size)
+		{
+			free(data);
+			data = NULL;
+		}
+		*len = (size_t)size;
+	}
+	fclose(f);
+	return data;
+}
+
+static uint32_t Le16(const uint8_t *p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+}
+
+static uint32_t Le32(const uint8_t *p)
+{
+	return Le16(p) | (Le16(p + 2) << 16);
+}
+
+static uint64_t Le64(const uint8_t *p)
+{
+	return (uint64_t)Le32(p) | ((uint64_t)Le32(p + 4) << 32);
+}
+
+/// Collects the loaded PROGBITS sections of a 32 bit little endian ELF file
+static int LoadElf(struct Strings *strings, const uint8_t *elf, size_t len)
+{
+	uint32_t shoff;
+	uint32_t shentsize;
+	uint32_t shnum;
+
+	if (len < 52 || memcmp(elf, "\177ELF", 4) != 0 || elf[4] != 1 || elf[5] != 1)
+	{
+		return -1;	// Not ELF, not 32 bit or not little endian
+	}
+	shoff = Le32(&elf[0x20]);
+	shentsize = Le16(&elf[0x2E]);
+	shnum = Le16(&elf[0x30]);
+	if (shentsize < 40 || shoff > len || shnum > (len - shoff) / shentsize)
+	{
+		return -1;
+	}
+
+	strings->count = 0;
+	for (uint32_t i = 0; i < shnum && strings->count < MAX_SECTIONS; i++)
+	{
+		const uint8_t *sh = &elf[shoff + i * shentsize];
+		uint32_t offset = Le32(&sh[16]);
+		uint32_t size = Le32(&sh[20]);
+
+		if (Le32(&sh[4]) != SHT_PROGBITS || (Le32(&sh[8]) & SHF_ALLOC) == 0 || size == 0 || offset > len || size > len - offset)
+		{
+			continue;
+		}
+		strings->sections[strings->count].address = Le32(&sh[12]);
+		strings->sections[strings->count].size = size;
+		strings->sections[strings->count].data = &elf[offset];
+		strings->count++;
+	}
+	return strings->count > 0 ? 0 : -1;
+}
+
+/// Returns the NUL terminated string at a target address, or NULL
+static const char *LookupElf(const void *context, uint32_t id)
+{
+	const struct Strings *strings = context;
+
+	for (int i = 0; i < strings->count; i++)
+	{
+		const struct Section *s = &strings->sections[i];
+
+		if (id >= s->address && id - s->address < s->size)
+		{
+			uint32_t start = id - s->address;
+			return memchr(&s->data[start], 0, s->size - start) != NULL ? (const char *)&s->data[start] : NULL;
+		}
+	}
+	return NULL;
+}
+
+static const char *LookupTest(const void *context, uint32_t id)
+{
+	const struct TestStrings *strings = context;
+
+	for (int i = 0; i < strings->count; i++)
+	{
+		if ((uint32_t)(uintptr_t)strings->formats[i] == id)
+		{
+			return strings->formats[i];
+		}
+	}
+	return NULL;
+}
+
+/// Appends to text, never past TEXT_MAX
+static void Append(char *text, size_t *pos, const char *spec, ...)
+{
+	va_list ap;
+	int n;
+
+	va_start(ap, spec);
+	n = vsnprintf(&text[*pos], TEXT_MAX - *pos, spec, ap);
+	va_end(ap);
+	if (n > 0)
+	{
+		*pos += (size_t)n < TEXT_MAX - *pos ? (size_t)n : TEXT_MAX - 1 - *pos;
+	}
+}
+
+/// Formats the payload of a frame with its format string, the way the target's vsnprintf would
+/// Returns -1 if the payload does not match the format
+static int FormatPayload(char *text, const char *format, const uint8_t *payload, size_t len)
+{
+	const uint8_t *in = payload;
+	const uint8_t *end = payload + len;
+	size_t pos = 0;
+	const char *p = format;
+
+	text[0] = '\0';
+	while (*p != '\0')
+	{
+		char spec[48];
+		size_t specLen = 1;
+		int longs = 0;
+		int halves = 0;
+		int wide = 0;
+		char conversion;
+
+		if (*p != '%')
+		{
+			const char *next = strchr(p, '%');
+			size_t n = next != NULL ? (size_t)(next - p) : strlen(p);
+			Append(text, &pos, "%.*s", (int)n, p);
+			p += n;
+			continue;
+		}
+		p++;
+		if (*p == '%')
+		{
+			Append(text, &pos, "%%");
+			p++;
+			continue;
+		}
+
+		// Rebuild the conversion for the host: width and precision given by * are spelled out
+		spec[0] = '%';
+		while (*p != '\0' && strchr("-+ #0'", *p) != NULL && specLen < 8)
+		{
+			spec[specLen++] = *p++;
+		}
+		for (int part = 0; part < 2; part++)
+		{
+			if (*p == '*')
+			{
+				if (end - in < 4)
+				{
+					return -1;
+				}
+				specLen += (size_t)snprintf(&spec[specLen], sizeof(spec) - specLen, "%d", (int32_t)Le32(in));
+				in += 4;
+				p++;
+			}
+			else
+			{
+				while (*p >= '0' && *p <= '9' && specLen < 24)
+				{
+					spec[specLen++] = *p++;
+				}
+			}
+			if (part == 0 && *p == '.')
+			{
+				spec[specLen++] = *p++;
+			}
+			else
+			{
+				break;
+			}
+		}
+		for (;; p++)
+		{
+			if (*p == 'l')
+			{
+				longs++;
+			}
+			else if (*p == 'h')
+			{
+				halves++;
+			}
+			else if (*p == 'j')
+			{
+				wide = 1;
+			}
+			else if (*p != 'z' && *p != 't' && *p != 'L')
+			{
+				break;
+			}
+		}
+		wide |= (longs >= 2);
+		conversion = *p++;
+		spec[specLen] = '\0';
+
+		switch (conversion)
+		{
+			case 'd':
+			case 'i':
+			case 'o':
+			case 'u':
+			case 'x':
+			case 'X':
+			{
+				int isSigned = (conversion == 'd' || conversion == 'i');
+				unsigned long long value;
+
+				if (end - in < (wide ? 8 : 4))
+				{
+					return -1;
+				}
+				if (wide)
+				{
+					value = Le64(in);
+					in += 8;
+				}
+				else
+				{
+					uint32_t raw = Le32(in);
+					in += 4;
+					if (halves == 1)
+					{
+						value = isSigned ? (unsigned long long)(long long)(int16_t)raw : (uint16_t)raw;
+					}
+					else if (halves >= 2)
+					{
+						value = isSigned ? (unsigned long long)(long long)(int8_t)raw : (uint8_t)raw;
+					}
+					else
+					{
+						value = isSigned ? (unsigned long long)(long long)(int32_t)raw : raw;
+					}
+				}
+				spec[specLen] = 'l';
+				spec[specLen + 1] = 'l';
+				spec[specLen + 2] = conversion;
+				spec[specLen + 3] = '\0';
+				if (isSigned)
+				{
+					Append(text, &pos, spec, (long long)value);
+				}
+				else
+				{
+					Append(text, &pos, spec, value);
+				}
+				break;
+			}
+
+			case 'c':
+			case 'p':
+				if (end - in < 4)
+				{
+					return -1;
+				}
+				if (conversion == 'c')
+				{
+					strcpy(&spec[specLen], "c");
+					Append(text, &pos, spec, (int)Le32(in));
+				}
+				else
+				{
+					Append(text, &pos, "0x%lx", (unsigned long)Le32(in));
+				}
+				in += 4;
+				break;
+
+			case 'a':
+			case 'A':
+			case 'e':
+			case 'E':
+			case 'f':
+			case 'F':
+			case 'g':
+			case 'G':
+			{
+				uint64_t bits;
+				double value;
+
+				if (end - in < 8)
+				{
+					return -1;
+				}
+				bits = Le64(in);
+				in += 8;
+				memcpy(&value, &bits, sizeof(value));
+				spec[specLen] = conversion;
+				spec[specLen + 1] = '\0';
+				Append(text, &pos, spec, value);
+				break;
+			}
+
+			case 's':
+			{
+				char string[LOG_STRING_MAX + 1];
+
+				if (end - in < 1 || in[0] > LOG_STRING_MAX || end - in - 1 < in[0])
+				{
+					return -1;
+				}
+				memcpy(string, &in[1], in[0]);
+				string[in[0]] = '\0';
+				in += 1 + in[0];
+				strcpy(&spec[specLen], "s");
+				Append(text, &pos, spec, string);
+				break;
+			}
+
+			case 'n':
+				break;
+
+			default:
+				return -1;	// The target never packs these
+		}
+	}
+	return in == end ? 0 : -1;
+}
+
+/// Checks a complete frame and formats it. Returns -1 if it is not a valid frame
+static int DecodeFrame(char *text, const uint8_t *frame, LookupFunction lookup, const void *context)
+{
+	size_t len = frame[1];
+	uint8_t sum = 0;
+	const char *format;
+
+	for (size_t i = 1; i < LOG_FRAME_HEADER_SIZE + len; i++)
+	{
+		sum += frame[i];
+	}
+	sum = (uint8_t)~sum;
+	if (sum != frame[LOG_FRAME_HEADER_SIZE + len])
+	{
+		return -1;
+	}
+	format = lookup(context, Le32(&frame[4]));
+	if (format == NULL)
+	{
+		return -1;
+	}
+	return FormatPayload(text, format, &frame[LOG_FRAME_HEADER_SIZE], len);
+}
+
+/// Decodes a console stream: frames are formatted, everything else is copied through
+static void DecodeStream(FILE *in, LookupFunction lookup, const void *context, int showLevel)
+{
+	uint8_t frame[LOG_FRAME_MAX_SIZE];
+	uint8_t pushback[LOG_FRAME_MAX_SIZE];
+	size_t have = 0;
+	size_t pushed = 0;
+	int nextSequence = -1;
+	unsigned long decoded = 0;
+	unsigned long lost = 0;
+
+	for (;;)
+	{
+		int c;
+
+		if (pushed > 0)
+		{
+			c = pushback[--pushed];
+		}
+		else if ((c = getc(in)) == EOF)
+		{
+			break;
+		}
+
+		if (have == 0 && c != LOG_FRAME_SYNC)
+		{
+			putchar(c);
+			continue;
+		}
+		frame[have++] = (uint8_t)c;
+		if (have >= 2 && frame[1] > LOG_FRAME_MAX_PAYLOAD)
+		{
+			// Length out of range: not a frame
+		}
+		else if (have < 2 || have < LOG_FRAME_HEADER_SIZE + (size_t)frame[1] + 1)
+		{
+			continue;
+		}
+		else
+		{
+			char text[TEXT_MAX];
+
+			if (DecodeFrame(text, frame, lookup, context) == 0)
+			{
+				if (nextSequence >= 0 && frame[3] != (uint8_t)nextSequence)
+				{
+					unsigned gap = (uint8_t)(frame[3] - nextSequence);
+					printf("<%u log frames lost>\r\n", gap);
+					lost += gap;
+				}
+				nextSequence = (uint8_t)(frame[3] + 1);
+				if (showLevel)
+				{
+					printf("[%s] ", frame[2] < sizeof(levelNames) / sizeof(levelNames[0]) ? levelNames[frame[2]] : "?");
+				}
+				fputs(text, stdout);
+				decoded++;
+				have = 0;
+				continue;
+			}
+		}
+
+		// Not a frame: the sync byte was text, the bytes after it are scanned again
+		putchar(frame[0]);
+		while (have > 1)
+		{
+			pushback[pushed++] = frame[--have];
+		}
+		have = 0;
+	}
+	for (size_t i = 0; i < have; i++)
+	{
+		putchar(frame[i]);	// Incomplete frame at the end of the input
+	}
+	fflush(stdout);
+	fprintf(stderr, "logdecode: %lu messages decoded, %lu lost\n", decoded, lost);
+}
+
+static size_t PackTest(uint8_t *frame, char *expected, uint8_t sequence, const char *format, ...)
+{
+	va_list ap;
+	size_t len;
+
+	va_start(ap, format);
+	vsnprintf(expected, TEXT_MAX, format, ap);
+	va_end(ap);
+	va_start(ap, format);
+	len = LogEncoderPack(frame, 1, sequence, format, ap);
+	va_end(ap);
+	return len;
+}
+
+/// Round trips messages through LogEncoderPack and DecodeFrame and compares with vsnprintf
+static int SelfTest(void)
+{
+	static const char *const formats[] = {
+		"Plain text\r\n",
+		"%d %i %u %x %X %o %%\r\n",
+		"%5d|%-5d|%05u|%+d|% d|%#x\r\n",
+		"%hd %hu %hhd %hhu\r\n",
+		"%ld %lu %lx %zu\r\n",
+		"%lld %llu %llx\r\n",
+		"%c%c%c\r\n",
+		"%s and %.*s, %10s|%-10s|\r\n",
+		"%*d|%-*d|%.*d\r\n",
+		"%f %.2f %e %g\r\n",
+		"%p\r\n",
+		"Long string %s\r\n",
+		"Too much %s %s %s %s\r\n",
+		"Bad %k\r\n",
+	};
+	const char *long32 = "0123456789abcdefghijklmnopqrstuvwxyz";
+	struct TestStrings strings = {formats, (int)(sizeof(formats) / sizeof(formats[0]))};
+	uint8_t frame[LOG_FRAME_MAX_SIZE];
+	char expected[TEXT_MAX];
+	char text[TEXT_MAX];
+	size_t lens[sizeof(formats) / sizeof(formats[0])];
+	int failed = 0;
+
+	for (int i = 0; i < strings.count; i++)
+	{
+		switch (i)
+		{
+			case 0:	lens[i] = PackTest(frame, expected, i, formats[i]); break;
+			case 1:	lens[i] = PackTest(frame, expected, i, formats[i], -42, 7, 3000000000u, 0xBEEF, 0xBEEF, 8); break;
+			case 2:	lens[i] = PackTest(frame, expected, i, formats[i], 42, -42, 42u, 42, 42, 255); break;
+			case 3:	lens[i] = PackTest(frame, expected, i, formats[i], (short)-2, (unsigned short)65535, (signed char)-3, (unsigned char)250); break;
+			case 4:	lens[i] = PackTest(frame, expected, i, formats[i], -100000L, 4000000000UL, 0xDEADL, (size_t)512); break;
+			case 5:	lens[i] = PackTest(frame, expected, i, formats[i], -1234567890123LL, 18446744073709551615ULL, 0x123456789ABCULL); break;
+			case 6:	lens[i] = PackTest(frame, expected, i, formats[i], 'a', 'b', 'c'); break;
+			case 7:	lens[i] = PackTest(frame, expected, i, formats[i], "one", 3, "twofold", "right", "left"); break;
+			case 8:	lens[i] = PackTest(frame, expected, i, formats[i], 6, 42, 6, -42, 4, 7); break;
+			case 9:	lens[i] = PackTest(frame, expected, i, formats[i], 3.25, -0.125, 12345.678, 1e-5); break;
+			case 10: lens[i] = PackTest(frame, expected, i, formats[i], (void *)(uintptr_t)0x20001234u); break;
+			case 11: lens[i] = PackTest(frame, expected, i, formats[i], long32); break;
+			case 12: lens[i] = PackTest(frame, expected, i, formats[i], long32, long32, long32, long32); break;
+			default: lens[i] = PackTest(frame, expected, i, formats[i], 1); break;
+		}
+
+		if (i == 11)
+		{
+			snprintf(expected, TEXT_MAX, formats[i], "0123456789abcdefghijklmnopqrstuv");	// Cut to LOG_STRING_MAX
+		}
+		if (i >= 12)
+		{
+			// Expected to fall back to text: payload too long, unknown conversion
+			if (lens[i] != 0)
+			{
+				printf("FAIL %-36s packed %zu bytes, expected text fallback\n", formats[i], lens[i]);
+				failed = 1;
+			}
+			continue;
+		}
+		if (lens[i] == 0 || DecodeFrame(text, frame, LookupTest, &strings) != 0 || frame[3] != (uint8_t)i || strcmp(text, expected) != 0)
+		{
+			printf("FAIL %-36s expected \"%s\"\n", formats[i], expected);
+			failed = 1;
+			continue;
+		}
+		text[strcspn(text, "\r\n")] = '\0';
+		printf("ok   %2zu bytes  %s\n", lens[i], text);
+	}
+
+	printf(failed ? "self test FAILED\n" : "self test passed\n");
+	return failed;
+}
+
+/******************************************************************************
+* Global Functions
+******************************************************************************/
+int main(int argc, char **argv)
+{
+	struct Strings strings;
+	uint8_t *elf;
+	size_t elfLen = 0;
+	FILE *in = stdin;
+	int showLevel = 0;
+	int first = 1;
+
+	if (argc == 2 && strcmp(argv[1], "-t") == 0)
+	{
+		return SelfTest();
+	}
+	if (argc > 1 && strcmp(argv[1], "-l") == 0)
+	{
+		showLevel = 1;
+		first = 2;
+	}
+	if (first >= argc || argc - first > 2)
+	{
+		fprintf(stderr, "usage: %s [-l] <firmware.elf> [capture.bin]\n       %s -t\n", argv[0], argv[0]);
+		return 2;
+	}
+
+	elf = ReadFile(argv[first], &elfLen);
+	if (elf == NULL || LoadElf(&strings, elf, elfLen) != 0)
+	{
+		fprintf(stderr, "%s: not a 32 bit little endian ELF file\n", argv[first]);
+		return 1;
+	}
+	if (argc - first == 2 && (in = fopen(argv[first + 1], "rb")) == NULL)
+	{
+		fprintf(stderr, "cannot open %s\n", argv[first + 1]);
+		return 1;
+	}
+
+	setvbuf(stdout, NULL, _IOLBF, 0);
+	DecodeStream(in, LookupElf, &strings, showLevel);
+	if (in != stdin)
+	{
+		fclose(in);
+	}
+	free(elf);
+	return 0;
+}
@@ -0,0 +1,198 @@
+/**************************************************************************//**
+* @file      lzbench.c
+* @brief     Reports compression ratio and decompression throughput of the LZ image format
+* @details   Every file is compressed with LzEncoder, then decompressed repeatedly with the bootloader's
+*			 LzDecoder. The decoder is driven the same way as on target: 64 byte fills from the input and
+*			 one 256 byte NVM row per read. The round trip is checked byte for byte.
+*
+*			 Usage:
+*				lzbench [-n iterations] <file.bin>...
+*				lzbench "../Bootloader Test Binaries/TestA.bin" "../Bootloader Test Binaries/TestB.bin"
+*
+*			 Build (from this folder):
+*				gcc -O2 -Wall -o lzbench lzbench.c LzEncoder.c ../SD_MMC_Bootloader/src/Lz/LzDecoder.c
+* @author
+* @date      2026-10-17
+
+******************************************************************************/
+
+
+/******************************************************************************
+* Includes
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "LzEncoder.h"
+#include "../SD_MMC_Bootloader/src/Lz/LzDecoder.h"
+
+/******************************************************************************
+* Defines
+******************************************************************************/
+#define ROW_SIZE			256		///< NVM row size of the SAMD21. The bootloader decodes one row at a time
+#define DEFAULT_ITERATIONS	200
+
+/******************************************************************************
+* Structures and Enumerations
+******************************************************************************/
+struct MemorySource {
+	const uint8_t *data;
+	size_t len;
+	size_t pos;
+};
+
+/******************************************************************************
+* Static Functions
+******************************************************************************/
+static double NowSeconds(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint8_t *ReadFile(const char *path, size_t *len)
+{
+	FILE *f = fopen(path, "rb");
+	uint8_t *data = NULL;
+	long size;
+
+	if (f == NULL)
+	{
+		return NULL;
+	}
+	if (fseek(f, 0, SEEK_END) == 0 && (size = ftell(f)) >= 0 && fseek(f, 0, SEEK_SET) == 0)
+	{
+		data = malloc((size_t)size + 1);
+		if (data != NULL && fread(data, 1, (size_t)size, f) != (size_t)size)
+		{
+			free(data);
+			data = NULL;
+		}
+		*len = (size_t)size;
+	}
+	fclose(f);
+	return data;
+}
+
+static size_t MemoryFill(void *context, uint8_t *buffer, size_t length)
+{
+	struct MemorySource *src = context;
+	size_t n = src->len - src->pos;
+
+	if (n > length)
+	{
+		n = length;
+	}
+	memcpy(buffer, &src->data[src->pos], n);
+	src->pos += n;
+	return n;
+}
+
+/// Decodes a payload row by row into output. Returns 0 on success
+static int DecodeRows(struct LzDecoder *decoder, const uint8_t *payload, size_t payloadLen, uint8_t *output, size_t rawLen)
+{
+	struct MemorySource src = { payload, payloadLen, 0 };
+	size_t done = 0;
+
+	LzDecoder_Init(decoder, (uint32_t)rawLen, MemoryFill, &src);
+	while (done < rawLen)
+	{
+		int32_t n = LzDecoder_Read(decoder, &output[done], ROW_SIZE);
+		if (n <= 0)
+		{
+			return -1;
+		}
+		done += (size_t)n;
+	}
+	return 0;
+}
+
+static int BenchFile(const char *path, unsigned iterations)
+{
+	static struct LzDecoder decoder;
+	size_t rawLen = 0;
+	uint8_t *raw = ReadFile(path, &rawLen);
+	uint8_t *payload;
+	uint8_t *output;
+	size_t bound;
+	size_t packed;
+	double t0, compressTime, decodeTime;
+
+	if (raw == NULL)
+	{
+		fprintf(stderr, "could not read %s\n", path);
+		return -1;
+	}
+
+	bound = LZ_ENCODER_BOUND(rawLen);
+	payload = malloc(bound + 1);
+	output = malloc(rawLen + 1);
+	if (payload == NULL || output == NULL)
+	{
+		free(raw);
+		free(payload);
+		free(output);
+		return -1;
+	}
+
+	t0 = NowSeconds();
+	packed = LzEncoder_Compress(raw, rawLen, payload, bound, LZ_ENCODER_MAX_CHAIN);
+	compressTime = NowSeconds() - t0;
+
+	t0 = NowSeconds();
+	for (unsigned i = 0; i < iterations; i++)
+	{
+		if (DecodeRows(&decoder, payload, packed, output, rawLen) != 0)
+		{
+			fprintf(stderr, "%s: decode failed\n", path);
+			free(raw);
+			free(payload);
+			free(output);
+			return -1;
+		}
+	}
+	decodeTime = (NowSeconds() - t0) / iterations;
+
+	int match = memcmp(raw, output, rawLen) == 0;
+	printf("%-40s %8zu %8zu %7.1f%% %10.1f %10.1f  %s\n", path, rawLen, packed + LZ_HEADER_SIZE,
+		rawLen ? 100.0 * (double)(packed + LZ_HEADER_SIZE) / (double)rawLen : 0.0,
+		compressTime > 0 ? (double)rawLen / compressTime / 1e6 : 0.0,
+		decodeTime > 0 ? (double)rawLen / decodeTime / 1e6 : 0.0,
+		match ? "ok" : "MISMATCH");
+
+	free(raw);
+	free(payload);
+	free(output);
+	return match ? 0 : -1;
+}
+
+/******************************************************************************
+* Global Functions
+******************************************************************************/
+int main(int argc, char **argv)
+{
+	unsigned iterations = DEFAULT_ITERATIONS;
+	int first = 1;
+	int failed = 0;
+
+	if (argc > 2 && strcmp(argv[1], "-n") == 0)
+	{
+		iterations = (unsigned)strtoul(argv[2], NULL, 0);
+		first = 3;
+	}
+	if (first >= argc || iterations == 0)
+	{
+		fprintf(stderr, "usage: %s [-n iterations] <file.bin>...\n", argv[0]);
+		return 2;
+	}
+
+	printf("LZ window %u bytes, decoder state %zu bytes\n", LZ_WINDOW_SIZE, sizeof(struct LzDecoder));
+	printf("%-40s %8s %8s %8s %10s %10s\n", "file", "raw", "packed", "ratio", "comp MB/s", "dec MB/s");
+	for (int i = first; i < argc; i++)
+	{
+		failed |= BenchFile(argv[i], iterations) != 0;
+	}
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,189 @@
+/**************************************************************************//**
+* @file      lzpack.c
+* @brief     Packs a raw firmware binary into the LZ compressed image container read by the bootloader
+* @details   Usage:
+*				lzpack <input.bin> <output.bin>		Compress. The output can be copied to the SD card as TestA.bin / TestB.bin
+*				lzpack -d <input.bin> <output.bin>	Decompress, using the same decoder as the bootloader
+*
+*			 Build (from this folder):
+*				gcc -O2 -Wall -o lzpack lzpack.c LzEncoder.c ../SD_MMC_Bootloader/src/Lz/LzDecoder.c
+* @author
+* @date      2026-10-17
+
+******************************************************************************/
+
+
+/******************************************************************************
+* Includes
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "LzEncoder.h"
+#include "../SD_MMC_Bootloader/src/Lz/LzDecoder.h"
+
+/******************************************************************************
+* Structures and Enumerations
+******************************************************************************/
+/// Memory source for the decoder fill callback
+struct MemorySource {
+	const uint8_t *data;
+	size_t len;
+	size_t pos;
+};
+
+/******************************************************************************
+* Static Functions
+******************************************************************************/
+static uint8_t *ReadFile(const char *path, size_t *len)
+{
+	FILE *f = fopen(path, "rb");
+	uint8_t *data = NULL;
+	long size;
+
+	if (f == NULL)
+	{
+		return NULL;
+	}
+	if (fseek(f, 0, SEEK_END) == 0 && (size = ftell(f)) >= 0 && fseek(f, 0, SEEK_SET) == 0)
+	{
+		data = malloc((size_t)size + 1);
+		if (data != NULL && fread(data, 1, (size_t)size, f) != (size_t)size)
+		{
+			free(data);
+			data = NULL;
+		}
+		*len = (size_t)size;
+	}
+	fclose(f);
+	return data;
+}
+
+static int WriteFile(const char *path, const uint8_t *data, size_t len)
+{
+	FILE *f = fopen(path, "wb");
+	int ok;
+
+	if (f == NULL)
+	{
+		return -1;
+	}
+	ok = fwrite(data, 1, len, f) == len;
+	ok &= fclose(f) == 0;
+	return ok ? 0 : -1;
+}
+
+static size_t MemoryFill(void *context, uint8_t *buffer, size_t length)
+{
+	struct MemorySource *src = context;
+	size_t n = src->len - src->pos;
+
+	if (n > length)
+	{
+		n = length;
+	}
+	memcpy(buffer, &src->data[src->pos], n);
+	src->pos += n;
+	return n;
+}
+
+static int Pack(const uint8_t *input, size_t inputLen, const char *outPath)
+{
+	size_t bound = LZ_HEADER_SIZE + LZ_ENCODER_BOUND(inputLen);
+	uint8_t *output = malloc(bound);
+	struct LzHeader header;
+	size_t packed;
+
+	if (output == NULL)
+	{
+		return -1;
+	}
+	packed = LzEncoder_Compress(input, inputLen, &output[LZ_HEADER_SIZE], bound - LZ_HEADER_SIZE, LZ_ENCODER_MAX_CHAIN);
+	if (packed == 0 && inputLen != 0)
+	{
+		free(output);
+		return -1;
+	}
+
+	header.magic = LZ_MAGIC;
+	header.rawSize = (uint32_t)inputLen;
+	header.packedSize = (uint32_t)packed;
+	header.windowBits = LZ_WINDOW_BITS;
+	LzFormat_WriteHeader(output, &header);
+
+	printf("%zu -> %zu bytes (%.1f%%)\n", inputLen, packed + LZ_HEADER_SIZE, inputLen ? 100.0 * (double)(packed + LZ_HEADER_SIZE) / (double)inputLen : 0.0);
+	int ret = WriteFile(outPath, output, packed + LZ_HEADER_SIZE);
+	free(output);
+	return ret;
+}
+
+static int Unpack(const uint8_t *input, size_t inputLen, const char *outPath)
+{
+	static struct LzDecoder decoder;
+	struct LzHeader header;
+	struct MemorySource src;
+	uint8_t *output;
+
+	if (inputLen < LZ_HEADER_SIZE || LzFormat_ParseHeader(input, &header) != 0 || header.packedSize > inputLen - LZ_HEADER_SIZE)
+	{
+		fprintf(stderr, "not an LZ image\n");
+		return -1;
+	}
+
+	output = malloc(header.rawSize + 1);
+	if (output == NULL)
+	{
+		return -1;
+	}
+	src.data = &input[LZ_HEADER_SIZE];
+	src.len = header.packedSize;
+	src.pos = 0;
+	LzDecoder_Init(&decoder, header.rawSize, MemoryFill, &src);
+	if (LzDecoder_Read(&decoder, output, header.rawSize) != (int32_t)header.rawSize)
+	{
+		fprintf(stderr, "corrupt payload\n");
+		free(output);
+		return -1;
+	}
+
+	int ret = WriteFile(outPath, output, header.rawSize);
+	free(output);
+	return ret;
+}
+
+/******************************************************************************
+* Global Functions
+******************************************************************************/
+int main(int argc, char **argv)
+{
+	int decompress = argc == 4 && strcmp(argv[1], "-d") == 0;
+	const char *inPath;
+	const char *outPath;
+	uint8_t *input;
+	size_t inputLen = 0;
+	int ret;
+
+	if (argc != 3 && !decompress)
+	{
+		fprintf(stderr, "usage: %s [-d] <input> <output>\n", argv[0]);
+		return 2;
+	}
+	inPath = argv[argc - 2];
+	outPath = argv[argc - 1];
+
+	input = ReadFile(inPath, &inputLen);
+	if (input == NULL)
+	{
+		fprintf(stderr, "could not read %s\n", inPath);
+		return 1;
+	}
+
+	ret = decompress ? Unpack(input, inputLen, outPath) : Pack(input, inputLen, outPath);
+	free(input);
+	if (ret != 0)
+	{
+		fprintf(stderr, "could not create %s\n", outPath);
+		return 1;
+	}
+	return 0;
+}
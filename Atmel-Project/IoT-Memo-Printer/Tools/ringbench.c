@@ -0,0 +1,441 @@
+/**************************************************************************//**
+* @file      ringbench.c
+* @brief     Benchmarks and stress tests the serial console ring (SerialConsole/circular_buffer.c)
+* @details   The benchmark pushes log-line sized chunks through a 512 byte ring and drains it again, on one
+*			 thread, with:
+*				old			the previous ring, copied below, one byte per call with a modulo per index step
+*				byte		the new ring, one byte per call
+*				bulk		the new ring, circular_buf_put_n / circular_buf_get_n
+*				span		the new ring, circular_buf_reserve / commit and circular_buf_peek / consume
+*
+*			 The stress test runs a producer and a consumer thread on one ring, each mixing the byte, bulk
+*			 and span calls with random lengths, and checks that the consumer sees the producer's pseudo
+*			 random byte stream unchanged. Small rings are used so the indexes wrap often. A side that finds
+*			 the ring full or empty yields, so the test also runs on a single core host.
+*
+*			 Usage:
+*				ringbench [-n megabytes] [-t seconds] [-r ringsize]
+*
+*			 Build (from this folder):
+*				gcc -O2 -Wall -pthread -o ringbench ringbench.c ../SD_MMC_Bootloader/src/SerialConsole/circular_buffer.c
+* @author
+* @date      2026-10-17
+
+******************************************************************************/
+
+
+/******************************************************************************
+* Includes
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sched.h>
+#include "../SD_MMC_Bootloader/src/SerialConsole/circular_buffer.h"
+
+/******************************************************************************
+* Defines
+******************************************************************************/
+#define BENCH_RING_SIZE		512		///< TX ring of the main firmware
+#define BENCH_CHUNK			80		///< Typical LogMessage line
+#define DEFAULT_MEGABYTES	64
+#define DEFAULT_SECONDS		5
+#define DEFAULT_STRESS_RING	64
+#define STRESS_MAX_CHUNK	96		///< Longer than the default stress ring, so bulk calls hit a full ring
+
+/******************************************************************************
+* Structures and Enumerations
+******************************************************************************/
+/// Previous ring, as it was in SerialConsole/circular_buffer.c (embeddedartistry, Phillips Johnston)
+struct OldRing {
+	uint8_t *buffer;
+	size_t head;
+	size_t tail;
+	size_t max;
+	bool full;
+};
+
+struct StressSide {
+	circular_buf_t *ring;
+	uint64_t bytes;		///< Bytes to move
+	uint64_t calls;		///< Calls that moved at least one byte
+	uint64_t stalls;	///< Calls that found the ring full (producer) or empty (consumer)
+	uint64_t errors;	///< Bytes that did not match the stream (consumer)
+	uint32_t seed;
+};
+
+/******************************************************************************
+* Static Functions
+******************************************************************************/
+static double NowSeconds(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint32_t XorShift(uint32_t *state)
+{
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return x;
+}
+
+/// Byte n of the stress stream
+static uint8_t StreamByte(uint64_t n)
+{
+	uint64_t x = n * 0x9E3779B97F4A7C15ULL;
+	return (uint8_t)(x >> 56);
+}
+
+static void OldAdvance(struct OldRing *cbuf)
+{
+	if (cbuf->full)
+	{
+		cbuf->tail = (cbuf->tail + 1) % cbuf->max;
+	}
+	cbuf->head = (cbuf->head + 1) % cbuf->max;
+	cbuf->full = (cbuf->head == cbuf->tail);
+}
+
+static void OldPut(struct OldRing *cbuf, uint8_t data)
+{
+	cbuf->buffer[cbuf->head] = data;
+	OldAdvance(cbuf);
+}
+
+static int OldGet(struct OldRing *cbuf, uint8_t *data)
+{
+	if (!cbuf->full && cbuf->head == cbuf->tail)
+	{
+		return -1;
+	}
+	*data = cbuf->buffer[cbuf->tail];
+	cbuf->full = false;
+	cbuf->tail = (cbuf->tail + 1) % cbuf->max;
+	return 0;
+}
+
+/// Moves total bytes through the ring in BENCH_CHUNK pieces with the given method. Returns a checksum of what came out
+static uint32_t BenchRun(int method, uint64_t total, const uint8_t *chunk)
+{
+	static uint8_t storage[BENCH_RING_SIZE];
+	static struct OldRing old;
+	static circular_buf_t ring;
+	uint8_t out[BENCH_CHUNK];
+	uint32_t sum = 0;
+	uint64_t moved;
+	size_t i;
+
+	old.buffer = storage;
+	old.max = sizeof(storage);
+	old.head = old.tail = 0;
+	old.full = false;
+	circular_buf_init(&ring, storage, sizeof(storage));
+
+	for (moved = 0; moved < total; moved += BENCH_CHUNK)
+	{
+		switch (method)
+		{
+		case 0:
+			for (i = 0; i < BENCH_CHUNK; i++)
+			{
+				OldPut(&old, chunk[i]);
+			}
+			for (i = 0; OldGet(&old, &out[i]) == 0; i++)
+			{
+			}
+			break;
+		case 1:
+			for (i = 0; i < BENCH_CHUNK; i++)
+			{
+				circular_buf_put(&ring, chunk[i]);
+			}
+			for (i = 0; circular_buf_get(&ring, &out[i]) == 0; i++)
+			{
+			}
+			break;
+		case 2:
+			circular_buf_put_n(&ring, chunk, BENCH_CHUNK);
+			circular_buf_get_n(&ring, out, BENCH_CHUNK);
+			break;
+		default:
+		{
+			uint8_t *span;
+			const uint8_t *readSpan;
+			size_t done = 0;
+			size_t length;
+
+			while (done < BENCH_CHUNK)
+			{
+				length = circular_buf_reserve(&ring, &span);
+				if (length > BENCH_CHUNK - done)
+				{
+					length = BENCH_CHUNK - done;
+				}
+				memcpy(span, &chunk[done], length);
+				circular_buf_commit(&ring, length);
+				done += length;
+			}
+			for (done = 0; (length = circular_buf_peek(&ring, &readSpan)) > 0; done += length)
+			{
+				memcpy(&out[done], readSpan, length);
+				circular_buf_consume(&ring, length);
+			}
+			break;
+		}
+		}
+		sum += out[moved % BENCH_CHUNK];
+	}
+	return sum;
+}
+
+static void Bench(uint64_t megabytes)
+{
+	static const char *names[] = { "old", "byte", "bulk", "span" };
+	uint8_t chunk[BENCH_CHUNK];
+	uint64_t total = megabytes << 20;
+	double baseline = 0.0;
+	int method;
+	size_t i;
+
+	for (i = 0; i < sizeof(chunk); i++)
+	{
+		chunk[i] = (uint8_t)(' ' + i % 95);
+	}
+
+	printf("Benchmark: %llu MB in %d byte chunks through a %d byte ring\n", (unsigned long long)megabytes, BENCH_CHUNK, BENCH_RING_SIZE);
+	for (method = 0; method < 4; method++)
+	{
+		double start = NowSeconds();
+		uint32_t sum = BenchRun(method, total, chunk);
+		double seconds = NowSeconds() - start;
+
+		if (method == 0)
+		{
+			baseline = seconds;
+		}
+		printf("  %-5s %8.1f MB/s %7.2f ns/byte %6.2fx   (sum %08X)\n", names[method], (double)megabytes / seconds,
+			seconds * 1e9 / (double)total, baseline / seconds, sum);
+		fflush(stdout);
+	}
+}
+
+static void *StressProducer(void *arg)
+{
+	struct StressSide *side = arg;
+	uint8_t data[STRESS_MAX_CHUNK];
+	uint64_t n = 0;
+
+	while (n < side->bytes)
+	{
+		uint32_t r = XorShift(&side->seed);
+		size_t want = 1 + (r >> 8) % STRESS_MAX_CHUNK;
+		size_t done = 0;
+		size_t i;
+
+		if (want > side->bytes - n)
+		{
+			want = (size_t)(side->bytes - n);
+		}
+		switch (r & 3)
+		{
+		case 0:
+			done = (circular_buf_put(side->ring, StreamByte(n)) == 0) ? 1 : 0;
+			break;
+		case 1:
+			for (i = 0; i < want; i++)
+			{
+				data[i] = StreamByte(n + i);
+			}
+			done = circular_buf_put_n(side->ring, data, want);
+			break;
+		default:
+		{
+			uint8_t *span;
+
+			done = circular_buf_reserve(side->ring, &span);
+			if (done > want)
+			{
+				done = want;
+			}
+			for (i = 0; i < done; i++)
+			{
+				span[i] = StreamByte(n + i);
+			}
+			circular_buf_commit(side->ring, done);
+			break;
+		}
+		}
+		if (done == 0)
+		{
+			side->stalls++;
+			sched_yield();	//Lets the other side run on a single core host
+		}
+		else
+		{
+			side->calls++;
+		}
+		n += done;
+	}
+	return NULL;
+}
+
+static void *StressConsumer(void *arg)
+{
+	struct StressSide *side = arg;
+	uint8_t data[STRESS_MAX_CHUNK];
+	uint64_t n = 0;
+
+	while (n < side->bytes)
+	{
+		uint32_t r = XorShift(&side->seed);
+		size_t want = 1 + (r >> 8) % STRESS_MAX_CHUNK;
+		size_t done = 0;
+		size_t i;
+
+		switch (r & 3)
+		{
+		case 0:
+			done = (circular_buf_get(side->ring, data) == 0) ? 1 : 0;
+			break;
+		case 1:
+			done = circular_buf_get_n(side->ring, data, want);
+			break;
+		default:
+		{
+			const uint8_t *span;
+
+			done = circular_buf_peek(side->ring, &span);
+			if (done > want)
+			{
+				done = want;
+			}
+			memcpy(data, span, done);
+			circular_buf_consume(side->ring, done);
+			break;
+		}
+		}
+		for (i = 0; i < done; i++)
+		{
+			side->errors += (data[i] != StreamByte(n + i));
+		}
+		if (done == 0)
+		{
+			side->stalls++;
+			sched_yield();	//Lets the other side run on a single core host
+		}
+		else
+		{
+			side->calls++;
+		}
+		n += done;
+	}
+	return NULL;
+}
+
+/// Runs the two threads over rings of ringSize bytes for about seconds. Returns the number of stream errors
+static uint64_t Stress(size_t ringSize, double seconds)
+{
+	uint8_t *storage = malloc(ringSize);
+	circular_buf_t ring;
+	struct StressSide producer = { 0 };
+	struct StressSide consumer = { 0 };
+	uint64_t bytes = 1 << 20;
+	uint64_t total = 0;
+	uint64_t errors = 0;
+	double start = NowSeconds();
+	unsigned pass;
+
+	if (storage == NULL)
+	{
+		return 1;
+	}
+
+	printf("Stress: %zu byte ring, %.0f s\n", ringSize, seconds);
+	for (pass = 0; NowSeconds() - start < seconds; pass++)
+	{
+		pthread_t threads[2];
+
+		circular_buf_init(&ring, storage, ringSize);
+		memset(&producer, 0, sizeof(producer));
+		memset(&consumer, 0, sizeof(consumer));
+		producer.ring = consumer.ring = &ring;
+		producer.bytes = consumer.bytes = bytes;
+		producer.seed = 0x12345678u + pass;
+		consumer.seed = 0x9ABCDEF0u + pass;
+
+		pthread_create(&threads[0], NULL, StressProducer, &producer);
+		pthread_create(&threads[1], NULL, StressConsumer, &consumer);
+		pthread_join(threads[0], NULL);
+		pthread_join(threads[1], NULL);
+
+		total += consumer.bytes;
+		errors += consumer.errors;
+		if (!circular_buf_empty(&ring))
+		{
+			errors++;
+		}
+	}
+	printf("  %u passes, %llu MB, %llu errors. Last pass: %llu producer calls (%llu full), %llu consumer calls (%llu empty)\n",
+		pass, (unsigned long long)(total >> 20), (unsigned long long)errors,
+		(unsigned long long)producer.calls, (unsigned long long)producer.stalls,
+		(unsigned long long)consumer.calls, (unsigned long long)consumer.stalls);
+	free(storage);
+	return errors;
+}
+
+/******************************************************************************
+* Main
+******************************************************************************/
+int main(int argc, char **argv)
+{
+	uint64_t megabytes = DEFAULT_MEGABYTES;
+	double seconds = DEFAULT_SECONDS;
+	size_t ringSize = 0;
+	uint64_t errors = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:t:r:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'n':
+			megabytes = strtoull(optarg, NULL, 0);
+			break;
+		case 't':
+			seconds = atof(optarg);
+			break;
+		case 'r':
+			ringSize = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-n megabytes] [-t seconds] [-r ringsize]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	if (megabytes > 0)
+	{
+		Bench(megabytes);
+	}
+	if (seconds > 0.0)
+	{
+		if (ringSize != 0)
+		{
+			errors += Stress(ringSize, seconds);
+		}
+		else
+		{
+			errors += Stress(DEFAULT_STRESS_RING, seconds / 2);
+			errors += Stress(BENCH_RING_SIZE, seconds / 2);
+		}
+	}
+	return (errors == 0) ? 0 : 1;
+}
@@ -0,0 +1,334 @@
+/**************************************************************************//**
+* @file      streamcap.c
+* @brief     Captures the sensor stream of the main firmware as CSV
+* @details   After "stream imu,dist,temp 200" the firmware sends one packet per sample on the console
+*			 (WINC1500_HTTP_DOWNLOADER/src/SensorStream/StreamPacket.h). This tool reads the console stream,
+*			 checks the CRC of each packet and writes one CSV row per sample, in physical units. Everything that
+*			 is not a valid packet (CLI replies, echo, log messages) goes to stderr unchanged, so stdout holds
+*			 only the CSV. Packets dropped on a full TX buffer show up as gaps in the sequence numbers and are
+*			 counted in the summary printed at the end.
+*
+*			 Usage:
+*				streamcap [-q] [capture.bin] > samples.csv		reads the capture, or stdin
+*				stty -F /dev/ttyACM0 115200 raw && streamcap < /dev/ttyACM0 > samples.csv
+*				streamcap -t									round trips packets through the codec
+*
+*			 -q drops the console text instead of copying it to stderr.
+*
+*			 At 115200 baud an IMU packet (23 bytes) every 2 ms fills the line: run the firmware with a higher
+*			 SERIAL_CONSOLE_BAUDRATE for rates above a few hundred Hz. Above 500 kbaud the console runs from
+*			 the 48 MHz clock and keeps the board out of standby.
+*
+*			 Build (from this folder):
+*				gcc -O2 -Wall -o streamcap streamcap.c ../WINC1500_HTTP_DOWNLOADER/src/SensorStream/StreamPacket.c
+* @author
+* @date      2026-10-17
+
+******************************************************************************/
+
+
+/******************************************************************************
+* Includes
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../WINC1500_HTTP_DOWNLOADER/src/SensorStream/StreamPacket.h"
+
+/******************************************************************************
+* Defines
+******************************************************************************/
+#define ACCELERATION_MG_PER_LSB		0.061	///< LSM6DSO at 2 g full scale
+#define ANGULAR_RATE_DPS_PER_LSB	0.070	///< LSM6DSO at 2000 dps full scale
+
+/******************************************************************************
+* Structures and Enumerations
+******************************************************************************/
+struct Totals {
+	unsigned long packets;
+	unsigned long lost;
+	unsigned long textBytes;
+	unsigned long sensorPackets[3];	///< Packets holding each STREAM_SENSOR_ bit
+	uint32_t firstTimestamp;
+	uint32_t lastTimestamp;
+};
+
+/******************************************************************************
+* Static Functions
+******************************************************************************/
+static void PrintHeader(FILE *out)
+{
+	fprintf(out, "sequence,time_ms,ax_mg,ay_mg,az_mg,gx_dps,gy_dps,gz_dps,distance_mm,temperature_c,humidity_rh\n");
+}
+
+/// One CSV row. The columns of a sensor missing from the sample are left empty
+static void PrintSample(FILE *out, const struct StreamSample *sample)
+{
+	fprintf(out, "%u,%lu", sample->sequence, (unsigned long)sample->timestamp);
+	if (sample->sensors & STREAM_SENSOR_IMU)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			fprintf(out, ",%.1f", sample->acceleration[i] * ACCELERATION_MG_PER_LSB);
+		}
+		for (int i = 0; i < 3; i++)
+		{
+			fprintf(out, ",%.2f", sample->angularRate[i] * ANGULAR_RATE_DPS_PER_LSB);
+		}
+	}
+	else
+	{
+		fputs(",,,,,,", out);
+	}
+	if (sample->sensors & STREAM_SENSOR_DISTANCE)
+	{
+		fprintf(out, ",%u", sample->distance);
+	}
+	else
+	{
+		fputc(',', out);
+	}
+	if (sample->sensors & STREAM_SENSOR_TEMPERATURE)
+	{
+		fprintf(out, ",%.2f,%.1f", -45.0 + 175.0 * sample->temperature / 65536.0, 100.0 * sample->humidity / 65536.0);
+	}
+	else
+	{
+		fputs(",,", out);
+	}
+	fputc('\n', out);
+}
+
+/// Splits a console stream: packets go to csv, everything else to text (if not NULL)
+static void CaptureStream(FILE *in, FILE *csv, FILE *text, struct Totals *totals)
+{
+	uint8_t packet[STREAM_PACKET_MAX_SIZE];
+	uint8_t pushback[STREAM_PACKET_MAX_SIZE];
+	size_t have = 0;
+	size_t pushed = 0;
+	long nextSequence = -1;
+
+	memset(totals, 0, sizeof(*totals));
+	PrintHeader(csv);
+
+	for (;;)
+	{
+		struct StreamSample sample;
+		size_t length;
+		int c;
+
+		if (pushed > 0)
+		{
+			c = pushback[--pushed];
+		}
+		else if ((c = getc(in)) == EOF)
+		{
+			break;
+		}
+
+		if (have == 0 && c != STREAM_PACKET_SYNC)
+		{
+			totals->textBytes++;
+			if (text != NULL)
+			{
+				fputc(c, text);
+			}
+			continue;
+		}
+		packet[have++] = (uint8_t)c;
+		if (have < 2)
+		{
+			continue;
+		}
+		length = StreamPacketLength(packet);
+		if (length != 0 && have < length)
+		{
+			continue;
+		}
+		if (length != 0 && StreamPacketParse(packet, &sample) == 0)
+		{
+			if (nextSequence >= 0 && sample.sequence != (uint16_t)nextSequence)
+			{
+				totals->lost += (uint16_t)(sample.sequence - nextSequence);
+			}
+			nextSequence = (uint16_t)(sample.sequence + 1);
+			if (totals->packets == 0)
+			{
+				totals->firstTimestamp = sample.timestamp;
+			}
+			totals->lastTimestamp = sample.timestamp;
+			totals->packets++;
+			for (int bit = 0; bit < 3; bit++)
+			{
+				totals->sensorPackets[bit] += (sample.sensors >> bit) & 1;
+			}
+			PrintSample(csv, &sample);
+			have = 0;
+			continue;
+		}
+
+		// Not a packet: the sync byte was text, the bytes after it are scanned again
+		totals->textBytes++;
+		if (text != NULL)
+		{
+			fputc(packet[0], text);
+		}
+		while (have > 1)
+		{
+			pushback[pushed++] = packet[--have];
+		}
+		have = 0;
+	}
+	totals->textBytes += have;	// Incomplete packet at the end of the input
+	if (text != NULL)
+	{
+		fwrite(packet, 1, have, text);
+	}
+	fflush(csv);
+}
+
+static void PrintTotals(const struct Totals *totals)
+{
+	double seconds = (totals->lastTimestamp - totals->firstTimestamp) / 1000.0;
+
+	fprintf(stderr, "streamcap: %lu packets, %lu lost (%.2f%%), %lu text bytes\n", totals->packets, totals->lost,
+			totals->packets + totals->lost > 0 ? 100.0 * totals->lost / (totals->packets + totals->lost) : 0.0, totals->textBytes);
+	if (totals->packets > 1 && seconds > 0)
+	{
+		fprintf(stderr, "streamcap: %.3f s, %.1f samples/s (imu %.1f, dist %.1f, temp %.1f)\n", seconds,
+				(totals->packets + totals->lost - 1) / seconds, totals->sensorPackets[0] / seconds,
+				totals->sensorPackets[1] / seconds, totals->sensorPackets[2] / seconds);
+	}
+}
+
+/// Packs samples, mixes them with text, a corrupted packet and a gap, and checks what CaptureStream finds
+static int SelfTest(void)
+{
+	static const char banner[] = "stream running: imu at 500 Hz\r\n";
+	uint8_t packet[STREAM_PACKET_MAX_SIZE];
+	struct StreamSample sample;
+	struct StreamSample parsed;
+	struct Totals totals;
+	FILE *in = tmpfile();
+	FILE *csv = tmpfile();
+	FILE *text = tmpfile();
+	char line[256];
+	int failed = 0;
+	int rows = 0;
+
+	if (in == NULL || csv == NULL || text == NULL)
+	{
+		printf("cannot create temporary files\n");
+		return 1;
+	}
+
+	// "123456789" is the check input of CRC-16/CCITT-FALSE
+	if (StreamPacketCrc((const uint8_t *)"123456789", 9) != 0x29B1)
+	{
+		printf("FAIL crc of \"123456789\" is %04X, expected 29B1\n", StreamPacketCrc((const uint8_t *)"123456789", 9));
+		failed = 1;
+	}
+
+	fputs(banner, in);
+	for (int i = 0; i < 20; i++)
+	{
+		size_t length;
+
+		memset(&sample, 0, sizeof(sample));
+		sample.sensors = (i % 5 == 0) ? STREAM_SENSOR_ALL : STREAM_SENSOR_IMU;
+		sample.sequence = (uint16_t)(65530 + i + (i >= 10));	// Wraps, and skips one after the 10th
+		sample.timestamp = 1000 + 2 * i;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			sample.acceleration[axis] = (int16_t)(-16000 + 1000 * axis + i);
+			sample.angularRate[axis] = (int16_t)(300 * axis - i);
+		}
+		sample.distance = 1234;
+		sample.temperature = 0x6666;
+		sample.humidity = 0x8000;
+
+		length = StreamPacketPack(packet, &sample);
+		if (StreamPacketLength(packet) != length || StreamPacketParse(packet, &parsed) != 0 || parsed.sequence != sample.sequence ||
+			parsed.timestamp != sample.timestamp || parsed.sensors != sample.sensors ||
+			memcmp(parsed.acceleration, sample.acceleration, sizeof(sample.acceleration)) != 0 ||
+			memcmp(parsed.angularRate, sample.angularRate, sizeof(sample.angularRate)) != 0)
+		{
+			printf("FAIL round trip of packet %d\n", i);
+			failed = 1;
+		}
+		if (i == 7)
+		{
+			packet[length / 2] ^= 0x10;	// Corrupted on the wire: must be dropped, counted as lost
+		}
+		fwrite(packet, 1, length, in);
+		if (i == 3)
+		{
+			fputs("> ", in);	// CLI echo between packets
+		}
+	}
+	rewind(in);
+
+	CaptureStream(in, csv, text, &totals);
+	rewind(csv);
+	while (fgets(line, sizeof(line), csv) != NULL)
+	{
+		rows++;
+	}
+	if (rows != 1 + 19 || totals.packets != 19 || totals.lost != 2)
+	{
+		printf("FAIL %d rows, %lu packets, %lu lost: expected 20 rows, 19 packets, 2 lost\n", rows, totals.packets, totals.lost);
+		failed = 1;
+	}
+	rewind(text);
+	if (fgets(line, sizeof(line), text) == NULL || strcmp(line, "stream running: imu at 500 Hz\r\n") != 0)
+	{
+		printf("FAIL console text not passed through\n");
+		failed = 1;
+	}
+
+	fclose(in);
+	fclose(csv);
+	fclose(text);
+	printf(failed ? "self test FAILED\n" : "self test passed\n");
+	return failed;
+}
+
+/******************************************************************************
+* Global Functions
+******************************************************************************/
+int main(int argc, char **argv)
+{
+	struct Totals totals;
+	FILE *in = stdin;
+	int quiet = 0;
+	int first = 1;
+
+	if (argc == 2 && strcmp(argv[1], "-t") == 0)
+	{
+		return SelfTest();
+	}
+	if (argc > 1 && strcmp(argv[1], "-q") == 0)
+	{
+		quiet = 1;
+		first = 2;
+	}
+	if (argc - first > 1)
+	{
+		fprintf(stderr, "usage: %s [-q] [capture.bin]\n       %s -t\n", argv[0], argv[0]);
+		return 2;
+	}
+	if (argc - first == 1 && (in = fopen(argv[first], "rb")) == NULL)
+	{
+		fprintf(stderr, "cannot open %s\n", argv[first]);
+		return 1;
+	}
+
+	setvbuf(stdout, NULL, _IOLBF, 0);
+	CaptureStream(in, stdout, quiet ? NULL : stderr, &totals);
+	PrintTotals(&totals);
+	if (in != stdin)
+	{
+		fclose(in);
+	}
+	return 0;
+}
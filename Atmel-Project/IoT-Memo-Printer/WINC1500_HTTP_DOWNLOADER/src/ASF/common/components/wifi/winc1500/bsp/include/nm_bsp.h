@@ -281,6 +281,42 @@ void nm_bsp_register_isr(tpfNmBspIsr pfIsr);
 void nm_bsp_interrupt_ctrl(uint8 u8Enable);
   /**@}*/
 
+/** @defgroup NmBspWaitForEventFn nm_bsp_wait_for_event
+*     @ingroup BSPAPI
+*    Wait for the WINC to host interrupt
+*/
+/**@{*/
+/*!
+ * @fn           void nm_bsp_wait_for_event(uint32);
+ * @brief        Blocks the calling task until the WINC raises its IRQ line or the timeout expires, in place of
+ *				 spinning on m2m_wifi_handle_events. Returns at once if an event is already pending.
+ *				 Call m2m_wifi_handle_events after it returns.
+ * @param [in]   u32TimeoutMsec
+ *               Longest wait in milliseconds, for the timers of the caller
+ * @pre          The interrupt must be registered using nm_bsp_register_isr first.
+ * @note         Under FreeRTOS the IRQ gives a semaphore. Without an RTOS it returns at once, so the caller spins as before.
+ * @return       None
+ */
+void nm_bsp_wait_for_event(uint32 u32TimeoutMsec);
+/*!
+ * @fn           void nm_bsp_register_event_hook(tpfNmBspIsr);
+ * @brief        Registers a function the IRQ calls after giving the event semaphore, so a task that blocks on
+ *				 more than the WINC (e.g. a queue set) can be woken by it too. NULL removes it.
+ * @param [in]   pfHook
+ *               Called from the interrupt
+ * @note         Kept across nm_bsp_init.
+ * @return       None
+ */
+void nm_bsp_register_event_hook(tpfNmBspIsr pfHook);
+/*!
+ * @fn           uint8 nm_bsp_event_pending(void);
+ * @brief        Returns 1 if the WINC holds its IRQ line low: an event is pending and no edge is coming for it.
+ *				 Call m2m_wifi_handle_events instead of blocking.
+ * @return       1 if an event is pending, 0 otherwise
+ */
+uint8 nm_bsp_event_pending(void);
+  /**@}*/
+
 #ifdef __cplusplus
 }
 #endif
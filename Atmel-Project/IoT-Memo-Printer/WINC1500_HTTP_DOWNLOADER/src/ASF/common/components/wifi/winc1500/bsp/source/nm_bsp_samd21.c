@@ -37,14 +37,33 @@
 #include "common/include/nm_common.h"
 #include "asf.h"
 #include "conf_winc.h"
+#ifdef __FREERTOS__
+#include "RamPlan/RamPlan.h"
+#endif
 
 static tpfNmBspIsr gpfIsr;
+#ifdef __FREERTOS__
+/* Given by the IRQ line, taken by the task that handles the WINC events. */
+static SemaphoreHandle_t gpxEventSemaphore;
+static StaticSemaphore_t gstrEventSemaphoreBuffer RAM_PLAN(wifi);
+/* Called by the IRQ as well, see nm_bsp_register_event_hook. */
+static tpfNmBspIsr gpfEventHook;
+#endif
 
 static void chip_isr(void)
 {
 	if (gpfIsr) {
 		gpfIsr();
 	}
+#ifdef __FREERTOS__
+	BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+	xSemaphoreGiveFromISR(gpxEventSemaphore, &xHigherPriorityTaskWoken);
+	portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+	if (gpfEventHook) {
+		gpfEventHook();
+	}
+#endif
 }
 
 /*
@@ -74,6 +93,11 @@ static void init_chip_pins(void)
 sint8 nm_bsp_init(void)
 {
 	gpfIsr = NULL;
+#ifdef __FREERTOS__
+	if (gpxEventSemaphore == NULL) {
+		gpxEventSemaphore = xSemaphoreCreateBinaryStatic(&gstrEventSemaphoreBuffer);
+	}
+#endif
 
 	/* Initialize chip IOs. */
 	init_chip_pins();
@@ -139,6 +163,50 @@ void nm_bsp_sleep(uint32 u32TimeMsec)
 #endif
 }
 
+/*
+ *	@fn		nm_bsp_wait_for_event
+ *	@brief	Block until the WINC raises its IRQ line, at most u32TimeoutMsec
+ *	@param[IN]	u32TimeoutMsec
+ *				Time in milliseconds
+ */
+void nm_bsp_wait_for_event(uint32 u32TimeoutMsec)
+{
+#ifdef __FREERTOS__
+	/* The line stays low while an event is pending: no edge is coming for it. */
+	if (nm_bsp_event_pending()) {
+		return;
+	}
+	xSemaphoreTake(gpxEventSemaphore, pdMS_TO_TICKS(u32TimeoutMsec));
+#else
+	(void)u32TimeoutMsec;
+#endif
+}
+
+/*
+ *	@fn		nm_bsp_register_event_hook
+ *	@brief	Register a function the IRQ calls after giving the event semaphore
+ *	@param[IN]	pfHook
+ *				Pointer to the hook, NULL to remove it
+ */
+void nm_bsp_register_event_hook(tpfNmBspIsr pfHook)
+{
+#ifdef __FREERTOS__
+	gpfEventHook = pfHook;
+#else
+	(void)pfHook;
+#endif
+}
+
+/*
+ *	@fn		nm_bsp_event_pending
+ *	@brief	Check whether the WINC holds its IRQ line low
+ *	@return	1 if an event is pending, 0 otherwise
+ */
+uint8 nm_bsp_event_pending(void)
+{
+	return port_pin_get_input_level(CONF_WINC_SPI_INT_PIN) == false;
+}
+
 /*
  *	@fn		nm_bsp_register_isr
  *	@brief	Register interrupt service routine
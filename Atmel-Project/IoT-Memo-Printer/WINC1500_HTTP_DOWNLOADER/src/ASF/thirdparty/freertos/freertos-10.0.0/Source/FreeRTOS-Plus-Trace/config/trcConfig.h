@@ -83,6 +83,18 @@ extern "C" {
  ******************************************************************************/
 #define TRC_CFG_HARDWARE_PORT TRC_HARDWARE_PORT_ARM_Cortex_M
 
+/*******************************************************************************
+ * Configuration Macro: TRC_CFG_ACKNOWLEDGE_TICKLESS_IDLE_WARNING
+ *
+ * On Cortex-M0+ the timestamps come from SysTick, which PowerSuppressTicksAndSleep
+ * (Power/Power.c) stops while the CPU sleeps. The only counter that keeps running
+ * in standby is the 24 bit, 32 kHz POWER_TIMER, too coarse for timestamps and
+ * slow to read. PowerSuppressTicksAndSleep adds the ticks it slept to the trace
+ * tick count, so sleeps keep their length in the trace, but an event just after
+ * one may be off by up to a tick. Use the "power" CLI command for the residency.
+ ******************************************************************************/
+#define TRC_CFG_ACKNOWLEDGE_TICKLESS_IDLE_WARNING
+
 /*******************************************************************************
  * Configuration Macro: TRC_CFG_RECORDER_MODE
  *
@@ -25,6 +25,7 @@
 
 #define IPV4_BYTE(val,index) 	((val >> (index * 8)) & 0xFF)
 #define MQTT_RX_POOL_SIZE		256
+#define WINC_EVENT_WAIT_MS		100	/* Longest sleep between two checks of a callback flag */
 
 static unsigned long MilliTimer=0;
 static int32_t gi32MQTTBrokerIp=0;
@@ -161,6 +162,7 @@ static int WINC1500_read(Network* n, unsigned char* buffer, int len, int timeout
 	  //call handle_events until we get rx callback 
 	  while (false==gbMQTTBrokerRecvDone){
 		  m2m_wifi_handle_events(NULL);
+		  if (false==gbMQTTBrokerRecvDone) nm_bsp_wait_for_event(WINC_EVENT_WAIT_MS);
 	  }
 	  
 	  //update current FIFO length
@@ -215,6 +217,7 @@ static int WINC1500_write(Network* n, unsigned char* buffer, int len, int timeou
   //wait for send callback
   while (false==gbMQTTBrokerSendDone){
 	  m2m_wifi_handle_events(NULL);
+	  if (false==gbMQTTBrokerSendDone) nm_bsp_wait_for_event(WINC_EVENT_WAIT_MS);
   }
   
   #ifdef MQTT_PLATFORM_DBG
@@ -256,6 +259,7 @@ int ConnectNetwork(Network* n, char* addr, int port, int TLSFlag){
   //wait for resolver callback
   while (false==gbMQTTBrokerIpresolved){
 	  m2m_wifi_handle_events(NULL);
+	  if (false==gbMQTTBrokerIpresolved) nm_bsp_wait_for_event(WINC_EVENT_WAIT_MS);
   }
   
   n->hostIP = gi32MQTTBrokerIp;
@@ -292,6 +296,7 @@ int ConnectNetwork(Network* n, char* addr, int port, int TLSFlag){
   /*wait for SOCKET_MSG_CONNECT event */
   while(false==gbMQTTBrokerConnected){
     m2m_wifi_handle_events(NULL);
+    if (false==gbMQTTBrokerConnected) nm_bsp_wait_for_event(WINC_EVENT_WAIT_MS);
   }
   
   /* Success */
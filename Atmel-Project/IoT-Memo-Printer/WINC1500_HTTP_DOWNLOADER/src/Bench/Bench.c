@@ -0,0 +1,148 @@
+/**************************************************************************/ /**
+ * @file      Bench.c
+ * @brief     Micro-benchmark registry and runner for the "bench" CLI command
+ * @details   The samples of a run are kept and sorted for the median, so a run is bounded by BENCH_MAX_SAMPLES.
+ *            Times are differences of the free running timer, correct across its wrap.
+ * @author
+ * @date      2026-10-17
+
+ ******************************************************************************/
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "Bench.h"
+
+#include <string.h>
+
+/******************************************************************************
+ * Variables
+ ******************************************************************************/
+uint8_t benchBuffer[BENCH_BUFFER_SIZE] __attribute__((aligned(4)));  ///< Data buffer shared by the kernels, word aligned for the DSU
+static const struct BenchKernel *benchKernels[BENCH_MAX_KERNELS];  ///< Kernels listed by BenchRegister
+
+/******************************************************************************
+ * Global Functions
+ ******************************************************************************/
+
+/**
+ * @fn          void BenchRegister(const struct BenchKernel *kernel)
+ * @brief       Lists a kernel for "bench"
+ * @param[in]   kernel Kernel, kept by reference. Ignored if NULL
+ * @note        Kernels past BENCH_MAX_KERNELS are not listed
+ */
+void BenchRegister(const struct BenchKernel *kernel)
+{
+    for (uint32_t i = 0; i < BENCH_MAX_KERNELS && NULL != kernel; i++) {
+        if (NULL == benchKernels[i]) {
+            benchKernels[i] = kernel;
+            break;
+        }
+    }
+}
+
+/**
+ * @fn          const struct BenchKernel *BenchGetKernel(uint32_t index)
+ * @brief       Returns a listed kernel
+ * @param[in]   index Position in the list, from 0
+ * @return      The kernel, or NULL past the end of the list
+ */
+const struct BenchKernel *BenchGetKernel(uint32_t index)
+{
+    return (index < BENCH_MAX_KERNELS) ? benchKernels[index] : NULL;
+}
+
+/**
+ * @fn          const struct BenchKernel *BenchFindKernel(const char *name, size_t length)
+ * @brief       Finds a listed kernel by name
+ * @param[in]   name Name, not necessarily terminated
+ * @param[in]   length Length of name
+ * @return      The kernel, or NULL if none has this name
+ */
+const struct BenchKernel *BenchFindKernel(const char *name, size_t length)
+{
+    const struct BenchKernel *kernel;
+
+    for (uint32_t i = 0; NULL != (kernel = BenchGetKernel(i)); i++) {
+        if (strlen(kernel->name) == length && 0 == strncmp(kernel->name, name, length)) {
+            return kernel;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @fn          void BenchRun(const struct BenchKernel *kernel, uint32_t samples, struct BenchResult *result)
+ * @brief       Times a kernel
+ * @details     Runs setup, then calls run once per sample, timing each call, then teardown. The run stops at the
+ *              first failed call: the result then holds the samples taken before it.
+ * @param[in]   kernel Kernel to time
+ * @param[in]   samples Number of samples, capped to 1..BENCH_MAX_SAMPLES
+ * @param[out]  result Timing in BenchTimerGet counts per call of run
+ */
+void BenchRun(const struct BenchKernel *kernel, uint32_t samples, struct BenchResult *result)
+{
+    static uint32_t times[BENCH_MAX_SAMPLES];  // Off the stack of the CLI task, which also runs FatFs in the kernels
+    uint32_t taken = 0;
+
+    memset(result, 0, sizeof(*result));
+    samples = (samples == 0) ? 1 : (samples > BENCH_MAX_SAMPLES) ? BENCH_MAX_SAMPLES : samples;
+
+    if (NULL != kernel->setup && (result->error = kernel->setup()) < 0) {
+        return;
+    }
+
+    while (taken < samples) {
+        uint32_t start = BenchTimerGet();
+        int32_t error = kernel->run();
+        uint32_t time = BenchTimerGet() - start;
+        uint32_t i;
+
+        if (error < 0) {
+            result->error = error;
+            break;
+        }
+        // Insertion sort: the samples are few and mostly arrive in order
+        for (i = taken; i > 0 && times[i - 1] > time; i--) {
+            times[i] = times[i - 1];
+        }
+        times[i] = time;
+        taken++;
+    }
+
+    if (NULL != kernel->teardown) {
+        kernel->teardown();
+    }
+    if (taken > 0) {
+        result->samples = taken;
+        result->min = times[0];
+        result->median = (taken & 1) ? times[taken / 2] : (uint32_t)(((uint64_t)times[taken / 2 - 1] + times[taken / 2]) / 2);
+        result->max = times[taken - 1];
+    }
+}
+
+/**
+ * @fn          uint32_t BenchCountsToNs(uint32_t counts, uint32_t operations)
+ * @brief       Converts a sample time to ns per operation
+ * @param[in]   counts Time of one call of run, in BenchTimerGet counts
+ * @param[in]   operations Operations done by the call
+ * @return      ns per operation, saturated to UINT32_MAX
+ */
+uint32_t BenchCountsToNs(uint32_t counts, uint32_t operations)
+{
+    uint64_t ns = ((uint64_t)counts * 1000000000ULL) / ((uint64_t)BenchTimerHz() * (operations ? operations : 1));
+
+    return (ns > UINT32_MAX) ? UINT32_MAX : (uint32_t)ns;
+}
+
+/**
+ * @fn          uint32_t BenchThroughputKBps(uint32_t counts, uint32_t bytes)
+ * @brief       Converts a sample time to a throughput
+ * @param[in]   counts Time of one call of run, in BenchTimerGet counts
+ * @param[in]   bytes Bytes moved by the call
+ * @return      kB/s (1000 bytes), 0 if counts is 0
+ */
+uint32_t BenchThroughputKBps(uint32_t counts, uint32_t bytes)
+{
+    return (counts == 0) ? 0 : (uint32_t)(((uint64_t)bytes * BenchTimerHz()) / ((uint64_t)counts * 1000));
+}
@@ -0,0 +1,98 @@
+/**************************************************************************/ /**
+ * @file      Bench.h
+ * @brief     Micro-benchmark registry and runner for the "bench" CLI command
+ * @details   A kernel is a named operation timed as a whole, once per sample, with the high resolution timer of the
+ *            platform (BenchTimerGet). The runner reports the minimum, median and maximum over the samples. Kernels
+ *            are listed at start up with BenchRegister, like the queues of RunTimeStats.
+ *
+ *            Plain C: the runner and the portable kernels (BenchKernels.c) also build on Linux, in
+ *            Tools/benchhost.c, which supplies the timer and stubs for the kernels that need the hardware
+ *            (BenchTarget.c on target), so results can be compared across commits on either side.
+ * @author
+ * @date      2026-10-17
+
+ ******************************************************************************/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/******************************************************************************
+ * Defines
+ ******************************************************************************/
+#define BENCH_MAX_KERNELS 16       ///< Kernels BenchRegister can list
+#define BENCH_MAX_SAMPLES 64       ///< Most samples per run: the median needs all of them
+#define BENCH_DEFAULT_SAMPLES 16   ///< Samples per run if none are asked for
+#define BENCH_BUFFER_SIZE 1024     ///< Data buffer shared by the kernels
+#define BENCH_FILE_NAME "0:bench.bin"  ///< File of the SD kernels, created on first use
+#define BENCH_FILE_SIZE (64 * 1024UL)  ///< Size of BENCH_FILE_NAME
+
+/******************************************************************************
+ * Structures and Enumerations
+ ******************************************************************************/
+/// One benchmark. setup and teardown run once per run, outside the timed samples
+struct BenchKernel {
+    const char *name;          ///< Name given to "bench"
+    const char *description;   ///< One line shown by "bench" without parameters
+    uint32_t operations;       ///< Operations done by one call of run, for the time per operation
+    uint32_t bytes;            ///< Bytes moved by one call of run, for the throughput. 0 if not relevant
+    int32_t (*setup)(void);    ///< Optional. Returns < 0 if the kernel cannot run (missing hardware, no SD card)
+    int32_t (*run)(void);      ///< The timed operation. Returns < 0 on error
+    void (*teardown)(void);    ///< Optional
+};
+
+/// What the HTTP client reported for a response fed by BenchHttpParse
+struct BenchHttpTotals {
+    int32_t responseCode;   ///< Status code, 0 if none was parsed
+    int32_t contentLength;  ///< Content-Length, -1 if chunked
+    uint32_t bodyBytes;     ///< Body bytes handed to the callback
+    uint32_t bodySum;       ///< Sum of these bytes
+    uint32_t chunks;        ///< Pieces the body came in, 0 if it fit the receive buffer
+    bool complete;          ///< The client saw the whole body
+    bool disconnected;      ///< The client dropped the connection
+};
+
+/// Timing of one run, in timer counts for the whole call of run
+struct BenchResult {
+    int32_t error;     ///< 0, or the error of setup or of the first failed sample
+    uint32_t samples;  ///< Samples taken
+    uint32_t min;      ///< Fastest sample
+    uint32_t median;   ///< Median sample
+    uint32_t max;      ///< Slowest sample
+};
+
+/******************************************************************************
+ * Global Function Declarations
+ ******************************************************************************/
+void BenchRegister(const struct BenchKernel *kernel);
+const struct BenchKernel *BenchGetKernel(uint32_t index);
+const struct BenchKernel *BenchFindKernel(const char *name, size_t length);
+void BenchRun(const struct BenchKernel *kernel, uint32_t samples, struct BenchResult *result);  // Not reentrant
+uint32_t BenchCountsToNs(uint32_t counts, uint32_t operations);
+uint32_t BenchThroughputKBps(uint32_t counts, uint32_t bytes);
+
+void BenchRegisterPortableKernels(void);
+void BenchRegisterProtocolKernels(void);
+int32_t BenchHttpParse(const char *response, size_t length, size_t packet, struct BenchHttpTotals *totals);
+void BenchRegisterPlatformKernels(void);
+extern uint8_t benchBuffer[BENCH_BUFFER_SIZE];
+
+// Supplied by the platform, with BenchRegisterPlatformKernels: BenchTarget.c on target, Tools/benchhost.c on Linux
+uint32_t BenchTimerGet(void);
+uint32_t BenchTimerHz(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BENCH_H */
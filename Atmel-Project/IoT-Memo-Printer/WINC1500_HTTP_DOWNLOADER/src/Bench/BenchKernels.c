@@ -0,0 +1,234 @@
+/**************************************************************************/ /**
+ * @file      BenchKernels.c
+ * @brief     Benchmark kernels that build on target and on Linux
+ * @details   Console ring operations, the software CRC32 of ASF, FatFs reads, and the heap against a memory pool.
+ *            The SD kernels read BENCH_FILE_NAME on the mounted volume 0: the SD card on target, a RAM disk in
+ *            Tools/benchhost.c.
+ * @author
+ * @date      2026-10-17
+
+ ******************************************************************************/
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "Bench.h"
+
+#include <crc32.h>
+
+#include "Memory/MemoryPool.h"
+#include "SerialConsole/circular_buffer.h"
+#include "FreeRTOS.h"
+#include "ff.h"
+
+/******************************************************************************
+ * Defines
+ ******************************************************************************/
+#define BENCH_RING_SIZE 512     ///< Same as the console TX ring
+#define BENCH_RING_CHUNK 256    ///< Bytes put and got per pass
+#define BENCH_SD_BLOCK 512      ///< Bytes per f_read: one sector
+#define BENCH_SD_READS 16       ///< f_read calls per sample
+#define BENCH_HEAP_BLOCKS 4     ///< pvPortMalloc calls per sample, each freed again
+#define BENCH_POOL_BLOCKS 4     ///< MemoryPoolAlloc calls per sample, each freed again
+
+/******************************************************************************
+ * Local Function Declaration
+ ******************************************************************************/
+static int32_t ring_setup(void);
+static int32_t ring_byte_run(void);
+static int32_t ring_bulk_run(void);
+static int32_t crc32_sw_run(void);
+static int32_t sd_setup(void);
+static int32_t sd_sequential_run(void);
+static int32_t sd_random_run(void);
+static void sd_teardown(void);
+static int32_t heap_run(void);
+static int32_t pool_run(void);
+
+/******************************************************************************
+ * Variables
+ ******************************************************************************/
+static circular_buf_t benchRing;  ///< Ring of the ring kernels, over the first half of benchBuffer
+static FIL benchFile;              ///< BENCH_FILE_NAME while an SD kernel runs
+static uint32_t benchFilePosition; ///< Next offset of the sequential read
+static uint32_t benchRandom;       ///< State of the random offsets
+static volatile uint32_t benchSink; ///< Results of the compute kernels, kept so they are not optimized away
+static void *benchBlocks[BENCH_HEAP_BLOCKS];  ///< Blocks of the heap and pool kernels
+
+static const struct BenchKernel ringByteKernel = {"ring.byte", "Console ring, one byte per put/get call", 2 * BENCH_RING_CHUNK, BENCH_RING_CHUNK, ring_setup, ring_byte_run, NULL};
+static const struct BenchKernel ringBulkKernel = {"ring.bulk", "Console ring, put_n/get_n of 256 bytes", 2, BENCH_RING_CHUNK, ring_setup, ring_bulk_run, NULL};
+static const struct BenchKernel crc32SwKernel = {"crc32.sw", "ASF software CRC32 over 1 kB", 1, BENCH_BUFFER_SIZE, NULL, crc32_sw_run, NULL};
+static const struct BenchKernel sdSequentialKernel = {"sd.seq", "FatFs sequential 512 byte reads", BENCH_SD_READS, BENCH_SD_READS * BENCH_SD_BLOCK, sd_setup, sd_sequential_run, sd_teardown};
+static const struct BenchKernel sdRandomKernel = {"sd.rand", "FatFs random 512 byte reads", BENCH_SD_READS, BENCH_SD_READS * BENCH_SD_BLOCK, sd_setup, sd_random_run, sd_teardown};
+static const struct BenchKernel heapKernel = {"heap.mix", "pvPortMalloc and vPortFree of 24 to 200 bytes", 2 * BENCH_HEAP_BLOCKS, 0, NULL, heap_run, NULL};
+static const struct BenchKernel poolKernel = {"pool.frag", "MemoryPoolAlloc and MemoryPoolFree of fragment blocks", 2 * BENCH_POOL_BLOCKS, 0, NULL, pool_run, NULL};
+
+/******************************************************************************
+ * Global Functions
+ ******************************************************************************/
+
+/**
+ * @fn          void BenchRegisterPortableKernels(void)
+ * @brief       Lists the kernels of this file and of BenchProtocolKernels.c
+ */
+void BenchRegisterPortableKernels(void)
+{
+    BenchRegister(&ringByteKernel);
+    BenchRegister(&ringBulkKernel);
+    BenchRegister(&crc32SwKernel);
+    BenchRegister(&sdSequentialKernel);
+    BenchRegister(&sdRandomKernel);
+    BenchRegister(&heapKernel);
+    BenchRegister(&poolKernel);
+    BenchRegisterProtocolKernels();
+}
+
+/******************************************************************************
+ * Local Functions
+ ******************************************************************************/
+
+static int32_t ring_setup(void)
+{
+    circular_buf_init(&benchRing, benchBuffer, BENCH_RING_SIZE);
+    return 0;
+}
+
+static int32_t ring_byte_run(void)
+{
+    const uint8_t *data = &benchBuffer[BENCH_RING_SIZE];
+    uint8_t *out = &benchBuffer[BENCH_RING_SIZE + BENCH_RING_CHUNK];
+
+    for (uint32_t i = 0; i < BENCH_RING_CHUNK; i++) {
+        circular_buf_put(&benchRing, data[i]);
+    }
+    for (uint32_t i = 0; i < BENCH_RING_CHUNK; i++) {
+        if (circular_buf_get(&benchRing, &out[i]) < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int32_t ring_bulk_run(void)
+{
+    if (circular_buf_put_n(&benchRing, &benchBuffer[BENCH_RING_SIZE], BENCH_RING_CHUNK) != BENCH_RING_CHUNK ||
+        circular_buf_get_n(&benchRing, &benchBuffer[BENCH_RING_SIZE + BENCH_RING_CHUNK], BENCH_RING_CHUNK) != BENCH_RING_CHUNK) {
+        return -1;
+    }
+    return 0;
+}
+
+static int32_t crc32_sw_run(void)
+{
+    crc32_t crc;
+
+    crc32_calculate(benchBuffer, BENCH_BUFFER_SIZE, &crc);
+    benchSink = crc;
+    return 0;
+}
+
+/**
+ * @fn          static int32_t sd_setup(void)
+ * @brief       Opens BENCH_FILE_NAME, writing it first if it is missing or short
+ * @return      0, or the FRESULT as a negative number
+ * @note        The write is not timed
+ */
+static int32_t sd_setup(void)
+{
+    FRESULT res = f_open(&benchFile, BENCH_FILE_NAME, FA_READ | FA_WRITE | FA_OPEN_ALWAYS);
+    UINT written;
+
+    if (FR_OK == res && f_size(&benchFile) < BENCH_FILE_SIZE) {
+        for (uint32_t i = 0; i < BENCH_BUFFER_SIZE; i++) {
+            benchBuffer[i] = (uint8_t)(i * 7);
+        }
+        for (uint32_t offset = 0; FR_OK == res && offset < BENCH_FILE_SIZE; offset += BENCH_BUFFER_SIZE) {
+            res = f_write(&benchFile, benchBuffer, BENCH_BUFFER_SIZE, &written);
+        }
+        if (FR_OK == res) {
+            res = f_sync(&benchFile);
+        }
+    }
+    if (FR_OK != res) {
+        f_close(&benchFile);
+        return -(int32_t)res;
+    }
+    benchFilePosition = 0;
+    benchRandom = 1;
+    return 0;
+}
+
+static int32_t sd_sequential_run(void)
+{
+    UINT got;
+
+    if (FR_OK != f_lseek(&benchFile, benchFilePosition)) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < BENCH_SD_READS; i++) {
+        if (FR_OK != f_read(&benchFile, benchBuffer, BENCH_SD_BLOCK, &got) || got != BENCH_SD_BLOCK) {
+            return -1;
+        }
+    }
+    benchFilePosition = (benchFilePosition + BENCH_SD_READS * BENCH_SD_BLOCK) % BENCH_FILE_SIZE;
+    return 0;
+}
+
+static int32_t sd_random_run(void)
+{
+    UINT got;
+
+    for (uint32_t i = 0; i < BENCH_SD_READS; i++) {
+        benchRandom = benchRandom * 1103515245UL + 12345UL;  // Same offsets on every platform
+        if (FR_OK != f_lseek(&benchFile, ((benchRandom >> 16) % (BENCH_FILE_SIZE / BENCH_SD_BLOCK)) * BENCH_SD_BLOCK) ||
+            FR_OK != f_read(&benchFile, benchBuffer, BENCH_SD_BLOCK, &got) || got != BENCH_SD_BLOCK) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void sd_teardown(void)
+{
+    f_close(&benchFile);
+}
+
+/**
+ * @fn          static int32_t heap_run(void)
+ * @brief       Allocates blocks of several sizes, then frees them out of order so the heap has to merge
+ * @return      0, or -1 if the heap is short
+ */
+static int32_t heap_run(void)
+{
+    static const size_t sizes[BENCH_HEAP_BLOCKS] = {24, 200, 64, 96};
+    static const uint8_t freeOrder[BENCH_HEAP_BLOCKS] = {1, 3, 0, 2};
+    int32_t error = 0;
+
+    for (uint32_t i = 0; i < BENCH_HEAP_BLOCKS; i++) {
+        benchBlocks[i] = pvPortMalloc(sizes[i]);
+        error |= (NULL == benchBlocks[i]) ? -1 : 0;
+    }
+    for (uint32_t i = 0; i < BENCH_HEAP_BLOCKS; i++) {
+        vPortFree(benchBlocks[freeOrder[i]]);
+    }
+    return error;
+}
+
+/**
+ * @fn          static int32_t pool_run(void)
+ * @brief       Takes blocks of the fragment pool and gives them back
+ * @return      0, or -1 if the pool is short, as it may be while games are queued
+ */
+static int32_t pool_run(void)
+{
+    int32_t error = 0;
+
+    for (uint32_t i = 0; i < BENCH_POOL_BLOCKS; i++) {
+        benchBlocks[i] = MemoryPoolAlloc(&fragmentPool);
+        error |= (NULL == benchBlocks[i]) ? -1 : 0;
+    }
+    for (uint32_t i = 0; i < BENCH_POOL_BLOCKS; i++) {
+        MemoryPoolFree(&fragmentPool, benchBlocks[i]);
+    }
+    return error;
+}
@@ -0,0 +1,217 @@
+/**************************************************************************/ /**
+ * @file      BenchProtocolKernels.c
+ * @brief     Benchmark kernels of the network code paths that need no network
+ * @details   The stream writer that formats HTTP requests, the HTTP client parsing a download as the WINC1500
+ *            delivers it, and MQTT PUBLISH packets through pahomqtt. They build on target and on Linux
+ *            (Tools/benchhost.c), where the same code is also checked for correctness.
+ * @author
+ * @date      2026-10-17
+
+ ******************************************************************************/
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "Bench.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "MQTTPacket/MQTTPacket.h"
+#include "iot/http/http_client.h"
+#include "iot/stream_writer.h"
+
+/******************************************************************************
+ * Defines
+ ******************************************************************************/
+#define BENCH_WRITER_BUFFER 64      ///< Buffer of the stream writer, flushed when full
+#define BENCH_WRITER_BYTES 256      ///< Bytes sent per call of the writer kernel
+#define BENCH_HTTP_BUFFER 512       ///< Same as MAIN_BUFFER_MAX_SIZE of the download
+#define BENCH_HTTP_BODY 1024        ///< Longer than the buffer, so it arrives as chunked data like a download
+#define BENCH_HTTP_PACKET 256       ///< Bytes per receive, as the WINC1500 hands them over
+#define BENCH_MQTT_PAYLOAD 128      ///< Payload of the PUBLISH packets
+#define BENCH_MQTT_TOPIC "memo/printer"
+
+/******************************************************************************
+ * Local Function Declaration
+ ******************************************************************************/
+static int writer_flush(void *module, char *buffer, size_t buffer_len);
+static int32_t writer_run(void);
+static void http_callback(struct http_client_module *module_inst, int type, union http_client_data *data);
+static int32_t http_setup(void);
+static int32_t http_run(void);
+static int32_t mqtt_run(void);
+
+// Entry of the parser from the socket callback, internal to http_client.c
+void _http_client_recved_packet(struct http_client_module *const module, int read_len);
+
+/******************************************************************************
+ * Variables
+ ******************************************************************************/
+static struct stream_writer benchWriter;                  ///< Writer of the writer kernel
+static struct http_client_module benchHttp;               ///< Client of the HTTP kernel, never connected
+static char benchHttpBuffer[BENCH_HTTP_BUFFER + 1];       ///< Receive buffer. The extra byte stays 0 for the header parser's strstr
+static char benchHttpResponse[160 + BENCH_HTTP_BODY];     ///< Response fed to the client
+static size_t benchHttpResponseLength;                    ///< Bytes in benchHttpResponse
+static struct BenchHttpTotals benchHttpTotals;            ///< What the client reported for the last response
+static volatile uint32_t benchProtocolSink;               ///< Results of the kernels, kept so they are not optimized away
+
+static const struct BenchKernel writerKernel = {"stream.wr", "Stream writer, 256 bytes one at a time", BENCH_WRITER_BYTES, BENCH_WRITER_BYTES, NULL, writer_run, NULL};
+static const struct BenchKernel httpKernel = {"http.resp", "HTTP client parsing a 1 kB download", 1, BENCH_HTTP_BODY, http_setup, http_run, NULL};
+static const struct BenchKernel mqttKernel = {"mqtt.pub", "MQTT PUBLISH of 128 bytes, serialize and parse", 2, BENCH_MQTT_PAYLOAD, NULL, mqtt_run, NULL};
+
+/******************************************************************************
+ * Global Functions
+ ******************************************************************************/
+
+/**
+ * @fn          void BenchRegisterProtocolKernels(void)
+ * @brief       Lists the kernels of this file
+ */
+void BenchRegisterProtocolKernels(void)
+{
+    BenchRegister(&writerKernel);
+    BenchRegister(&httpKernel);
+    BenchRegister(&mqttKernel);
+}
+
+/**
+ * @fn          int32_t BenchHttpParse(const char *response, size_t length, size_t packet, struct BenchHttpTotals *totals)
+ * @brief       Feeds a response to an HTTP client that is not connected, as the socket callback would
+ * @param[in]   response Status line, headers and body
+ * @param[in]   length Bytes in response
+ * @param[in]   packet Bytes per receive
+ * @param[out]  totals What the client reported through its callback
+ * @return      0, or -1 if the client stopped taking data
+ */
+int32_t BenchHttpParse(const char *response, size_t length, size_t packet, struct BenchHttpTotals *totals)
+{
+    memset(&benchHttp, 0, sizeof(benchHttp));
+    memset(&benchHttpTotals, 0, sizeof(benchHttpTotals));
+    benchHttp.config.recv_buffer = benchHttpBuffer;
+    benchHttp.config.recv_buffer_size = BENCH_HTTP_BUFFER;
+    benchHttp.config.timeout = 0;  // No sw_timer to stop
+    benchHttp.cb = http_callback;
+    benchHttpBuffer[BENCH_HTTP_BUFFER] = '\0';
+
+    for (size_t offset = 0; offset < length;) {
+        size_t chunk = length - offset;
+
+        if (chunk > packet) {
+            chunk = packet;
+        }
+        if (chunk > BENCH_HTTP_BUFFER - benchHttp.recved_size) {
+            chunk = BENCH_HTTP_BUFFER - benchHttp.recved_size;
+        }
+        if (0 == chunk || benchHttpTotals.disconnected) {
+            *totals = benchHttpTotals;
+            return -1;
+        }
+        memcpy(benchHttpBuffer + benchHttp.recved_size, response + offset, chunk);
+        _http_client_recved_packet(&benchHttp, (int)chunk);
+        offset += chunk;
+    }
+    *totals = benchHttpTotals;
+    return 0;
+}
+
+/******************************************************************************
+ * Local Functions
+ ******************************************************************************/
+
+static int writer_flush(void *module, char *buffer, size_t buffer_len)
+{
+    benchProtocolSink += (uint8_t)buffer[0] + buffer_len;
+    return 0;
+}
+
+static int32_t writer_run(void)
+{
+    stream_writer_init(&benchWriter, (char *)benchBuffer, BENCH_WRITER_BUFFER, writer_flush, NULL);
+    stream_writer_send_buffer(&benchWriter, (const char *)&benchBuffer[BENCH_WRITER_BUFFER], BENCH_WRITER_BYTES);
+    stream_writer_send_remain(&benchWriter);
+    return 0;
+}
+
+static void http_callback(struct http_client_module *module_inst, int type, union http_client_data *data)
+{
+    switch (type) {
+        case HTTP_CLIENT_CALLBACK_RECV_RESPONSE:
+            benchHttpTotals.responseCode = data->recv_response.response_code;
+            benchHttpTotals.contentLength = data->recv_response.content_length;
+            if (NULL != data->recv_response.content) {
+                benchHttpTotals.bodyBytes += data->recv_response.content_length;
+                for (int i = 0; i < data->recv_response.content_length; i++) {
+                    benchHttpTotals.bodySum += (uint8_t)data->recv_response.content[i];
+                }
+                benchHttpTotals.complete = true;
+            }
+            break;
+        case HTTP_CLIENT_CALLBACK_RECV_CHUNKED_DATA:
+            benchHttpTotals.chunks++;
+            benchHttpTotals.bodyBytes += data->recv_chunked_data.length;
+            for (uint32_t i = 0; i < data->recv_chunked_data.length; i++) {
+                benchHttpTotals.bodySum += (uint8_t)data->recv_chunked_data.data[i];
+            }
+            benchHttpTotals.complete = data->recv_chunked_data.is_complete;
+            break;
+        case HTTP_CLIENT_CALLBACK_DISCONNECTED:
+            benchHttpTotals.disconnected = true;
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @fn          static int32_t http_setup(void)
+ * @brief       Builds a keep alive response with a body longer than the receive buffer
+ * @details     Keep alive, so the client never closes its (unconnected) socket.
+ */
+static int32_t http_setup(void)
+{
+    int header = snprintf(benchHttpResponse, sizeof(benchHttpResponse),
+                          "HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\nContent-Length: %d\r\nConnection: keep-alive\r\n\r\n",
+                          BENCH_HTTP_BODY);
+
+    for (uint32_t i = 0; i < BENCH_HTTP_BODY; i++) {
+        benchHttpResponse[header + i] = (char)(i * 31);
+    }
+    benchHttpResponseLength = (size_t)header + BENCH_HTTP_BODY;
+    return 0;
+}
+
+static int32_t http_run(void)
+{
+    struct BenchHttpTotals totals;
+
+    if (BenchHttpParse(benchHttpResponse, benchHttpResponseLength, BENCH_HTTP_PACKET, &totals) < 0 || BENCH_HTTP_BODY != totals.bodyBytes ||
+        !totals.complete) {
+        return -1;
+    }
+    benchProtocolSink = totals.bodySum;
+    return 0;
+}
+
+static int32_t mqtt_run(void)
+{
+    MQTTString topic = MQTTString_initializer;
+    MQTTString parsedTopic;
+    unsigned char dup;
+    unsigned char retained;
+    unsigned short packetId;
+    unsigned char *payload;
+    int payloadLength;
+    int qos;
+    int length;
+
+    topic.cstring = BENCH_MQTT_TOPIC;
+    length = MQTTSerialize_publish(benchBuffer, BENCH_BUFFER_SIZE / 2, 0, 1, 0, 42, topic, &benchBuffer[BENCH_BUFFER_SIZE / 2],
+                                   BENCH_MQTT_PAYLOAD);
+    if (length <= 0 || 1 != MQTTDeserialize_publish(&dup, &qos, &retained, &packetId, &parsedTopic, &payload, &payloadLength, benchBuffer, length) ||
+        BENCH_MQTT_PAYLOAD != payloadLength) {
+        return -1;
+    }
+    benchProtocolSink = packetId + payload[0];
+    return 0;
+}
@@ -0,0 +1,154 @@
+/**************************************************************************/ /**
+ * @file      BenchTarget.c
+ * @brief     Benchmark timer and the kernels that need the hardware
+ * @details   The timer is the run time stats counter (TC4/TC5). The kernels time an I2C read of the IMU, SPI
+ *            transfers on the WINC1500 bus with its chip select left high, and the DSU CRC32 against the software
+ *            one of BenchKernels.c.
+ * @author
+ * @date      2026-10-17
+
+ ******************************************************************************/
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "Bench.h"
+
+#include <asf.h>
+
+#include "ASF/sam0/drivers/dsu/crc32/crc32.h"
+#include "FreeRTOS.h"
+#include "I2cDriver/I2cDriver.h"
+#include "IMU/lsm6dso_reg.h"
+#include "RunTimeStats/RunTimeStats.h"
+#include "config/conf_winc.h"
+#include "task.h"
+
+/******************************************************************************
+ * Defines
+ ******************************************************************************/
+#define BENCH_IMU_ADDRESS (LSM6DSO_I2C_ADD_L >> 1)  ///< 7 bit address of the IMU
+#define BENCH_I2C_WAIT_MS 100                       ///< Longest wait for an I2C transfer
+#define BENCH_SPI_BLOCK 512                         ///< Bytes per SPI transfer
+
+/******************************************************************************
+ * Local Function Declaration
+ ******************************************************************************/
+static int32_t i2c_imu_setup(void);
+static int32_t i2c_imu_run(void);
+static int32_t spi_winc_run(void);
+static int32_t crc32_dsu_setup(void);
+static int32_t crc32_dsu_run(void);
+
+/******************************************************************************
+ * Variables
+ ******************************************************************************/
+extern struct spi_module master;  ///< SPI bus of the WINC1500, owned by nm_bus_wrapper_samd21.c
+
+static const uint8_t whoAmIRegister = LSM6DSO_WHO_AM_I;  ///< Register read by the I2C kernel
+static uint8_t whoAmI;                                   ///< Value read by the I2C kernel
+static volatile uint32_t benchTargetSink;                ///< Results of the compute kernels
+
+static const struct BenchKernel i2cImuKernel = {"i2c.imu", "I2cReadDataWait of the IMU WHO_AM_I register", 1, 1, i2c_imu_setup, i2c_imu_run, NULL};
+static const struct BenchKernel spiWincKernel = {"spi.winc", "SPI transfer of 512 bytes on the WINC1500 bus", 1, BENCH_SPI_BLOCK, NULL, spi_winc_run, NULL};
+static const struct BenchKernel crc32DsuKernel = {"crc32.dsu", "DSU CRC32 over 1 kB", 1, BENCH_BUFFER_SIZE, crc32_dsu_setup, crc32_dsu_run, NULL};
+
+/******************************************************************************
+ * Global Functions
+ ******************************************************************************/
+
+/**
+ * @fn          uint32_t BenchTimerGet(void)
+ * @brief       Reads the benchmark timer
+ * @return      Counts of RunTimeStatsTimerGet
+ */
+uint32_t BenchTimerGet(void)
+{
+    return RunTimeStatsTimerGet();
+}
+
+/**
+ * @fn          uint32_t BenchTimerHz(void)
+ * @brief       Frequency of the benchmark timer
+ * @return      Counts per second
+ */
+uint32_t BenchTimerHz(void)
+{
+    return RunTimeStatsTimerHz();
+}
+
+/**
+ * @fn          void BenchRegisterPlatformKernels(void)
+ * @brief       Lists the kernels of this file
+ */
+void BenchRegisterPlatformKernels(void)
+{
+    BenchRegister(&i2cImuKernel);
+    BenchRegister(&spiWincKernel);
+    BenchRegister(&crc32DsuKernel);
+}
+
+/******************************************************************************
+ * Local Functions
+ ******************************************************************************/
+
+/**
+ * @fn          static int32_t i2c_imu_setup(void)
+ * @brief       Checks that the IMU answers, so a missing board fails once instead of on every sample
+ * @return      0, or the I2C error
+ */
+static int32_t i2c_imu_setup(void)
+{
+    int32_t error = i2c_imu_run();
+
+    return (ERROR_NONE == error && LSM6DSO_ID != whoAmI) ? ERROR_UNSUPPORTED_DEV : error;
+}
+
+static int32_t i2c_imu_run(void)
+{
+    I2C_Data data;
+
+    data.address = BENCH_IMU_ADDRESS;
+    data.msgOut = &whoAmIRegister;
+    data.lenOut = sizeof(whoAmIRegister);
+    data.msgIn = &whoAmI;
+    data.lenIn = sizeof(whoAmI);
+    return I2cReadDataWait(&data, 0, BENCH_I2C_WAIT_MS);
+}
+
+/**
+ * @fn          static int32_t spi_winc_run(void)
+ * @brief       Clocks BENCH_SPI_BLOCK bytes on the WINC1500 bus with the chip select high
+ * @details     The WINC1500 ignores the bus while it is not selected, so this measures the transfer alone. The
+ *              scheduler is held so the WiFi task cannot start a transaction in the middle.
+ * @return      0, ERROR_BUSY if the WiFi task was suspended in the middle of a transaction, or the SPI error
+ */
+static int32_t spi_winc_run(void)
+{
+    enum status_code status = STATUS_BUSY;
+
+    vTaskSuspendAll();
+    if (port_pin_get_output_level(CONF_WINC_SPI_CS_PIN)) {
+        status = spi_transceive_buffer_wait(&master, benchBuffer, &benchBuffer[BENCH_SPI_BLOCK], BENCH_SPI_BLOCK);
+    }
+    xTaskResumeAll();
+
+    return (STATUS_OK == status) ? ERROR_NONE : (STATUS_BUSY == status) ? ERROR_BUSY : ERROR_IO;
+}
+
+static int32_t crc32_dsu_setup(void)
+{
+    dsu_crc32_init();
+    return 0;
+}
+
+static int32_t crc32_dsu_run(void)
+{
+    uint32_t crc = 0xFFFFFFFF;
+
+    if (STATUS_OK != dsu_crc32_cal((uint32_t)benchBuffer, BENCH_BUFFER_SIZE, &crc)) {
+        return ERROR_IO;
+    }
+    benchTargetSink = crc;
+    return 0;
+}
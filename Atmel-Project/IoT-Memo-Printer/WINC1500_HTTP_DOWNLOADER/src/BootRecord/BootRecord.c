@@ -0,0 +1,58 @@
+/**************************************************************************/ /**
+ * @file      BootRecord.c
+ * @brief     Boot phase timing left in RAM by the bootloader
+ * @details   The record is only trusted if its magic, size and check word match: after a power up, or with
+ *            an older bootloader, the section holds whatever the RAM powered up with.
+ * @author
+ * @date      2026-10-17
+
+ ******************************************************************************/
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "BootRecord/BootRecord.h"
+
+#include <stddef.h>
+
+/******************************************************************************
+ * Variables
+ ******************************************************************************/
+static const char *const bootPhaseNames[BOOT_PHASE_COUNT] = {"init", "sd init", "mount", "flags", "check", "flash", " read", " erase", " program", " verify", "deinit"};
+
+/******************************************************************************
+ * Global Functions
+ ******************************************************************************/
+
+/**
+ * @fn          const struct BootRecord *BootRecordGet(void)
+ * @brief       Returns the record of the last boot
+ * @return      Pointer to the record, or NULL if the bootloader did not leave a valid one
+ */
+const struct BootRecord *BootRecordGet(void)
+{
+    const struct BootRecord *record = (const struct BootRecord *)BOOT_RECORD_ADDRESS;
+    const uint32_t *word = (const uint32_t *)record;
+    uint32_t sum = 0;
+
+    if (record->magic != BOOT_RECORD_MAGIC || record->size != sizeof(struct BootRecord) || record->phaseCount != BOOT_PHASE_COUNT) {
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < offsetof(struct BootRecord, check) / 4; i++) {
+        sum += word[i];
+    }
+
+    return (record->check == ~sum) ? record : NULL;
+}
+
+/**
+ * @fn          const char *BootRecordPhaseName(uint32_t phase)
+ * @brief       Returns the name of a boot phase, as printed by the bootloader
+ * @param[in]   phase  enum BootPhase value
+ * @return      Name of the phase. Sub-phases of the flash phase start with a space
+ */
+const char *BootRecordPhaseName(uint32_t phase)
+{
+    return (phase < BOOT_PHASE_COUNT) ? bootPhaseNames[phase] : "?";
+}
@@ -0,0 +1,66 @@
+/**************************************************************************/ /**
+ * @file      BootRecord.h
+ * @brief     Boot phase timing left in RAM by the bootloader
+ * @details   The bootloader times each boot phase and leaves the record of the last boot in the .bootrecord
+ *            section (last 256 bytes of RAM, reserved by the linker script). The layout must match
+ *            SD_MMC_Bootloader/src/BootTiming/BootTiming.h.
+ * @author
+ * @date      2026-10-17
+
+ ******************************************************************************/
+
+#ifndef BOOT_RECORD_H
+#define BOOT_RECORD_H
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include <asf.h>
+
+/******************************************************************************
+ * Defines
+ ******************************************************************************/
+#define BOOT_RECORD_ADDRESS ((uint32_t)0x20007F00)  ///< Start of the .bootrecord section
+#define BOOT_RECORD_MAGIC 0x43455242UL               ///< "BREC" read as a little endian word
+
+#define BOOT_RECORD_FLAG_SD 0x00000001UL       ///< The SD card was mounted (update requested or no application)
+#define BOOT_RECORD_FLAG_UPDATED 0x00000002UL  ///< A new image was flashed and verified
+
+/******************************************************************************
+ * Structures and Enumerations
+ ******************************************************************************/
+/// Boot phases, in the order they run. The FLASH_* phases split BOOT_PHASE_FLASH and are not added to the total
+enum BootPhase {
+    BOOT_PHASE_INIT = 0,
+    BOOT_PHASE_SD_INIT,
+    BOOT_PHASE_MOUNT,
+    BOOT_PHASE_FLAGS,
+    BOOT_PHASE_CHECK,
+    BOOT_PHASE_FLASH,
+    BOOT_PHASE_FLASH_READ,
+    BOOT_PHASE_FLASH_ERASE,
+    BOOT_PHASE_FLASH_PROGRAM,
+    BOOT_PHASE_FLASH_VERIFY,
+    BOOT_PHASE_DEINIT,
+    BOOT_PHASE_COUNT
+};
+
+/// Record of one boot, as written by the bootloader
+struct BootRecord {
+    uint32_t magic;                      ///< BOOT_RECORD_MAGIC
+    uint16_t size;                       ///< sizeof(struct BootRecord)
+    uint16_t phaseCount;                 ///< BOOT_PHASE_COUNT
+    uint32_t flags;                      ///< BOOT_RECORD_FLAG_*
+    int32_t updateStatus;                ///< Result of the update (enum status_code). STATUS_OK if there was none
+    uint32_t phaseUs[BOOT_PHASE_COUNT];  ///< Time spent in each phase, in us
+    uint32_t totalUs;                    ///< Time from the bootloader Systick start to the jump, in us
+    uint32_t check;                      ///< Complement of the sum of the words above
+};
+
+/******************************************************************************
+ * Global Function Declarations
+ ******************************************************************************/
+const struct BootRecord *BootRecordGet(void);
+const char *BootRecordPhaseName(uint32_t phase);
+
+#endif /*BOOT_RECORD_H*/
@@ -0,0 +1,70 @@
+/**************************************************************************/ /**
+ * @file      BootRequest.c
+ * @brief     Requests to the bootloader, passed through a reserved NVM row
+ * @details   The request is three words at the start of BOOT_REQUEST_ROW_ADDRESS: BOOT_REQUEST_MAGIC, the
+ *            request bits and their complement. The bootloader erases the row once it has served the request.
+ * @author
+ * @date      2026-10-17
+
+ ******************************************************************************/
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "BootRequest/BootRequest.h"
+
+#include <string.h>
+
+/******************************************************************************
+ * Global Functions
+ ******************************************************************************/
+
+/**
+ * @fn          int32_t BootRequestSet(uint32_t requests)
+ * @brief       Leaves a request for the bootloader. It is served on the next reset
+ * @details     Pending requests are kept: the new bits are added to them. The CPU stalls while the row is erased
+ *              and written (a few ms), so call it right before the reset.
+ * @param[in]   requests  BOOT_REQUEST_* bits
+ * @return      STATUS_OK on success, error reported by the NVM driver otherwise
+ */
+int32_t BootRequestSet(uint32_t requests)
+{
+    struct nvm_config configNvm;
+    const uint32_t *current = (const uint32_t *)BOOT_REQUEST_ROW_ADDRESS;
+    uint32_t page[NVMCTRL_PAGE_SIZE / 4];
+    int32_t error;
+
+    // The NVM driver needs the page size and count before the first write
+    nvm_get_config_defaults(&configNvm);
+    configNvm.manual_page_write = false;
+    error = nvm_set_config(&configNvm);
+    if (STATUS_OK != error) goto exit;
+
+    if (current[0] == BOOT_REQUEST_MAGIC && current[1] == ~current[2]) {
+        requests |= current[1];
+    }
+
+    memset(page, 0xFF, sizeof(page));
+    page[0] = BOOT_REQUEST_MAGIC;
+    page[1] = requests;
+    page[2] = ~requests;
+
+    do {
+        error = nvm_erase_row(BOOT_REQUEST_ROW_ADDRESS);
+    } while (STATUS_BUSY == error);
+    if (STATUS_OK != error) goto exit;
+
+    do {
+        error = nvm_write_buffer(BOOT_REQUEST_ROW_ADDRESS, (const uint8_t *)page, NVMCTRL_PAGE_SIZE);
+    } while (STATUS_BUSY == error);
+    if (STATUS_OK != error) goto exit;
+
+    while (!nvm_is_ready()) {
+    }
+    if (NVM_ERROR_NONE != nvm_get_error()) {
+        error = STATUS_ABORTED;
+    }
+
+exit:
+    return error;
+}
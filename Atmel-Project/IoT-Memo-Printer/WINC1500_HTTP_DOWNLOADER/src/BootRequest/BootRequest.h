@@ -0,0 +1,38 @@
+/**************************************************************************/ /**
+ * @file      BootRequest.h
+ * @brief     Requests to the bootloader, passed through a reserved NVM row
+ * @details   The bootloader only mounts the SD card when a request is pending, so the application must
+ *            call BootRequestSet(BOOT_REQUEST_UPDATE) once a new image and its flag file are on the SD card,
+ *            then reset. The row layout must match SD_MMC_Bootloader/src/BootInfo/BootInfo.h.
+ * @author
+ * @date      2026-10-17
+
+ ******************************************************************************/
+
+#ifndef BOOT_REQUEST_H
+#define BOOT_REQUEST_H
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include <asf.h>
+
+/******************************************************************************
+ * Defines
+ ******************************************************************************/
+#define BOOT_REQUEST_ROW_ADDRESS ((uint32_t)0x11E00)  ///< Reserved NVM row, below the bootloader record row and the application
+#define BOOT_REQUEST_MAGIC 0x51455242UL               ///< "BREQ" read as a little endian word. Marks a valid request
+
+#define BOOT_REQUEST_UPDATE 0x00000001UL      ///< Mount the SD card and look for an update flag file
+#define BOOT_REQUEST_DIAGNOSTIC 0x00000002UL  ///< Also run the SD card write test
+
+/******************************************************************************
+ * Structures and Enumerations
+ ******************************************************************************/
+
+/******************************************************************************
+ * Global Function Declarations
+ ******************************************************************************/
+int32_t BootRequestSet(uint32_t requests);
+
+#endif /*BOOT_REQUEST_H*/
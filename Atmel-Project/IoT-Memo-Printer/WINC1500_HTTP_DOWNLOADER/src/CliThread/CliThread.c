@@ -15,10 +15,22 @@
 #include "IMU\lsm6dso_reg.h"
 #include "SeesawDriver/Seesaw.h"
 #include "WifiHandlerThread/WifiHandler.h"
+#include "BootRecord/BootRecord.h"
+#include "RunTimeStats/RunTimeStats.h"
+#include "SensorStream/SensorStream.h"
+#include "Bench/Bench.h"
+#include "Memory/Heap.h"
+#include "Memory/MemoryPool.h"
+#include "RamPlan/RamPlan.h"
+#include "Power/Power.h"
 
 /******************************************************************************
  * Defines
  ******************************************************************************/
+#define CLI_TOP_MAX_TASKS 10            ///< Tasks "top" can show
+#define CLI_TOP_DEFAULT_WINDOW_MS 1000  ///< Window over which "top" measures CPU usage, if none is given
+#define CLI_TOP_MAX_WINDOW_MS 60000     ///< Longest window. Well below the wrap of the run time counter
+#define CLI_STREAM_DEFAULT_RATE_HZ 100  ///< Sample rate of "stream", if none is given
 
 /******************************************************************************
  * Variables
@@ -31,6 +43,40 @@ static const CLI_Command_Definition_t xOTAUCommand = {"fw", "fw: Download a file
 
 static const CLI_Command_Definition_t xResetCommand = {"reset", "reset: Resets the device\r\n", (const pdCOMMAND_LINE_CALLBACK)CLI_ResetDevice, 0};
 
+static const CLI_Command_Definition_t xBootTimeCommand = {"boottime", "boottime: Prints the boot phase timing left by the bootloader\r\n", (const pdCOMMAND_LINE_CALLBACK)CLI_BootTime, 0};
+
+static const CLI_Command_Definition_t xTopCommand = {"top",
+                                                     "top [ms]: Shows CPU usage per task over a window, stack high water marks, heap and queue fill\r\n",
+                                                     (const pdCOMMAND_LINE_CALLBACK)CLI_Top,
+                                                     -1};
+
+static const CLI_Command_Definition_t xLogModeCommand = {"logmode",
+                                                         "logmode [text|binary]: Sets or prints how log messages are sent. Decode binary logs with Tools/logdecode\r\n",
+                                                         (const pdCOMMAND_LINE_CALLBACK)CLI_LogMode,
+                                                         -1};
+
+static const CLI_Command_Definition_t xLogLevelCommand = {"loglevel",
+                                                          "loglevel [module|all] [info|debug|warning|error|fatal|off]: Sets or prints the log level of each module\r\n",
+                                                          (const pdCOMMAND_LINE_CALLBACK)CLI_LogLevel,
+                                                          -1};
+
+static const CLI_Command_Definition_t xStreamCommand = {"stream",
+                                                        "stream [imu,dist,temp|all|stop] [hz]: Streams sensor samples as binary packets. Capture with Tools/streamcap\r\n",
+                                                        (const pdCOMMAND_LINE_CALLBACK)CLI_Stream,
+                                                        -1};
+
+static const CLI_Command_Definition_t xBenchCommand = {"bench",
+                                                       "bench [kernel|all] [samples]: Times benchmark kernels: min, median and max per operation. Lists them without parameters\r\n",
+                                                       (const pdCOMMAND_LINE_CALLBACK)CLI_Bench,
+                                                       -1};
+
+static const CLI_Command_Definition_t xMemCommand = {"mem", "mem: Shows the heap counters and the use of each memory pool\r\n", (const pdCOMMAND_LINE_CALLBACK)CLI_Mem, 0};
+
+static const CLI_Command_Definition_t xPowerCommand = {"power",
+                                                       "power [clear]: Shows the time spent in each sleep mode and the locks held on it\r\n",
+                                                       (const pdCOMMAND_LINE_CALLBACK)CLI_Power,
+                                                       -1};
+
 static const CLI_Command_Definition_t xNeotrellisTurnLEDCommand = {"led",
                                                                    "led [keynum][R][G][B]: Sets the given LED to the given R,G,B values.\r\n",
                                                                    (const pdCOMMAND_LINE_CALLBACK)CLI_NeotrellisSetLed,
@@ -56,7 +102,8 @@ static const CLI_Command_Definition_t xI2cScan = {"i2c", "i2c: Scans I2C bus\r\n
 // Clear screen command
 const CLI_Command_Definition_t xClearScreen = {CLI_COMMAND_CLEAR_SCREEN, CLI_HELP_CLEAR_SCREEN, CLI_CALLBACK_CLEAR_SCREEN, CLI_PARAMS_CLEAR_SCREEN};
 
-SemaphoreHandle_t cliCharReadySemaphore;  ///< Semaphore to indicate that a character has been received
+SemaphoreHandle_t cliCharReadySemaphore;  ///< Semaphore to indicate that characters have been received. Given once per burst, or per half RX buffer
+static StaticSemaphore_t cliCharReadySemaphoreBuffer RAM_PLAN(cli);  ///< Control block of cliCharReadySemaphore
 
 /******************************************************************************
  * Forward Declarations
@@ -77,12 +124,23 @@ void vCommandConsoleTask(void *pvParameters)
     FreeRTOS_CLIRegisterCommand(&xImuGetCommand);
     FreeRTOS_CLIRegisterCommand(&xClearScreen);
     FreeRTOS_CLIRegisterCommand(&xResetCommand);
+    FreeRTOS_CLIRegisterCommand(&xBootTimeCommand);
+    FreeRTOS_CLIRegisterCommand(&xTopCommand);
+    FreeRTOS_CLIRegisterCommand(&xLogModeCommand);
+    FreeRTOS_CLIRegisterCommand(&xLogLevelCommand);
+    FreeRTOS_CLIRegisterCommand(&xStreamCommand);
+    FreeRTOS_CLIRegisterCommand(&xBenchCommand);
+    FreeRTOS_CLIRegisterCommand(&xMemCommand);
+    FreeRTOS_CLIRegisterCommand(&xPowerCommand);
     FreeRTOS_CLIRegisterCommand(&xNeotrellisTurnLEDCommand);
     FreeRTOS_CLIRegisterCommand(&xNeotrellisProcessButtonCommand);
     FreeRTOS_CLIRegisterCommand(&xDistanceSensorGetDistance);
     FreeRTOS_CLIRegisterCommand(&xSendDummyGameData);
 	FreeRTOS_CLIRegisterCommand(&xI2cScan);
 
+    BenchRegisterPortableKernels();
+    BenchRegisterPlatformKernels();
+
     char cRxedChar[2];
     unsigned char cInputIndex = 0;
     BaseType_t xMoreDataToFollow;
@@ -101,9 +159,9 @@ void vCommandConsoleTask(void *pvParameters)
     SerialConsoleWriteString((char *)pcWelcomeMessage);
 
     // Any semaphores/mutexes/etc you needed to be initialized, you can do them here
-    cliCharReadySemaphore = xSemaphoreCreateBinary();
+    cliCharReadySemaphore = xSemaphoreCreateBinaryStatic(&cliCharReadySemaphoreBuffer);
     if (cliCharReadySemaphore == NULL) {
-        LogMessage(LOG_ERROR_LVL, "Could not allocate semaphore\r\n");
+        LOG_ERROR(GENERAL, "Could not allocate semaphore\r\n");
         vTaskSuspend(NULL);
     }
 
@@ -127,17 +185,19 @@ void vCommandConsoleTask(void *pvParameters)
             do {
                 /* Send the command string to the command interpreter.  Any
                 output generated by the command interpreter will be placed in the
-                pcOutputString buffer. */
+                pcOutputString buffer. Commands with long output stream it with
+                SerialConsolePrintf instead and leave the buffer empty. */
+                pcOutputString[0] = 0;
                 xMoreDataToFollow = FreeRTOS_CLIProcessCommand(pcInputString,        /* The command string.*/
                                                                pcOutputString,       /* The output buffer. */
                                                                MAX_OUTPUT_LENGTH_CLI /* The size of the output buffer. */
                 );
 
                 /* Write the output generated by the command interpreter to the
-                console. */
+                console, waiting for room in the TX ring rather than dropping it. */
                 // Ensure it is null terminated
                 pcOutputString[MAX_OUTPUT_LENGTH_CLI - 1] = 0;
-                SerialConsoleWriteString(pcOutputString);
+                SerialConsoleWrite(pcOutputString, strlen(pcOutputString));
 
             } while (xMoreDataToFollow != pdFALSE);
 
@@ -146,7 +206,6 @@ void vCommandConsoleTask(void *pvParameters)
             to receive the next command. */
             cInputIndex = 0;
             memset(pcInputString, 0x00, MAX_INPUT_LENGTH_CLI);
-            memset(pcOutputString, 0, MAX_OUTPUT_LENGTH_CLI);
         } else {
             /* The if() clause performs the processing after a newline character
 is received.  This else clause performs the processing if any other
@@ -220,7 +279,9 @@ character is received. */
 /**
  * @fn			void FreeRTOS_read(char* character)
  * @brief		This function block the thread unless we received a character
- * @details		This function blocks until UartSemaphoreHandle is released to continue reading characters in CLI
+ * @details		This function blocks until UartSemaphoreHandle is released to continue reading characters in CLI.
+ *				The serial console gives it once per burst of characters (see SerialConsole.c), so the characters of
+ *				a pasted line are read here back to back without blocking.
  * @note
  */
 static void FreeRTOS_read(char *character)
@@ -317,6 +378,391 @@ BaseType_t CLI_ResetDevice(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const
     return pdFALSE;
 }
 
+/**
+ BaseType_t CLI_BootTime( int8_t *pcWriteBuffer,size_t xWriteBufferLen,const int8_t *pcCommandString )
+ * @brief	CLI command to print the boot phase timing the bootloader left in RAM (see BootRecord/BootRecord.h)
+ * @param[out] *pcWriteBuffer. Unused: the table is streamed with SerialConsolePrintf
+ * @param[in] xWriteBufferLen. How much we can write into the buffer
+ * @param[in] *pcCommandString. Buffer that contains the complete input.
+ * @return		Returns pdFALSE, the CLI command finished.
+ * @note        Phases that did not run are left out.
+ */
+BaseType_t CLI_BootTime(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString)
+{
+    const struct BootRecord *record = BootRecordGet();
+
+    if (NULL == record) {
+        SerialConsolePrintf("No boot record\r\n");
+        return pdFALSE;
+    }
+
+    SerialConsolePrintf("Boot %lu.%03lu ms, flags 0x%lX, update %ld\r\n", (unsigned long)(record->totalUs / 1000UL), (unsigned long)(record->totalUs % 1000UL),
+                        (unsigned long)record->flags, (long)record->updateStatus);
+    for (uint32_t phase = 0; phase < BOOT_PHASE_COUNT; phase++) {
+        if (0 != record->phaseUs[phase]) {
+            SerialConsolePrintf("%-9s %6lu.%03lu\r\n", BootRecordPhaseName(phase), (unsigned long)(record->phaseUs[phase] / 1000UL),
+                                (unsigned long)(record->phaseUs[phase] % 1000UL));
+        }
+    }
+    return pdFALSE;
+}
+
+/**
+ BaseType_t CLI_Top( int8_t *pcWriteBuffer,size_t xWriteBufferLen,const int8_t *pcCommandString )
+ * @brief	CLI command to show what each task costs: CPU share over a window, and the least stack it ever had free.
+ Also prints the free heap, its minimum ever, and the fill level of the queues listed with RunTimeStatsAddQueue.
+ * @param[out] *pcWriteBuffer. Usage errors only: the table is streamed with SerialConsolePrintf
+ * @param[in] xWriteBufferLen. How much we can write into the buffer
+ * @param[in] *pcCommandString. Buffer that contains the complete input. The optional parameter is the window in ms.
+ * @return		Returns pdFALSE, the CLI command finished.
+ * @note        Blocks the CLI task for the window. Stack is in words, as the task sizes are given.
+ */
+BaseType_t CLI_Top(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString)
+{
+    static TaskStatus_t tasks[CLI_TOP_MAX_TASKS];
+    static TaskHandle_t startHandles[CLI_TOP_MAX_TASKS];
+    static uint32_t startRunTime[CLI_TOP_MAX_TASKS];
+    static const char taskStates[] = {'X', 'R', 'B', 'S', 'D', '?'};  // Per eTaskState
+    BaseType_t length = 0;
+    const char *window = FreeRTOS_CLIGetParameter((const char *)pcCommandString, 1, &length);
+    uint32_t windowMs = (NULL != window) ? strtoul(window, NULL, 10) : CLI_TOP_DEFAULT_WINDOW_MS;
+    UBaseType_t startCount;
+    UBaseType_t taskCount;
+    uint32_t startTotal;
+    uint32_t totalRunTime;
+    const char *queueName;
+    QueueHandle_t queue;
+
+    if (0 == windowMs || windowMs > CLI_TOP_MAX_WINDOW_MS) {
+        snprintf((char *)pcWriteBuffer, xWriteBufferLen, "Usage: top [1..%u ms]\r\n", CLI_TOP_MAX_WINDOW_MS);
+        return pdFALSE;
+    }
+    if (uxTaskGetNumberOfTasks() > CLI_TOP_MAX_TASKS) {
+        snprintf((char *)pcWriteBuffer, xWriteBufferLen, "More than %u tasks\r\n", CLI_TOP_MAX_TASKS);
+        return pdFALSE;
+    }
+
+    // Run time of every task at the start and at the end of the window
+    startCount = uxTaskGetSystemState(tasks, CLI_TOP_MAX_TASKS, &startTotal);
+    for (UBaseType_t i = 0; i < startCount; i++) {
+        startHandles[i] = tasks[i].xHandle;
+        startRunTime[i] = tasks[i].ulRunTimeCounter;
+    }
+    vTaskDelay(pdMS_TO_TICKS(windowMs));
+    taskCount = uxTaskGetSystemState(tasks, CLI_TOP_MAX_TASKS, &totalRunTime);
+    for (UBaseType_t i = 0; i < taskCount; i++) {
+        for (UBaseType_t j = 0; j < startCount; j++) {
+            if (startHandles[j] == tasks[i].xHandle) {
+                tasks[i].ulRunTimeCounter -= startRunTime[j];
+                break;
+            }
+        }
+    }
+    totalRunTime -= startTotal;
+
+    SerialConsolePrintf("%lu ms, %lu counts/s. Heap free %u, min %u of %u bytes\r\n", (unsigned long)windowMs, (unsigned long)RunTimeStatsTimerHz(),
+                        (unsigned int)xPortGetFreeHeapSize(), (unsigned int)xPortGetMinimumEverFreeHeapSize(), (unsigned int)configTOTAL_HEAP_SIZE);
+    SerialConsolePrintf("%-8s Pri St   CPU%%  Stack\r\n", "Task");
+    for (UBaseType_t i = 0; i < taskCount; i++) {
+        const TaskStatus_t *task = &tasks[i];
+        uint32_t permille = (totalRunTime > 0) ? (uint32_t)(((uint64_t)task->ulRunTimeCounter * 1000) / totalRunTime) : 0;
+
+        SerialConsolePrintf("%-8s %3u  %c  %3lu.%lu  %5u\r\n", task->pcTaskName, (unsigned int)task->uxCurrentPriority,
+                            taskStates[(task->eCurrentState < eInvalid) ? task->eCurrentState : eInvalid], (unsigned long)(permille / 10),
+                            (unsigned long)(permille % 10), (unsigned int)task->usStackHighWaterMark);
+    }
+
+    SerialConsolePrintf("%-10s Used Size\r\n", "Queue");
+    for (uint32_t i = 0; NULL != (queue = RunTimeStatsGetQueue(i, &queueName)); i++) {
+        SerialConsolePrintf("%-10s %4u %4u\r\n", queueName, (unsigned int)uxQueueMessagesWaiting(queue),
+                            (unsigned int)(uxQueueMessagesWaiting(queue) + uxQueueSpacesAvailable(queue)));
+    }
+    return pdFALSE;
+}
+
+/**
+ BaseType_t CLI_LogMode( int8_t *pcWriteBuffer,size_t xWriteBufferLen,const int8_t *pcCommandString )
+ * @brief	CLI command to switch log messages between text and binary frames (see SerialConsole/LogFormat.h)
+ * @param[out] *pcWriteBuffer. Buffer we can use to write the CLI command response to! See other CLI examples on how we use this to write back!
+ * @param[in] xWriteBufferLen. How much we can write into the buffer
+ * @param[in] *pcCommandString. Buffer that contains the complete input. The optional parameter is "text" or "binary".
+ * @return		Returns pdFALSE, the CLI command finished.
+ * @note        Without a parameter, prints the current mode and the number of frames dropped on a full TX buffer.
+ */
+BaseType_t CLI_LogMode(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString)
+{
+    BaseType_t length = 0;
+    const char *mode = FreeRTOS_CLIGetParameter((const char *)pcCommandString, 1, &length);
+
+    if (NULL != mode) {
+        if (4 == length && 0 == strncmp(mode, "text", 4)) {
+            setLogMode(LOG_MODE_TEXT);
+        } else if (6 == length && 0 == strncmp(mode, "binary", 6)) {
+            setLogMode(LOG_MODE_BINARY);
+        } else {
+            snprintf((char *)pcWriteBuffer, xWriteBufferLen, "Usage: logmode [text|binary]\r\n");
+            return pdFALSE;
+        }
+    }
+
+    snprintf((char *)pcWriteBuffer, xWriteBufferLen, "Log mode %s, %lu frames dropped\r\n", (LOG_MODE_BINARY == getLogMode()) ? "binary" : "text",
+             (unsigned long)getLogFramesDropped());
+    return pdFALSE;
+}
+
+/**
+ BaseType_t CLI_LogLevel( int8_t *pcWriteBuffer,size_t xWriteBufferLen,const int8_t *pcCommandString )
+ * @brief	CLI command to set the runtime log level of one module, or of all of them (see the LOG macros in SerialConsole.h)
+ * @param[out] *pcWriteBuffer. Usage errors only: the table is streamed with SerialConsolePrintf
+ * @param[in] xWriteBufferLen. How much we can write into the buffer
+ * @param[in] *pcCommandString. Buffer that contains the complete input. The optional parameters are a module name (or "all") and a level name.
+ * @return		Returns pdFALSE, the CLI command finished.
+ * @note        Prints the level of every module after setting it. A level the build compiled out stays
+ *              silent whatever is set here.
+ */
+BaseType_t CLI_LogLevel(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString)
+{
+    BaseType_t moduleLength = 0;
+    BaseType_t levelLength = 0;
+    const char *moduleName = FreeRTOS_CLIGetParameter((const char *)pcCommandString, 1, &moduleLength);
+    const char *levelName = FreeRTOS_CLIGetParameter((const char *)pcCommandString, 2, &levelLength);
+
+    if (NULL != moduleName) {
+        uint32_t target;
+        uint32_t level;
+
+        for (target = 0; target < N_LOG_MODULES; target++) {
+            if (strlen(LogModuleName(target)) == (size_t)moduleLength && 0 == strncmp(moduleName, LogModuleName(target), moduleLength)) {
+                break;
+            }
+        }
+        for (level = 0; NULL != levelName && level < N_DEBUG_LEVELS; level++) {
+            if (strlen(LogLevelName(level)) == (size_t)levelLength && 0 == strncmp(levelName, LogLevelName(level), levelLength)) {
+                break;
+            }
+        }
+        if ((target == N_LOG_MODULES && !(3 == moduleLength && 0 == strncmp(moduleName, "all", 3))) || NULL == levelName || level == N_DEBUG_LEVELS) {
+            snprintf((char *)pcWriteBuffer, xWriteBufferLen, "Usage: loglevel [module|all] [info|debug|warning|error|fatal|off]\r\n");
+            return pdFALSE;
+        }
+        for (uint32_t i = 0; i < N_LOG_MODULES; i++) {
+            if (i == target || N_LOG_MODULES == target) {
+                setLogModuleLevel(i, level);
+            }
+        }
+    }
+
+    for (uint32_t module = 0; module < N_LOG_MODULES; module++) {
+        SerialConsolePrintf("%-8s %s\r\n", LogModuleName(module), LogLevelName(getLogModuleLevel(module)));
+    }
+    return pdFALSE;
+}
+
+/**
+ BaseType_t CLI_Stream( int8_t *pcWriteBuffer,size_t xWriteBufferLen,const int8_t *pcCommandString )
+ * @brief	CLI command to start or stop the sensor stream (see SensorStream/StreamPacket.h)
+ * @param[out] *pcWriteBuffer. Usage errors only: the reply is streamed with SerialConsolePrintf
+ * @param[in] xWriteBufferLen. How much we can write into the buffer
+ * @param[in] *pcCommandString. Buffer that contains the complete input. The optional parameters are a comma separated
+ *              list of sensors (imu, dist, temp), "all" or "stop", and the sample rate in Hz.
+ * @return		Returns pdFALSE, the CLI command finished.
+ * @note        Without a parameter, prints the state of the stream and its packet counters. The packets share the
+ *              console with the CLI, so the stream can be stopped while it runs.
+ */
+BaseType_t CLI_Stream(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString)
+{
+    static const char *const sensorNames[] = {"imu", "dist", "temp"};  ///< Names of the STREAM_SENSOR_ bits, in bit order
+    BaseType_t listLength = 0;
+    BaseType_t rateLength = 0;
+    const char *list = FreeRTOS_CLIGetParameter((const char *)pcCommandString, 1, &listLength);
+    const char *rate = FreeRTOS_CLIGetParameter((const char *)pcCommandString, 2, &rateLength);
+    struct SensorStreamStatus status;
+
+    if (NULL != list && 4 == listLength && 0 == strncmp(list, "stop", 4)) {
+        SensorStreamStop();
+    } else if (NULL != list) {
+        uint8_t sensors = 0;
+        uint32_t rateHz = (NULL != rate) ? strtoul(rate, NULL, 10) : CLI_STREAM_DEFAULT_RATE_HZ;
+        int32_t started;
+
+        if (3 == listLength && 0 == strncmp(list, "all", 3)) {
+            sensors = STREAM_SENSOR_ALL;
+            listLength = 0;
+        }
+        while (listLength > 0) {
+            BaseType_t nameLength = (BaseType_t)strcspn(list, ", ");
+            uint32_t bit;
+
+            for (bit = 0; bit < sizeof(sensorNames) / sizeof(sensorNames[0]); bit++) {
+                if (strlen(sensorNames[bit]) == (size_t)nameLength && 0 == strncmp(list, sensorNames[bit], nameLength)) {
+                    break;
+                }
+            }
+            if (bit == sizeof(sensorNames) / sizeof(sensorNames[0])) {
+                break;  // Unknown name: usage below
+            }
+            sensors |= (1u << bit);
+            list += nameLength;
+            listLength -= nameLength;
+            if (listLength > 0 && *list == ',') {
+                list++;
+                listLength--;
+            }
+        }
+
+        started = (0 != listLength) ? ERROR_INVALID_ARG : SensorStreamStart(sensors, rateHz);
+        if (started < 0) {
+            snprintf((char *)pcWriteBuffer, xWriteBufferLen, "Usage: stream [imu,dist,temp|all|stop] [1-%d]\r\n", (int)SENSOR_STREAM_MAX_RATE_HZ);
+            return pdFALSE;
+        }
+    }
+
+    SensorStreamGetStatus(&status);
+    SerialConsolePrintf("stream %s:", status.running ? "running" : "stopped");
+    for (uint32_t bit = 0; bit < sizeof(sensorNames) / sizeof(sensorNames[0]); bit++) {
+        if (status.sensors & (1u << bit)) {
+            SerialConsolePrintf(" %s", sensorNames[bit]);
+        }
+    }
+    SerialConsolePrintf(" at %lu Hz, %lu packets sent, %lu dropped\r\n", (unsigned long)status.rateHz, (unsigned long)status.sent, (unsigned long)status.dropped);
+    return pdFALSE;
+}
+
+/**
+ BaseType_t CLI_Bench( int8_t *pcWriteBuffer,size_t xWriteBufferLen,const int8_t *pcCommandString )
+ * @brief	CLI command to time benchmark kernels (see Bench/Bench.h)
+ * @param[out] *pcWriteBuffer. Usage errors only: the table is streamed with SerialConsolePrintf
+ * @param[in] xWriteBufferLen. How much we can write into the buffer
+ * @param[in] *pcCommandString. Buffer that contains the complete input. The optional parameters are a kernel name (or "all")
+ *              and the number of samples.
+ * @return		Returns pdFALSE, the CLI command finished.
+ * @note        Without a parameter, lists the kernels. Times are ns per operation, the throughput is taken from the
+ *              median. FatFs is not reentrant: do not run the sd kernels during a download.
+ */
+BaseType_t CLI_Bench(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString)
+{
+    BaseType_t nameLength = 0;
+    BaseType_t samplesLength = 0;
+    const char *name = FreeRTOS_CLIGetParameter((const char *)pcCommandString, 1, &nameLength);
+    const char *samplesText = FreeRTOS_CLIGetParameter((const char *)pcCommandString, 2, &samplesLength);
+    uint32_t samples = (NULL != samplesText) ? strtoul(samplesText, NULL, 10) : BENCH_DEFAULT_SAMPLES;
+    const struct BenchKernel *only = NULL;
+    const struct BenchKernel *kernel;
+
+    if (NULL == name) {
+        for (uint32_t i = 0; NULL != (kernel = BenchGetKernel(i)); i++) {
+            SerialConsolePrintf("%-10s %s\r\n", kernel->name, kernel->description);
+        }
+        return pdFALSE;
+    }
+    if (!(3 == nameLength && 0 == strncmp(name, "all", 3))) {
+        only = BenchFindKernel(name, (size_t)nameLength);
+    }
+    if ((NULL == only && !(3 == nameLength && 0 == strncmp(name, "all", 3))) || 0 == samples || samples > BENCH_MAX_SAMPLES) {
+        snprintf((char *)pcWriteBuffer, xWriteBufferLen, "Usage: bench [kernel|all] [1..%u samples]\r\n", BENCH_MAX_SAMPLES);
+        return pdFALSE;
+    }
+
+    SerialConsolePrintf("%lu counts/s, %lu samples. ns per operation:\r\n", (unsigned long)BenchTimerHz(), (unsigned long)samples);
+    SerialConsolePrintf("%-10s %9s %9s %9s %7s\r\n", "Kernel", "min", "median", "max", "kB/s");
+    for (uint32_t i = 0; NULL != (kernel = BenchGetKernel(i)); i++) {
+        struct BenchResult result;
+
+        if (NULL != only && kernel != only) {
+            continue;
+        }
+        BenchRun(kernel, samples, &result);
+        if (0 == result.samples) {
+            SerialConsolePrintf("%-10s error %ld\r\n", kernel->name, (long)result.error);
+            continue;
+        }
+        SerialConsolePrintf("%-10s %9lu %9lu %9lu %7lu", kernel->name, (unsigned long)BenchCountsToNs(result.min, kernel->operations),
+                            (unsigned long)BenchCountsToNs(result.median, kernel->operations),
+                            (unsigned long)BenchCountsToNs(result.max, kernel->operations),
+                            (unsigned long)BenchThroughputKBps(result.median, kernel->bytes));
+        if (result.error < 0) {
+            SerialConsolePrintf("  error %ld after %lu samples", (long)result.error, (unsigned long)result.samples);
+        }
+        SerialConsolePrintf("\r\n");
+    }
+    return pdFALSE;
+}
+
+/**
+ BaseType_t CLI_Mem( int8_t *pcWriteBuffer,size_t xWriteBufferLen,const int8_t *pcCommandString )
+ * @brief	CLI command to show the heap counters (Memory/Heap.h) and the use of each memory pool (Memory/MemoryPool.h)
+ * @param[out] *pcWriteBuffer. Unused: the tables are streamed with SerialConsolePrintf
+ * @param[in] xWriteBufferLen. How much we can write into the buffer
+ * @param[in] *pcCommandString. Buffer that contains the complete input. No parameters.
+ * @return		Returns pdFALSE, the CLI command finished.
+ * @note        Heap sizes include the block headers. Fails counts the requests that found the heap or the pool short.
+ */
+BaseType_t CLI_Mem(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString)
+{
+    struct HeapStats heap;
+    const struct MemoryPool *pool;
+
+    HeapGetStats(&heap);
+    SerialConsolePrintf("Heap %u of %u bytes free, %u at least, largest block %u of %lu free blocks\r\n", (unsigned int)heap.freeBytes,
+                        (unsigned int)heap.totalBytes, (unsigned int)heap.minimumFreeBytes, (unsigned int)heap.largestFreeBlock,
+                        (unsigned long)heap.freeBlocks);
+    SerialConsolePrintf("%lu allocations, %lu frees, %lu fails\r\n", (unsigned long)heap.allocations, (unsigned long)heap.frees,
+                        (unsigned long)heap.failures);
+
+    SerialConsolePrintf("%-10s Size Count Used High Fails\r\n", "Pool");
+    for (uint32_t i = 0; NULL != (pool = MemoryPoolGet(i)); i++) {
+        SerialConsolePrintf("%-10s %4u %5u %4u %4u %5lu\r\n", pool->name, (unsigned int)pool->blockSize, (unsigned int)pool->blockCount,
+                            (unsigned int)pool->used, (unsigned int)pool->highWater, (unsigned long)pool->failures);
+    }
+    return pdFALSE;
+}
+
+/**
+ BaseType_t CLI_Power( int8_t *pcWriteBuffer,size_t xWriteBufferLen,const int8_t *pcCommandString )
+ * @brief	CLI command to show the residency of each sleep mode (Power/Power.h) since boot or the last "power clear"
+ * @param[out] *pcWriteBuffer. Usage errors only: the table is streamed with SerialConsolePrintf
+ * @param[in] xWriteBufferLen. How much we can write into the buffer
+ * @param[in] *pcCommandString. Buffer that contains the complete input. The optional parameter is "clear".
+ * @return		Returns pdFALSE, the CLI command finished.
+ * @note        Active is the rest of the window. Locks is the count held on each mode: the deepest mode with a lock is
+ *              the deepest the CPU may enter. The console holds an idle lock from each burst of input to its end.
+ */
+BaseType_t CLI_Power(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString)
+{
+    static const char *const modeNames[SLEEPMGR_NR_OF_MODES] = {"active", "idle0", "idle1", "idle2", "standby"};
+    BaseType_t length = 0;
+    const char *parameter = FreeRTOS_CLIGetParameter((const char *)pcCommandString, 1, &length);
+    struct PowerResidency residency;
+    uint32_t windowMs, asleepMs = 0, modeMs;
+
+    if (NULL != parameter) {
+        if (5 == length && 0 == strncmp(parameter, "clear", 5)) {
+            PowerClearResidency();
+        } else {
+            snprintf((char *)pcWriteBuffer, xWriteBufferLen, "Usage: power [clear]\r\n");
+        }
+        return pdFALSE;
+    }
+
+    windowMs = (xTaskGetTickCount() - PowerGetResidencyStart()) * portTICK_PERIOD_MS;
+    if (0 == windowMs) {
+        windowMs = 1;
+    }
+    SerialConsolePrintf("Residency over %lu ms, %lu sleeps aborted\r\n", (unsigned long)windowMs, (unsigned long)PowerGetAborts());
+    SerialConsolePrintf("%-8s Locks Entries    Time ms      %%\r\n", "Mode");
+    for (uint32_t mode = SLEEPMGR_IDLE_0; mode < SLEEPMGR_NR_OF_MODES; mode++) {
+        PowerGetResidency((enum sleepmgr_mode)mode, &residency);
+        modeMs = (uint32_t)((residency.counts * 1000) / POWER_TIMER_HZ);
+        asleepMs += modeMs;
+        SerialConsolePrintf("%-8s %5u %7lu %10lu %4lu.%lu\r\n", modeNames[mode], (unsigned int)sleepmgr_locks[mode], (unsigned long)residency.entries,
+                            (unsigned long)modeMs, (unsigned long)(modeMs * 100ULL / windowMs), (unsigned long)((modeMs * 1000ULL / windowMs) % 10));
+    }
+    modeMs = (asleepMs < windowMs) ? windowMs - asleepMs : 0;
+    SerialConsolePrintf("%-8s %5u %7s %10lu %4lu.%lu\r\n", modeNames[SLEEPMGR_ACTIVE], (unsigned int)sleepmgr_locks[SLEEPMGR_ACTIVE], "",
+                        (unsigned long)modeMs, (unsigned long)(modeMs * 100ULL / windowMs), (unsigned long)((modeMs * 1000ULL / windowMs) % 10));
+    return pdFALSE;
+}
+
 /**
  BaseType_t CLI_NeotrellisSetLed( int8_t *pcWriteBuffer,size_t xWriteBufferLen,const int8_t *pcCommandString )
  * @brief	CLI command to turn on a given LED to a given R,G,B, value
@@ -487,11 +933,10 @@ BaseType_t CLI_i2cScan(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8
 		i2cOled.msgOut = (const uint8_t*) &dataOut[0];
 		i2cOled.lenIn = 1;
 
-            SerialConsoleWriteString("0  1  2  3  4  5  6  7  8  9  a  b  c  d  e  f\r\n");
+            SerialConsolePrintf("0  1  2  3  4  5  6  7  8  9  a  b  c  d  e  f\r\n");
             for (int i = 0; i < 128; i += 16)
             {
-				snprintf(bufCli, CLI_MSG_LEN - 1, "%02x: ", i);
-                SerialConsoleWriteString(bufCli);
+                SerialConsolePrintf("%02x: ", i);
 
                 for (int j = 0; j < 16; j++)
                 {
@@ -502,18 +947,16 @@ BaseType_t CLI_i2cScan(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8
                     int32_t ret = I2cPingAddressWait(&i2cOled, 100, 100);
                     if (ret == 0)
                     {
-						snprintf(bufCli, CLI_MSG_LEN - 1, "%02x ", i2cOled.address);
-                        SerialConsoleWriteString(bufCli);
+                        SerialConsolePrintf("%02x ", i2cOled.address);
                     }
                     else
                     {
-                        snprintf(bufCli, CLI_MSG_LEN - 1, "X  ");
-						SerialConsoleWriteString(bufCli);
+                        SerialConsolePrintf("X  ");
                     }
                 }
-                SerialConsoleWriteString( "\r\n");
+                SerialConsolePrintf("\r\n");
             }
-            SerialConsoleWriteString( "\r\n");
+            SerialConsolePrintf("\r\n");
 			return pdFALSE;
 
 }
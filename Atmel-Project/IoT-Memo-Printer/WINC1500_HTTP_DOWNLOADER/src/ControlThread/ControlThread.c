@@ -16,6 +16,9 @@
 #include "SerialConsole.h"
 #include "UiHandlerThread/UiHandlerThread.h"
 #include "WifiHandlerThread/WifiHandler.h"
+#include "RunTimeStats/RunTimeStats.h"
+#include "Memory/MemoryPool.h"
+#include "RamPlan/RamPlan.h"
 #include "asf.h"
 #include "main.h"
 #include "shtc3.h"
@@ -24,13 +27,22 @@
 /******************************************************************************
  * Defines
  ******************************************************************************/
+#define CONTROL_GAME_QUEUE_LENGTH 2  ///< Games queued for the UI
+#define CONTROL_RGB_QUEUE_LENGTH 2   ///< LED colors queued
+#define CONTROL_IDLE_PERIOD 40       ///< Ticks between two passes of a state without an event to block on
+#define CONTROL_NETWORK_WAIT_MS 5000  ///< Longest wait for the MQTT broker before a play is queued for it anyway
 
 /******************************************************************************
  * Variables
  ******************************************************************************/
-QueueHandle_t xQueueGameBufferIn = NULL;    ///< Queue to send the next play to the UI
+QueueHandle_t xQueueGameBufferIn = NULL;    ///< Queue to send the next play to the UI. Items are fragmentPool blocks
 QueueHandle_t xQueueRgbColorBuffer = NULL;  ///< Queue to receive an LED Color packet
 
+static StaticQueue_t gameInQueueBuffer RAM_PLAN(control);                                                         ///< Control block of xQueueGameBufferIn
+static StaticQueue_t rgbColorQueueBuffer RAM_PLAN(control);                                                       ///< Control block of xQueueRgbColorBuffer
+static uint8_t gameInQueueStorage[CONTROL_GAME_QUEUE_LENGTH * sizeof(struct GameDataPacket *)] RAM_PLAN(control); ///< Items of xQueueGameBufferIn
+static uint8_t rgbColorQueueStorage[CONTROL_RGB_QUEUE_LENGTH * sizeof(struct RgbColorPacket)] RAM_PLAN(control);  ///< Items of xQueueRgbColorBuffer
+
 controlStateMachine_state controlState;  ///< Holds the current state of the control thread
 
 /******************************************************************************
@@ -59,21 +71,24 @@ void vControlHandlerTask(void *pvParameters)
     SerialConsoleWriteString((char *)"ESE516 - Control Init Code\r\n");
 
     // Initialize Queues
-    xQueueGameBufferIn = xQueueCreate(2, sizeof(struct GameDataPacket));
-    xQueueRgbColorBuffer = xQueueCreate(2, sizeof(struct RgbColorPacket));
+    xQueueGameBufferIn = xQueueCreateStatic(CONTROL_GAME_QUEUE_LENGTH, sizeof(struct GameDataPacket *), gameInQueueStorage, &gameInQueueBuffer);
+    xQueueRgbColorBuffer = xQueueCreateStatic(CONTROL_RGB_QUEUE_LENGTH, sizeof(struct RgbColorPacket), rgbColorQueueStorage, &rgbColorQueueBuffer);
 
     if (xQueueGameBufferIn == NULL || xQueueRgbColorBuffer == NULL) {
         SerialConsoleWriteString((char *)"ERROR Initializing Control Data queues!\r\n");
     }
+    RunTimeStatsAddQueue(xQueueGameBufferIn, "GameIn");
+    RunTimeStatsAddQueue(xQueueRgbColorBuffer, "RgbColor");
     controlState = CONTROL_WAIT_FOR_GAME;  // Initial state
 
     while (1) {
         switch (controlState) {
             case (CONTROL_WAIT_FOR_GAME): {  // Should set the UI to ignore button presses and should wait until there is a message from the server with a new play.
-                struct GameDataPacket gamePacketIn;
-                if (pdPASS == xQueueReceive(xQueueGameBufferIn, &gamePacketIn, 0)) {
-                    LogMessage(LOG_DEBUG_LVL, "Control Thread: Consumed game packet!\r\n");
-                    UiOrderShowMoves(&gamePacketIn);
+                struct GameDataPacket *gamePacketIn;
+                if (pdPASS == xQueueReceive(xQueueGameBufferIn, &gamePacketIn, portMAX_DELAY)) {
+                    LOG_DEBUG(CTRL, "Control Thread: Consumed game packet!\r\n");
+                    UiOrderShowMoves(gamePacketIn);
+                    MemoryPoolFree(&fragmentPool, gamePacketIn);
                     controlState = CONTROL_PLAYING_MOVE;
                 }
 
@@ -82,10 +97,14 @@ void vControlHandlerTask(void *pvParameters)
 
             case (CONTROL_PLAYING_MOVE): {  // Should wait until the UI thread has showed the move AND comes back with the play from the user. Should go back to CONTROL_WAIT_FOR_GAME
                 // after posting the game to MQTT
-                if (UiPlayIsDone() == true) {
+                if (UiWaitForPlay(portMAX_DELAY) == true) {
+                    // The broker may be reconnecting: give it a while, the Wifi queue only holds a couple of games
+                    if (0 == (WifiWaitForNetwork(MQTT_CONNECTED, pdMS_TO_TICKS(CONTROL_NETWORK_WAIT_MS)) & MQTT_CONNECTED)) {
+                        LOG_WARNING(CTRL, "Control Thread: MQTT broker not connected, queuing the play anyway\r\n");
+                    }
                     // Send back local game packet
                     if (pdTRUE != WifiAddGameDataToQueue(UiGetGamePacketOut())) {
-                        LogMessage(LOG_DEBUG_LVL, "Control Thread: Could not send game packet!\r\n");
+                        LOG_DEBUG(CTRL, "Control Thread: Could not send game packet!\r\n");
                     }
                     controlState = CONTROL_WAIT_FOR_GAME;
                 }
@@ -94,6 +113,7 @@ void vControlHandlerTask(void *pvParameters)
             }
 
             case (CONTROL_END_GAME): {
+                vTaskDelay(CONTROL_IDLE_PERIOD);  // Nothing to wait for
                 break;
             }
 
@@ -101,7 +121,6 @@ void vControlHandlerTask(void *pvParameters)
                 controlState = CONTROL_WAIT_FOR_GAME;
                 break;
         }
-        vTaskDelay(40);
     }
 }
 
@@ -116,6 +135,16 @@ void vControlHandlerTask(void *pvParameters)
  */
 int ControlAddGameData(struct GameDataPacket *gameIn)
 {
-    int error = xQueueSend(xQueueGameBufferIn, gameIn, (TickType_t)10);
+    struct GameDataPacket *block = MemoryPoolAlloc(&fragmentPool);
+    int error = pdFALSE;
+
+    // The queue passes the block, not a copy of the game
+    if (NULL != block) {
+        memcpy(block, gameIn, sizeof(struct GameDataPacket));
+        error = xQueueSend(xQueueGameBufferIn, &block, (TickType_t)10);
+        if (pdTRUE != error) {
+            MemoryPoolFree(&fragmentPool, block);
+        }
+    }
     return error;
 }
@@ -17,6 +17,8 @@
 #include "DistanceDriver/DistanceSensor.h"
 
 #include "I2cDriver/I2cDriver.h"
+#include "Power/Power.h"
+#include "RamPlan/RamPlan.h"
 #include "SerialConsole/SerialConsole.h"
 
 /******************************************************************************
@@ -28,6 +30,9 @@ struct usart_module usart_instance_dist;  ///< Distance sensor UART module
 SemaphoreHandle_t sensorDistanceMutexHandle;      ///< Mutex to handle the sensor I2C bus thread access.
 SemaphoreHandle_t sensorDistanceSemaphoreHandle;  ///< Binary semaphore to notify task that we have received an I2C interrupt on the Sensor bus
 
+static StaticSemaphore_t sensorDistanceMutexBuffer RAM_PLAN(drivers);      ///< Control block of sensorDistanceMutexHandle
+static StaticSemaphore_t sensorDistanceSemaphoreBuffer RAM_PLAN(drivers);  ///< Control block of sensorDistanceSemaphoreHandle
+
 /******************************************************************************
  * Structures and Enumerations
  ******************************************************************************/
@@ -84,8 +89,8 @@ void InitializeDistanceSensor(void)
     configure_usart();
     configure_usart_callbacks();
 
-    sensorDistanceMutexHandle = xSemaphoreCreateMutex();
-    sensorDistanceSemaphoreHandle = xSemaphoreCreateBinary();
+    sensorDistanceMutexHandle = xSemaphoreCreateMutexStatic(&sensorDistanceMutexBuffer);
+    sensorDistanceSemaphoreHandle = xSemaphoreCreateBinaryStatic(&sensorDistanceSemaphoreBuffer);
 
     if (NULL == sensorDistanceMutexHandle || NULL == sensorDistanceSemaphoreHandle) {
         SerialConsoleWriteString((char *)"Could not initialize Distance Sensor!");
@@ -105,12 +110,16 @@ void DeinitializeDistanceSerial(void)
 /**
  * @fn			int32_t DistanceSensorGetDistance (uint16_t *distance)
  * @brief		Gets the distance from the distance sensor.
- * @note			Returns 0 if successful. -1 if an error occurred
+ * @note			Returns 0 if successful. -1 if an error occurred. ERROR_NOT_INITIALIZED before InitializeDistanceSensor
  */
 int32_t DistanceSensorGetDistance(uint16_t *distance, const TickType_t xMaxBlockTime)
 {
     int error = ERROR_NONE;
 
+    if (NULL == sensorDistanceMutexHandle) {
+        return ERROR_NOT_INITIALIZED;  // The sensor is optional; see main21.c
+    }
+
     // 1. Get MUTEX. DistanceSensorGetMutex. If we cant get it, goto
     error = DistanceSensorGetMutex(WAIT_I2C_LINE_MS);
     if (ERROR_NONE != error) goto exitf;
@@ -201,6 +210,8 @@ static int32_t DistanceSensorFreeMutex(void)
 
     if (xSemaphoreGive(sensorDistanceMutexHandle) != pdTRUE) {
         error = ERROR_NOT_INITIALIZED;  // We could not return the mutex! We must not have it!
+    } else {
+        sleepmgr_unlock_mode(POWER_PERIPHERAL_LOCK);
     }
     return error;
 }
@@ -218,6 +229,8 @@ static int32_t DistanceSensorGetMutex(TickType_t waitTime)
     int32_t error = ERROR_NONE;
     if (xSemaphoreTake(sensorDistanceMutexHandle, waitTime) != pdTRUE) {
         error = ERROR_NOT_READY;
+    } else {
+        sleepmgr_lock_mode(POWER_PERIPHERAL_LOCK);  // The UART runs on GCLK0, which stops in standby
     }
     return error;
 }
\ No newline at end of file
@@ -10,6 +10,10 @@
  * Includes
  ******************************************************************************/
 #include "I2cDriver.h"
+#include "Power/Power.h"
+
+#include "RamPlan/RamPlan.h"
+#include "SerialConsole/SerialConsole.h"
 
 /******************************************************************************
  * Defines
@@ -20,6 +24,8 @@
  ******************************************************************************/
 SemaphoreHandle_t sensorI2cMutexHandle;                       ///< Mutex to handle the sensor I2C bus thread access.
 SemaphoreHandle_t sensorI2cSemaphoreHandle;                   ///< Binary semaphore to notify task that we have received an I2C interrupt on the Sensor bus
+static StaticSemaphore_t sensorI2cMutexBuffer RAM_PLAN(drivers);      ///< Control block of sensorI2cMutexHandle
+static StaticSemaphore_t sensorI2cSemaphoreBuffer RAM_PLAN(drivers);  ///< Control block of sensorI2cSemaphoreHandle
 static volatile TaskHandle_t xTaskToNotifySensorDone = NULL;  ///< Stores the handle of the task that will be notified when the SENSOR transmission is complete. */
 static uint8_t sensorTransmitError = false;                   ///< Flag used to indicate that there was an I2C transmission error on the SENSOR bus.
 
@@ -155,9 +161,9 @@ int32_t I2cInitializeDriver(void)
 
     I2cDriverRegisterSensorBusCallbacks();
 
-    sensorI2cMutexHandle = xSemaphoreCreateMutex();
+    sensorI2cMutexHandle = xSemaphoreCreateMutexStatic(&sensorI2cMutexBuffer);
 
-    sensorI2cSemaphoreHandle = xSemaphoreCreateBinary();
+    sensorI2cSemaphoreHandle = xSemaphoreCreateBinaryStatic(&sensorI2cSemaphoreBuffer);
     // xSemaphoreGive(sensorI2cSemaphoreHandle);
 
     if (NULL == sensorI2cMutexHandle || NULL == sensorI2cSemaphoreHandle) {
@@ -258,6 +264,8 @@ int32_t I2cFreeMutex(void)
 
     if (xSemaphoreGive(sensorI2cMutexHandle) != pdTRUE) {
         error = ERROR_NOT_INITIALIZED;  // We could not return the mutex! We must not have it!
+    } else {
+        sleepmgr_unlock_mode(POWER_PERIPHERAL_LOCK);
     }
     return error;
 }
@@ -275,6 +283,8 @@ int32_t I2cGetMutex(TickType_t waitTime)
     int32_t error = ERROR_NONE;
     if (xSemaphoreTake(sensorI2cMutexHandle, waitTime) != pdTRUE) {
         error = ERROR_NOT_READY;
+    } else {
+        sleepmgr_lock_mode(POWER_PERIPHERAL_LOCK);  // The SERCOM runs on GCLK0, which stops in standby
     }
     return error;
 }
@@ -375,6 +385,7 @@ exit:
 exitError0:
     error |= I2cFreeMutex();
     // xSemaphoreGive(semHandle);
+    LOG_ERROR(I2C, "I2C write to 0x%02x failed (%ld)\r\n", data->address, (long)error);
     return error;
 }
 
@@ -453,6 +464,7 @@ exit:
 exitError0:
     I2cFreeMutex();
     // xSemaphoreGive(semHandle);
+    LOG_ERROR(I2C, "I2C read from 0x%02x failed (%ld)\r\n", data->address, (long)error);
     return error;
 }
 
@@ -11,14 +11,26 @@
  ******************************************************************************/
 #include "shtc3.h"
 
-#include "i2c_master.h"
-#include "i2c_master_interrupt.h"
 #include "stdint.h"
 
-struct i2c_master_module i2cSensorBusInstance;
-static const uint16_t SHT3_wakeup_cmd = SHT3_SLEEP_COMMAND;  // Why am I used here?
+/******************************************************************************
+ * Defines
+ ******************************************************************************/
+#define SHT3_MEASURE_DELAY_MS 13  ///< Longest normal mode measurement (12.1 ms), rounded up to whole ticks
+#define SHT3_WAIT_MS 100          ///< Longest wait for an I2C transfer to complete
+
+/******************************************************************************
+ * Variables
+ ******************************************************************************/
+static const uint8_t SHT3_wakeup_cmd[] = {SHT3_WAKEUP_COMMAND >> 8, SHT3_WAKEUP_COMMAND & 0xFF};  ///< Wake up command, MSB first
+static const uint8_t SHT3_measure_cmd[] = {SHT3_NORMAL_MODE_MEASURE_NM >> 8, SHT3_NORMAL_MODE_MEASURE_NM & 0xFF};  ///< Measure command, MSB first
+
+/******************************************************************************
+ * Local Function Declaration
+ ******************************************************************************/
+static int SHTC3_SendI2cCommand(const uint8_t *buf, uint8_t size);
+static uint8_t SHTC3_Crc(const uint8_t *data);
 
-static int SHTC3_SendI2cCommand(uint8_t *buf, uint8_t size);  // Why am I here? What am I?
 /**
  * @fn		int SHTC3_Init(void)
  * @brief	Function to initialize the SHTC3 sensor
@@ -30,23 +42,75 @@ int SHTC3_Init(void)
 {
     return SHTC3_SendI2cCommand(SHT3_wakeup_cmd, sizeof(SHT3_wakeup_cmd));
 }
+
 /**
- * @fn		static int SHTC3_SendI2cCommand(uint8_t *buf, uint8_t size)
+ * @fn		int SHTC3_Measure(uint16_t *temperature, uint16_t *humidity)
+ * @brief	Measures temperature and humidity
+ * @details 	Sends the measure command, sleeps while the sensor converts (no clock stretching) and reads both
+ *			words. Each word is checked against its CRC.
+ * @param[out]	temperature Raw temperature: -45 + 175 * raw / 65536 degrees C
+ * @param[out]	humidity Raw relative humidity: 100 * raw / 65536 %RH
+ * @return		Returns SHT3_OK if the measurement is valid, SHT3_COMM_ERROR otherwise
+ * @note		Call SHTC3_Init first. Blocks the calling task for SHT3_MEASURE_DELAY_MS
+ */
+int SHTC3_Measure(uint16_t *temperature, uint16_t *humidity)
+{
+    uint8_t response[6];
+    I2C_Data data;
+
+    data.address = SHT3_LOW_ADDRESS;
+    data.msgOut = SHT3_measure_cmd;
+    data.lenOut = sizeof(SHT3_measure_cmd);
+    data.msgIn = response;
+    data.lenIn = sizeof(response);
+
+    if (ERROR_NONE != I2cReadDataWait(&data, SHT3_MEASURE_DELAY_MS, SHT3_WAIT_MS) || SHTC3_Crc(&response[0]) != response[2] ||
+        SHTC3_Crc(&response[3]) != response[5]) {
+        return SHT3_COMM_ERROR;
+    }
+
+    *temperature = (uint16_t)((response[0] << 8) | response[1]);
+    *humidity = (uint16_t)((response[3] << 8) | response[4]);
+    return SHT3_OK;
+}
+
+/**
+ * @fn		static int SHTC3_SendI2cCommand(const uint8_t *buf, uint8_t size)
  * @brief	Static interface function use to send an I2C command
  * @param[in]	buf Pointer to a data buffer to send
  * @param[in]	size Ammount of bytes to send
  * @return		Returns SHT3_OK if initialized correctly
  * @note
  */
-static int SHTC3_SendI2cCommand(uint8_t *buf, uint8_t size)
+static int SHTC3_SendI2cCommand(const uint8_t *buf, uint8_t size)
 {
-    // Write WAKE command to the device address
-    struct i2c_master_packet sensorPacketWrite;
+    I2C_Data data;
+
+    data.address = SHT3_LOW_ADDRESS;  // Address to send to
+    data.msgOut = buf;
+    data.lenOut = size;  // Length to send.
+    data.msgIn = NULL;
+    data.lenIn = 0;
+
+    return (ERROR_NONE == I2cWriteDataWait(&data, SHT3_WAIT_MS)) ? SHT3_OK : SHT3_COMM_ERROR;
+}
 
-    // Prepare to write
-    sensorPacketWrite.address = SHT3_LOW_ADDRESS;             // Address to send to
-    sensorPacketWrite.data = (uint8_t *)SHT3_wakeup_cmd;      // Requires a pointer to the data to send. Why dont we put a #define here?
-    sensorPacketWrite.data_length = sizeof(SHT3_wakeup_cmd);  // Length to send.
+/**
+ * @fn		static uint8_t SHTC3_Crc(const uint8_t *data)
+ * @brief	CRC of one 16 bit word of the sensor: polynomial 0x31, initial value 0xFF
+ * @param[in]	data The two bytes of the word, MSB first
+ * @return		The CRC the sensor sends after the word
+ * @note
+ */
+static uint8_t SHTC3_Crc(const uint8_t *data)
+{
+    uint8_t crc = 0xFF;
 
-    return i2c_master_write_packet_job(&i2cSensorBusInstance, &sensorPacketWrite);
-}
\ No newline at end of file
+    for (int i = 0; i < 2; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
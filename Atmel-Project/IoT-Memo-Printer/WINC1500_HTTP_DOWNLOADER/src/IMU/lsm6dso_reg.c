@@ -20,6 +20,7 @@
 #include "lsm6dso_reg.h"
 #include "I2cDriver\I2cDriver.h"
 #include <stddef.h>
+#include <string.h>
 
 /**
   * @defgroup  LSM6DSO
@@ -13138,8 +13139,9 @@ static int32_t platform_read(void *handle, uint8_t reg, uint8_t *bufp, uint16_t
 
 stmdev_ctx_t dev_ctx = {.write_reg = platform_write, .read_reg = platform_read};
 
-uint8_t msgOutImu[64]; ///<USE ME AS A BUFFER FOR platform_write and platform_read
-I2C_Data imuData; ///<Use me as a structure to communicate with the IMU on platform_write and platform_read
+#define IMU_I2C_ADDRESS (LSM6DSO_I2C_ADD_L >> 1) ///< 7 bit address, SDO/SA0 low
+#define IMU_I2C_WAIT_MS 100 ///< Longest wait for an I2C transfer to complete
+#define IMU_MAX_WRITE 16 ///< Longest register write, in bytes
 
 /**************************************************************************//**
  * @fn			static int32_t platform_write(void *handle, uint8_t reg, uint8_t *bufp,uint16_t len)
@@ -13151,15 +13153,27 @@ I2C_Data imuData; ///<Use me as a structure to communicate with the IMU on platf
  * @param[in]   bufp Pointer to the data to be sent
  * @param[in]   len Length of the data sent
  * @return      Returns what the function "I2cWriteDataWait" returns
- * @note        STUDENTS TO FILL  
+ * @note
 *****************************************************************************/
 static int32_t platform_write(void *handle, uint8_t reg, uint8_t *bufp,uint16_t len)
 {
-	//YOUR JOB: Fill out the structure "imuData" to send to the device
-	//TIP: Use the array "msgOutImu" to copy the data to be sent. Remember that the position [0] of the array you send must be the register, and
-	//starting from position [1] you can copy the data to be sent. Remember to adjust the length accordingly
-return 0;
+	// The buffers are local: the CLI and the sensor stream task reach the IMU concurrently, the I2C mutex is only
+	// taken inside I2cWriteDataWait
+	uint8_t msgOut[IMU_MAX_WRITE + 1];
+	I2C_Data data;
 
+	if (len > IMU_MAX_WRITE) {
+		return ERROR_INVALID_ARG;
+	}
+	msgOut[0] = reg;
+	memcpy(&msgOut[1], bufp, len);
+
+	data.address = IMU_I2C_ADDRESS;
+	data.msgOut = msgOut;
+	data.lenOut = len + 1;
+	data.msgIn = NULL;
+	data.lenIn = 0;
+	return I2cWriteDataWait(&data, IMU_I2C_WAIT_MS);
 }
 
 /**************************************************************************//**
@@ -13172,15 +13186,18 @@ return 0;
  * @param[out]   bufp Pointer to the data to write to (write what was read)
  * @param[in]   len Length of the data to be read
  * @return      Returns what the function "I2cReadDataWait" returns
- * @note        STUDENTS TO FILL  
+ * @note
 *****************************************************************************/
 static  int32_t platform_read(void *handle, uint8_t reg, uint8_t *bufp, uint16_t len)
 {
-	//YOUR JOB: Fill out the structure "imuData" to send to the device
-	//TIP: Check the structure "imuData" and notice that it has a msgOut and msgIn parameter. How do we fill this to our advantage?
-return 0;
-
+	I2C_Data data;
 
+	data.address = IMU_I2C_ADDRESS;
+	data.msgOut = &reg;  // Register first, then a repeated transfer reads the data
+	data.lenOut = 1;
+	data.msgIn = bufp;
+	data.lenIn = len;
+	return I2cReadDataWait(&data, 0, IMU_I2C_WAIT_MS);
 }
 
 
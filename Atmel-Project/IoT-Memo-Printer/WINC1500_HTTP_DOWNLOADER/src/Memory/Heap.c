@@ -0,0 +1,253 @@
+/**************************************************************************/ /**
+ * @file      Heap.c
+ * @brief     FreeRTOS heap with coalescing and counters, in place of heap_1
+ * @details   Every block starts with a header holding the address of the next free block and the block size.
+ *            The top bit of the size marks a block handed out, which vPortFree checks. The free list ends on a
+ *            zero size block at the top of the storage, so the first fit search needs no end test. The list is
+ *            changed with the scheduler suspended, as in the FreeRTOS heaps.
+ * @author
+ * @date      2026-10-17
+
+ ******************************************************************************/
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "Memory/Heap.h"
+
+#include "FreeRTOS.h"
+#include "RamPlan/RamPlan.h"
+#include "task.h"
+
+/******************************************************************************
+ * Defines
+ ******************************************************************************/
+#define HEAP_ALLOCATED_BIT ((size_t)1 << (sizeof(size_t) * 8 - 1))                                              ///< Set in the size of a block handed out
+#define HEAP_HEADER_SIZE ((sizeof(struct HeapBlock) + portBYTE_ALIGNMENT - 1) & ~((size_t)portBYTE_ALIGNMENT_MASK))  ///< Header, rounded up to keep the data aligned
+#define HEAP_MIN_BLOCK_SIZE (HEAP_HEADER_SIZE * 2)                                                                 ///< Smallest remainder worth splitting off a block
+
+/******************************************************************************
+ * Structures and Enumerations
+ ******************************************************************************/
+/// Header of a block
+struct HeapBlock {
+    struct HeapBlock *next;  ///< Next free block by address, NULL while handed out
+    size_t size;             ///< Bytes of the block, header included. HEAP_ALLOCATED_BIT while handed out
+};
+
+/******************************************************************************
+ * Local Function Declaration
+ ******************************************************************************/
+static void heap_init(void);
+static void heap_insert_free(struct HeapBlock *block);
+
+/******************************************************************************
+ * Variables
+ ******************************************************************************/
+static uint8_t heapStorage[configTOTAL_HEAP_SIZE] RAM_PLAN(heap) __attribute__((aligned(portBYTE_ALIGNMENT)));  ///< The heap
+static struct HeapBlock heapStart;                                                                              ///< Head of the free list, outside the storage
+static struct HeapBlock *heapEnd = NULL;                                                                        ///< End of the free list. NULL until the first call
+static struct HeapStats heapStats;                                                                              ///< Counters, less the free list walk of HeapGetStats
+
+/******************************************************************************
+ * Global Functions
+ ******************************************************************************/
+
+/**
+ * @fn          void *pvPortMalloc(size_t xWantedSize)
+ * @brief       Hands out a block from the first free block large enough
+ * @param[in]   xWantedSize Bytes needed
+ * @return      The block, aligned to portBYTE_ALIGNMENT, or NULL. vApplicationMallocFailedHook is called on NULL
+ * @note        Not from an ISR
+ */
+void *pvPortMalloc(size_t xWantedSize)
+{
+    void *memory = NULL;
+    size_t size = xWantedSize + HEAP_HEADER_SIZE;
+
+    size = (size + portBYTE_ALIGNMENT_MASK) & ~((size_t)portBYTE_ALIGNMENT_MASK);
+
+    vTaskSuspendAll();
+    if (NULL == heapEnd) {
+        heap_init();
+    }
+
+    if (xWantedSize > 0 && xWantedSize < configTOTAL_HEAP_SIZE && size <= heapStats.freeBytes) {
+        struct HeapBlock *previous = &heapStart;
+        struct HeapBlock *block = heapStart.next;
+
+        while (block->size < size && block != heapEnd) {
+            previous = block;
+            block = block->next;
+        }
+
+        if (block != heapEnd) {
+            previous->next = block->next;
+
+            // Return the top of a large block to the free list
+            if (block->size - size >= HEAP_MIN_BLOCK_SIZE) {
+                struct HeapBlock *rest = (struct HeapBlock *)((uint8_t *)block + size);
+
+                rest->size = block->size - size;
+                block->size = size;
+                heap_insert_free(rest);
+            }
+
+            heapStats.freeBytes -= block->size;
+            if (heapStats.freeBytes < heapStats.minimumFreeBytes) {
+                heapStats.minimumFreeBytes = heapStats.freeBytes;
+            }
+            heapStats.allocations++;
+            block->size |= HEAP_ALLOCATED_BIT;
+            block->next = NULL;
+            memory = (uint8_t *)block + HEAP_HEADER_SIZE;
+        }
+    }
+
+    if (NULL == memory) {
+        heapStats.failures++;
+    }
+    traceMALLOC(memory, xWantedSize);
+    (void)xTaskResumeAll();
+
+#if (configUSE_MALLOC_FAILED_HOOK == 1)
+    if (NULL == memory) {
+        extern void vApplicationMallocFailedHook(void);
+        vApplicationMallocFailedHook();
+    }
+#endif
+
+    return memory;
+}
+
+/**
+ * @fn          void vPortFree(void *pv)
+ * @brief       Returns a block of pvPortMalloc, merged with the free blocks next to it
+ * @param[in]   pv Block, or NULL
+ * @note        Not from an ISR
+ */
+void vPortFree(void *pv)
+{
+    struct HeapBlock *block = (struct HeapBlock *)((uint8_t *)pv - HEAP_HEADER_SIZE);
+
+    if (NULL == pv) {
+        return;
+    }
+    configASSERT((block->size & HEAP_ALLOCATED_BIT) != 0);
+    configASSERT(NULL == block->next);
+    if ((block->size & HEAP_ALLOCATED_BIT) == 0 || NULL != block->next) {
+        return;  // Not a block handed out, or freed twice
+    }
+
+    vTaskSuspendAll();
+    block->size &= ~HEAP_ALLOCATED_BIT;
+    heapStats.freeBytes += block->size;
+    heapStats.frees++;
+    traceFREE(pv, block->size);
+    heap_insert_free(block);
+    (void)xTaskResumeAll();
+}
+
+/**
+ * @fn          size_t xPortGetFreeHeapSize(void)
+ * @brief       Bytes free now, headers included
+ */
+size_t xPortGetFreeHeapSize(void)
+{
+    return (NULL != heapEnd) ? heapStats.freeBytes : configTOTAL_HEAP_SIZE;
+}
+
+/**
+ * @fn          size_t xPortGetMinimumEverFreeHeapSize(void)
+ * @brief       Least bytes ever free, headers included
+ */
+size_t xPortGetMinimumEverFreeHeapSize(void)
+{
+    return (NULL != heapEnd) ? heapStats.minimumFreeBytes : configTOTAL_HEAP_SIZE;
+}
+
+/**
+ * @fn          void vPortInitialiseBlocks(void)
+ * @brief       Nothing to do: the heap sets itself up on the first pvPortMalloc
+ */
+void vPortInitialiseBlocks(void)
+{
+}
+
+/**
+ * @fn          void HeapGetStats(struct HeapStats *stats)
+ * @brief       Copies the heap counters and walks the free list for the largest block
+ * @param[out]  stats Counters
+ * @note        Holds the scheduler for the walk, a few blocks on this heap
+ */
+void HeapGetStats(struct HeapStats *stats)
+{
+    vTaskSuspendAll();
+    if (NULL == heapEnd) {
+        heap_init();
+    }
+    *stats = heapStats;
+    for (const struct HeapBlock *block = heapStart.next; block != heapEnd; block = block->next) {
+        stats->freeBlocks++;
+        if (block->size > stats->largestFreeBlock) {
+            stats->largestFreeBlock = block->size;
+        }
+    }
+    (void)xTaskResumeAll();
+}
+
+/******************************************************************************
+ * Local Functions
+ ******************************************************************************/
+
+/**
+ * @fn          static void heap_init(void)
+ * @brief       Makes the storage one free block, ended by heapEnd
+ */
+static void heap_init(void)
+{
+    struct HeapBlock *first = (struct HeapBlock *)heapStorage;
+
+    heapEnd = (struct HeapBlock *)(heapStorage + ((configTOTAL_HEAP_SIZE - HEAP_HEADER_SIZE) & ~((size_t)portBYTE_ALIGNMENT_MASK)));
+    heapEnd->size = 0;
+    heapEnd->next = NULL;
+
+    first->size = (size_t)((uint8_t *)heapEnd - heapStorage);
+    first->next = heapEnd;
+    heapStart.size = 0;
+    heapStart.next = first;
+
+    heapStats.totalBytes = first->size;
+    heapStats.freeBytes = first->size;
+    heapStats.minimumFreeBytes = first->size;
+}
+
+/**
+ * @fn          static void heap_insert_free(struct HeapBlock *block)
+ * @brief       Puts a block in the free list by address, merged with the free blocks right below and above it
+ * @param[in]   block Block with its size set
+ */
+static void heap_insert_free(struct HeapBlock *block)
+{
+    struct HeapBlock *previous = &heapStart;
+
+    while (previous->next < block) {
+        previous = previous->next;
+    }
+
+    if (previous != &heapStart && (uint8_t *)previous + previous->size == (uint8_t *)block) {
+        previous->size += block->size;
+        block = previous;
+    }
+
+    if (previous->next != heapEnd && (uint8_t *)block + block->size == (uint8_t *)previous->next) {
+        block->size += previous->next->size;
+        block->next = previous->next->next;
+    } else {
+        block->next = previous->next;
+    }
+
+    if (block != previous) {
+        previous->next = block;
+    }
+}
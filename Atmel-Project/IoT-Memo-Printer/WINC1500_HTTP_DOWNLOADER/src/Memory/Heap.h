@@ -0,0 +1,49 @@
+/**************************************************************************/ /**
+ * @file      Heap.h
+ * @brief     FreeRTOS heap with coalescing and counters, in place of heap_1
+ * @details   Implements pvPortMalloc and vPortFree over configTOTAL_HEAP_SIZE bytes: first fit over a free list
+ *            kept in address order, so a freed block merges with its free neighbours. Tasks only, as the FreeRTOS
+ *            heaps: the fixed size objects that ISRs need come from the pools of MemoryPool.h.
+ * @author
+ * @date      2026-10-17
+
+ ******************************************************************************/
+
+#ifndef HEAP_H
+#define HEAP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include <stddef.h>
+#include <stdint.h>
+
+/******************************************************************************
+ * Structures and Enumerations
+ ******************************************************************************/
+/// Heap counters, for the "mem" CLI command
+struct HeapStats {
+    size_t totalBytes;        ///< Bytes the heap can hand out, block headers included
+    size_t freeBytes;         ///< Bytes free now
+    size_t minimumFreeBytes;  ///< Least bytes ever free
+    size_t largestFreeBlock;  ///< Largest block free now, header included: bigger requests fail
+    uint32_t freeBlocks;      ///< Blocks in the free list. Many small ones mean fragmentation
+    uint32_t allocations;     ///< pvPortMalloc calls that succeeded
+    uint32_t frees;           ///< vPortFree calls with a block
+    uint32_t failures;        ///< pvPortMalloc calls that returned NULL
+};
+
+/******************************************************************************
+ * Global Function Declarations
+ ******************************************************************************/
+void HeapGetStats(struct HeapStats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HEAP_H */
@@ -0,0 +1,190 @@
+/**************************************************************************/ /**
+ * @file      MemoryPool.c
+ * @brief     Fixed block memory pools for the objects passed between tasks and ISRs
+ * @details   The free list is threaded through the free blocks themselves, so a pool costs its blocks and this
+ *            structure only. A block given back is checked to lie on a block boundary of its own pool.
+ * @author
+ * @date      2026-10-17
+
+ ******************************************************************************/
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "Memory/MemoryPool.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+/******************************************************************************
+ * Local Function Declaration
+ ******************************************************************************/
+static void *pool_take(struct MemoryPool *pool);
+static void pool_give(struct MemoryPool *pool, void *block);
+
+/******************************************************************************
+ * Variables
+ ******************************************************************************/
+struct MemoryPool fragmentPool;  ///< Game and memo fragments
+struct MemoryPool networkPool;   ///< Network buffers
+
+static struct MemoryPool *memoryPools[MEMORY_POOL_MAX_POOLS];  ///< Pools listed by MemoryPoolCreate
+
+/******************************************************************************
+ * Global Functions
+ ******************************************************************************/
+
+/**
+ * @fn          void MemoryPoolsInit(void)
+ * @brief       Creates the pools of MemoryPool.h
+ * @note        Call before starting the tasks that use them
+ */
+void MemoryPoolsInit(void)
+{
+    MemoryPoolCreate(&fragmentPool, "fragment", MEMORY_POOL_FRAGMENT_SIZE, MEMORY_POOL_FRAGMENT_COUNT);
+    MemoryPoolCreate(&networkPool, "network", MEMORY_POOL_NETWORK_SIZE, MEMORY_POOL_NETWORK_COUNT);
+}
+
+/**
+ * @fn          bool MemoryPoolCreate(struct MemoryPool *pool, const char *name, size_t blockSize, uint16_t blockCount)
+ * @brief       Takes the blocks of a pool from the heap and lists the pool for the CLI
+ * @param[out]  pool Pool to set up
+ * @param[in]   name Name shown by the CLI, kept by reference
+ * @param[in]   blockSize Bytes per block
+ * @param[in]   blockCount Blocks in the pool
+ * @return      true, or false if the heap could not hold the blocks (once vApplicationMallocFailedHook returns):
+ *              the pool is then empty and every allocation from it fails and is counted
+ * @note        From a task. The blocks are never given back to the heap
+ */
+bool MemoryPoolCreate(struct MemoryPool *pool, const char *name, size_t blockSize, uint16_t blockCount)
+{
+    pool->name = name;
+    pool->blockSize = (blockSize + portBYTE_ALIGNMENT_MASK) & ~((size_t)portBYTE_ALIGNMENT_MASK);
+    if (pool->blockSize < sizeof(void *)) {
+        pool->blockSize = portBYTE_ALIGNMENT;
+    }
+    pool->used = 0;
+    pool->highWater = 0;
+    pool->failures = 0;
+    pool->freeList = NULL;
+    pool->storage = (blockCount > 0) ? pvPortMalloc(pool->blockSize * blockCount) : NULL;
+    pool->blockCount = (NULL != pool->storage) ? blockCount : 0;
+
+    // Free list in address order, so a fresh pool hands out its blocks from the bottom
+    for (uint16_t i = pool->blockCount; i > 0; i--) {
+        void **block = (void **)(pool->storage + (size_t)(i - 1) * pool->blockSize);
+
+        *block = pool->freeList;
+        pool->freeList = block;
+    }
+
+    for (uint32_t i = 0; i < MEMORY_POOL_MAX_POOLS; i++) {
+        if (NULL == memoryPools[i] || pool == memoryPools[i]) {
+            memoryPools[i] = pool;
+            break;
+        }
+    }
+    return NULL != pool->storage;
+}
+
+/**
+ * @fn          void *MemoryPoolAlloc(struct MemoryPool *pool)
+ * @brief       Takes a block from a pool
+ * @param[in]   pool Pool
+ * @return      A block of pool->blockSize bytes, not cleared, or NULL if the pool is empty
+ */
+void *MemoryPoolAlloc(struct MemoryPool *pool)
+{
+    void *block;
+
+    taskENTER_CRITICAL();
+    block = pool_take(pool);
+    taskEXIT_CRITICAL();
+    return block;
+}
+
+/**
+ * @fn          void *MemoryPoolAllocFromISR(struct MemoryPool *pool)
+ * @brief       MemoryPoolAlloc for interrupts
+ */
+void *MemoryPoolAllocFromISR(struct MemoryPool *pool)
+{
+    UBaseType_t interruptStatus = taskENTER_CRITICAL_FROM_ISR();
+    void *block = pool_take(pool);
+
+    taskEXIT_CRITICAL_FROM_ISR(interruptStatus);
+    return block;
+}
+
+/**
+ * @fn          void MemoryPoolFree(struct MemoryPool *pool, void *block)
+ * @brief       Gives a block back to the pool it came from
+ * @param[in]   pool Pool of the block
+ * @param[in]   block Block, or NULL
+ */
+void MemoryPoolFree(struct MemoryPool *pool, void *block)
+{
+    taskENTER_CRITICAL();
+    pool_give(pool, block);
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @fn          void MemoryPoolFreeFromISR(struct MemoryPool *pool, void *block)
+ * @brief       MemoryPoolFree for interrupts
+ */
+void MemoryPoolFreeFromISR(struct MemoryPool *pool, void *block)
+{
+    UBaseType_t interruptStatus = taskENTER_CRITICAL_FROM_ISR();
+
+    pool_give(pool, block);
+    taskEXIT_CRITICAL_FROM_ISR(interruptStatus);
+}
+
+/**
+ * @fn          struct MemoryPool *MemoryPoolGet(uint32_t index)
+ * @brief       Returns a pool listed by MemoryPoolCreate
+ * @param[in]   index Position in the list, from 0
+ * @return      The pool, or NULL past the end of the list
+ */
+struct MemoryPool *MemoryPoolGet(uint32_t index)
+{
+    return (index < MEMORY_POOL_MAX_POOLS) ? memoryPools[index] : NULL;
+}
+
+/******************************************************************************
+ * Local Functions
+ ******************************************************************************/
+
+static void *pool_take(struct MemoryPool *pool)
+{
+    void **block = pool->freeList;
+
+    if (NULL == block) {
+        pool->failures++;
+        return NULL;
+    }
+    pool->freeList = *block;
+    pool->used++;
+    if (pool->used > pool->highWater) {
+        pool->highWater = pool->used;
+    }
+    return block;
+}
+
+static void pool_give(struct MemoryPool *pool, void *block)
+{
+    size_t offset = (size_t)((uint8_t *)block - pool->storage);
+
+    if (NULL == block) {
+        return;
+    }
+    configASSERT((uint8_t *)block >= pool->storage && offset < pool->blockSize * pool->blockCount && 0 == offset % pool->blockSize);
+    configASSERT(pool->used > 0);
+    if ((uint8_t *)block < pool->storage || offset >= pool->blockSize * pool->blockCount || 0 != offset % pool->blockSize || 0 == pool->used) {
+        return;  // Not a block of this pool, or one too many
+    }
+    *(void **)block = pool->freeList;
+    pool->freeList = block;
+    pool->used--;
+}
@@ -0,0 +1,73 @@
+/**************************************************************************/ /**
+ * @file      MemoryPool.h
+ * @brief     Fixed block memory pools for the objects passed between tasks and ISRs
+ * @details   A pool hands out blocks of one size from storage taken from the heap when it is created, so a pool
+ *            never fragments the heap and alloc and free are O(1): a pop and a push on a list of free blocks,
+ *            in a critical section. The FromISR variants may be called from interrupts. Each pool counts its
+ *            blocks in use, the most ever in use and the requests it could not serve, for the "mem" CLI command.
+ * @author
+ * @date      2026-10-17
+
+ ******************************************************************************/
+
+#ifndef MEMORY_POOL_H
+#define MEMORY_POOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/******************************************************************************
+ * Defines
+ ******************************************************************************/
+#define MEMORY_POOL_MAX_POOLS 6  ///< Pools MemoryPoolCreate can list for the CLI
+
+#define MEMORY_POOL_FRAGMENT_SIZE 24    ///< Game and memo fragments: a GameDataPacket
+#define MEMORY_POOL_FRAGMENT_COUNT 6    ///< The game queues of the control and Wi-Fi tasks, 2 each, and one in hand per task
+#define MEMORY_POOL_NETWORK_SIZE 512    ///< Network buffers: MAIN_BUFFER_MAX_SIZE of the HTTP client
+#define MEMORY_POOL_NETWORK_COUNT 1
+
+/******************************************************************************
+ * Structures and Enumerations
+ ******************************************************************************/
+/// A pool. Read the counters, change nothing: use the functions
+struct MemoryPool {
+    const char *name;     ///< Name shown by the CLI
+    size_t blockSize;     ///< Bytes per block, rounded up to the heap alignment
+    uint16_t blockCount;  ///< Blocks in the pool
+    uint16_t used;        ///< Blocks handed out now
+    uint16_t highWater;   ///< Most blocks ever handed out at once
+    uint32_t failures;    ///< Allocations that found the pool empty
+    void *freeList;       ///< First free block. Each free block holds the address of the next
+    uint8_t *storage;     ///< The blocks, from the heap
+};
+
+/******************************************************************************
+ * Global Variables
+ ******************************************************************************/
+extern struct MemoryPool fragmentPool;  ///< MEMORY_POOL_FRAGMENT_SIZE blocks
+extern struct MemoryPool networkPool;   ///< MEMORY_POOL_NETWORK_SIZE blocks
+
+/******************************************************************************
+ * Global Function Declarations
+ ******************************************************************************/
+void MemoryPoolsInit(void);
+bool MemoryPoolCreate(struct MemoryPool *pool, const char *name, size_t blockSize, uint16_t blockCount);
+void *MemoryPoolAlloc(struct MemoryPool *pool);
+void *MemoryPoolAllocFromISR(struct MemoryPool *pool);
+void MemoryPoolFree(struct MemoryPool *pool, void *block);
+void MemoryPoolFreeFromISR(struct MemoryPool *pool, void *block);
+struct MemoryPool *MemoryPoolGet(uint32_t index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MEMORY_POOL_H */
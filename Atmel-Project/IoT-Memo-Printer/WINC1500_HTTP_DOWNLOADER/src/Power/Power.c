@@ -0,0 +1,221 @@
+/**************************************************************************/ /**
+ * @file      Power.c
+ * @brief     Tickless idle: sleeps in the deepest mode the sleep manager allows and counts the time spent in each
+ * @details   A millisecond is 32.768 POWER_TIMER counts, or 4096 / 125. The time asleep is converted to ticks in
+ *            1/4096 ms units, so a count is 125 units and ticks are a shift away. The part of a tick left over is
+ *            carried to the next sleep, so the tick count does not drift however often the CPU sleeps.
+ * @author
+ * @date      2026-10-17
+
+ ******************************************************************************/
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "Power/Power.h"
+
+#include <string.h>
+
+#include "RunTimeStats/RunTimeStats.h"
+#include "task.h"
+
+/******************************************************************************
+ * Defines
+ ******************************************************************************/
+#define POWER_UNITS_PER_TICK 4096UL  ///< 1/4096 ms units per tick
+#define POWER_UNITS_PER_COUNT 125UL  ///< 1/4096 ms units per POWER_TIMER count
+#define POWER_UNITS_TICK_SHIFT 12    ///< log2(POWER_UNITS_PER_TICK)
+
+/******************************************************************************
+ * Variables
+ ******************************************************************************/
+static struct tcc_module powerTimer;                                 ///< Free running 32 kHz counter, compare 0 ends a sleep
+static struct PowerResidency powerResidency[SLEEPMGR_NR_OF_MODES];  ///< Time per sleep mode. The active entry is unused
+static uint32_t powerAborts;                                         ///< Sleeps cancelled by a task or tick that came due
+static TickType_t powerResidencyStart;                               ///< Tick count when the residency was last cleared
+static uint32_t powerTickFraction;                                   ///< Time past the last tick stepped, in 1/4096 ms
+
+#if (TRC_USE_TRACEALYZER_RECORDER == 1) && (TRC_CFG_RECORDER_MODE == TRC_RECORDER_MODE_SNAPSHOT)
+extern uint32_t uiTraceTickCount;  ///< Ticks seen by the trace recorder (trcSnapshotRecorder.c). Its tick hook misses stepped ticks
+#endif
+
+/******************************************************************************
+ * Forward Declarations
+ ******************************************************************************/
+static void power_timer_callback(struct tcc_module *const module);
+static void power_restart_tick(void);
+
+/******************************************************************************
+ * Global Functions
+ ******************************************************************************/
+
+/**
+ * @fn          void PowerInit(void)
+ * @brief       Starts the sleep manager and POWER_TIMER as a free running counter that keeps counting in standby
+ * @note        Call once before vTaskStartScheduler
+ */
+void PowerInit(void)
+{
+    struct tcc_config config;
+
+    sleepmgr_init();
+
+    tcc_get_config_defaults(&config, POWER_TIMER);
+    config.counter.clock_source = POWER_TIMER_GCLK;
+    config.counter.clock_prescaler = TCC_CLOCK_PRESCALER_DIV1;
+    config.counter.period = POWER_TIMER_MASK;
+    config.double_buffering_enabled = false;  // The compare must apply at once, not at the next wrap
+    config.run_in_standby = true;
+    tcc_init(&powerTimer, POWER_TIMER, &config);
+    tcc_register_callback(&powerTimer, power_timer_callback, TCC_CALLBACK_CHANNEL_0);
+    tcc_enable(&powerTimer);
+}
+
+/**
+ * @fn          void PowerSuppressTicksAndSleep(TickType_t expectedIdleTime)
+ * @brief       Stops the tick and sleeps until POWER_TIMER reaches the next timeout or an interrupt wakes the CPU
+ * @param[in]   expectedIdleTime Ticks until a task unblocks
+ * @note        portSUPPRESS_TICKS_AND_SLEEP, called by the idle task with the scheduler suspended. Returns without
+ *              sleeping if a lock holds the CPU active, or if a task or tick came due meanwhile
+ */
+void PowerSuppressTicksAndSleep(TickType_t expectedIdleTime)
+{
+    enum sleepmgr_mode mode = sleepmgr_get_sleep_mode();
+    uint32_t partialUnits, sleepUnits, start, elapsedCounts, elapsedUnits;
+    TickType_t elapsedTicks;
+
+    if (SLEEPMGR_ACTIVE == mode) {
+        return;
+    }
+    if (expectedIdleTime > POWER_MAX_SLEEP_TICKS) {
+        expectedIdleTime = POWER_MAX_SLEEP_TICKS;
+    }
+
+    __disable_irq();
+    if (eAbortSleep == eTaskConfirmSleepModeStatus()) {
+        powerAborts++;
+        __enable_irq();
+        return;
+    }
+
+    // Stop the tick. If it wrapped meanwhile its interrupt is pending: let it run instead of sleeping
+    SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+    partialUnits = powerTickFraction + ((SysTick->LOAD - SysTick->VAL) * POWER_UNITS_PER_TICK) / (SysTick->LOAD + 1);
+    sleepUnits = expectedIdleTime * POWER_UNITS_PER_TICK;
+    if ((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) || partialUnits + POWER_MIN_SLEEP_COUNTS * POWER_UNITS_PER_COUNT > sleepUnits) {
+        SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+        powerAborts++;
+        __enable_irq();
+        return;
+    }
+    sleepUnits -= partialUnits;
+
+    // Wake at the tick boundary of the timeout, or earlier on any interrupt
+    start = tcc_get_count_value(&powerTimer);
+    tcc_set_compare_value(&powerTimer, TCC_MATCH_CAPTURE_CHANNEL_0, (start + sleepUnits / POWER_UNITS_PER_COUNT) & POWER_TIMER_MASK);
+    powerTimer.hw->INTFLAG.reg = TCC_INTFLAG_MC0;
+    NVIC_ClearPendingIRQ(TCC1_IRQn);
+    tcc_enable_callback(&powerTimer, TCC_CALLBACK_CHANNEL_0);
+
+    system_set_sleepmode((enum system_sleepmode)(mode - 1));
+    system_sleep();  // With PRIMASK set, a pending interrupt wakes the CPU without being taken
+
+    // Take the interrupt that woke the CPU, then account for the time asleep
+    __enable_irq();
+    __ISB();
+    __disable_irq();
+
+    elapsedCounts = (tcc_get_count_value(&powerTimer) - start) & POWER_TIMER_MASK;
+    tcc_disable_callback(&powerTimer, TCC_CALLBACK_CHANNEL_0);
+
+    elapsedUnits = partialUnits + elapsedCounts * POWER_UNITS_PER_COUNT;
+    elapsedTicks = elapsedUnits >> POWER_UNITS_TICK_SHIFT;
+    if (elapsedTicks > expectedIdleTime) {
+        elapsedTicks = expectedIdleTime;  // Wake up latency. The rest is carried and stepped on a later sleep
+    }
+    powerTickFraction = elapsedUnits - elapsedTicks * POWER_UNITS_PER_TICK;
+
+    powerResidency[mode].entries++;
+    powerResidency[mode].counts += elapsedCounts;
+    if (SLEEPMGR_STANDBY == mode) {
+        RunTimeStatsAddStoppedTime(elapsedCounts, POWER_TIMER_HZ);  // GCLK0 stopped: charge the sleep to the idle task
+    }
+
+    power_restart_tick();
+    vTaskStepTick(elapsedTicks);
+#if (TRC_USE_TRACEALYZER_RECORDER == 1) && (TRC_CFG_RECORDER_MODE == TRC_RECORDER_MODE_SNAPSHOT)
+    uiTraceTickCount += elapsedTicks;  // The snapshot recorder times events by its own tick count, see trcConfig.h
+#endif
+    __enable_irq();
+}
+
+/**
+ * @fn          void PowerGetResidency(enum sleepmgr_mode mode, struct PowerResidency *residency)
+ * @brief       Returns the time spent in a sleep mode since the residency was last cleared
+ * @param[in]   mode Sleep mode, SLEEPMGR_IDLE_0 to SLEEPMGR_STANDBY
+ * @param[out]  residency Entries and time asleep
+ */
+void PowerGetResidency(enum sleepmgr_mode mode, struct PowerResidency *residency)
+{
+    taskENTER_CRITICAL();
+    *residency = powerResidency[mode];
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @fn          uint32_t PowerGetAborts(void)
+ * @brief       Returns the sleeps cancelled because a task or tick came due, since the residency was last cleared
+ */
+uint32_t PowerGetAborts(void)
+{
+    return powerAborts;
+}
+
+/**
+ * @fn          TickType_t PowerGetResidencyStart(void)
+ * @brief       Returns the tick count when the residency was last cleared, 0 if it never was
+ */
+TickType_t PowerGetResidencyStart(void)
+{
+    return powerResidencyStart;
+}
+
+/**
+ * @fn          void PowerClearResidency(void)
+ * @brief       Restarts the residency counters of every mode
+ */
+void PowerClearResidency(void)
+{
+    taskENTER_CRITICAL();
+    memset(powerResidency, 0, sizeof(powerResidency));
+    powerAborts = 0;
+    powerResidencyStart = xTaskGetTickCount();
+    taskEXIT_CRITICAL();
+}
+
+/******************************************************************************
+ * Local Functions
+ ******************************************************************************/
+
+/**
+ * @fn          static void power_restart_tick(void)
+ * @brief       Restarts SysTick on a whole period. The part of a tick already elapsed is in powerTickFraction
+ */
+static void power_restart_tick(void)
+{
+    SysTick->VAL = 0;
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+}
+
+/******************************************************************************
+ * Callback Functions
+ ******************************************************************************/
+
+/**
+ * @fn          static void power_timer_callback(struct tcc_module *const module)
+ * @brief       Compare 0 of POWER_TIMER: the timeout of a sleep. Waking the CPU is all it has to do
+ * @note        Runs in the TCC1 interrupt
+ */
+static void power_timer_callback(struct tcc_module *const module)
+{
+}
@@ -0,0 +1,57 @@
+/**************************************************************************/ /**
+ * @file      Power.h
+ * @brief     Tickless idle: sleeps in the deepest mode the sleep manager allows and counts the time spent in each
+ * @details   When every task is blocked, FreeRTOS calls PowerSuppressTicksAndSleep with the number of ticks until
+ *            the next timeout. SysTick is stopped and POWER_TIMER (TCC1 on GCLK2, the 32 kHz oscillator that runs in
+ *            standby) is set to wake the CPU at that time. Drivers that need GCLK0 or the DMAC while a task sleeps
+ *            hold sleepmgr_lock_mode(POWER_PERIPHERAL_LOCK); otherwise the CPU enters standby, where only the
+ *            external interrupts (buttons, WINC1500 IRQ), a start bit on the serial console and POWER_TIMER can
+ *            wake it.
+ * @author
+ * @date      2026-10-17
+
+ ******************************************************************************/
+
+#ifndef POWER_H
+#define POWER_H
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include <asf.h>
+
+#include "FreeRTOS.h"
+
+/******************************************************************************
+ * Defines
+ ******************************************************************************/
+#define POWER_TIMER TCC1                       ///< 24 bit free running counter. The RTC keeps the FatFs calendar
+#define POWER_TIMER_GCLK GCLK_GENERATOR_2      ///< ULP32K, runs in standby (conf_clocks.h)
+#define POWER_TIMER_HZ 32768                   ///< Rate of POWER_TIMER. The conversions below assume it
+#define POWER_TIMER_MASK 0xFFFFFFUL            ///< Range of POWER_TIMER
+#define POWER_MIN_SLEEP_COUNTS 8               ///< Shortest sleep worth the compare write, which takes ~3 counts to sync
+#define POWER_MAX_SLEEP_TICKS 500000UL         ///< Longest sleep, within one wrap of POWER_TIMER (512 s)
+#define POWER_PERIPHERAL_LOCK SLEEPMGR_IDLE_0  ///< Lock held while GCLK0, the DMAC or a SERCOM must keep running
+
+/******************************************************************************
+ * Structures and Enumerations
+ ******************************************************************************/
+/**
+ * Time spent in one sleep mode since boot or the last PowerClearResidency
+ */
+struct PowerResidency {
+    uint32_t entries;  ///< Sleeps in this mode
+    uint64_t counts;   ///< Time asleep, in POWER_TIMER counts
+};
+
+/******************************************************************************
+ * Global Function Declarations
+ ******************************************************************************/
+void PowerInit(void);
+void PowerSuppressTicksAndSleep(TickType_t expectedIdleTime);
+void PowerGetResidency(enum sleepmgr_mode mode, struct PowerResidency *residency);
+uint32_t PowerGetAborts(void);
+TickType_t PowerGetResidencyStart(void);
+void PowerClearResidency(void);
+
+#endif /*POWER_H*/
@@ -0,0 +1,97 @@
+/**************************************************************************/ /**
+ * @file      RamPlan.c
+ * @brief     Boot report of the static RAM plan
+ * @details   The group bounds and budgets are symbols of the linker script: only their addresses carry a value.
+ * @author
+ * @date      2026-10-17
+
+ ******************************************************************************/
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "RamPlan/RamPlan.h"
+
+#include "FreeRTOS.h"
+#include "SerialConsole.h"
+
+/******************************************************************************
+ * Defines
+ ******************************************************************************/
+/// Linker symbols of one subsystem
+#define RAM_PLAN_SYMBOLS(subsystem, SUBSYSTEM) extern uint8_t _sram_plan_##subsystem[], _eram_plan_##subsystem[], RAM_PLAN_##SUBSYSTEM##_BUDGET[]
+/// Row of ramPlan for one subsystem
+#define RAM_PLAN_ROW(subsystem, SUBSYSTEM) {#subsystem, _sram_plan_##subsystem, _eram_plan_##subsystem, RAM_PLAN_##SUBSYSTEM##_BUDGET}
+
+/******************************************************************************
+ * Structures and Enumerations
+ ******************************************************************************/
+/// One subsystem of the plan
+struct RamPlanGroup {
+    const char *name;       ///< Subsystem, as given to RAM_PLAN
+    const uint8_t *start;   ///< First byte of its group
+    const uint8_t *end;     ///< Byte after its group
+    const uint8_t *budget;  ///< Its budget in bytes, as an address
+};
+
+/******************************************************************************
+ * Variables
+ ******************************************************************************/
+RAM_PLAN_SYMBOLS(kernel, KERNEL);
+RAM_PLAN_SYMBOLS(cli, CLI);
+RAM_PLAN_SYMBOLS(wifi, WIFI);
+RAM_PLAN_SYMBOLS(ui, UI);
+RAM_PLAN_SYMBOLS(control, CONTROL);
+RAM_PLAN_SYMBOLS(stream, STREAM);
+RAM_PLAN_SYMBOLS(drivers, DRIVERS);
+RAM_PLAN_SYMBOLS(heap, HEAP);
+extern uint8_t _srelocate[], _erelocate[], _sbss[], _ebss[], _sstack[], _estack[], _sram[], _eram[];
+
+static const struct RamPlanGroup ramPlan[] = {  ///< Subsystems, in linker script order
+    RAM_PLAN_ROW(kernel, KERNEL),
+    RAM_PLAN_ROW(cli, CLI),
+    RAM_PLAN_ROW(wifi, WIFI),
+    RAM_PLAN_ROW(ui, UI),
+    RAM_PLAN_ROW(control, CONTROL),
+    RAM_PLAN_ROW(stream, STREAM),
+    RAM_PLAN_ROW(drivers, DRIVERS),
+    RAM_PLAN_ROW(heap, HEAP),
+};
+
+/******************************************************************************
+ * Global Functions
+ ******************************************************************************/
+
+/**
+ * @fn          int32_t RamPlanReport(void)
+ * @brief       Prints the use of each subsystem against its budget, the RAM map and the heap taken by the start up
+ * @details     The link already failed if a subsystem is over budget; the check stays so a linker script without
+ *              the asserts shows up here. The heap check fails if less than RAM_PLAN_HEAP_RESERVE bytes are left.
+ * @return      Number of failed checks, 0 if the plan holds
+ * @note        Call once the tasks are created
+ */
+int32_t RamPlanReport(void)
+{
+    int32_t failed = 0;
+    size_t planned = 0;
+    size_t heapUsed = configTOTAL_HEAP_SIZE - xPortGetMinimumEverFreeHeapSize();
+
+    SerialConsolePrintf("%-8s  Used Budget\r\n", "RAM plan");
+    for (uint32_t i = 0; i < sizeof(ramPlan) / sizeof(ramPlan[0]); i++) {
+        const struct RamPlanGroup *group = &ramPlan[i];
+        size_t used = (size_t)(group->end - group->start);
+        bool over = used > (size_t)group->budget;
+
+        SerialConsolePrintf("%-8s %5u %6u%s\r\n", group->name, (unsigned int)used, (unsigned int)(size_t)group->budget, over ? "  OVER" : "");
+        planned += used;
+        failed += over ? 1 : 0;
+    }
+
+    SerialConsolePrintf("RAM %u bytes: data %u, bss %u (plan %u), main stack %u, free %u\r\n", (unsigned int)(_eram - _sram),
+                        (unsigned int)(_erelocate - _srelocate), (unsigned int)(_ebss - _sbss), (unsigned int)planned,
+                        (unsigned int)(_estack - _sstack), (unsigned int)(_eram - _estack));
+    SerialConsolePrintf("Heap %u of %u bytes used by the start up, %u kept free%s\r\n", (unsigned int)heapUsed, (unsigned int)configTOTAL_HEAP_SIZE,
+                        (unsigned int)RAM_PLAN_HEAP_RESERVE, (configTOTAL_HEAP_SIZE - heapUsed < RAM_PLAN_HEAP_RESERVE) ? "  SHORT" : "");
+    failed += (configTOTAL_HEAP_SIZE - heapUsed < RAM_PLAN_HEAP_RESERVE) ? 1 : 0;
+    return failed;
+}
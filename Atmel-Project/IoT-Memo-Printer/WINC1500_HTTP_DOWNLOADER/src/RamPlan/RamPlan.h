@@ -0,0 +1,44 @@
+/**************************************************************************/ /**
+ * @file      RamPlan.h
+ * @brief     Static RAM plan: the task stacks, TCBs, queues and semaphores of each subsystem, with a budget
+ * @details   Every kernel object is allocated statically (configSUPPORT_DYNAMIC_ALLOCATION is 0) and its storage
+ *            is tagged with RAM_PLAN(subsystem). The linker script groups the storage of each subsystem between
+ *            _sram_plan_<subsystem> and _eram_plan_<subsystem> and fails the link if a group is larger than its
+ *            RAM_PLAN_<SUBSYSTEM>_BUDGET. RamPlanReport prints the plan at boot and checks what the linker
+ *            cannot: how much of the heap the start up took.
+ * @author
+ * @date      2026-10-17
+
+ ******************************************************************************/
+
+#ifndef RAM_PLAN_H
+#define RAM_PLAN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include <stdint.h>
+
+/******************************************************************************
+ * Defines
+ ******************************************************************************/
+/// Places a zero initialized variable in the RAM plan of a subsystem: kernel, cli, wifi, ui, control, stream,
+/// drivers or heap. A new subsystem needs its group and budget in the linker script and a row in RamPlan.c
+#define RAM_PLAN(subsystem) __attribute__((section(".bss.plan." #subsystem)))
+
+#define RAM_PLAN_HEAP_RESERVE 512  ///< Heap that must stay free after start up, for the dynamic work (pools, CLI, bench)
+
+/******************************************************************************
+ * Global Function Declarations
+ ******************************************************************************/
+int32_t RamPlanReport(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RAM_PLAN_H */
@@ -0,0 +1,117 @@
+/**************************************************************************/ /**
+ * @file      RunTimeStats.c
+ * @brief     Run time statistics time base and queue list for the "top" CLI command
+ * @details   The counter is read at every context switch, so it is read directly: continuous read
+ *            synchronization keeps COUNT up to date without a read request per access. GCLK0 stops in standby, and
+ *            the counter with it: Power.c reports each standby sleep, which is added to the counter as an offset.
+ * @author
+ * @date      2026-10-17
+
+ ******************************************************************************/
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "RunTimeStats/RunTimeStats.h"
+
+/******************************************************************************
+ * Variables
+ ******************************************************************************/
+static struct tc_module runTimeStatsTimer;                            ///< Free running 32 bit counter
+static QueueHandle_t runTimeStatsQueues[RUN_TIME_STATS_MAX_QUEUES];   ///< Queues shown by "top"
+static const char *runTimeStatsQueueNames[RUN_TIME_STATS_MAX_QUEUES];  ///< Names of runTimeStatsQueues
+static uint32_t runTimeStatsHz;                                       ///< Rate of the counter, read once at init
+static volatile uint32_t runTimeStatsStopped;                         ///< Counts added for the time the counter stood still
+static uint32_t runTimeStatsStoppedFraction;                          ///< Part of a count not added yet, in counts times the caller's rate
+
+/******************************************************************************
+ * Global Functions
+ ******************************************************************************/
+
+/**
+ * @fn          void RunTimeStatsTimerInit(void)
+ * @brief       Starts RUN_TIME_STATS_TIMER as a free running 32 bit up counter
+ * @note        portCONFIGURE_TIMER_FOR_RUN_TIME_STATS, called once by vTaskStartScheduler
+ */
+void RunTimeStatsTimerInit(void)
+{
+    struct tc_config config;
+
+    tc_get_config_defaults(&config);
+    config.counter_size = TC_COUNTER_SIZE_32BIT;
+    config.clock_prescaler = RUN_TIME_STATS_PRESCALER;
+    config.wave_generation = TC_WAVE_GENERATION_NORMAL_FREQ;
+    tc_init(&runTimeStatsTimer, RUN_TIME_STATS_TIMER, &config);
+    tc_enable(&runTimeStatsTimer);
+
+    runTimeStatsTimer.hw->COUNT32.READREQ.reg = TC_READREQ_RCONT | TC_READREQ_ADDR(TC_COUNT32_COUNT_OFFSET);
+    runTimeStatsHz = RunTimeStatsTimerHz();
+}
+
+/**
+ * @fn          uint32_t RunTimeStatsTimerGet(void)
+ * @brief       Returns the run time counter
+ * @note        portGET_RUN_TIME_COUNTER_VALUE. Runs in the context switch
+ */
+uint32_t RunTimeStatsTimerGet(void)
+{
+    return runTimeStatsTimer.hw->COUNT32.COUNT.reg + runTimeStatsStopped;
+}
+
+/**
+ * @fn          void RunTimeStatsAddStoppedTime(uint32_t counts, uint32_t countsHz)
+ * @brief       Advances the run time counter over a time it stood still, so the task that ran meanwhile is charged
+ * @param[in]   counts Time stopped, in units of another counter
+ * @param[in]   countsHz Rate of that counter
+ * @note        Called by the idle task after a standby sleep, with interrupts disabled
+ */
+void RunTimeStatsAddStoppedTime(uint32_t counts, uint32_t countsHz)
+{
+    uint64_t scaled = (uint64_t)counts * runTimeStatsHz + runTimeStatsStoppedFraction;
+
+    runTimeStatsStopped += (uint32_t)(scaled / countsHz);
+    runTimeStatsStoppedFraction = (uint32_t)(scaled % countsHz);
+}
+
+/**
+ * @fn          uint32_t RunTimeStatsTimerHz(void)
+ * @brief       Returns the rate of the run time counter, in counts per second
+ */
+uint32_t RunTimeStatsTimerHz(void)
+{
+    return system_gclk_gen_get_hz(GCLK_GENERATOR_0) / RUN_TIME_STATS_PRESCALER_DIVISION;
+}
+
+/**
+ * @fn          void RunTimeStatsAddQueue(QueueHandle_t queue, const char *name)
+ * @brief       Lists a queue in the output of "top"
+ * @param[in]   queue Queue, ignored if NULL
+ * @param[in]   name Name shown, kept by reference
+ * @note        Call once after creating the queue. Queues past RUN_TIME_STATS_MAX_QUEUES are not listed
+ */
+void RunTimeStatsAddQueue(QueueHandle_t queue, const char *name)
+{
+    for (uint32_t i = 0; i < RUN_TIME_STATS_MAX_QUEUES && NULL != queue; i++) {
+        if (NULL == runTimeStatsQueues[i]) {
+            runTimeStatsQueueNames[i] = name;
+            runTimeStatsQueues[i] = queue;
+            break;
+        }
+    }
+}
+
+/**
+ * @fn          QueueHandle_t RunTimeStatsGetQueue(uint32_t index, const char **name)
+ * @brief       Returns a listed queue
+ * @param[in]   index Position in the list, from 0
+ * @param[out]  name Name given to RunTimeStatsAddQueue
+ * @return      The queue, or NULL past the end of the list
+ */
+QueueHandle_t RunTimeStatsGetQueue(uint32_t index, const char **name)
+{
+    if (index >= RUN_TIME_STATS_MAX_QUEUES || NULL == runTimeStatsQueues[index]) {
+        return NULL;
+    }
+    *name = runTimeStatsQueueNames[index];
+    return runTimeStatsQueues[index];
+}
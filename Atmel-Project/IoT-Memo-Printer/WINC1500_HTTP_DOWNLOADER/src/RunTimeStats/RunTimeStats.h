@@ -0,0 +1,42 @@
+/**************************************************************************/ /**
+ * @file      RunTimeStats.h
+ * @brief     Run time statistics time base and queue list for the "top" CLI command
+ * @details   FreeRTOS charges the time between two context switches to the task that ran, read from
+ *            RUN_TIME_STATS_TIMER (TC4 and TC5 chained as one free running 32 bit counter, no interrupts), plus the
+ *            standby time it missed. The queues worth watching are listed here by the modules that create them,
+ *            since FreeRTOS 10.0 cannot enumerate its queues.
+ * @author
+ * @date      2026-10-17
+
+ ******************************************************************************/
+
+#ifndef RUN_TIME_STATS_H
+#define RUN_TIME_STATS_H
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include <asf.h>
+
+#include "FreeRTOS.h"
+#include "queue.h"
+
+/******************************************************************************
+ * Defines
+ ******************************************************************************/
+#define RUN_TIME_STATS_TIMER TC4                                ///< Master of the 32 bit pair TC4/TC5
+#define RUN_TIME_STATS_PRESCALER TC_CLOCK_PRESCALER_DIV8       ///< GCLK0 / 8: 6 MHz at 48 MHz, wraps after 11.9 minutes
+#define RUN_TIME_STATS_PRESCALER_DIVISION 8                    ///< Division of RUN_TIME_STATS_PRESCALER
+#define RUN_TIME_STATS_MAX_QUEUES 8                            ///< Queues RunTimeStatsAddQueue can list
+
+/******************************************************************************
+ * Global Function Declarations
+ ******************************************************************************/
+void RunTimeStatsTimerInit(void);
+uint32_t RunTimeStatsTimerGet(void);
+uint32_t RunTimeStatsTimerHz(void);
+void RunTimeStatsAddStoppedTime(uint32_t counts, uint32_t countsHz);
+void RunTimeStatsAddQueue(QueueHandle_t queue, const char *name);
+QueueHandle_t RunTimeStatsGetQueue(uint32_t index, const char **name);
+
+#endif /*RUN_TIME_STATS_H*/
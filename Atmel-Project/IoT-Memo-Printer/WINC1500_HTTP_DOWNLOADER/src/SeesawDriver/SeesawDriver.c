@@ -66,12 +66,12 @@ int InitializeSeesaw(void)
     int error = I2cReadDataWait(&seesawData, 0, 100);
 
     if (ERROR_NONE != error) {
-        SerialConsoleWriteString("Error initializing Seesaw!/r/n");
+        LOG_ERROR(I2C, "Error initializing Seesaw!\r\n");
     } else {
         if (readData[0] != SEESAW_HW_ID_CODE) {
-            SerialConsoleWriteString("Error/r/n");
+            LOG_ERROR(I2C, "Seesaw answered with HW ID 0x%02x!\r\n", readData[0]);
         } else {
-            SerialConsoleWriteString("Found Seesaw!/r/n");
+            LOG_INFO(I2C, "Found Seesaw!\r\n");
         }
     }
 
@@ -81,7 +81,7 @@ int InitializeSeesaw(void)
 
     error = I2cWriteDataWait(&seesawData, 100);
     if (ERROR_NONE != error) {
-        SerialConsoleWriteString("Could not write Seesaw pin!/r/n");
+        LOG_ERROR(I2C, "Could not write Seesaw pin!\r\n");
     }
 
     // Set seesaw Neopixel speed
@@ -90,7 +90,7 @@ int InitializeSeesaw(void)
 
     error = I2cWriteDataWait(&seesawData, 100);
     if (ERROR_NONE != error) {
-        SerialConsoleWriteString("Could not set seesaw Neopixel speed!/r/n");
+        LOG_ERROR(I2C, "Could not set seesaw Neopixel speed!\r\n");
     }
 
     // Set seesaw Neopixel number of devices
@@ -99,7 +99,7 @@ int InitializeSeesaw(void)
 
     error = I2cWriteDataWait(&seesawData, 100);
     if (ERROR_NONE != error) {
-        SerialConsoleWriteString("Could not set seesaw Neopixel number of devices/r/n");
+        LOG_ERROR(I2C, "Could not set seesaw Neopixel number of devices!\r\n");
     }
 
     SeesawTurnOnLedTest();
@@ -128,7 +128,7 @@ uint8_t SeesawGetKeypadCount(void)
     int error = I2cReadDataWait(&seesawData, 0, 100);
 
     if (ERROR_NONE != error) {
-        SerialConsoleWriteString("Error reading Seesaw counts!/r/n");
+        LOG_ERROR(I2C, "Error reading Seesaw counts!\r\n");
     }
     return count;
 }
@@ -155,7 +155,7 @@ int32_t SeesawReadKeypad(uint8_t *buffer, uint8_t count)
     int error = I2cReadDataWait(&seesawData, 0, 100);
 
     if (ERROR_NONE != error) {
-        SerialConsoleWriteString("Error reading Seesaw counts!/r/n");
+        LOG_ERROR(I2C, "Error reading Seesaw counts!\r\n");
     }
     return error;
 }
@@ -242,7 +242,7 @@ static void SeesawInitializeKeypad(void)
 
     int32_t error = I2cWriteDataWait(&seesawData, 100);
     if (ERROR_NONE != error) {
-        SerialConsoleWriteString("Could not initialize Keypad!/r/n");
+        LOG_ERROR(I2C, "Could not initialize Keypad!\r\n");
     }
 
     // Initialize all buttons to register an event for both press and release
@@ -250,7 +250,7 @@ static void SeesawInitializeKeypad(void)
         error = SeesawActivateKey(NEO_TRELLIS_KEY(i), SEESAW_KEYPAD_EDGE_RISING, true);
         error |= SeesawActivateKey(NEO_TRELLIS_KEY(i), SEESAW_KEYPAD_EDGE_FALLING, true);
         if (ERROR_NONE != error) {
-            SerialConsoleWriteString("Could not initialize Keypad!/r/n");
+            LOG_ERROR(I2C, "Could not initialize Keypad!\r\n");
         }
     }
 }
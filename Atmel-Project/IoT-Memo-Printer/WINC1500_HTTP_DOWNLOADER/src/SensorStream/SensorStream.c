@@ -0,0 +1,247 @@
+/**************************************************************************/ /**
+ * @file      SensorStream.c
+ * @brief     Task that streams sensor samples as binary packets on the serial console
+ * @details   The task paces itself with vTaskDelayUntil, so the sample rate does not drift with the time the reads
+ *            take. The distance and SHTC3 reads block for several ms; they are done at SENSOR_STREAM_SLOW_RATE_HZ
+ *            and the periods they overrun are caught up back to back, keeping the average rate. The timestamp of
+ *            each packet is the time the sample was taken.
+ * @author
+ * @date      2026-10-17
+
+ ******************************************************************************/
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "SensorStream/SensorStream.h"
+
+#include "DistanceDriver/DistanceSensor.h"
+#include "I2cDriver/I2cDriver.h"
+#include "I2cDriver/shtc3.h"
+#include "IMU/lsm6dso_reg.h"
+#include "SerialConsole.h"
+#include "task.h"
+
+/******************************************************************************
+ * Structures and Enumerations
+ ******************************************************************************/
+/// IMU output data rate for a stream rate
+struct ImuRate {
+    uint32_t hz;                ///< Highest stream rate served by this data rate
+    lsm6dso_odr_xl_t xlRate;    ///< Accelerometer data rate
+    lsm6dso_odr_g_t gyRate;     ///< Gyroscope data rate
+};
+
+/******************************************************************************
+ * Variables
+ ******************************************************************************/
+static const struct ImuRate imuRates[] = {
+    {12, LSM6DSO_XL_ODR_12Hz5, LSM6DSO_GY_ODR_12Hz5}, {26, LSM6DSO_XL_ODR_26Hz, LSM6DSO_GY_ODR_26Hz},
+    {52, LSM6DSO_XL_ODR_52Hz, LSM6DSO_GY_ODR_52Hz},   {104, LSM6DSO_XL_ODR_104Hz, LSM6DSO_GY_ODR_104Hz},
+    {208, LSM6DSO_XL_ODR_208Hz, LSM6DSO_GY_ODR_208Hz}, {417, LSM6DSO_XL_ODR_417Hz, LSM6DSO_GY_ODR_417Hz},
+    {833, LSM6DSO_XL_ODR_833Hz, LSM6DSO_GY_ODR_833Hz}, {1667, LSM6DSO_XL_ODR_1667Hz, LSM6DSO_GY_ODR_1667Hz},
+};
+
+static TaskHandle_t streamTaskHandle = NULL;  ///< Stream task, woken by SensorStreamStart
+static volatile bool streamRunning;           ///< Set by SensorStreamStart, cleared by SensorStreamStop
+static volatile uint8_t streamSensors;        ///< STREAM_SENSOR_ bits selected
+static volatile TickType_t streamPeriod = 1;  ///< Sample period, in ticks
+static volatile uint32_t streamGeneration;    ///< Counts SensorStreamStart calls. A change restarts the stream
+static volatile uint32_t streamSent;          ///< Packets queued since the stream started
+static volatile uint32_t streamDropped;       ///< Packets dropped on a full TX ring since the stream started
+
+/******************************************************************************
+ * Local Function Declaration
+ ******************************************************************************/
+static void stream_configure(uint8_t sensors, TickType_t period);
+static void stream_sample(struct StreamSample *sample, uint8_t sensors, bool slow);
+
+/******************************************************************************
+ * Task Functions
+ ******************************************************************************/
+
+/**
+ * @fn		void vSensorStreamTask(void *pvParameters)
+ * @brief	Samples the selected sensors while a stream is started
+ * @details	Waits for a notification from SensorStreamStart, then sends one packet per period until the stream is
+ *stopped or started again with other settings. The IMU is put back to its idle data rate (InitImu) when the stream
+ *ends.
+ * @param[in]	Parameters passed when task is initialized. In this case we can ignore them!
+ * @return		Should not return! This is a task defining function.
+ * @note
+ */
+void vSensorStreamTask(void *pvParameters)
+{
+    uint8_t packet[STREAM_PACKET_MAX_SIZE];
+    struct StreamSample sample;
+    uint16_t sequence = 0;
+
+    streamTaskHandle = xTaskGetCurrentTaskHandle();
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        while (streamRunning) {
+            uint32_t generation = streamGeneration;
+            uint8_t sensors = streamSensors;
+            TickType_t period = streamPeriod;
+            TickType_t slowPeriod = configTICK_RATE_HZ / SENSOR_STREAM_SLOW_RATE_HZ;
+            TickType_t lastWake;
+            TickType_t slowDue;
+
+            stream_configure(sensors, period);
+            lastWake = xTaskGetTickCount();
+            slowDue = lastWake;
+
+            while (streamRunning && generation == streamGeneration) {
+                bool slow = false;
+
+                vTaskDelayUntil(&lastWake, period);
+                if ((int32_t)(lastWake - slowDue) >= 0) {
+                    slow = true;
+                    slowDue = lastWake + slowPeriod;
+                }
+
+                sample.sequence = sequence++;
+                stream_sample(&sample, sensors, slow);
+                if (SerialConsoleWriteFrame(packet, StreamPacketPack(packet, &sample))) {
+                    streamSent++;
+                } else {
+                    streamDropped++;
+                }
+            }
+        }
+
+        stream_configure(0, 0);
+    }
+}
+
+/******************************************************************************
+ * Global Functions
+ ******************************************************************************/
+
+/**
+ * @fn			int32_t SensorStreamStart(uint8_t sensors, uint32_t rateHz)
+ * @brief		Starts a stream, or changes the settings of the running one
+ * @param[in]	sensors STREAM_SENSOR_ bits of the sensors to sample
+ * @param[in]	rateHz Samples per second, 1 to SENSOR_STREAM_MAX_RATE_HZ. Rounded to a whole number of ticks
+ * @return		The sample rate used, or ERROR_INVALID_ARG / ERROR_NOT_INITIALIZED
+ * @note		The sequence numbers continue across restarts, the counters of SensorStreamGetStatus start again
+ */
+int32_t SensorStreamStart(uint8_t sensors, uint32_t rateHz)
+{
+    TickType_t period;
+
+    if (0 == (sensors & STREAM_SENSOR_ALL) || rateHz == 0 || rateHz > SENSOR_STREAM_MAX_RATE_HZ) {
+        return ERROR_INVALID_ARG;
+    }
+    if (NULL == streamTaskHandle) {
+        return ERROR_NOT_INITIALIZED;
+    }
+
+    period = (configTICK_RATE_HZ + rateHz / 2) / rateHz;
+    taskENTER_CRITICAL();
+    streamSensors = sensors & STREAM_SENSOR_ALL;
+    streamPeriod = period;
+    streamSent = 0;
+    streamDropped = 0;
+    streamGeneration++;
+    streamRunning = true;
+    taskEXIT_CRITICAL();
+    xTaskNotifyGive(streamTaskHandle);
+
+    return configTICK_RATE_HZ / period;
+}
+
+/**
+ * @fn			void SensorStreamStop(void)
+ * @brief		Stops the stream. The task finishes the packet in progress first
+ * @note
+ */
+void SensorStreamStop(void)
+{
+    streamRunning = false;
+}
+
+/**
+ * @fn			void SensorStreamGetStatus(struct SensorStreamStatus *status)
+ * @brief		Returns the settings and counters of the stream
+ * @param[out]	status State of the stream
+ * @note
+ */
+void SensorStreamGetStatus(struct SensorStreamStatus *status)
+{
+    taskENTER_CRITICAL();
+    status->running = streamRunning;
+    status->sensors = streamSensors;
+    status->rateHz = configTICK_RATE_HZ / streamPeriod;
+    status->sent = streamSent;
+    status->dropped = streamDropped;
+    taskEXIT_CRITICAL();
+}
+
+/******************************************************************************
+ * Local Functions
+ ******************************************************************************/
+
+/**
+ * @fn			static void stream_configure(uint8_t sensors, TickType_t period)
+ * @brief		Prepares the sensors for a stream
+ * @details		The IMU data rate is raised to the first one at or above the stream rate, so every sample is a new
+ *reading; without the IMU in the stream it goes back to the rate set by InitImu. The SHTC3 is woken up.
+ * @param[in]	sensors STREAM_SENSOR_ bits selected, 0 when the stream ends
+ * @param[in]	period Sample period, in ticks
+ * @note
+ */
+static void stream_configure(uint8_t sensors, TickType_t period)
+{
+    stmdev_ctx_t *dev_ctx = GetImuStruct();
+    const struct ImuRate *rate = &imuRates[0];
+
+    if (sensors & STREAM_SENSOR_IMU) {
+        uint32_t hz = configTICK_RATE_HZ / period;
+
+        for (uint32_t i = 0; i < sizeof(imuRates) / sizeof(imuRates[0]); i++) {
+            rate = &imuRates[i];
+            if (rate->hz >= hz) {
+                break;
+            }
+        }
+    }
+    lsm6dso_xl_data_rate_set(dev_ctx, rate->xlRate);
+    lsm6dso_gy_data_rate_set(dev_ctx, rate->gyRate);
+
+    if (sensors & STREAM_SENSOR_TEMPERATURE) {
+        SHTC3_Init();
+    }
+}
+
+/**
+ * @fn			static void stream_sample(struct StreamSample *sample, uint8_t sensors, bool slow)
+ * @brief		Reads the selected sensors into a sample
+ * @param[out]	sample Sample. Sensors that failed to read are left out of sample->sensors
+ * @param[in]	sensors STREAM_SENSOR_ bits selected
+ * @param[in]	slow True if the slow sensors (distance, SHTC3) are due in this period
+ * @note
+ */
+static void stream_sample(struct StreamSample *sample, uint8_t sensors, bool slow)
+{
+    stmdev_ctx_t *dev_ctx = GetImuStruct();
+
+    sample->sensors = 0;
+    sample->timestamp = xTaskGetTickCount();
+
+    if ((sensors & STREAM_SENSOR_IMU) && 0 == lsm6dso_acceleration_raw_get(dev_ctx, sample->acceleration) &&
+        0 == lsm6dso_angular_rate_raw_get(dev_ctx, sample->angularRate)) {
+        sample->sensors |= STREAM_SENSOR_IMU;
+    }
+    if (!slow) {
+        return;
+    }
+    if ((sensors & STREAM_SENSOR_DISTANCE) && ERROR_NONE == DistanceSensorGetDistance(&sample->distance, SENSOR_STREAM_DISTANCE_TIMEOUT_MS)) {
+        sample->sensors |= STREAM_SENSOR_DISTANCE;
+    }
+    if ((sensors & STREAM_SENSOR_TEMPERATURE) && SHT3_OK == SHTC3_Measure(&sample->temperature, &sample->humidity)) {
+        sample->sensors |= STREAM_SENSOR_TEMPERATURE;
+    }
+}
@@ -0,0 +1,61 @@
+/**************************************************************************/ /**
+ * @file      SensorStream.h
+ * @brief     Task that streams sensor samples as binary packets on the serial console
+ * @details   Started and stopped by the "stream" CLI command. The task sleeps until a stream is started, then
+ *            samples the selected sensors once per period and queues one packet (StreamPacket.h) per sample on
+ *            the console TX ring. Packets that do not fit are dropped whole; Tools/streamcap.c captures them on
+ *            the host and reports the gaps.
+ * @author
+ * @date      2026-10-17
+
+ ******************************************************************************/
+
+#ifndef SENSOR_STREAM_H
+#define SENSOR_STREAM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include <asf.h>
+
+#include "FreeRTOS.h"
+#include "SensorStream/StreamPacket.h"
+
+/******************************************************************************
+ * Defines
+ ******************************************************************************/
+#define SENSOR_STREAM_TASK_SIZE 200                      ///< Size of stack to assign to the stream task. In words
+#define SENSOR_STREAM_PRIORITY (configMAX_PRIORITIES - 1)  ///< Same as the other sensor and UI tasks
+#define SENSOR_STREAM_MAX_RATE_HZ configTICK_RATE_HZ    ///< One sample per tick at most
+#define SENSOR_STREAM_SLOW_RATE_HZ 10                    ///< Rate of the distance and SHTC3 reads, which block for ms
+#define SENSOR_STREAM_DISTANCE_TIMEOUT_MS 50             ///< Longest wait for the US-100
+
+/******************************************************************************
+ * Structures and Enumerations
+ ******************************************************************************/
+/// State of the stream, for the CLI
+struct SensorStreamStatus {
+    bool running;      ///< A stream is started
+    uint8_t sensors;   ///< STREAM_SENSOR_ bits selected
+    uint32_t rateHz;   ///< Sample rate, as rounded to whole ticks
+    uint32_t sent;     ///< Packets queued since the stream started
+    uint32_t dropped;  ///< Packets that did not fit in the TX ring
+};
+
+/******************************************************************************
+ * Global Function Declarations
+ ******************************************************************************/
+void vSensorStreamTask(void *pvParameters);
+int32_t SensorStreamStart(uint8_t sensors, uint32_t rateHz);
+void SensorStreamStop(void);
+void SensorStreamGetStatus(struct SensorStreamStatus *status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SENSOR_STREAM_H */
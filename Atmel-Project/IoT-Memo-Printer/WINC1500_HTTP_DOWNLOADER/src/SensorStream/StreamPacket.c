@@ -0,0 +1,183 @@
+/**************************************************************************/ /**
+ * @file      StreamPacket.c
+ * @brief     Packs and checks the packets of the sensor stream (see StreamPacket.h)
+ * @details   Byte by byte, so the layout does not depend on the struct padding or byte order of the machine: the
+ *            same code packs on target and parses on the host.
+ * @author
+ * @date      2026-10-17
+
+ ******************************************************************************/
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "StreamPacket.h"
+
+/******************************************************************************
+ * Local Function Declaration
+ ******************************************************************************/
+static uint8_t *put_le(uint8_t *out, uint32_t value, int bytes);
+static uint32_t get_le(const uint8_t *in, int bytes);
+static size_t payload_length(uint8_t sensors);
+
+/******************************************************************************
+ * Global Functions
+ ******************************************************************************/
+
+/**
+ * @fn			size_t StreamPacketPack(uint8_t *packet, const struct StreamSample *sample)
+ * @brief		Builds the packet of one sample
+ * @param[out]	packet Output, at least STREAM_PACKET_MAX_SIZE bytes
+ * @param[in]	sample Sample to send. Sensor bits outside STREAM_SENSOR_ALL are ignored
+ * @return		Length of the packet
+ * @note
+ */
+size_t StreamPacketPack(uint8_t *packet, const struct StreamSample *sample)
+{
+    uint8_t sensors = sample->sensors & STREAM_SENSOR_ALL;
+    uint8_t *out = &packet[STREAM_PACKET_HEADER_SIZE];
+
+    packet[0] = STREAM_PACKET_SYNC;
+    packet[1] = (uint8_t)payload_length(sensors);
+    packet[2] = sensors;
+    put_le(&packet[3], sample->sequence, 2);
+    put_le(&packet[5], sample->timestamp, 4);
+
+    if (sensors & STREAM_SENSOR_IMU) {
+        for (int i = 0; i < 3; i++) {
+            out = put_le(out, (uint16_t)sample->acceleration[i], 2);
+        }
+        for (int i = 0; i < 3; i++) {
+            out = put_le(out, (uint16_t)sample->angularRate[i], 2);
+        }
+    }
+    if (sensors & STREAM_SENSOR_DISTANCE) {
+        out = put_le(out, sample->distance, 2);
+    }
+    if (sensors & STREAM_SENSOR_TEMPERATURE) {
+        out = put_le(out, sample->temperature, 2);
+        out = put_le(out, sample->humidity, 2);
+    }
+
+    out = put_le(out, StreamPacketCrc(&packet[1], (size_t)(out - &packet[1])), 2);
+    return (size_t)(out - packet);
+}
+
+/**
+ * @fn			size_t StreamPacketLength(const uint8_t *header)
+ * @brief		Returns the length of a packet from its first two bytes
+ * @param[in]	header Sync and length bytes of a candidate packet
+ * @return		Length of the whole packet, CRC included, or 0 if the bytes cannot start a packet
+ * @note
+ */
+size_t StreamPacketLength(const uint8_t *header)
+{
+    if (header[0] != STREAM_PACKET_SYNC || header[1] > STREAM_PACKET_MAX_PAYLOAD) {
+        return 0;
+    }
+    return STREAM_PACKET_HEADER_SIZE + header[1] + STREAM_PACKET_CRC_SIZE;
+}
+
+/**
+ * @fn			int StreamPacketParse(const uint8_t *packet, struct StreamSample *sample)
+ * @brief		Checks a packet and unpacks its sample
+ * @param[in]	packet Complete packet, StreamPacketLength bytes
+ * @param[out]	sample Sample of the packet
+ * @return		0 if the packet is valid, -1 otherwise (bad length, CRC or sensor bits)
+ * @note
+ */
+int StreamPacketParse(const uint8_t *packet, struct StreamSample *sample)
+{
+    size_t length = StreamPacketLength(packet);
+    const uint8_t *in = &packet[STREAM_PACKET_HEADER_SIZE];
+
+    if (length == 0 || (packet[2] & ~STREAM_SENSOR_ALL) != 0 || payload_length(packet[2]) != packet[1]) {
+        return -1;
+    }
+    if (StreamPacketCrc(&packet[1], length - 1 - STREAM_PACKET_CRC_SIZE) != get_le(&packet[length - STREAM_PACKET_CRC_SIZE], 2)) {
+        return -1;
+    }
+
+    sample->sensors = packet[2];
+    sample->sequence = (uint16_t)get_le(&packet[3], 2);
+    sample->timestamp = get_le(&packet[5], 4);
+    if (sample->sensors & STREAM_SENSOR_IMU) {
+        for (int i = 0; i < 3; i++, in += 2) {
+            sample->acceleration[i] = (int16_t)get_le(in, 2);
+        }
+        for (int i = 0; i < 3; i++, in += 2) {
+            sample->angularRate[i] = (int16_t)get_le(in, 2);
+        }
+    }
+    if (sample->sensors & STREAM_SENSOR_DISTANCE) {
+        sample->distance = (uint16_t)get_le(in, 2);
+        in += 2;
+    }
+    if (sample->sensors & STREAM_SENSOR_TEMPERATURE) {
+        sample->temperature = (uint16_t)get_le(in, 2);
+        sample->humidity = (uint16_t)get_le(in + 2, 2);
+    }
+    return 0;
+}
+
+/**
+ * @fn			uint16_t StreamPacketCrc(const uint8_t *data, size_t length)
+ * @brief		CRC-16/CCITT-FALSE: polynomial 0x1021, initial value 0xFFFF, no reflection
+ * @note		Bitwise: a 256 entry table would cost more flash than the few packets per ms need
+ */
+uint16_t StreamPacketCrc(const uint8_t *data, size_t length)
+{
+    uint16_t crc = 0xFFFF;
+
+    while (length-- > 0) {
+        crc ^= (uint16_t)(*data++ << 8);
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/******************************************************************************
+ * Local Functions
+ ******************************************************************************/
+
+/**
+ * @fn			static uint8_t *put_le(uint8_t *out, uint32_t value, int bytes)
+ * @brief		Stores the low bytes of value, little endian
+ * @return		Position after the stored bytes
+ * @note
+ */
+static uint8_t *put_le(uint8_t *out, uint32_t value, int bytes)
+{
+    for (int i = 0; i < bytes; i++) {
+        *out++ = (uint8_t)(value >> (8 * i));
+    }
+    return out;
+}
+
+/**
+ * @fn			static uint32_t get_le(const uint8_t *in, int bytes)
+ * @brief		Reads a little endian value
+ * @note
+ */
+static uint32_t get_le(const uint8_t *in, int bytes)
+{
+    uint32_t value = 0;
+
+    for (int i = bytes - 1; i >= 0; i--) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+/**
+ * @fn			static size_t payload_length(uint8_t sensors)
+ * @brief		Returns the payload length of a set of STREAM_SENSOR_ bits
+ * @note
+ */
+static size_t payload_length(uint8_t sensors)
+{
+    return ((sensors & STREAM_SENSOR_IMU) ? 12 : 0) + ((sensors & STREAM_SENSOR_DISTANCE) ? 2 : 0) +
+           ((sensors & STREAM_SENSOR_TEMPERATURE) ? 4 : 0);
+}
@@ -0,0 +1,77 @@
+/**************************************************************************/ /**
+ * @file      StreamPacket.h
+ * @brief     Packet layout of the sensor stream ("stream" CLI command)
+ * @details   Every sample period the stream task sends one packet, interleaved with the plain text of the console.
+ *
+ *            Packet:
+ *              STREAM_PACKET_SYNC, payload length, sensors, sequence (2 bytes), timestamp (4 bytes), payload, CRC
+ *            sensors holds one STREAM_SENSOR_ bit per sensor whose reading is in the payload, in bit order:
+ *              STREAM_SENSOR_IMU           acceleration x y z, angular rate x y z   6 x int16 raw (2 g, 2000 dps)
+ *              STREAM_SENSOR_DISTANCE      distance in mm                           uint16
+ *              STREAM_SENSOR_TEMPERATURE   SHTC3 temperature, humidity              2 x uint16 raw
+ *            A sensor selected for the stream can be missing from a packet: slow sensors are read at a lower
+ *            rate, and failed reads are left out. The timestamp is the FreeRTOS tick count (ms). The sequence
+ *            counts packets, so the host sees packets dropped on a full TX ring. The CRC is CRC-16/CCITT-FALSE
+ *            of every byte after the sync byte. All values are little endian.
+ *
+ *            Plain C only: shared with Tools/streamcap.c.
+ * @author
+ * @date      2026-10-17
+
+ ******************************************************************************/
+
+#ifndef STREAM_PACKET_H
+#define STREAM_PACKET_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include <stddef.h>
+#include <stdint.h>
+
+/******************************************************************************
+ * Defines
+ ******************************************************************************/
+#define STREAM_PACKET_SYNC 0xFD          ///< First byte of a packet. Not LOG_FRAME_SYNC, never sent by the text console
+#define STREAM_PACKET_HEADER_SIZE 9      ///< Sync, length, sensors, sequence and timestamp
+#define STREAM_PACKET_MAX_PAYLOAD 18     ///< Payload with every sensor present
+#define STREAM_PACKET_CRC_SIZE 2         ///< CRC after the payload
+#define STREAM_PACKET_MAX_SIZE (STREAM_PACKET_HEADER_SIZE + STREAM_PACKET_MAX_PAYLOAD + STREAM_PACKET_CRC_SIZE)  ///< Longest packet
+
+#define STREAM_SENSOR_IMU 0x01          ///< LSM6DSO accelerometer and gyroscope
+#define STREAM_SENSOR_DISTANCE 0x02     ///< US-100 distance sensor
+#define STREAM_SENSOR_TEMPERATURE 0x04  ///< SHTC3 temperature and humidity sensor
+#define STREAM_SENSOR_ALL (STREAM_SENSOR_IMU | STREAM_SENSOR_DISTANCE | STREAM_SENSOR_TEMPERATURE)
+
+/******************************************************************************
+ * Structures and Enumerations
+ ******************************************************************************/
+/// One sample of the stream. Only the fields of the sensors in "sensors" are valid
+struct StreamSample {
+    uint8_t sensors;          ///< STREAM_SENSOR_ bits of the readings present
+    uint16_t sequence;        ///< Packet counter of the sender
+    uint32_t timestamp;       ///< Tick count when the sample was taken, in ms
+    int16_t acceleration[3];  ///< Raw accelerometer output, x y z
+    int16_t angularRate[3];   ///< Raw gyroscope output, x y z
+    uint16_t distance;        ///< Distance in mm
+    uint16_t temperature;     ///< Raw SHTC3 temperature: -45 + 175 * raw / 65536 degrees C
+    uint16_t humidity;        ///< Raw SHTC3 humidity: 100 * raw / 65536 %RH
+};
+
+/******************************************************************************
+ * Global Function Declarations
+ ******************************************************************************/
+size_t StreamPacketPack(uint8_t *packet, const struct StreamSample *sample);
+size_t StreamPacketLength(const uint8_t *header);
+int StreamPacketParse(const uint8_t *packet, struct StreamSample *sample);
+uint16_t StreamPacketCrc(const uint8_t *data, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STREAM_PACKET_H */
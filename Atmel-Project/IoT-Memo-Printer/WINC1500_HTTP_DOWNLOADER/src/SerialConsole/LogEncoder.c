@@ -0,0 +1,208 @@
+/**************************************************************************/ /**
+ * @file      LogEncoder.c
+ * @brief     Packs a LogMessage call into a binary log frame (see LogFormat.h)
+ * @details   The format address is the token: it is resolved on the host from the ELF file, so the call sites do
+ *            not change and no string table is kept on target. Integer sizes follow the target (ARM EABI: int,
+ *            long, size_t and pointers are 32 bits), also when the encoder runs on a 64 bit host.
+ * @author
+ * @date      2026-10-17
+
+ ******************************************************************************/
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "LogEncoder.h"
+
+#include <string.h>
+
+/******************************************************************************
+ * Local Function Declaration
+ ******************************************************************************/
+static uint8_t *put_le(uint8_t *out, uint64_t value, int bytes);
+
+/******************************************************************************
+ * Global Functions
+ ******************************************************************************/
+
+/**
+ * @fn			size_t LogEncoderPack(uint8_t *frame, uint8_t level, uint8_t sequence, const char *format, va_list ap)
+ * @brief		Builds the frame of one log message
+ * @param[out]	frame Output, at least LOG_FRAME_MAX_SIZE bytes
+ * @param[in]	level Log level of the message (enum eDebugLogLevels)
+ * @param[in]	sequence Frame counter of the sender
+ * @param[in]	format printf format string. Its address is sent, so it must stay in the flash image
+ * @param[in]	ap Arguments of the format. Consumed
+ * @return		Length of the frame, or 0 if the message cannot be sent as a frame (its arguments exceed
+ *				LOG_FRAME_MAX_PAYLOAD, or the format has a conversion the decoder does not know). The caller then
+ *				formats the text from a copy of the arguments.
+ * @note
+ */
+size_t LogEncoderPack(uint8_t *frame, uint8_t level, uint8_t sequence, const char *format, va_list ap)
+{
+    uint8_t *out = &frame[LOG_FRAME_HEADER_SIZE];
+    uint8_t *const end = &frame[LOG_FRAME_HEADER_SIZE + LOG_FRAME_MAX_PAYLOAD];
+    const char *p = format;
+    uint8_t sum = 0;
+    size_t length;
+
+    while (*p != '\0') {
+        int longs = 0;
+        int halves = 0;
+        int wide = 0;  // 8 byte integer on target: ll or j
+
+        if (*p++ != '%') {
+            continue;
+        }
+        if (*p == '%') {
+            p++;
+            continue;
+        }
+
+        // Flags, width and precision. A * takes an int argument
+        while (*p != '\0' && strchr("-+ #0'", *p) != NULL) {
+            p++;
+        }
+        for (int part = 0; part < 2; part++) {
+            if (*p == '*') {
+                if (end - out < 4) {
+                    return 0;
+                }
+                out = put_le(out, (uint32_t)va_arg(ap, int), 4);
+                p++;
+            } else {
+                while (*p >= '0' && *p <= '9') {
+                    p++;
+                }
+            }
+            if (part == 0 && *p == '.') {
+                p++;
+            } else {
+                break;
+            }
+        }
+
+        // Length
+        for (;; p++) {
+            if (*p == 'l') {
+                longs++;
+            } else if (*p == 'h') {
+                halves++;
+            } else if (*p == 'j') {
+                wide = 1;
+            } else if (*p != 'z' && *p != 't' && *p != 'L') {
+                break;
+            }
+        }
+        wide |= (longs >= 2);
+
+        switch (*p++) {
+            case 'c':
+            case 'd':
+            case 'i':
+            case 'o':
+            case 'u':
+            case 'x':
+            case 'X':
+                if (end - out < (wide ? 8 : 4)) {
+                    return 0;
+                }
+                if (wide) {
+                    out = put_le(out, (uint64_t)va_arg(ap, long long), 8);
+                } else if (longs == 1 && halves == 0) {
+                    out = put_le(out, (uint32_t)va_arg(ap, long), 4);
+                } else if (p[-2] == 'z' || p[-2] == 't') {
+                    out = put_le(out, (uint32_t)va_arg(ap, size_t), 4);
+                } else {
+                    out = put_le(out, (uint32_t)va_arg(ap, int), 4);  // h and hh arguments are promoted to int
+                }
+                break;
+
+            case 'p':
+                if (end - out < 4) {
+                    return 0;
+                }
+                out = put_le(out, (uint32_t)(uintptr_t)va_arg(ap, void *), 4);
+                break;
+
+            case 'a':
+            case 'A':
+            case 'e':
+            case 'E':
+            case 'f':
+            case 'F':
+            case 'g':
+            case 'G': {
+                double value = (p[-2] == 'L') ? (double)va_arg(ap, long double) : va_arg(ap, double);
+                uint64_t bits;
+
+                if (end - out < 8) {
+                    return 0;
+                }
+                memcpy(&bits, &value, sizeof(bits));
+                out = put_le(out, bits, 8);
+                break;
+            }
+
+            case 's': {
+                const char *string = va_arg(ap, const char *);
+                size_t count;
+
+                if (longs != 0) {
+                    return 0;  // Wide strings are not supported
+                }
+                if (string == NULL) {
+                    string = "(null)";
+                }
+                for (count = 0; count < LOG_STRING_MAX && string[count] != '\0'; count++) {
+                }
+                if ((size_t)(end - out) < count + 1) {
+                    return 0;
+                }
+                *out++ = (uint8_t)count;
+                memcpy(out, string, count);
+                out += count;
+                break;
+            }
+
+            case 'n':
+                (void)va_arg(ap, void *);  // Nothing is written back
+                break;
+
+            default:
+                return 0;  // Unknown conversion, or the format ended inside one
+        }
+    }
+
+    length = (size_t)(out - &frame[LOG_FRAME_HEADER_SIZE]);
+    frame[0] = LOG_FRAME_SYNC;
+    frame[1] = (uint8_t)length;
+    frame[2] = level;
+    frame[3] = sequence;
+    put_le(&frame[4], (uint32_t)(uintptr_t)format, 4);
+
+    for (size_t i = 1; i < LOG_FRAME_HEADER_SIZE + length; i++) {
+        sum += frame[i];
+    }
+    *out++ = (uint8_t)~sum;
+
+    return (size_t)(out - frame);
+}
+
+/******************************************************************************
+ * Local Functions
+ ******************************************************************************/
+
+/**
+ * @fn			static uint8_t *put_le(uint8_t *out, uint64_t value, int bytes)
+ * @brief		Stores the low bytes of value, little endian
+ * @return		Position after the stored bytes
+ * @note
+ */
+static uint8_t *put_le(uint8_t *out, uint64_t value, int bytes)
+{
+    for (int i = 0; i < bytes; i++) {
+        *out++ = (uint8_t)(value >> (8 * i));
+    }
+    return out;
+}
@@ -0,0 +1,36 @@
+/**************************************************************************/ /**
+ * @file      LogEncoder.h
+ * @brief     Packs a LogMessage call into a binary log frame (see LogFormat.h)
+ * @details   Walks the format string only to find its conversions and copies each argument raw. No
+ *            formatting is done on target. Plain C only: also built into Tools/logdecode.c for its self test.
+ * @author
+ * @date      2026-10-17
+
+ ******************************************************************************/
+
+#ifndef LOG_ENCODER_H
+#define LOG_ENCODER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "LogFormat.h"
+
+/******************************************************************************
+ * Global Function Declarations
+ ******************************************************************************/
+size_t LogEncoderPack(uint8_t *frame, uint8_t level, uint8_t sequence, const char *format, va_list ap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LOG_ENCODER_H */
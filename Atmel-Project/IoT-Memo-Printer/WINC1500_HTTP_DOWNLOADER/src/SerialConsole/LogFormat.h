@@ -0,0 +1,40 @@
+/**************************************************************************/ /**
+ * @file      LogFormat.h
+ * @brief     Frame layout of the binary (tokenized) log mode
+ * @details   In LOG_MODE_BINARY, LogMessage does not format its text. It sends a frame holding the address of
+ *            its format string and the raw arguments, interleaved with the plain text of the console. The
+ *            format strings stay in the flash image, so Tools/logdecode.c rebuilds the text from the ELF file
+ *            of the same build.
+ *
+ *            Frame:
+ *              LOG_FRAME_SYNC, payload length, level, sequence, format address (4 bytes, little endian),
+ *              payload, checksum
+ *            The checksum is the complement of the 8 bit sum of every byte after the sync byte. The sequence
+ *            number counts frames, so the decoder sees frames dropped on a full TX ring.
+ *
+ *            Payload: one field per argument the format consumes, in order:
+ *              * width or precision, integer conversions (c d i o u x X p, any length but ll)   4 bytes
+ *              ll conversions                                                                   8 bytes
+ *              a e f g conversions (as double)                                                  8 bytes
+ *              s conversions           1 length byte, then up to LOG_STRING_MAX bytes, no terminator
+ *            All values are little endian. %% and %n take no field.
+ *
+ *            Plain C only: shared with Tools/logdecode.c.
+ * @author
+ * @date      2026-10-17
+
+ ******************************************************************************/
+
+#ifndef LOG_FORMAT_H
+#define LOG_FORMAT_H
+
+/******************************************************************************
+ * Defines
+ ******************************************************************************/
+#define LOG_FRAME_SYNC 0xFE        ///< First byte of a frame. Never sent by the text console, which is ASCII
+#define LOG_FRAME_HEADER_SIZE 8    ///< Sync, length, level, sequence and the 4 byte format address
+#define LOG_FRAME_MAX_PAYLOAD 96   ///< Longest payload. Messages with more argument data are sent as text
+#define LOG_FRAME_MAX_SIZE (LOG_FRAME_HEADER_SIZE + LOG_FRAME_MAX_PAYLOAD + 1)  ///< Longest frame, checksum included
+#define LOG_STRING_MAX 32          ///< Longest %s argument sent. Longer strings are cut
+
+#endif /* LOG_FORMAT_H */
@@ -8,10 +8,16 @@
  *uses it to receive command from the user as well as print debug information.
  *
  *				The code in this file will:
- *				--Initialize a SERCOM port (SERCOM # ) to be an UART channel operating at 115200 baud/second,
- *8N1
+ *				--Initialize a SERCOM port (SERCOM # ) to be an UART channel operating at SERIAL_CONSOLE_BAUDRATE
+ *(115200 by default) baud/second, 8N1
  *				--Register callbacks for the device to read and write characters asynchronously as required by
- *the CLI
+ *the CLI. Transmission goes through a DMA channel: each contiguous span of the TX ring is sent as one DMA job,
+ *so the CPU takes one interrupt per burst instead of one per character. Reception goes through a second DMA
+ *channel that runs forever over the RX ring storage. Received bytes are handed to the CLI task when half of the
+ *ring has filled or when the line goes idle (a timer retriggered by every received byte expires)
+ *				--Send log messages either as text, or in LOG_MODE_BINARY as frames holding the address of the format
+ *string and the raw arguments (LogFormat.h). Formatting then happens on the host (Tools/logdecode.c), which
+ *takes vsnprintf off the logging tasks
  *				--Initialize the CLI and Debug Logger data structures
  *
  *				Usage:
@@ -28,43 +34,79 @@
  ******************************************************************************/
 #include "SerialConsole.h"
 #include "CliThread/CliThread.h"
+#include "LogEncoder.h"
+#include "Power/Power.h"
 
 /******************************************************************************
  * Defines
  ******************************************************************************/
-#define RX_BUFFER_SIZE 512  ///< Size of character buffer for RX, in bytes
-#define TX_BUFFER_SIZE 512  ///< Size of character buffers for TX, in bytes
+#define RX_BUFFER_SIZE 512  ///< Size of character buffer for RX, in bytes. Power of two (circular_buffer.h)
+#define TX_BUFFER_SIZE 512  ///< Size of character buffers for TX, in bytes. Power of two (circular_buffer.h)
+#define SERIAL_CONSOLE_DMAC_ID_TX SERCOM4_DMAC_ID_TX  ///< DMA trigger raised when the TX data register of EDBG_CDC_MODULE (SERCOM4) is empty
+#define SERIAL_CONSOLE_DMAC_ID_RX SERCOM4_DMAC_ID_RX  ///< DMA trigger raised when EDBG_CDC_MODULE (SERCOM4) has received a character
+#define RX_DMA_BLOCKS 2                                ///< The RX DMA fills the RX buffer as this many linked blocks, interrupting once per block
+#define RX_DMA_BLOCK_SIZE (RX_BUFFER_SIZE / RX_DMA_BLOCKS)  ///< Bytes per RX DMA block
+#define RX_IDLE_TIMER TC3                              ///< Timer measuring the idle gap after the last received character
+#define RX_IDLE_TIMER_EVSYS_USER EVSYS_ID_USER_TC3_EVU  ///< Event input of RX_IDLE_TIMER, retriggered by every RX DMA beat
+#define RX_IDLE_CHARACTERS 2                           ///< RX is idle after this many character times (10 bits each) without a character
+#define SERIAL_CONSOLE_GCLK GCLK_GENERATOR_5           ///< OSC8M, on demand. Kept in standby so a start bit can wake the CPU (conf_clocks.h)
+#define SERIAL_CONSOLE_OVERSAMPLING 16                 ///< Samples per bit at the default USART sample rate. Bounds the baud rate per clock
+#define TX_PRINTF_MAX (TX_BUFFER_SIZE / 2 - 1)         ///< Longest output of one SerialConsolePrintf call. Longer output is cut
 
 char debugBuffer[128];
 
 /******************************************************************************
  * Structures and Enumerations
  ******************************************************************************/
-cbuf_handle_t cbufRx;  ///< Circular buffer handler for receiving characters from the Serial Interface
-cbuf_handle_t cbufTx;  ///< Circular buffer handler for transmitting characters from the Serial Interface
+circular_buf_t cbufRx;  ///< Circular buffer for receiving characters from the Serial Interface. Producer: the RX DMA (committed by the read and idle callbacks), consumer: CLI task
+circular_buf_t cbufTx;  ///< Circular buffer for transmitting characters from the Serial Interface. Consumer: whoever starts the next write job
 
-char latestRx;  ///< Holds the latest character that was received
-char latestTx;  ///< Holds the latest character to be transmitted.
+volatile size_t txInFlight;    ///< Bytes of cbufTx handed to the current DMA job. They stay in the ring until it completes
+volatile uint32_t rxOverruns;  ///< Times the RX DMA caught up with unread characters of cbufRx (the CLI task fell behind)
 
 /******************************************************************************
  *  Callback Declaration
  ******************************************************************************/
-void usart_write_callback(struct usart_module *const usart_module);  // Callback for when we finish writing characters to UART
-void usart_read_callback(struct usart_module *const usart_module);   // Callback for when we finis reading characters from UART
+void usart_write_callback(struct dma_resource *const resource);     // Callback for when the DMA finishes writing a span to UART
+void usart_read_callback(struct dma_resource *const resource);      // Callback for when the DMA fills one block of the RX buffer
+void usart_rx_idle_callback(struct tc_module *const module);        // Callback for when no character arrived for RX_IDLE_CHARACTERS
+void usart_rx_start_callback(struct usart_module *const module);    // Callback for when a start bit arrives while RX is idle
 
 /******************************************************************************
  * Local Function Declaration
  ******************************************************************************/
 static void configure_usart(void);
-static void configure_usart_callbacks(void);
+static void configure_usart_dma(void);
+static void configure_usart_rx_dma(void);
+static void configure_usart_rx_idle_timer(void);
+static void start_usart_write(void);
+static int serial_console_vprintf(const char *format, va_list ap);
+static size_t usart_rx_dma_position(void);
+static size_t usart_rx_commit(void);
+static void log_message(enum eDebugLogLevels level, const char *format, va_list ap);
+static bool log_message_binary(enum eDebugLogLevels level, const char *format, va_list ap);
 
 /******************************************************************************
  * Global Local Variables
  ******************************************************************************/
 struct usart_module usart_instance;
+struct dma_resource txDmaResource;                      ///< DMA channel feeding the USART TX data register
+COMPILER_ALIGNED(16) DmacDescriptor txDmaDescriptor;    ///< Descriptor of txDmaResource. Source and length are set for every span
+struct dma_resource rxDmaResource;                      ///< DMA channel draining the USART RX data register into rxCharacterBuffer
+COMPILER_ALIGNED(16) DmacDescriptor rxDmaDescriptor[RX_DMA_BLOCKS];  ///< Blocks of rxDmaResource, linked in a loop
+struct events_resource rxEventResource;                 ///< Event channel from the RX DMA beats to RX_IDLE_TIMER
+struct tc_module rxIdleTimer;                           ///< One shot timer, restarted by every received character
+size_t rxDmaCommitted;                                  ///< Offset in rxCharacterBuffer up to which the RX DMA output is in cbufRx
+volatile bool rxAwake;                                  ///< RX holds POWER_PERIPHERAL_LOCK from the start bit of a burst to its end
 char rxCharacterBuffer[RX_BUFFER_SIZE];                 ///< Buffer to store received characters
 char txCharacterBuffer[TX_BUFFER_SIZE];                 ///< Buffer to store characters to be sent
-enum eDebugLogLevels currentDebugLevel = LOG_INFO_LVL;  ///< Variable that holds the level of debug log messages to show. Defaults to showing all debug values
+uint8_t logModuleLevels[N_LOG_MODULES] = {LOG_INFO_LVL};  ///< Level of debug log messages to show, per module. LOG_MODULE_GENERAL is the level of LogMessage. Defaults to showing all debug values
+static const char *const logModuleNames[N_LOG_MODULES] = {"general", "wifi", "http", "mqtt", "i2c", "ui", "ctrl"};  ///< Names used by the CLI, per enum eLogModules
+static const char *const logLevelNames[N_DEBUG_LEVELS] = {"info", "debug", "warning", "error", "fatal", "off"};      ///< Names used by the CLI, per enum eDebugLogLevels
+enum eLogModes currentLogMode = LOG_MODE_TEXT;          ///< How log messages are sent. Defaults to text
+uint8_t logFrame[LOG_FRAME_MAX_SIZE];                   ///< Frame being built in LOG_MODE_BINARY. Used with the scheduler suspended
+uint8_t logSequence;                                    ///< Sequence number of the next log frame
+volatile uint32_t logFramesDropped;                     ///< Log frames that did not fit in cbufTx
 
 /******************************************************************************
  * Global Functions
@@ -82,14 +124,14 @@ enum eDebugLogLevels currentDebugLevel = LOG_INFO_LVL;  ///< Variable that holds
 void InitializeSerialConsole(void)
 {
     // Initialize circular buffers for RX and TX
-    cbufRx = circular_buf_init((uint8_t *)rxCharacterBuffer, RX_BUFFER_SIZE);
-    cbufTx = circular_buf_init((uint8_t *)txCharacterBuffer, RX_BUFFER_SIZE);
+    circular_buf_init(&cbufRx, (uint8_t *)rxCharacterBuffer, RX_BUFFER_SIZE);
+    circular_buf_init(&cbufTx, (uint8_t *)txCharacterBuffer, TX_BUFFER_SIZE);
 
-    // Configure USART and Callbacks
+    // Configure USART and the DMA channels. The RX DMA keeps reading characters from here on
     configure_usart();
-    configure_usart_callbacks();
-
-    usart_read_buffer_job(&usart_instance, (uint8_t *)&latestRx, 1);  // Kicks off constant reading of characters
+    configure_usart_dma();
+    configure_usart_rx_dma();
+    configure_usart_rx_idle_timer();
 
     // Add any other calls you need to do to initialize your Serial Console
 }
@@ -109,23 +151,96 @@ void DeinitializeSerialConsole(void)
  * @brief		Writes a string to be written to the uart. Copies the string to a ring buffer that is used to hold the
  *text send to the uart
  * @details		Uses the ringbuffer 'cbufTx', which in turn uses the array 'txCharacterBuffer'. Modified to be
- *thread safe.
+ *thread safe: the ring takes a single producer, so tasks are serialized with the scheduler suspended. The write
+ *callback needs no lock. Characters that do not fit in the ring are dropped.
  * @note			Use to send a string of characters to the user via UART
  */
 void SerialConsoleWriteString(const char *string)
 {
     vTaskSuspendAll();
     if (string != NULL) {
-        for (size_t iter = 0; iter < strlen(string); iter++) {
-            circular_buf_put(cbufTx, string[iter]);
+        circular_buf_put_n(&cbufTx, (const uint8_t *)string, strlen(string));
+
+        if (dma_get_job_status(&txDmaResource) != STATUS_BUSY) {
+            start_usart_write();  // Perform only if the TX DMA channel is free (not busy)
+        }
+    }
+    xTaskResumeAll();
+}
+
+/**
+ * @fn			void SerialConsoleWrite(const char *data, size_t length)
+ * @brief		Writes characters to the uart, waiting for room in the TX ring instead of dropping them
+ * @details		Copies as much as fits, starts the TX DMA and sleeps a tick while the ring drains. Long output may
+ *interleave with other writers at the points where it waited.
+ * @param[in]	data Characters to send, not necessarily terminated
+ * @param[in]	length Number of characters
+ * @note			Call from a task only. Use for bulk output (CLI replies, dumps); log messages stay non blocking
+ */
+void SerialConsoleWrite(const char *data, size_t length)
+{
+    while (length > 0) {
+        size_t written;
+
+        vTaskSuspendAll();
+        written = circular_buf_put_n(&cbufTx, (const uint8_t *)data, length);
+        if (dma_get_job_status(&txDmaResource) != STATUS_BUSY) {
+            start_usart_write();  // Perform only if the TX DMA channel is free (not busy)
         }
+        xTaskResumeAll();
 
-        if (usart_get_job_status(&usart_instance, USART_TRANSCEIVER_TX) == STATUS_OK) {
-            circular_buf_get(cbufTx, (uint8_t *)&latestTx);  // Perform only if the SERCOM TX is free (not busy)
-            usart_write_buffer_job(&usart_instance, (uint8_t *)&latestTx, 1);
+        data += written;
+        length -= written;
+        if (length > 0) {
+            vTaskDelay(1);
         }
     }
+}
+
+/**
+ * @fn			bool SerialConsoleWriteFrame(const uint8_t *frame, size_t length)
+ * @brief		Queues a binary frame whole on the TX ring, or drops it
+ * @details		Never cuts a frame and never waits, so a producer running at a fixed rate (sensor stream, binary
+ *log) cannot be slowed down by the console. Receivers see the dropped frames as gaps in the sequence numbers.
+ * @param[in]	frame Bytes of the frame
+ * @param[in]	length Number of bytes
+ * @return		Returns true if the frame was queued, false if it did not fit
+ * @note			Safe with the scheduler suspended
+ */
+bool SerialConsoleWriteFrame(const uint8_t *frame, size_t length)
+{
+    bool queued = false;
+
+    vTaskSuspendAll();
+    if (circular_buf_capacity(&cbufTx) - circular_buf_size(&cbufTx) >= length) {
+        circular_buf_put_n(&cbufTx, frame, length);
+        if (dma_get_job_status(&txDmaResource) != STATUS_BUSY) {
+            start_usart_write();  // Perform only if the TX DMA channel is free (not busy)
+        }
+        queued = true;
+    }
     xTaskResumeAll();
+    return queued;
+}
+
+/**
+ * @fn			int SerialConsolePrintf(const char *format, ...)
+ * @brief		Formats straight into the TX ring, waiting for room instead of dropping characters
+ * @details		No intermediate buffer: the text is formatted in place in cbufTx and published whole, so CLI commands
+ *can stream long output with one call per line instead of returning through the CLI output buffer.
+ * @param[in]	format printf format string
+ * @return		Number of characters queued, at most TX_PRINTF_MAX, or -1 on a format error
+ * @note			Call from a task only
+ */
+int SerialConsolePrintf(const char *format, ...)
+{
+    va_list ap;
+    int length;
+
+    va_start(ap, format);
+    length = serial_console_vprintf(format, ap);
+    va_end(ap);
+    return length;
 }
 
 /**
@@ -133,17 +248,15 @@ void SerialConsoleWriteString(const char *string)
  * @brief		Reads a character from the RX ring buffer and stores it on the pointer given as an argument.
  *				Also, returns -1 if there is no characters on the buffer
  *				This buffer has values added to it when the UART receives ASCII characters from the terminal
- * @details		Uses the ringbuffer 'cbufTx', which in turn uses the array 'txCharacterBuffer'
+ * @details		Uses the ringbuffer 'cbufRx', which in turn uses the array 'rxCharacterBuffer'. The CLI task is its only
+ *consumer, so no lock is taken.
  * @param[in]	Pointer to a character. This function will return the character from the RX buffer into this pointer
  * @return		Returns -1 if there are no characters in the buffer
  * @note			Use to receive characters from the RX buffer (FIFO)
  */
 int SerialConsoleReadCharacter(uint8_t *rxChar)
 {
-    vTaskSuspendAll();
-    int a = circular_buf_get(cbufRx, (uint8_t *)rxChar);
-    xTaskResumeAll();
-    return a;
+    return circular_buf_get(&cbufRx, (uint8_t *)rxChar);
 }
 
 /*
@@ -155,12 +268,12 @@ DEBUG LOGGER FUNCTIONS
  * @brief		Gets the level of debug to print to the console to the given argument.
  *				Debug logs below the given level will not be allowed to be printed on the system
  * @return		Returns the current debug level of the system.
- * @note
+ * @note			Applies to LogMessage, which is LOG_MODULE_GENERAL
  */
 
 enum eDebugLogLevels getLogLevel(void)
 {
-    return currentDebugLevel;
+    return getLogModuleLevel(LOG_MODULE_GENERAL);
 }
 
 /**
@@ -168,11 +281,91 @@ enum eDebugLogLevels getLogLevel(void)
  * @brief		Sets the level of debug to print to the console to the given argument.
  *				Debug logs below the given level will not be allowed to be printed on the system
  * @param[in]   debugLevel The debug level to be set for the debug logger
- * @note
+ * @note			Applies to LogMessage, which is LOG_MODULE_GENERAL
  */
 void setLogLevel(enum eDebugLogLevels debugLevel)
 {
-    currentDebugLevel = debugLevel;
+    setLogModuleLevel(LOG_MODULE_GENERAL, debugLevel);
+}
+
+/**
+ * @fn			enum eDebugLogLevels getLogModuleLevel(enum eLogModules module)
+ * @brief		Gets the runtime level of debug to print for one module
+ * @param[in]   module Module of the LOG macros
+ * @return		Returns the level of the module. Messages also need to pass its compile time LOG_LEVEL_<module>
+ * @note
+ */
+enum eDebugLogLevels getLogModuleLevel(enum eLogModules module)
+{
+    return (module < N_LOG_MODULES) ? (enum eDebugLogLevels)logModuleLevels[module] : LOG_OFF_LVL;
+}
+
+/**
+ * @fn			void setLogModuleLevel(enum eLogModules module, enum eDebugLogLevels debugLevel)
+ * @brief		Sets the runtime level of debug to print for one module
+ * @param[in]   module Module of the LOG macros
+ * @param[in]   debugLevel Messages of the module below this level are skipped before their arguments are evaluated
+ * @note			Levels below the compile time LOG_LEVEL_<module> stay off: their messages are not in the image
+ */
+void setLogModuleLevel(enum eLogModules module, enum eDebugLogLevels debugLevel)
+{
+    if (module < N_LOG_MODULES && debugLevel < N_DEBUG_LEVELS) {
+        logModuleLevels[module] = (uint8_t)debugLevel;
+    }
+}
+
+/**
+ * @fn			const char *LogModuleName(enum eLogModules module)
+ * @brief		Returns the name of a module, as used by the loglevel CLI command
+ * @note
+ */
+const char *LogModuleName(enum eLogModules module)
+{
+    return (module < N_LOG_MODULES) ? logModuleNames[module] : NULL;
+}
+
+/**
+ * @fn			const char *LogLevelName(enum eDebugLogLevels level)
+ * @brief		Returns the name of a level, as used by the loglevel CLI command
+ * @note
+ */
+const char *LogLevelName(enum eDebugLogLevels level)
+{
+    return (level < N_DEBUG_LEVELS) ? logLevelNames[level] : NULL;
+}
+
+/**
+ * @fn			enum eLogModes getLogMode(void)
+ * @brief		Gets how log messages are sent to the console
+ * @return		Returns LOG_MODE_TEXT or LOG_MODE_BINARY
+ * @note
+ */
+enum eLogModes getLogMode(void)
+{
+    return currentLogMode;
+}
+
+/**
+ * @fn			void setLogMode(enum eLogModes mode)
+ * @brief		Sets how log messages are sent to the console
+ * @param[in]   mode LOG_MODE_TEXT to format messages on target, LOG_MODE_BINARY to send them as frames decoded
+ *				by Tools/logdecode.c against the ELF file of this build
+ * @note			Console output that is not a log message (CLI replies, echo) stays text in both modes
+ */
+void setLogMode(enum eLogModes mode)
+{
+    currentLogMode = mode;
+}
+
+/**
+ * @fn			uint32_t getLogFramesDropped(void)
+ * @brief		Gets the number of binary log frames dropped because cbufTx was full
+ * @return		Frames dropped since boot
+ * @note
+ */
+uint32_t getLogFramesDropped(void)
+{
+    return logFramesDropped;
 }
 
 /**
@@ -185,8 +378,7 @@ void LogMessage(enum eDebugLogLevels level, const char *format, ...)
     if (getLogLevel() <= level) {
         va_list ap;
         va_start(ap, format);
-        vsnprintf(debugBuffer, 127, format, ap);
-        SerialConsoleWriteString(debugBuffer);
+        log_message(level, format, ap);
         va_end(ap);
     }
 };
@@ -198,9 +390,27 @@ void LogMessage(enum eDebugLogLevels level, const char *format, ...)
  */
 void LogMessageDebug(const char *format, ...)
 {
-    LogMessage(LOG_DEBUG_LVL, format);
+    if (getLogLevel() <= LOG_DEBUG_LVL) {
+        va_list ap;
+        va_start(ap, format);
+        log_message(LOG_DEBUG_LVL, format, ap);
+        va_end(ap);
+    }
 };
 
+/**
+ * @fn			void LogModuleMessage(enum eDebugLogLevels level, const char *format, ...)
+ * @brief		Sends a log message that the LOG macros already filtered by module
+ * @note			Call through LOG, LOG_DEBUG, ... only
+ */
+void LogModuleMessage(enum eDebugLogLevels level, const char *format, ...)
+{
+    va_list ap;
+    va_start(ap, format);
+    log_message(level, format, ap);
+    va_end(ap);
+}
+
 /*
 COMMAND LINE INTERFACE COMMANDS
 */
@@ -210,38 +420,326 @@ COMMAND LINE INTERFACE COMMANDS
  ******************************************************************************/
 
 /**
- * @fn			static void configure_usart(void)
- * @brief		Code to configure the SERCOM "EDBG_CDC_MODULE" to be a UART channel running at 115200 8N1
+ * @fn			static int serial_console_vprintf(const char *format, va_list ap)
+ * @brief		Formats into the free span at the head of cbufTx and commits the text
+ * @details		Runs with the scheduler suspended, so the text does not interleave with other writers. If it does not
+ *fit before the end of the ring storage, it is formatted a second time at the start of the storage; the part that
+ *belongs before the wrap is taken from there and the rest moved down, so the ring gets it in order. If there is not
+ *enough room yet, the scheduler is resumed and the call retries a tick later.
+ * @return		Number of characters queued, or -1 on a format error
  * @note
  */
+static int serial_console_vprintf(const char *format, va_list ap)
+{
+    for (;;) {
+        va_list args;
+        uint8_t *span;
+        size_t spanLength;
+        size_t space;
+        size_t count;
+        int length;
+
+        vTaskSuspendAll();
+        spanLength = circular_buf_reserve(&cbufTx, &span);
+        space = circular_buf_capacity(&cbufTx) - circular_buf_size(&cbufTx);
+        va_copy(args, ap);
+        length = vsnprintf((char *)span, spanLength, format, args);
+        va_end(args);
+        if (length < 0) {
+            xTaskResumeAll();
+            return -1;
+        }
+        count = ((size_t)length < TX_PRINTF_MAX) ? (size_t)length : TX_PRINTF_MAX;
+
+        if (count < spanLength || (space - spanLength) >= count + 1) {
+            if (count >= spanLength) {
+                // Wraps: format again at the start of the storage, then split
+                va_copy(args, ap);
+                vsnprintf(txCharacterBuffer, count + 1, format, args);
+                va_end(args);
+                if (spanLength > 0) {
+                    span[spanLength - 1] = txCharacterBuffer[spanLength - 1];  // vsnprintf put its terminator there
+                }
+                memmove(txCharacterBuffer, &txCharacterBuffer[spanLength], count - spanLength);
+            }
+            circular_buf_commit(&cbufTx, count);
+            if (dma_get_job_status(&txDmaResource) != STATUS_BUSY) {
+                start_usart_write();  // Perform only if the TX DMA channel is free (not busy)
+            }
+            xTaskResumeAll();
+            return (int)count;
+        }
+
+        xTaskResumeAll();
+        vTaskDelay(1);  // Wait for the TX DMA to drain the ring
+    }
+}
+
+/**
+ * @fn			static void log_message(enum eDebugLogLevels level, const char *format, va_list ap)
+ * @brief		Sends one log message, as a frame in LOG_MODE_BINARY, as text otherwise
+ * @details		Messages that cannot be sent as a frame (format string outside the flash image, too much argument
+ *data) are sent as text in either mode.
+ * @note
+ */
+static void log_message(enum eDebugLogLevels level, const char *format, va_list ap)
+{
+    if (currentLogMode == LOG_MODE_BINARY && log_message_binary(level, format, ap)) {
+        return;
+    }
+    vsnprintf(debugBuffer, 127, format, ap);
+    SerialConsoleWriteString(debugBuffer);
+}
+
+/**
+ * @fn			static bool log_message_binary(enum eDebugLogLevels level, const char *format, va_list ap)
+ * @brief		Packs a log message into a frame and queues it whole on cbufTx
+ * @details		The frame is built and queued with the scheduler suspended, so frames of different tasks do not
+ *interleave and their sequence numbers follow the order on the wire. A frame that does not fit in cbufTx is
+ *dropped, never cut: its sequence number is skipped, so the decoder reports the gap.
+ * @return		Returns false if the message must be sent as text instead. ap is left untouched in that case
+ * @note
+ */
+static bool log_message_binary(enum eDebugLogLevels level, const char *format, va_list ap)
+{
+    va_list args;
+    size_t length;
+
+    if ((uint32_t)format >= FLASH_ADDR + FLASH_SIZE) {
+        return false;  // Not a literal: the decoder could not find it in the ELF file
+    }
+
+    va_copy(args, ap);
+    vTaskSuspendAll();
+    length = LogEncoderPack(logFrame, (uint8_t)level, logSequence, format, args);
+    if (length > 0) {
+        logSequence++;
+        if (!SerialConsoleWriteFrame(logFrame, length)) {
+            logFramesDropped++;
+        }
+    }
+    xTaskResumeAll();
+    va_end(args);
+
+    return length > 0;
+}
+
+/**
+ * @fn			static void configure_usart(void)
+ * @brief		Code to configure the SERCOM "EDBG_CDC_MODULE" to be a UART channel running at SERIAL_CONSOLE_BAUDRATE 8N1
+ * @note			Up to SERIAL_CONSOLE_GCLK / SERIAL_CONSOLE_OVERSAMPLING (500 kbaud), the SERCOM runs from OSC8M with start of
+ *frame detection, so a character typed while the CPU is in standby wakes it instead of being lost. The receive buffer
+ *holds the first characters until GCLK0 and the DMAC are back. Faster rates run from GCLK0, which stops in standby, so
+ *the console then holds POWER_PERIPHERAL_LOCK for good. Call after PowerInit, which clears the locks
+ */
 static void configure_usart(void)
 {
     struct usart_config config_usart;
     usart_get_config_defaults(&config_usart);
 
-    config_usart.baudrate = 115200;
+    config_usart.baudrate = SERIAL_CONSOLE_BAUDRATE;
     config_usart.mux_setting = EDBG_CDC_SERCOM_MUX_SETTING;
     config_usart.pinmux_pad0 = EDBG_CDC_SERCOM_PINMUX_PAD0;
     config_usart.pinmux_pad1 = EDBG_CDC_SERCOM_PINMUX_PAD1;
     config_usart.pinmux_pad2 = EDBG_CDC_SERCOM_PINMUX_PAD2;
     config_usart.pinmux_pad3 = EDBG_CDC_SERCOM_PINMUX_PAD3;
+    if ((uint64_t)SERIAL_CONSOLE_BAUDRATE * SERIAL_CONSOLE_OVERSAMPLING <= system_gclk_gen_get_hz(SERIAL_CONSOLE_GCLK)) {
+        config_usart.generator_source = SERIAL_CONSOLE_GCLK;
+        config_usart.run_in_standby = true;
+        config_usart.start_frame_detection_enable = true;
+    } else {
+        sleepmgr_lock_mode(POWER_PERIPHERAL_LOCK);  // Stays on GCLK0 (the default), which cannot wake the CPU from standby
+    }
     while (usart_init(&usart_instance, EDBG_CDC_MODULE, &config_usart) != STATUS_OK) {
     }
 
+    usart_register_callback(&usart_instance, usart_rx_start_callback, USART_CALLBACK_START_RECEIVED);
+    usart_enable_callback(&usart_instance, USART_CALLBACK_START_RECEIVED);
     usart_enable(&usart_instance);
+    if (config_usart.start_frame_detection_enable) {
+        usart_instance.hw->USART.INTENSET.reg = SERCOM_USART_INTFLAG_RXS;  // Armed here and after every burst, see usart_rx_start_callback
+    }
+}
+
+/**
+ * @fn			static void configure_usart_dma(void)
+ * @brief		Allocates the DMA channel that moves TX characters from cbufTx to the USART, one byte per TX data
+ *register empty trigger
+ * @note
+ */
+static void configure_usart_dma(void)
+{
+    struct dma_resource_config config;
+    struct dma_descriptor_config descriptorConfig;
+
+    dma_get_config_defaults(&config);
+    config.peripheral_trigger = SERIAL_CONSOLE_DMAC_ID_TX;
+    config.trigger_action = DMA_TRIGGER_ACTION_BEAT;
+    dma_allocate(&txDmaResource, &config);
+
+    dma_descriptor_get_config_defaults(&descriptorConfig);
+    descriptorConfig.beat_size = DMA_BEAT_SIZE_BYTE;
+    descriptorConfig.dst_increment_enable = false;
+    descriptorConfig.block_transfer_count = 1;  // Set for every span by start_usart_write
+    descriptorConfig.source_address = (uint32_t)txCharacterBuffer;
+    descriptorConfig.destination_address = (uint32_t)(&usart_instance.hw->USART.DATA.reg);
+    dma_descriptor_create(&txDmaDescriptor, &descriptorConfig);
+    dma_add_descriptor(&txDmaResource, &txDmaDescriptor);
+
+    dma_register_callback(&txDmaResource, usart_write_callback, DMA_CALLBACK_TRANSFER_DONE);
+    dma_enable_callback(&txDmaResource, DMA_CALLBACK_TRANSFER_DONE);
+}
+
+/**
+ * @fn			static void start_usart_write(void)
+ * @brief		Starts a DMA job over the contiguous span at the start of cbufTx, if there is one
+ * @details		The span is sent in place and released by the write callback once the job completes.
+ * @note			Call only when the TX DMA channel is free
+ */
+static void start_usart_write(void)
+{
+    const uint8_t *span;
+    size_t length = circular_buf_peek(&cbufTx, &span);
+
+    // Hold the CPU out of standby, where GCLK0 and the DMAC stop, from the first span to the last
+    if (0 == txInFlight && length > 0) {
+        sleepmgr_lock_mode(POWER_PERIPHERAL_LOCK);
+    } else if (txInFlight > 0 && 0 == length) {
+        sleepmgr_unlock_mode(POWER_PERIPHERAL_LOCK);
+    }
+    txInFlight = length;
+    if (length > 0) {
+        txDmaDescriptor.BTCNT.reg = (uint16_t)length;
+        txDmaDescriptor.SRCADDR.reg = (uint32_t)span + length;  // With the source incremented, SRCADDR holds the end of the block
+        dma_start_transfer_job(&txDmaResource);
+    }
 }
 
 /**
- * @fn			static void configure_usart_callbacks(void)
- * @brief		Code to register callbacks
+ * @fn			static void configure_usart_rx_dma(void)
+ * @brief		Starts the DMA channel that copies every received character into rxCharacterBuffer
+ * @details		The buffer is covered by RX_DMA_BLOCKS descriptors linked in a loop, so the channel never stops.
+ *				Each block raises an interrupt when it is full, and each beat (character) raises an event that
+ *				restarts the idle timer. Only the first descriptor is added to the resource: dma_add_descriptor
+ *				walks the chain, which never ends once the loop is closed.
  * @note
  */
-static void configure_usart_callbacks(void)
+static void configure_usart_rx_dma(void)
 {
-    usart_register_callback(&usart_instance, usart_write_callback, USART_CALLBACK_BUFFER_TRANSMITTED);
-    usart_register_callback(&usart_instance, usart_read_callback, USART_CALLBACK_BUFFER_RECEIVED);
-    usart_enable_callback(&usart_instance, USART_CALLBACK_BUFFER_TRANSMITTED);
-    usart_enable_callback(&usart_instance, USART_CALLBACK_BUFFER_RECEIVED);
+    struct dma_resource_config config;
+    struct dma_descriptor_config descriptorConfig;
+
+    dma_get_config_defaults(&config);
+    config.peripheral_trigger = SERIAL_CONSOLE_DMAC_ID_RX;
+    config.trigger_action = DMA_TRIGGER_ACTION_BEAT;
+    config.event_config.event_output_enable = true;
+    dma_allocate(&rxDmaResource, &config);
+
+    for (int block = 0; block < RX_DMA_BLOCKS; block++) {
+        dma_descriptor_get_config_defaults(&descriptorConfig);
+        descriptorConfig.beat_size = DMA_BEAT_SIZE_BYTE;
+        descriptorConfig.src_increment_enable = false;
+        descriptorConfig.block_transfer_count = RX_DMA_BLOCK_SIZE;
+        descriptorConfig.source_address = (uint32_t)(&usart_instance.hw->USART.DATA.reg);
+        descriptorConfig.destination_address = (uint32_t)&rxCharacterBuffer[(block + 1) * RX_DMA_BLOCK_SIZE];  // End of the block
+        descriptorConfig.block_action = DMA_BLOCK_ACTION_INT;
+        descriptorConfig.event_output_selection = DMA_EVENT_OUTPUT_BEAT;
+        descriptorConfig.next_descriptor_address = (uint32_t)&rxDmaDescriptor[(block + 1) % RX_DMA_BLOCKS];
+        dma_descriptor_create(&rxDmaDescriptor[block], &descriptorConfig);
+    }
+    dma_add_descriptor(&rxDmaResource, &rxDmaDescriptor[0]);
+
+    dma_register_callback(&rxDmaResource, usart_read_callback, DMA_CALLBACK_TRANSFER_DONE);
+    dma_enable_callback(&rxDmaResource, DMA_CALLBACK_TRANSFER_DONE);
+    rxDmaCommitted = 0;
+    dma_start_transfer_job(&rxDmaResource);
+}
+
+/**
+ * @fn			static void configure_usart_rx_idle_timer(void)
+ * @brief		Sets up RX_IDLE_TIMER as a one shot timer of RX_IDLE_CHARACTERS character times, restarted through the
+ *event system by every beat of the RX DMA
+ * @note			Its expiry is the idle line detection the SERCOM does not have
+ */
+static void configure_usart_rx_idle_timer(void)
+{
+    struct tc_config config;
+    struct tc_events events = {0};
+    struct events_config eventConfig;
+    uint32_t ticks = (system_gclk_gen_get_hz(GCLK_GENERATOR_0) / 64) * 10 * RX_IDLE_CHARACTERS / SERIAL_CONSOLE_BAUDRATE;
+
+    tc_get_config_defaults(&config);
+    config.clock_prescaler = TC_CLOCK_PRESCALER_DIV64;
+    config.wave_generation = TC_WAVE_GENERATION_MATCH_FREQ;
+    config.oneshot = true;
+    config.counter_16_bit.compare_capture_channel[TC_COMPARE_CAPTURE_CHANNEL_0] = (uint16_t)(ticks > 1 ? ticks : 1);
+    tc_init(&rxIdleTimer, RX_IDLE_TIMER, &config);
+
+    events.on_event_perform_action = true;
+    events.event_action = TC_EVENT_ACTION_RETRIGGER;
+    tc_enable_events(&rxIdleTimer, &events);
+
+    tc_register_callback(&rxIdleTimer, usart_rx_idle_callback, TC_CALLBACK_OVERFLOW);
+    tc_enable_callback(&rxIdleTimer, TC_CALLBACK_OVERFLOW);
+    tc_enable(&rxIdleTimer);
+
+    events_get_config_defaults(&eventConfig);
+    eventConfig.generator = EVSYS_ID_GEN_DMAC_CH_0 + rxDmaResource.channel_id;
+    eventConfig.path = EVENTS_PATH_RESYNCHRONIZED;
+    eventConfig.edge_detect = EVENTS_EDGE_DETECT_RISING;
+    events_allocate(&rxEventResource, &eventConfig);
+    events_attach_user(&rxEventResource, RX_IDLE_TIMER_EVSYS_USER);
+}
+
+/**
+ * @fn			static size_t usart_rx_dma_position(void)
+ * @brief		Returns the offset in rxCharacterBuffer where the RX DMA writes the next character
+ * @details		Read from the write-back descriptor of the channel: DESCADDR names the block after the one being
+ *filled and BTCNT the characters still missing from it. The pair is read again if the block changed in between.
+ * @note
+ */
+static size_t usart_rx_dma_position(void)
+{
+    volatile DmacDescriptor *writeBack = &((DmacDescriptor *)DMAC->WRBADDR.reg)[rxDmaResource.channel_id];
+    uint32_t next;
+    uint32_t remaining;
+    size_t block;
+
+    do {
+        next = writeBack->DESCADDR.reg;
+        remaining = writeBack->BTCNT.reg;
+    } while (next != writeBack->DESCADDR.reg);
+
+    if (next == 0) {
+        return rxDmaCommitted;  // The channel has not written back yet: nothing received
+    }
+
+    block = (next - (uint32_t)&rxDmaDescriptor[0]) / sizeof(DmacDescriptor);
+    block = (block + RX_DMA_BLOCKS - 1) % RX_DMA_BLOCKS;  // The block being filled precedes the next one
+    return ((block + 1) * RX_DMA_BLOCK_SIZE - remaining) % RX_BUFFER_SIZE;
+}
+
+/**
+ * @fn			static size_t usart_rx_commit(void)
+ * @brief		Publishes the characters the RX DMA wrote since the last call to cbufRx
+ * @return		Number of characters published
+ * @note			Called from the DMAC and RX_IDLE_TIMER interrupts only, which have the same priority, so cbufRx keeps a
+ *single producer. If the CLI task fell so far behind that the DMA wrapped onto unread characters, only the free space is
+ *published and rxOverruns counts the event
+ */
+static size_t usart_rx_commit(void)
+{
+    size_t position = usart_rx_dma_position();
+    size_t count = (position - rxDmaCommitted) % RX_BUFFER_SIZE;
+    size_t space = circular_buf_capacity(&cbufRx) - circular_buf_size(&cbufRx);
+
+    if (count > space) {
+        rxOverruns++;
+        count = space;
+    }
+    circular_buf_commit(&cbufRx, count);
+    rxDmaCommitted = (rxDmaCommitted + count) % RX_BUFFER_SIZE;
+    return count;
 }
 
 /******************************************************************************
@@ -249,30 +747,62 @@ static void configure_usart_callbacks(void)
  ******************************************************************************/
 
 /**
- * @fn			void usart_read_callback(struct usart_module *const usart_module)
- * @brief		Callback called when the system finishes receives all the bytes requested from a UART read job
- * @note
+ * @fn			void usart_read_callback(struct dma_resource *const resource)
+ * @brief		Callback called when the RX DMA fills one block of rxCharacterBuffer
+ * @note			Runs in the DMAC interrupt. During a long burst this hands characters to the CLI task every
+ *RX_DMA_BLOCK_SIZE characters, before the DMA can wrap onto them
  */
-void usart_read_callback(struct usart_module *const usart_module)
+void usart_read_callback(struct dma_resource *const resource)
 {
-    circular_buf_put(cbufRx, (uint8_t)latestRx);                      // Add the latest read character into the RX circular Buffer
-    usart_read_buffer_job(&usart_instance, (uint8_t *)&latestRx, 1);  // Order the MCU to keep reading
-    CliCharReadySemaphoreGiveFromISR();                               // Give binary semaphore
+    if (usart_rx_commit() > 0) {
+        CliCharReadySemaphoreGiveFromISR();  // Give binary semaphore
+    }
 }
 
 /**
- * @fn			void usart_write_callback(struct usart_module *const usart_module)
- * @brief		Callback called when the system finishes sending all the bytes requested from a UART read job
- * @note
+ * @fn			void usart_rx_idle_callback(struct tc_module *const module)
+ * @brief		Callback called when RX_IDLE_TIMER expires: no character arrived for RX_IDLE_CHARACTERS character times
+ * @note			Ends a burst: a typed key, a pasted line or the tail of an upload reaches the CLI task here
+ */
+void usart_rx_idle_callback(struct tc_module *const module)
+{
+    if (usart_rx_commit() > 0) {
+        CliCharReadySemaphoreGiveFromISR();  // Give binary semaphore
+    }
+
+    if (rxAwake) {
+        rxAwake = false;
+        sleepmgr_unlock_mode(POWER_PERIPHERAL_LOCK);
+        usart_instance.hw->USART.INTENSET.reg = SERCOM_USART_INTFLAG_RXS;  // Let the next burst wake the CPU
+    }
+}
+
+/**
+ * @fn			void usart_rx_start_callback(struct usart_module *const module)
+ * @brief		Callback called on the first start bit of a burst, which also wakes the CPU from standby
+ * @note			Runs in the SERCOM interrupt, which disables itself. The CPU stays out of standby, where the DMAC and
+ *RX_IDLE_TIMER stop, until usart_rx_idle_callback ends the burst and arms it again
  */
-void usart_write_callback(struct usart_module *const usart_module)
+void usart_rx_start_callback(struct usart_module *const module)
 {
-    if (circular_buf_get(cbufTx, (uint8_t *)&latestTx) != -1)  // Only continue if there are more characters to send
-    {
-        usart_write_buffer_job(&usart_instance, (uint8_t *)&latestTx, 1);
+    if (!rxAwake) {
+        rxAwake = true;
+        sleepmgr_lock_mode(POWER_PERIPHERAL_LOCK);
     }
 }
 
+/**
+ * @fn			void usart_write_callback(struct dma_resource *const resource)
+ * @brief		Callback called when the TX DMA channel finishes moving a span of cbufTx to the UART
+ * @note			Runs in the DMAC interrupt. Starts the next span right away, so a burst of log output costs one
+ *interrupt per contiguous span
+ */
+void usart_write_callback(struct dma_resource *const resource)
+{
+    circular_buf_consume(&cbufTx, txInFlight);  // Release the span that was just sent
+    start_usart_write();                        // Only continues if there are more characters to send
+}
+
 struct usart_module *GetUsartModule(void)
 {
     return &usart_instance;
@@ -8,8 +8,8 @@
  *uses it to receive command from the user as well as print debug information.
  *
  *				The code in this file will:
- *				--Initialize a SERCOM port (SERCOM # ) to be an UART channel operating at 115200 baud/second,
- *8N1
+ *				--Initialize a SERCOM port (SERCOM # ) to be an UART channel operating at SERIAL_CONSOLE_BAUDRATE
+ *(115200 by default) baud/second, 8N1
  *				--Register callbacks for the device to read and write characters asycnhronously as required by the
  *CLI
  *				--Initialize the CLI and Debug Logger datastructures
@@ -41,6 +41,54 @@ extern "C" {
 /******************************************************************************
  * Defines
  ******************************************************************************/
+#ifndef SERIAL_CONSOLE_BAUDRATE
+#define SERIAL_CONSOLE_BAUDRATE 115200  ///< Console baud rate, 8N1. Build with e.g. -DSERIAL_CONSOLE_BAUDRATE=921600 for heavy logging; the terminal must match. Above 500 kbaud the console keeps the CPU out of standby
+#endif
+
+// Compile time log thresholds. Messages of a module below its threshold are removed by the compiler, arguments
+// included. Override per build, e.g. -DLOG_COMPILE_LEVEL=LOG_WARNING_LVL -DLOG_LEVEL_MQTT=LOG_DEBUG_LVL
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_INFO_LVL  ///< Default threshold of every module. LOG_INFO_LVL keeps all messages
+#endif
+#ifndef LOG_LEVEL_GENERAL
+#define LOG_LEVEL_GENERAL LOG_COMPILE_LEVEL
+#endif
+#ifndef LOG_LEVEL_WIFI
+#define LOG_LEVEL_WIFI LOG_COMPILE_LEVEL
+#endif
+#ifndef LOG_LEVEL_HTTP
+#define LOG_LEVEL_HTTP LOG_COMPILE_LEVEL
+#endif
+#ifndef LOG_LEVEL_MQTT
+#define LOG_LEVEL_MQTT LOG_COMPILE_LEVEL
+#endif
+#ifndef LOG_LEVEL_I2C
+#define LOG_LEVEL_I2C LOG_COMPILE_LEVEL
+#endif
+#ifndef LOG_LEVEL_UI
+#define LOG_LEVEL_UI LOG_COMPILE_LEVEL
+#endif
+#ifndef LOG_LEVEL_CTRL
+#define LOG_LEVEL_CTRL LOG_COMPILE_LEVEL
+#endif
+
+/// True if a message of the given module (WIFI, HTTP, ...) and level is shown. Constant false when compiled out,
+/// a single table read otherwise
+#define LOG_ENABLED(module, level) ((level) >= LOG_LEVEL_##module && (level) >= logModuleLevels[LOG_MODULE_##module])
+
+/// Logs a message of a module. Use instead of LogMessage: the arguments are not evaluated when the level is off
+#define LOG(module, level, ...)                         \
+    do {                                                \
+        if (LOG_ENABLED(module, level)) {               \
+            LogModuleMessage((level), __VA_ARGS__);     \
+        }                                               \
+    } while (0)
+
+#define LOG_INFO(module, ...) LOG(module, LOG_INFO_LVL, __VA_ARGS__)
+#define LOG_DEBUG(module, ...) LOG(module, LOG_DEBUG_LVL, __VA_ARGS__)
+#define LOG_WARNING(module, ...) LOG(module, LOG_WARNING_LVL, __VA_ARGS__)
+#define LOG_ERROR(module, ...) LOG(module, LOG_ERROR_LVL, __VA_ARGS__)
+#define LOG_FATAL(module, ...) LOG(module, LOG_FATAL_LVL, __VA_ARGS__)
 
 /******************************************************************************
  * Structures and Enumerations
@@ -55,18 +103,50 @@ enum eDebugLogLevels {
     N_DEBUG_LEVELS = 6    // Max number of log levels
 };
 
+enum eLogModules {
+    LOG_MODULE_GENERAL = 0,  // LogMessage calls without a module
+    LOG_MODULE_WIFI = 1,     // WINC1500 connection
+    LOG_MODULE_HTTP = 2,     // HTTP download and SD card storage
+    LOG_MODULE_MQTT = 3,     // MQTT broker and topics
+    LOG_MODULE_I2C = 4,      // I2C drivers
+    LOG_MODULE_UI = 5,       // UI task
+    LOG_MODULE_CTRL = 6,     // Control task
+    N_LOG_MODULES = 7        // Max number of log modules
+};
+
+enum eLogModes {
+    LOG_MODE_TEXT = 0,    // Log messages are formatted on target
+    LOG_MODE_BINARY = 1,  // Log messages are sent as frames (LogFormat.h), formatted on the host by Tools/logdecode.c
+};
+
+/******************************************************************************
+ * Global Variables
+ ******************************************************************************/
+extern uint8_t logModuleLevels[N_LOG_MODULES];  ///< Runtime threshold of each module (enum eDebugLogLevels). Read by LOG_ENABLED
+
 /******************************************************************************
  * Global Function Declarations
  ******************************************************************************/
 void InitializeSerialConsole(void);
 void DeinitializeSerialConsole(void);
 void SerialConsoleWriteString(const char *string);
+void SerialConsoleWrite(const char *data, size_t length);
+bool SerialConsoleWriteFrame(const uint8_t *frame, size_t length);
+int SerialConsolePrintf(const char *format, ...);
 int SerialConsoleReadCharacter(uint8_t *rxChar);
 void LogMessage(enum eDebugLogLevels level, const char *format, ...);
 void setLogLevel(enum eDebugLogLevels debugLevel);
 enum eDebugLogLevels getLogLevel(void);
 struct usart_module *GetUsartModule(void);
 void LogMessageDebug(const char *format, ...);
+void LogModuleMessage(enum eDebugLogLevels level, const char *format, ...);
+void setLogModuleLevel(enum eLogModules module, enum eDebugLogLevels debugLevel);
+enum eDebugLogLevels getLogModuleLevel(enum eLogModules module);
+const char *LogModuleName(enum eLogModules module);
+const char *LogLevelName(enum eDebugLogLevels level);
+void setLogMode(enum eLogModes mode);
+enum eLogModes getLogMode(void);
+uint32_t getLogFramesDropped(void);
 
 /******************************************************************************
  * Local Functions
@@ -18,6 +18,7 @@ Thread for ESE516 Spring (Online) Edition
 #include "IMU/lsm6dso_reg.h"
 #include "SeesawDriver/Seesaw.h"
 #include "SerialConsole.h"
+#include "RamPlan/RamPlan.h"
 #include "WifiHandlerThread/WifiHandler.h"
 #include "asf.h"
 #include "gfx_mono.h"
@@ -26,7 +27,10 @@ Thread for ESE516 Spring (Online) Edition
 /******************************************************************************
  * Defines
  ******************************************************************************/
-#define BUTTON_PRESSES_MAX 16  ///< Number of maximum button presses to analize in one go
+#define BUTTON_PRESSES_MAX 16     ///< Number of maximum button presses to analize in one go
+#define UI_BUTTON_POLL_PERIOD 50  ///< Ticks between two reads of the keypad. Its interrupt line is not wired
+#define UI_EVENT_SHOW_MOVES 0x01  ///< uiEvents bit: control ordered a play, set by UiOrderShowMoves
+#define UI_EVENT_PLAY_DONE 0x02   ///< uiEvents bit: the player finished the play, waited on by UiWaitForPlay
 
 /******************************************************************************
  * Variables
@@ -40,9 +44,10 @@ volatile uint8_t blue = 50;           ///< Holds the color of the blue LEDs. Can
 
 uint8_t pressedKeys = 0;              ///< Variable to count how many presses the player has done
 uint8_t keysToPress = 0;              ///< Variable that holds the number of new keypresses the user should do
-bool playIsDone = false;              ///< Boolean flag to indicate if the player has finished moving.
-                                      ///< Useful for COntrol to determine when to send back a play.
 uint8_t buttons[BUTTON_PRESSES_MAX];  ///< Array to hold button presses
+
+static EventGroupHandle_t uiEvents = NULL;              ///< UI_EVENT_ bits between the control and UI threads
+static StaticEventGroup_t uiEventsBuffer RAM_PLAN(ui);  ///< Storage of uiEvents
 /******************************************************************************
  * Forward Declarations
  ******************************************************************************/
@@ -55,6 +60,16 @@ uint8_t buttons[BUTTON_PRESSES_MAX];  ///< Array to hold button presses
  * Task Function
  ******************************************************************************/
 
+/**
+ * @fn		void UiHandlerInit(void)
+ * @brief	Creates the uiEvents group shared with the control thread
+ * @note		Call before creating the UI and control tasks: either may use the group first
+ */
+void UiHandlerInit(void)
+{
+    uiEvents = xEventGroupCreateStatic(&uiEventsBuffer);
+}
+
 /**
  * @fn		void vUiHandlerTask( void *pvParameters )
  * @brief	STUDENT TO FILL THIS
@@ -66,7 +81,7 @@ uint8_t buttons[BUTTON_PRESSES_MAX];  ///< Array to hold button presses
 void vUiHandlerTask(void *pvParameters)
 {
     // Do initialization code here
-    SerialConsoleWriteString("UI Task Started!");
+    LOG_INFO(UI, "UI Task Started!\r\n");
     uiState = UI_STATE_IGNORE_PRESSES;  // Initial state
 
     // Graphics Test - Students to uncomment to test out the OLED driver if you are using it! 
@@ -82,9 +97,11 @@ void vUiHandlerTask(void *pvParameters)
         switch (uiState) {
             case (UI_STATE_IGNORE_PRESSES): {
                 // Ignore any presses until we receive a command from the control thread
-                // to go to UI_STATE_SHOW_MOVES Will be changed by control with the
+                // to go to UI_STATE_SHOW_MOVES. Control sends it with the
                 // function void UiOrderShowMoves(struct GameDataPacket *packetIn) which
-                // gets called when a valid MQTT Package comes in!
+                // gets called when a valid MQTT Package comes in! Sleep until then.
+                xEventGroupWaitBits(uiEvents, UI_EVENT_SHOW_MOVES, pdTRUE, pdFALSE, portMAX_DELAY);
+                uiState = UI_STATE_SHOW_MOVES;
                 break;
             }
 
@@ -96,7 +113,7 @@ void vUiHandlerTask(void *pvParameters)
                                   // to the number of key presses needed.
                 memset(gamePacketOut.game, 0xff,
                        sizeof(gamePacketOut.game));  // Erase gamePacketOut to an initial state
-                playIsDone = false;                  // Set play to false
+                xEventGroupClearBits(uiEvents, UI_EVENT_PLAY_DONE);  // Set play to false
                 uint8_t presses = SeesawGetKeypadCount();
                 if (presses >= BUTTON_PRESSES_MAX) presses = BUTTON_PRESSES_MAX;
                 if (presses != 0)
@@ -161,7 +178,7 @@ void vUiHandlerTask(void *pvParameters)
                 if (pressedKeys >= keysToPress || pressedKeys >= GAME_SIZE) {
                     // Tell control gamePacketOut is ready to be send out AND go back to
                     // UI_STATE_IGNORE_PRESSES
-                    playIsDone = true;
+                    xEventGroupSetBits(uiEvents, UI_EVENT_PLAY_DONE);
                     uiState = UI_STATE_IGNORE_PRESSES;
                 }
 
@@ -174,8 +191,11 @@ void vUiHandlerTask(void *pvParameters)
                 break;
         }
 
-        // After execution, you can put a thread to sleep for some time.
-        vTaskDelay(50);
+        // After execution, you can put a thread to sleep for some time. Only the keypad
+        // is polled: the other states block on their own.
+        if (UI_STATE_HANDLE_BUTTONS == uiState) {
+            vTaskDelay(UI_BUTTON_POLL_PERIOD);
+        }
     }
 }
 
@@ -185,13 +205,25 @@ void vUiHandlerTask(void *pvParameters)
 void UiOrderShowMoves(struct GameDataPacket *packetIn)
 {
     memcpy(&gamePacketIn, packetIn, sizeof(gamePacketIn));
-    uiState = UI_STATE_SHOW_MOVES;
-    playIsDone = false;  // Set play to false
+    xEventGroupClearBits(uiEvents, UI_EVENT_PLAY_DONE);  // Set play to false
+    xEventGroupSetBits(uiEvents, UI_EVENT_SHOW_MOVES);   // Wakes the UI thread
 }
 
 bool UiPlayIsDone(void)
 {
-    return playIsDone;
+    return (xEventGroupGetBits(uiEvents) & UI_EVENT_PLAY_DONE) != 0;
+}
+
+/**
+ bool UiWaitForPlay(TickType_t ticksToWait);
+ * @brief	Blocks until the player finishes the play ordered by UiOrderShowMoves
+ * @param [in]	ticksToWait Most ticks to wait, portMAX_DELAY for ever
+ * @return		True if the play is done: UiGetGamePacketOut holds it. False on timeout
+ * @note		Consumes the play: UiPlayIsDone is false afterwards
+*/
+bool UiWaitForPlay(TickType_t ticksToWait)
+{
+    return (xEventGroupWaitBits(uiEvents, UI_EVENT_PLAY_DONE, pdTRUE, pdFALSE, ticksToWait) & UI_EVENT_PLAY_DONE) != 0;
 }
 
 struct GameDataPacket *UiGetGamePacketOut(void)
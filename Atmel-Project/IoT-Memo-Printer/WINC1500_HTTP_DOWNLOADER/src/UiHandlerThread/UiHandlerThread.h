@@ -34,9 +34,11 @@ typedef enum uiStateMachine_state {
 /******************************************************************************
  * Global Function Declaration
  ******************************************************************************/
+void UiHandlerInit(void);
 void vUiHandlerTask(void *pvParameters);
 void UiOrderShowMoves(struct GameDataPacket *packetIn);
 bool UiPlayIsDone(void);
+bool UiWaitForPlay(TickType_t ticksToWait);
 struct GameDataPacket *UiGetGamePacketOut(void);
 void UIChangeColors(uint8_t r, uint8_t g, uint8_t b);
 
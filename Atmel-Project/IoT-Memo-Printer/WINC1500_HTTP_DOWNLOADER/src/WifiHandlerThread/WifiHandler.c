@@ -14,10 +14,29 @@
 #include <errno.h>
 #include "ControlThread/ControlThread.h"
 #include "UiHandlerThread/UiHandlerThread.h"
+#include "BootRequest/BootRequest.h"
+#include "RunTimeStats/RunTimeStats.h"
+#include "Memory/MemoryPool.h"
+#include "RamPlan/RamPlan.h"
+#include "Power/Power.h"
+
+#if MEMORY_POOL_NETWORK_SIZE < MAIN_BUFFER_MAX_SIZE
+#error "The HTTP receive buffer does not fit a block of the network pool"
+#endif
+#if MEMORY_POOL_FRAGMENT_SIZE < GAME_SIZE
+#error "A game does not fit a block of the fragment pool"
+#endif
 
 /******************************************************************************
  * Defines
  ******************************************************************************/
+#define WIFI_IMU_QUEUE_LENGTH 5                                                       ///< IMU packets queued for the cloud
+#define WIFI_GAME_QUEUE_LENGTH 2                                                      ///< Games queued for the cloud
+#define WIFI_DISTANCE_QUEUE_LENGTH 5                                                  ///< Distances queued for the cloud
+#define WIFI_PUBLISH_SET_LENGTH (WIFI_IMU_QUEUE_LENGTH + WIFI_GAME_QUEUE_LENGTH + 1)  ///< Every item the publish queues can hold, and wifiIrqSemaphore
+#define WIFI_POLL_PERIOD 100                                                          ///< Most ticks between two services of the WINC1500, for the MQTT keep alive
+#define WIFI_EVENT_WAIT_MS 100                                                        ///< Longest sleep waiting for the WINC1500 IRQ, for the software timers
+#define WIFI_NETWORK_EVENTS_ALL 0x7F                                                  ///< Every download_state bit of the network event group
 
 /******************************************************************************
  * Variables
@@ -26,17 +45,30 @@ volatile char mqtt_msg[64] = "{\"d\":{\"temp\":17}}\"";
 volatile char mqtt_msg_temp[64] = "{\"d\":{\"temp\":17}}\"";
 
 volatile uint32_t temperature = 1;
-int8_t wifiStateMachine = WIFI_MQTT_INIT;   ///< Global variable that determines the state of the WIFI handler.
-QueueHandle_t xQueueWifiState = NULL;       ///< Queue to determine the Wifi state from other threads.
-QueueHandle_t xQueueGameBuffer = NULL;      ///< Queue to send the next play to the cloud
-QueueHandle_t xQueueImuBuffer = NULL;       ///< Queue to send IMU data to the cloud
-QueueHandle_t xQueueDistanceBuffer = NULL;  ///< Queue to send the distance to the cloud
+int8_t wifiStateMachine = WIFI_MQTT_INIT;          ///< Global variable that determines the state of the WIFI handler.
+QueueHandle_t xQueueGameBuffer = NULL;             ///< Queue to send the next play to the cloud. Items are fragmentPool blocks
+QueueHandle_t xQueueImuBuffer = NULL;              ///< Queue to send IMU data to the cloud
+QueueHandle_t xQueueDistanceBuffer = NULL;         ///< Queue to send the distance to the cloud
+static QueueSetHandle_t wifiPublishSet = NULL;     ///< xQueueImuBuffer, xQueueGameBuffer and wifiIrqSemaphore: the task waits on all at once
+static SemaphoreHandle_t wifiIrqSemaphore = NULL;  ///< Given by the WINC1500 IRQ. In wifiPublishSet, so only taken when the set selects it
+static TaskHandle_t wifiTask = NULL;               ///< The Wifi task, notified with a new state by WifiHandlerSetState
+
+static StaticQueue_t imuQueueBuffer RAM_PLAN(wifi);                                                         ///< Control block of xQueueImuBuffer
+static StaticQueue_t gameQueueBuffer RAM_PLAN(wifi);                                                        ///< Control block of xQueueGameBuffer
+static StaticQueue_t distanceQueueBuffer RAM_PLAN(wifi);                                                    ///< Control block of xQueueDistanceBuffer
+static StaticQueue_t publishSetBuffer RAM_PLAN(wifi);                                                       ///< Control block of wifiPublishSet
+static StaticSemaphore_t irqSemaphoreBuffer RAM_PLAN(wifi);                                                 ///< Control block of wifiIrqSemaphore
+static uint8_t imuQueueStorage[WIFI_IMU_QUEUE_LENGTH * sizeof(struct ImuDataPacket)] RAM_PLAN(wifi);        ///< Items of xQueueImuBuffer
+static uint8_t gameQueueStorage[WIFI_GAME_QUEUE_LENGTH * sizeof(struct GameDataPacket *)] RAM_PLAN(wifi);   ///< Items of xQueueGameBuffer
+static uint8_t distanceQueueStorage[WIFI_DISTANCE_QUEUE_LENGTH * sizeof(uint16_t)] RAM_PLAN(wifi);          ///< Items of xQueueDistanceBuffer
+static uint8_t publishSetStorage[WIFI_PUBLISH_SET_LENGTH * sizeof(QueueSetMemberHandle_t)] RAM_PLAN(wifi);  ///< Items of wifiPublishSet
 
 /*HTTP DOWNLOAD RELATED DEFINES AND VARIABLES*/
 
 uint8_t do_download_flag = false;  // Flag that when true initializes a download. False to connect to MQTT broker
 /** File download processing state. */
-static download_state down_state = NOT_READY;
+static EventGroupHandle_t networkEvents = NULL;                ///< download_state bits, for the tasks waiting on the network
+static StaticEventGroup_t networkEventsBuffer RAM_PLAN(wifi);  ///< Storage of networkEvents
 /** SD/MMC mount. */
 static FATFS fatfs;
 /** File pointer for file download. */
@@ -75,6 +107,7 @@ static unsigned char mqtt_send_buffer[MAIN_MQTT_BUFFER_SIZE];
 static void MQTT_InitRoutine(void);
 static void MQTT_HandleGameMessages(void);
 static void MQTT_HandleImuMessages(void);
+static void wifi_irq_hook(void);
 static void HTTP_DownloadFileInit(void);
 static void HTTP_DownloadFileTransaction(void);
 /******************************************************************************
@@ -88,7 +121,10 @@ static void HTTP_DownloadFileTransaction(void);
  */
 static void init_state(void)
 {
-    down_state = NOT_READY;
+    if (NULL == networkEvents) {
+        networkEvents = xEventGroupCreateStatic(&networkEventsBuffer);
+    }
+    xEventGroupClearBits(networkEvents, WIFI_NETWORK_EVENTS_ALL);
 }
 
 /**
@@ -97,7 +133,7 @@ static void init_state(void)
  */
 static void clear_state(download_state mask)
 {
-    down_state &= ~mask;
+    xEventGroupClearBits(networkEvents, mask);
 }
 
 /**
@@ -106,7 +142,7 @@ static void clear_state(download_state mask)
  */
 static void add_state(download_state mask)
 {
-    down_state |= mask;
+    xEventGroupSetBits(networkEvents, mask);
 }
 
 /**
@@ -117,7 +153,7 @@ static void add_state(download_state mask)
 
 static inline bool is_state_set(download_state mask)
 {
-    return ((down_state & mask) != 0);
+    return ((xEventGroupGetBits(networkEvents) & mask) != 0);
 }
 
 /**
@@ -214,27 +250,27 @@ static bool rename_to_unique(FIL *fp, char *file_path_name, uint8_t max_len)
 static void start_download(void)
 {
     if (!is_state_set(STORAGE_READY)) {
-        LogMessage(LOG_DEBUG_LVL, "start_download: MMC storage not ready.\r\n");
+        LOG_DEBUG(HTTP, "start_download: MMC storage not ready.\r\n");
         return;
     }
 
     if (!is_state_set(WIFI_CONNECTED)) {
-        LogMessage(LOG_DEBUG_LVL, "start_download: Wi-Fi is not connected.\r\n");
+        LOG_DEBUG(HTTP, "start_download: Wi-Fi is not connected.\r\n");
         return;
     }
 
     if (is_state_set(GET_REQUESTED)) {
-        LogMessage(LOG_DEBUG_LVL, "start_download: request is sent already.\r\n");
+        LOG_DEBUG(HTTP, "start_download: request is sent already.\r\n");
         return;
     }
 
     if (is_state_set(DOWNLOADING)) {
-        LogMessage(LOG_DEBUG_LVL, "start_download: running download already.\r\n");
+        LOG_DEBUG(HTTP, "start_download: running download already.\r\n");
         return;
     }
 
     /* Send the HTTP request. */
-    LogMessage(LOG_DEBUG_LVL, "start_download: sending HTTP request...\r\n");
+    LOG_DEBUG(HTTP, "start_download: sending HTTP request...\r\n");
     http_client_send_request(&http_client_module_inst, MAIN_HTTP_FILE_URL, HTTP_METHOD_GET, NULL, NULL);
 }
 
@@ -247,7 +283,7 @@ static void store_file_packet(char *data, uint32_t length)
 {
     FRESULT ret;
     if ((data == NULL) || (length < 1)) {
-        LogMessage(LOG_DEBUG_LVL, "store_file_packet: empty data.\r\n");
+        LOG_DEBUG(HTTP, "store_file_packet: empty data.\r\n");
         return;
     }
 
@@ -263,16 +299,16 @@ static void store_file_packet(char *data, uint32_t length)
             cp++;
             strcpy(&save_file_name[2], cp);
         } else {
-            LogMessage(LOG_DEBUG_LVL, "store_file_packet: file name is invalid. Download canceled.\r\n");
+            LOG_DEBUG(HTTP, "store_file_packet: file name is invalid. Download canceled.\r\n");
             add_state(CANCELED);
             return;
         }
 
         rename_to_unique(&file_object, save_file_name, MAIN_MAX_FILE_NAME_LENGTH);
-        LogMessage(LOG_DEBUG_LVL, "store_file_packet: creating file [%s]\r\n", save_file_name);
+        LOG_DEBUG(HTTP, "store_file_packet: creating file [%s]\r\n", save_file_name);
         ret = f_open(&file_object, (char const *)save_file_name, FA_CREATE_ALWAYS | FA_WRITE);
         if (ret != FR_OK) {
-            LogMessage(LOG_DEBUG_LVL, "store_file_packet: file creation error! ret:%d\r\n", ret);
+            LOG_DEBUG(HTTP, "store_file_packet: file creation error! ret:%d\r\n", ret);
             return;
         }
 
@@ -286,15 +322,15 @@ static void store_file_packet(char *data, uint32_t length)
         if (ret != FR_OK) {
             f_close(&file_object);
             add_state(CANCELED);
-            LogMessage(LOG_DEBUG_LVL, "store_file_packet: file write error, download canceled.\r\n");
+            LOG_DEBUG(HTTP, "store_file_packet: file write error, download canceled.\r\n");
             return;
         }
 
         received_file_size += wsize;
-        LogMessage(LOG_DEBUG_LVL, "store_file_packet: received[%lu], file size[%lu]\r\n", (unsigned long)received_file_size, (unsigned long)http_file_size);
+        LOG_DEBUG(HTTP, "store_file_packet: received[%lu], file size[%lu]\r\n", (unsigned long)received_file_size, (unsigned long)http_file_size);
         if (received_file_size >= http_file_size) {
             f_close(&file_object);
-            LogMessage(LOG_DEBUG_LVL, "store_file_packet: file downloaded successfully.\r\n");
+            LOG_DEBUG(HTTP, "store_file_packet: file downloaded successfully.\r\n");
             port_pin_set_output_level(LED_0_PIN, false);
             add_state(COMPLETED);
             return;
@@ -313,16 +349,16 @@ static void http_client_callback(struct http_client_module *module_inst, int typ
 {
     switch (type) {
         case HTTP_CLIENT_CALLBACK_SOCK_CONNECTED:
-            LogMessage(LOG_DEBUG_LVL, "http_client_callback: HTTP client socket connected.\r\n");
+            LOG_DEBUG(HTTP, "http_client_callback: HTTP client socket connected.\r\n");
             break;
 
         case HTTP_CLIENT_CALLBACK_REQUESTED:
-            LogMessage(LOG_DEBUG_LVL, "http_client_callback: request completed.\r\n");
+            LOG_DEBUG(HTTP, "http_client_callback: request completed.\r\n");
             add_state(GET_REQUESTED);
             break;
 
         case HTTP_CLIENT_CALLBACK_RECV_RESPONSE:
-            LogMessage(LOG_DEBUG_LVL, "http_client_callback: received response %u data size %u\r\n", (unsigned int)data->recv_response.response_code, (unsigned int)data->recv_response.content_length);
+            LOG_DEBUG(HTTP, "http_client_callback: received response %u data size %u\r\n", (unsigned int)data->recv_response.response_code, (unsigned int)data->recv_response.content_length);
             if ((unsigned int)data->recv_response.response_code == 200) {
                 http_file_size = data->recv_response.content_length;
                 received_file_size = 0;
@@ -345,7 +381,7 @@ static void http_client_callback(struct http_client_module *module_inst, int typ
             break;
 
         case HTTP_CLIENT_CALLBACK_DISCONNECTED:
-            LogMessage(LOG_DEBUG_LVL, "http_client_callback: disconnection reason:%d\r\n", data->disconnected.reason);
+            LOG_DEBUG(HTTP, "http_client_callback: disconnection reason:%d\r\n", data->disconnected.reason);
 
             /* If disconnect reason is equal to -ECONNRESET(-104),
              * It means the server has closed the connection (timeout).
@@ -401,7 +437,7 @@ static void socket_cb(SOCKET sock, uint8_t u8Msg, void *pvMsg)
  */
 static void resolve_cb(uint8_t *pu8DomainName, uint32_t u32ServerIP)
 {
-    LogMessage(LOG_DEBUG_LVL,
+    LOG_DEBUG(WIFI,
                "resolve_cb: %s IP address is %d.%d.%d.%d\r\n\r\n",
                pu8DomainName,
                (int)IPV4_BYTE(u32ServerIP, 0),
@@ -442,11 +478,11 @@ static void wifi_cb(uint8_t u8MsgType, void *pvMsg)
         case M2M_WIFI_RESP_CON_STATE_CHANGED: {
             tstrM2mWifiStateChanged *pstrWifiState = (tstrM2mWifiStateChanged *)pvMsg;
             if (pstrWifiState->u8CurrState == M2M_WIFI_CONNECTED) {
-                LogMessage(LOG_DEBUG_LVL, "wifi_cb: M2M_WIFI_CONNECTED\r\n");
+                LOG_DEBUG(WIFI, "wifi_cb: M2M_WIFI_CONNECTED\r\n");
                 m2m_wifi_request_dhcp_client();
             } else if (pstrWifiState->u8CurrState == M2M_WIFI_DISCONNECTED) {
-                LogMessage(LOG_DEBUG_LVL, "wifi_cb: M2M_WIFI_DISCONNECTED\r\n");
-                clear_state(WIFI_CONNECTED);
+                LOG_DEBUG(WIFI, "wifi_cb: M2M_WIFI_DISCONNECTED\r\n");
+                clear_state(WIFI_CONNECTED | MQTT_CONNECTED);
                 if (is_state_set(DOWNLOADING)) {
                     f_close(&file_object);
                     clear_state(DOWNLOADING);
@@ -468,7 +504,7 @@ static void wifi_cb(uint8_t u8MsgType, void *pvMsg)
 
         case M2M_WIFI_REQ_DHCP_CONF: {
             uint8_t *pu8IPAddress = (uint8_t *)pvMsg;
-            LogMessage(LOG_DEBUG_LVL, "wifi_cb: IP address is %u.%u.%u.%u\r\n", pu8IPAddress[0], pu8IPAddress[1], pu8IPAddress[2], pu8IPAddress[3]);
+            LOG_DEBUG(WIFI, "wifi_cb: IP address is %u.%u.%u.%u\r\n", pu8IPAddress[0], pu8IPAddress[1], pu8IPAddress[2], pu8IPAddress[3]);
             add_state(WIFI_CONNECTED);
 
             if (do_download_flag == 1) {
@@ -477,7 +513,7 @@ static void wifi_cb(uint8_t u8MsgType, void *pvMsg)
             } else {
                 /* Try to connect to MQTT broker when Wi-Fi was connected. */
                 if (mqtt_connect(&mqtt_inst, main_mqtt_broker)) {
-                    LogMessage(LOG_DEBUG_LVL, "Error connecting to MQTT Broker!\r\n");
+                    LOG_DEBUG(MQTT, "Error connecting to MQTT Broker!\r\n");
                 }
             }
         } break;
@@ -498,28 +534,28 @@ void init_storage(void)
     /* Initialize SD/MMC stack. */
     sd_mmc_init();
     while (true) {
-        LogMessage(LOG_DEBUG_LVL, "init_storage: please plug an SD/MMC card in slot...\r\n");
+        LOG_DEBUG(HTTP, "init_storage: please plug an SD/MMC card in slot...\r\n");
 
         /* Wait card present and ready. */
         do {
             status = sd_mmc_test_unit_ready(0);
             if (CTRL_FAIL == status) {
-                LogMessage(LOG_DEBUG_LVL, "init_storage: SD Card install failed.\r\n");
-                LogMessage(LOG_DEBUG_LVL, "init_storage: try unplug and re-plug the card.\r\n");
+                LOG_DEBUG(HTTP, "init_storage: SD Card install failed.\r\n");
+                LOG_DEBUG(HTTP, "init_storage: try unplug and re-plug the card.\r\n");
                 while (CTRL_NO_PRESENT != sd_mmc_check(0)) {
                 }
             }
         } while (CTRL_GOOD != status);
 
-        LogMessage(LOG_DEBUG_LVL, "init_storage: mounting SD card...\r\n");
+        LOG_DEBUG(HTTP, "init_storage: mounting SD card...\r\n");
         memset(&fatfs, 0, sizeof(FATFS));
         res = f_mount(LUN_ID_SD_MMC_0_MEM, &fatfs);
         if (FR_INVALID_DRIVE == res) {
-            LogMessage(LOG_DEBUG_LVL, "init_storage: SD card mount failed! (res %d)\r\n", res);
+            LOG_DEBUG(HTTP, "init_storage: SD card mount failed! (res %d)\r\n", res);
             return;
         }
 
-        LogMessage(LOG_DEBUG_LVL, "init_storage: SD card mount OK.\r\n");
+        LOG_DEBUG(HTTP, "init_storage: SD card mount OK.\r\n");
         add_state(STORAGE_READY);
         return;
     }
@@ -571,6 +607,8 @@ static void configure_http_client(void)
 
     http_client_get_config_defaults(&httpc_conf);
 
+    // From the network pool. If it is empty, http_client_init mallocs the buffer itself
+    httpc_conf.recv_buffer = MemoryPoolAlloc(&networkPool);
     httpc_conf.recv_buffer_size = MAIN_BUFFER_MAX_SIZE;
     httpc_conf.timer_inst = &swt_module_inst;
     httpc_conf.port = 443;
@@ -578,7 +616,7 @@ static void configure_http_client(void)
 
     ret = http_client_init(&http_client_module_inst, &httpc_conf);
     if (ret < 0) {
-        LogMessage(LOG_DEBUG_LVL, "configure_http_client: HTTP client initialization failed! (res %d)\r\n", ret);
+        LOG_DEBUG(HTTP, "configure_http_client: HTTP client initialization failed! (res %d)\r\n", ret);
         while (1) {
         } /* Loop forever. */
     }
@@ -631,7 +669,7 @@ static void socket_resolve_handler(uint8_t *doamin_name, uint32_t server_ip)
 void SubscribeHandlerLedTopic(MessageData *msgData)
 {
     uint8_t rgb[3] = {0, 0, 0};
-    LogMessage(LOG_DEBUG_LVL, "\r\n %.*s", msgData->topicName->lenstring.len, msgData->topicName->lenstring.data);
+    LOG_DEBUG(MQTT, "\r\n %.*s", msgData->topicName->lenstring.len, msgData->topicName->lenstring.data);
     // Will receive something of the style "rgb(222, 224, 189)"
     if (strncmp(msgData->message->payload, "rgb(", 4) == 0) {
         char *p = (char *)&msgData->message->payload[4];
@@ -641,7 +679,7 @@ void SubscribeHandlerLedTopic(MessageData *msgData)
             if (*p != ',') break;
             p++; /* skip, */
         }
-        LogMessage(LOG_DEBUG_LVL, "\r\nRGB %d %d %d\r\n", rgb[0], rgb[1], rgb[2]);
+        LOG_DEBUG(MQTT, "\r\nRGB %d %d %d\r\n", rgb[0], rgb[1], rgb[2]);
         UIChangeColors(rgb[0], rgb[1], rgb[2]);
     }
 }
@@ -653,9 +691,9 @@ void SubscribeHandlerGameTopic(MessageData *msgData)
 
     // Parse input. The start string must be '{"game":['
     if (strncmp(msgData->message->payload, "{\"game\":[", 9) == 0) {
-        LogMessage(LOG_DEBUG_LVL, "\r\nGame message received!\r\n");
-        LogMessage(LOG_DEBUG_LVL, "\r\n %.*s", msgData->topicName->lenstring.len, msgData->topicName->lenstring.data);
-        LogMessage(LOG_DEBUG_LVL, "%.*s", msgData->message->payloadlen, (char *)msgData->message->payload);
+        LOG_DEBUG(MQTT, "\r\nGame message received!\r\n");
+        LOG_DEBUG(MQTT, "\r\n %.*s", msgData->topicName->lenstring.len, msgData->topicName->lenstring.data);
+        LOG_DEBUG(MQTT, "%.*s", msgData->message->payloadlen, (char *)msgData->message->payload);
 
         int nb = 0;
         char *p = &msgData->message->payload[9];
@@ -664,41 +702,41 @@ void SubscribeHandlerGameTopic(MessageData *msgData)
             if (*p != ',') break;
             p++; /* skip, */
         }
-        LogMessage(LOG_DEBUG_LVL, "\r\nParsed Command: ");
+        LOG_DEBUG(MQTT, "\r\nParsed Command: ");
         for (int i = 0; i < GAME_SIZE; i++) {
-            LogMessage(LOG_DEBUG_LVL, "%d,", game.game[i]);
+            LOG_DEBUG(MQTT, "%d,", game.game[i]);
         }
 
         if (pdTRUE == ControlAddGameData(&game)) {
-            LogMessage(LOG_DEBUG_LVL, "\r\nSent play to control!\r\n");
+            LOG_DEBUG(MQTT, "\r\nSent play to control!\r\n");
         }
 
     } else {
-        LogMessage(LOG_DEBUG_LVL, "\r\nGame message received but not understood!\r\n");
-        LogMessage(LOG_DEBUG_LVL, "\r\n %.*s", msgData->topicName->lenstring.len, msgData->topicName->lenstring.data);
-        LogMessage(LOG_DEBUG_LVL, "%.*s", msgData->message->payloadlen, (char *)msgData->message->payload);
+        LOG_DEBUG(MQTT, "\r\nGame message received but not understood!\r\n");
+        LOG_DEBUG(MQTT, "\r\n %.*s", msgData->topicName->lenstring.len, msgData->topicName->lenstring.data);
+        LOG_DEBUG(MQTT, "%.*s", msgData->message->payloadlen, (char *)msgData->message->payload);
     }
 }
 
 void SubscribeHandlerImuTopic(MessageData *msgData)
 {
-	LogMessage(LOG_DEBUG_LVL, "\r\nIMU topic received!\r\n");
-    LogMessage(LOG_DEBUG_LVL, "\r\n %.*s", msgData->topicName->lenstring.len, msgData->topicName->lenstring.data);
+	LOG_DEBUG(MQTT, "\r\nIMU topic received!\r\n");
+    LOG_DEBUG(MQTT, "\r\n %.*s", msgData->topicName->lenstring.len, msgData->topicName->lenstring.data);
 }
 
 void SubscribeHandlerDistanceTopic(MessageData *msgData)
 {
-	LogMessage(LOG_DEBUG_LVL, "\r\nDistance topic received!\r\n");
-    LogMessage(LOG_DEBUG_LVL, "\r\n %.*s", msgData->topicName->lenstring.len, msgData->topicName->lenstring.data);
+	LOG_DEBUG(MQTT, "\r\nDistance topic received!\r\n");
+    LOG_DEBUG(MQTT, "\r\n %.*s", msgData->topicName->lenstring.len, msgData->topicName->lenstring.data);
 }
 
 void SubscribeHandler(MessageData *msgData)
 {
     /* You received publish message which you had subscribed. */
     /* Print Topic and message */
-    LogMessage(LOG_DEBUG_LVL, "\r\n %.*s", msgData->topicName->lenstring.len, msgData->topicName->lenstring.data);
-    LogMessage(LOG_DEBUG_LVL, " >> ");
-    LogMessage(LOG_DEBUG_LVL, "%.*s", msgData->message->payloadlen, (char *)msgData->message->payload);
+    LOG_DEBUG(MQTT, "\r\n %.*s", msgData->topicName->lenstring.len, msgData->topicName->lenstring.data);
+    LOG_DEBUG(MQTT, " >> ");
+    LOG_DEBUG(MQTT, "%.*s", msgData->message->payloadlen, (char *)msgData->message->payload);
 
     // Handle LedData message
     if (strncmp((char *)msgData->topicName->lenstring.data, LED_TOPIC, msgData->message->payloadlen) == 0) {
@@ -733,14 +771,14 @@ static void mqtt_callback(struct mqtt_module *module_inst, int type, union mqtt_
              * Or else retry to connect to broker server.
              */
             if (data->sock_connected.result >= 0) {
-                LogMessage(LOG_DEBUG_LVL, "\r\nConnecting to Broker...");
+                LOG_DEBUG(MQTT, "\r\nConnecting to Broker...");
                 if (0 != mqtt_connect_broker(module_inst, 1, CLOUDMQTT_USER_ID, CLOUDMQTT_USER_PASSWORD, CLOUDMQTT_USER_ID, NULL, NULL, 0, 0, 0)) {
-                    LogMessage(LOG_DEBUG_LVL, "MQTT  Error - NOT Connected to broker\r\n");
+                    LOG_DEBUG(MQTT, "MQTT  Error - NOT Connected to broker\r\n");
                 } else {
-                    LogMessage(LOG_DEBUG_LVL, "MQTT Connected to broker\r\n");
+                    LOG_DEBUG(MQTT, "MQTT Connected to broker\r\n");
                 }
             } else {
-                LogMessage(LOG_DEBUG_LVL, "Connect fail to server(%s)! retry it automatically.\r\n", main_mqtt_broker);
+                LOG_DEBUG(MQTT, "Connect fail to server(%s)! retry it automatically.\r\n", main_mqtt_broker);
                 mqtt_connect(module_inst, main_mqtt_broker); /* Retry that. */
             }
         } break;
@@ -751,19 +789,21 @@ static void mqtt_callback(struct mqtt_module *module_inst, int type, union mqtt_
                 mqtt_subscribe(module_inst, GAME_TOPIC_IN, 2, SubscribeHandlerGameTopic);
                 mqtt_subscribe(module_inst, LED_TOPIC, 2, SubscribeHandlerLedTopic);
                 mqtt_subscribe(module_inst, IMU_TOPIC, 2, SubscribeHandlerImuTopic);
+                add_state(MQTT_CONNECTED);
                 /* Enable USART receiving callback. */
 
-                LogMessage(LOG_DEBUG_LVL, "MQTT Connected\r\n");
+                LOG_DEBUG(MQTT, "MQTT Connected\r\n");
             } else {
                 /* Cannot connect for some reason. */
-                LogMessage(LOG_DEBUG_LVL, "MQTT broker decline your access! error code %d\r\n", data->connected.result);
+                LOG_DEBUG(MQTT, "MQTT broker decline your access! error code %d\r\n", data->connected.result);
             }
 
             break;
 
         case MQTT_CALLBACK_DISCONNECTED:
             /* Stop timer and USART callback. */
-            LogMessage(LOG_DEBUG_LVL, "MQTT disconnected\r\n");
+            LOG_DEBUG(MQTT, "MQTT disconnected\r\n");
+            clear_state(MQTT_CONNECTED);
             // usart_disable_callback(&cdc_uart_module, USART_CALLBACK_BUFFER_RECEIVED);
             break;
     }
@@ -788,14 +828,14 @@ static void configure_mqtt(void)
 
     result = mqtt_init(&mqtt_inst, &mqtt_conf);
     if (result < 0) {
-        LogMessage(LOG_DEBUG_LVL, "MQTT initialization failed. Error code is (%d)\r\n", result);
+        LOG_DEBUG(MQTT, "MQTT initialization failed. Error code is (%d)\r\n", result);
         while (1) {
         }
     }
 
     result = mqtt_register_callback(&mqtt_inst, mqtt_callback);
     if (result < 0) {
-        LogMessage(LOG_DEBUG_LVL, "MQTT register callback failed. Error code is (%d)\r\n", result);
+        LOG_DEBUG(MQTT, "MQTT register callback failed. Error code is (%d)\r\n", result);
         while (1) {
         }
     }
@@ -841,10 +881,11 @@ void extint_detection_callback(void)
 static void HTTP_DownloadFileInit(void)
 {
     if (mqtt_disconnect(&mqtt_inst, main_mqtt_broker)) {
-        LogMessage(LOG_DEBUG_LVL, "Error connecting to MQTT Broker!\r\n");
+        LOG_DEBUG(MQTT, "Error connecting to MQTT Broker!\r\n");
     }
     while ((mqtt_inst.isConnected)) {
         m2m_wifi_handle_events(NULL);
+        nm_bsp_wait_for_event(WIFI_EVENT_WAIT_MS);
     }
     socketDeinit();
     // DOWNLOAD A FILE
@@ -866,14 +907,19 @@ static void HTTP_DownloadFileInit(void)
 */
 static void HTTP_DownloadFileTransaction(void)
 {
+    // The HTTP client times out on the sw_timer, which stops in standby: stay in the idle modes until the end
+    sleepmgr_lock_mode(POWER_PERIPHERAL_LOCK);
+
     /* Connect to router. */
     while (!(is_state_set(COMPLETED) || is_state_set(CANCELED))) {
         /* Handle pending events from network controller. */
         m2m_wifi_handle_events(NULL);
         /* Checks the timer timeout. */
         sw_timer_task(&swt_module_inst);
-        vTaskDelay(5);
+        /* Sleep until the network controller has news. */
+        nm_bsp_wait_for_event(WIFI_EVENT_WAIT_MS);
     }
+    sleepmgr_unlock_mode(POWER_PERIPHERAL_LOCK);
 
     // Disable socket for HTTP Transfer
     socketDeinit();
@@ -886,10 +932,14 @@ static void HTTP_DownloadFileTransaction(void)
     test_file_name[0] = LUN_ID_SD_MMC_0_MEM + '0';
     FRESULT res = f_open(&file_object, (char const *)test_file_name, FA_CREATE_ALWAYS | FA_WRITE);
     if (res != FR_OK) {
-        LogMessage(LOG_INFO_LVL, "[FAIL] res %d\r\n", res);
+        LOG_INFO(HTTP, "[FAIL] res %d\r\n", res);
     } else {
 		f_close(&file_object);
         SerialConsoleWriteString("FlagA.txt added!\r\n");
+        // The bootloader skips the SD card unless a request is pending
+        if (STATUS_OK != BootRequestSet(BOOT_REQUEST_UPDATE)) {
+            SerialConsoleWriteString("Could not request the update from the bootloader!\r\n");
+        }
     }
 // 	if (f_stat("FlagA.txt", NULL) == FR_OK) // WILL STUCK HERE FOREVER IF FLAG FILE CREATED AND NOT CLOSED!!
 // 	{
@@ -915,12 +965,12 @@ static void MQTT_InitRoutine(void)
     /* Connect to router. */
     if (!(mqtt_inst.isConnected)) {
         if (mqtt_connect(&mqtt_inst, main_mqtt_broker)) {
-            LogMessage(LOG_DEBUG_LVL, "Error connecting to MQTT Broker!\r\n");
+            LOG_DEBUG(MQTT, "Error connecting to MQTT Broker!\r\n");
         }
     }
 
     if (mqtt_inst.isConnected) {
-        LogMessage(LOG_DEBUG_LVL, "Connected to MQTT Broker!\r\n");
+        LOG_DEBUG(MQTT, "Connected to MQTT Broker!\r\n");
     }
     wifiStateMachine = WIFI_MQTT_HANDLE;
 }
@@ -928,7 +978,7 @@ static void MQTT_InitRoutine(void)
 /**
  static void MQTT_HandleTransactions(void)
  * @brief	Routine to handle MQTT transactions
- * @note
+ * @note	Blocks up to WIFI_POLL_PERIOD ticks waiting for an IMU or game packet to publish, or for the WINC1500 IRQ
 
 */
 static void MQTT_HandleTransactions(void)
@@ -937,9 +987,16 @@ static void MQTT_HandleTransactions(void)
     m2m_wifi_handle_events(NULL);
     sw_timer_task(&swt_module_inst);
 
-    // Check if data has to be sent!
-    MQTT_HandleGameMessages();
-    MQTT_HandleImuMessages();
+    // Sleep until there is data to send or the network controller has news. An event still pending gives no edge
+    QueueSetMemberHandle_t ready = xQueueSelectFromSet(wifiPublishSet, nm_bsp_event_pending() ? 0 : WIFI_POLL_PERIOD);
+    if (ready == xQueueGameBuffer) {
+        MQTT_HandleGameMessages();
+    } else if (ready == xQueueImuBuffer) {
+        MQTT_HandleImuMessages();
+    } else if (ready == wifiIrqSemaphore) {
+        xSemaphoreTake(wifiIrqSemaphore, 0);
+        m2m_wifi_handle_events(NULL);
+    }
 
     // Handle MQTT messages
     if (mqtt_inst.isConnected) mqtt_yield(&mqtt_inst, 100);
@@ -956,15 +1013,15 @@ static void MQTT_HandleImuMessages(void)
 
 static void MQTT_HandleGameMessages(void)
 {
-    struct GameDataPacket gamePacket;
+    struct GameDataPacket *gamePacket;
     if (pdPASS == xQueueReceive(xQueueGameBuffer, &gamePacket, 0)) {
         snprintf(mqtt_msg, 63, "{\"game\":[");
         for (int iter = 0; iter < GAME_SIZE; iter++) {
             char numGame[5];
-            if (gamePacket.game[iter] != 0xFF) {
-                snprintf(numGame, 3, "%d", gamePacket.game[iter]);
+            if (gamePacket->game[iter] != 0xFF) {
+                snprintf(numGame, 3, "%d", gamePacket->game[iter]);
                 strcat(mqtt_msg, numGame);
-                if (gamePacket.game[iter + 1] != 0xFF && iter + 1 < GAME_SIZE) {
+                if (gamePacket->game[iter + 1] != 0xFF && iter + 1 < GAME_SIZE) {
                     snprintf(numGame, 5, ",");
                     strcat(mqtt_msg, numGame);
                 }
@@ -973,11 +1030,26 @@ static void MQTT_HandleGameMessages(void)
             }
         }
         strcat(mqtt_msg, "]}");
-        LogMessage(LOG_DEBUG_LVL, mqtt_msg);
-        LogMessage(LOG_DEBUG_LVL, "\r\n");
+        MemoryPoolFree(&fragmentPool, gamePacket);
+        LOG_DEBUG(MQTT, "%s", mqtt_msg);
+        LOG_DEBUG(MQTT, "\r\n");
         mqtt_publish(&mqtt_inst, GAME_TOPIC_OUT, mqtt_msg, strlen(mqtt_msg), 1, 0);
     }
 }
+/**
+ static void wifi_irq_hook(void)
+ * @brief	Gives wifiIrqSemaphore, so the WINC1500 IRQ wakes MQTT_HandleTransactions out of wifiPublishSet
+ * @note	Runs in the interrupt of the IRQ line, after the BSP gave its own event semaphore
+
+*/
+static void wifi_irq_hook(void)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    xSemaphoreGiveFromISR(wifiIrqSemaphore, &xHigherPriorityTaskWoken);
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
 /**
  * \brief Main application function.
  *
@@ -989,17 +1061,27 @@ void vWifiTask(void *pvParameters)
 {
     tstrWifiInitParam param;
     int8_t ret;
+    wifiTask = xTaskGetCurrentTaskHandle();
     vTaskDelay(100);
     init_state();
-    // Create buffers to send data
-    xQueueWifiState = xQueueCreate(5, sizeof(uint32_t));
-    xQueueImuBuffer = xQueueCreate(5, sizeof(struct ImuDataPacket));
-    xQueueGameBuffer = xQueueCreate(2, sizeof(struct GameDataPacket));
-    xQueueDistanceBuffer = xQueueCreate(5, sizeof(uint16_t));
-
-    if (xQueueWifiState == NULL || xQueueImuBuffer == NULL || xQueueGameBuffer == NULL || xQueueDistanceBuffer == NULL) {
+    // Create buffers to send data. The task waits on the publish queues and the WINC1500 IRQ together through
+    // wifiPublishSet, which must hold an entry for every item they can hold
+    xQueueImuBuffer = xQueueCreateStatic(WIFI_IMU_QUEUE_LENGTH, sizeof(struct ImuDataPacket), imuQueueStorage, &imuQueueBuffer);
+    xQueueGameBuffer = xQueueCreateStatic(WIFI_GAME_QUEUE_LENGTH, sizeof(struct GameDataPacket *), gameQueueStorage, &gameQueueBuffer);
+    xQueueDistanceBuffer = xQueueCreateStatic(WIFI_DISTANCE_QUEUE_LENGTH, sizeof(uint16_t), distanceQueueStorage, &distanceQueueBuffer);
+    wifiPublishSet =
+        xQueueGenericCreateStatic(WIFI_PUBLISH_SET_LENGTH, sizeof(QueueSetMemberHandle_t), publishSetStorage, &publishSetBuffer, queueQUEUE_TYPE_SET);
+    wifiIrqSemaphore = xSemaphoreCreateBinaryStatic(&irqSemaphoreBuffer);
+
+    if (xQueueImuBuffer == NULL || xQueueGameBuffer == NULL || xQueueDistanceBuffer == NULL || wifiPublishSet == NULL || wifiIrqSemaphore == NULL ||
+        xQueueAddToSet(xQueueImuBuffer, wifiPublishSet) != pdPASS || xQueueAddToSet(xQueueGameBuffer, wifiPublishSet) != pdPASS ||
+        xQueueAddToSet(wifiIrqSemaphore, wifiPublishSet) != pdPASS) {
         SerialConsoleWriteString("ERROR Initializing Wifi Data queues!\r\n");
     }
+    nm_bsp_register_event_hook(wifi_irq_hook);
+    RunTimeStatsAddQueue(xQueueImuBuffer, "Imu");
+    RunTimeStatsAddQueue(xQueueGameBuffer, "Game");
+    RunTimeStatsAddQueue(xQueueDistanceBuffer, "Distance");
 
     SerialConsoleWriteString("ESE516 - Wifi Init Code\r\n");
     /* Initialize the Timer. */
@@ -1027,12 +1109,12 @@ void vWifiTask(void *pvParameters)
     param.pfAppWifiCb = wifi_cb;
     ret = m2m_wifi_init(&param);
     if (M2M_SUCCESS != ret) {
-        LogMessage(LOG_DEBUG_LVL, "main: m2m_wifi_init call error! (res %d)\r\n", ret);
+        LOG_DEBUG(WIFI, "main: m2m_wifi_init call error! (res %d)\r\n", ret);
         while (1) {
         }
     }
 
-    LogMessage(LOG_DEBUG_LVL, "main: connecting to WiFi AP %s...\r\n", (char *)MAIN_WLAN_SSID);
+    LOG_DEBUG(WIFI, "main: connecting to WiFi AP %s...\r\n", (char *)MAIN_WLAN_SSID);
 
     // Re-enable socket for MQTT Transfer
     socketInit();
@@ -1045,6 +1127,8 @@ void vWifiTask(void *pvParameters)
         m2m_wifi_handle_events(NULL);
         /* Checks the timer timeout. */
         sw_timer_task(&swt_module_inst);
+        /* Sleep until the network controller has news. */
+        nm_bsp_wait_for_event(WIFI_EVENT_WAIT_MS);
     }
 
     vTaskDelay(1000);
@@ -1078,8 +1162,8 @@ void vWifiTask(void *pvParameters)
                 break;
         }
         // Check if a new state was called
-        uint8_t DataToReceive = 0;
-        if (pdPASS == xQueueReceive(xQueueWifiState, &DataToReceive, 0)) {
+        uint32_t DataToReceive = 0;
+        if (pdTRUE == xTaskNotifyWait(0, 0, &DataToReceive, 0)) {
             wifiStateMachine = DataToReceive;  // Update new state
         }
 
@@ -1087,23 +1171,42 @@ void vWifiTask(void *pvParameters)
         if(isPressed)
         {
             mqtt_publish(&mqtt_inst, TEMPERATURE_TOPIC, mqtt_msg_temp, strlen(mqtt_msg_temp), 1, 0);
-            LogMessage(LOG_DEBUG_LVL, "MQTT send %s\r\n", mqtt_msg_temp);
+            LOG_DEBUG(MQTT, "MQTT send %s\r\n", mqtt_msg_temp);
             isPressed = false;
 
         }
 
-        vTaskDelay(100);
+        // MQTT_HandleTransactions sleeps on the publish queues instead
+        if (WIFI_MQTT_HANDLE != wifiStateMachine) {
+            vTaskDelay(WIFI_POLL_PERIOD);
+        }
     }
     return;
 }
 
 void WifiHandlerSetState(uint8_t state)
 {
-    if (state <= WIFI_DOWNLOAD_HANDLE) {
-        xQueueSend(xQueueWifiState, &state, (TickType_t)10);
+    if (state <= WIFI_DOWNLOAD_HANDLE && NULL != wifiTask) {
+        xTaskNotify(wifiTask, state, eSetValueWithOverwrite);
     }
 }
 
+/**
+ EventBits_t WifiWaitForNetwork(EventBits_t bits, TickType_t ticksToWait)
+ * @brief	Blocks until any of the given network states is reached, e.g. WIFI_CONNECTED or MQTT_CONNECTED
+ * @param[in]	bits download_state bits to wait for
+ * @param[in]	ticksToWait Most ticks to wait, 0 to only check
+ * @return		The network state bits when the wait ended. None of the requested bits are set on timeout
+ * @note		Not from the Wifi task: it is the one that moves the network state on
+ */
+EventBits_t WifiWaitForNetwork(EventBits_t bits, TickType_t ticksToWait)
+{
+    if (NULL == networkEvents) {
+        return 0;
+    }
+    return xEventGroupWaitBits(networkEvents, bits, pdFALSE, pdFALSE, ticksToWait);
+}
+
 /**
  void WifiAddImuDataToQueue(struct ImuDataPacket* imuPacket)
  * @brief	Adds an IMU struct to the queue to send via MQTT
@@ -1145,6 +1248,16 @@ int WifiAddDistanceDataToQueue(uint16_t *distance)
 */
 int WifiAddGameDataToQueue(struct GameDataPacket *game)
 {
-    int error = xQueueSend(xQueueGameBuffer, game, (TickType_t)10);
+    struct GameDataPacket *block = MemoryPoolAlloc(&fragmentPool);
+    int error = pdFALSE;
+
+    // The queue passes the block, not a copy of the game
+    if (NULL != block) {
+        memcpy(block, game, sizeof(struct GameDataPacket));
+        error = xQueueSend(xQueueGameBuffer, &block, (TickType_t)10);
+        if (pdTRUE != error) {
+            MemoryPoolFree(&fragmentPool, block);
+        }
+    }
     return error;
 }
@@ -59,6 +59,7 @@ extern "C" {
 #define MAIN_ZERO_FMT(SZ) (SZ == 4) ? "%04d" : (SZ == 3) ? "%03d" : (SZ == 2) ? "%02d" : "%d"
 #define GAME_SIZE 20  ///< Number of plays in game
 
+/** Network state, published as the bits of the network event group. See WifiWaitForNetwork. */
 typedef enum {
     NOT_READY = 0,         /*!< Not ready. */
     STORAGE_READY = 0x01,  /*!< Storage is ready. */
@@ -66,7 +67,8 @@ typedef enum {
     GET_REQUESTED = 0x04,  /*!< GET request is sent. */
     DOWNLOADING = 0x08,    /*!< Running to download. */
     COMPLETED = 0x10,      /*!< Download completed. */
-    CANCELED = 0x20        /*!< Download canceled. */
+    CANCELED = 0x20,       /*!< Download canceled. */
+    MQTT_CONNECTED = 0x40  /*!< Connected to the MQTT broker. */
 } download_state;
 
 // Structure definition that holds IMU data
@@ -156,6 +158,7 @@ static const char main_mqtt_broker[] = "broker.hivemq.com";
 void vWifiTask(void *pvParameters);
 void init_storage(void);
 void WifiHandlerSetState(uint8_t state);
+EventBits_t WifiWaitForNetwork(EventBits_t bits, TickType_t ticksToWait);
 int WifiAddDistanceDataToQueue(uint16_t *distance);
 int WifiAddImuDataToQueue(struct ImuDataPacket *imuPacket);
 int WifiAddGameDataToQueue(struct GameDataPacket *game);
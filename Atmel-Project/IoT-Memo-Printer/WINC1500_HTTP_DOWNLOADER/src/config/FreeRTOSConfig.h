@@ -42,18 +42,23 @@
 #include <gclk.h>
 #include <stdint.h>
 void assert_triggered(const char *file, uint32_t line);
+void RunTimeStatsTimerInit(void);
+uint32_t RunTimeStatsTimerGet(void);
+void PowerSuppressTicksAndSleep(uint32_t expectedIdleTime);
 #endif
 
 #define configUSE_PREEMPTION 1
 #define configUSE_IDLE_HOOK 0
+#define configUSE_TICKLESS_IDLE 1
 #define configUSE_TICK_HOOK 0
 #define configPRIO_BITS 2
 #define configCPU_CLOCK_HZ (system_gclk_gen_get_hz(GCLK_GENERATOR_0))
 #define configTICK_RATE_HZ ((portTickType)1000)
 #define configMAX_PRIORITIES (5)
 #define configMINIMAL_STACK_SIZE ((unsigned short)150)
-/* configTOTAL_HEAP_SIZE is not used when heap_3.c is used. */
-#define configTOTAL_HEAP_SIZE ((size_t)(13000))
+/* Heap of Memory/Heap.c: the pools of Memory/MemoryPool.h, the CLI command list and the bench kernels. Every
+kernel object is static, in the RAM plan of RamPlan/RamPlan.h. */
+#define configTOTAL_HEAP_SIZE ((size_t)(2048))
 #define configMAX_TASK_NAME_LEN (8)
 #define configUSE_TRACE_FACILITY 1
 #define configUSE_16_BIT_TICKS 0
@@ -63,12 +68,21 @@ void assert_triggered(const char *file, uint32_t line);
 #define configCHECK_FOR_STACK_OVERFLOW 1
 #define configUSE_RECURSIVE_MUTEXES 1
 #define configUSE_MALLOC_FAILED_HOOK 1
+#define configSUPPORT_STATIC_ALLOCATION 1
+#define configSUPPORT_DYNAMIC_ALLOCATION 0
 #define configUSE_COUNTING_SEMAPHORES 1
 #define configUSE_QUEUE_SETS 1
-#define configGENERATE_RUN_TIME_STATS 0
+#define configGENERATE_RUN_TIME_STATS 1
 #define configENABLE_BACKWARD_COMPATIBILITY 1
 #define configUSE_DAEMON_TASK_STARTUP_HOOK 1  // Ported from FreeRToS 9.0.0
 
+/* Run time stats time base: free running TC4/TC5 counter (RunTimeStats/RunTimeStats.h). */
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() RunTimeStatsTimerInit()
+#define portGET_RUN_TIME_COUNTER_VALUE() RunTimeStatsTimerGet()
+
+/* Tickless idle on the 32 kHz TCC1, in the deepest mode the sleep manager allows (Power/Power.h). */
+#define portSUPPRESS_TICKS_AND_SLEEP(xExpectedIdleTime) PowerSuppressTicksAndSleep(xExpectedIdleTime)
+
 /* Co-routine definitions. */
 #define configUSE_CO_ROUTINES 0
 #define configMAX_CO_ROUTINE_PRIORITIES (2)
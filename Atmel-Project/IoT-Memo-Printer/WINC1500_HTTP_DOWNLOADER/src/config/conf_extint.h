@@ -33,6 +33,7 @@
 #ifndef CONF_EXTINT_H_INCLUDED
 #define CONF_EXTINT_H_INCLUDED
 
-#  define EXTINT_CLOCK_SOURCE      GCLK_GENERATOR_0
+/* GCLK2 (32 kHz) runs in standby, so the button and WINC1500 IRQ edges still wake the CPU from tickless idle */
+#  define EXTINT_CLOCK_SOURCE      GCLK_GENERATOR_2
 
 #endif
@@ -39,6 +39,7 @@
 #include <errno.h>
 
 #define DEFAULT_USER_AGENT "atmel/1.0.2"
+#define HTTP_EVENT_WAIT_MS 100 /* Longest sleep waiting for the send callback, for the software timers */
 
 #define MIN_SEND_BUFFER_SIZE 18 + HTTP_MAX_URI_LENGTH /* DELETE {URI} HTTP/1.1\r\n */
 
@@ -572,6 +573,10 @@ int _http_client_send_wait(void *_module, char *buffer, size_t buffer_len)
 	while (module->sending == 1 && module->req.state > STATE_SOCK_CONNECTED){
 		m2m_wifi_handle_events(NULL);
 		sw_timer_task(module->config.timer_inst);
+		if (module->sending == 1) {
+			/* Sleep until the send callback can have come. */
+			nm_bsp_wait_for_event(HTTP_EVENT_WAIT_MS);
+		}
 	}
 
 	return 0;
@@ -821,8 +826,8 @@ int _http_client_handle_header(struct http_client_module *const module)
 
 	for (ptr = module->config.recv_buffer ; ; ) {
 		ptr_line_end = strstr(ptr, new_line);
-		if (ptr_line_end == NULL || ptr_line_end >= module->config.recv_buffer + module->recved_size) {
-			/* not enough buffer. */
+		if (ptr_line_end == NULL || ptr_line_end + strlen(new_line) > module->config.recv_buffer + module->recved_size) {
+			/* not enough buffer. The new line must be received in full, not matched against stale data after it. */
 			_http_client_move_buffer(module, ptr);
 			return 0;
 		}
@@ -1041,7 +1046,7 @@ int _http_client_handle_entity(struct http_client_module *const module)
 void _http_client_move_buffer(struct http_client_module *const module, char *base)
 {
 	char *buffer = module->config.recv_buffer;
-	int remain = (int)module->recved_size - (int)base + (int)buffer;
+	int remain = (int)module->recved_size - (int)(base - buffer);
 
 	if (remain > 0) {
 		memmove(buffer, base, remain);
@@ -32,10 +32,30 @@
  */
 
 #include "sw_timer.h"
+#include "Power/Power.h"
 
 /** Tick count of timer. */
 static uint32_t sw_timer_tick = 0;
 
+/**
+ * \brief Enables or disables the callback of a handler.
+ *
+ * The TCC stops in standby, so every enabled callback holds the CPU out of
+ * it: a timeout must not stand still while the CPU waits for the network.
+ *
+ * \param[in]  handler         Handler of the callback.
+ * \param[in]  enable          1 to enable the callback, 0 to disable it.
+ */
+static void sw_timer_set_callback_enable(struct sw_timer_handle *handler, uint8_t enable)
+{
+	if (enable && !handler->callback_enable) {
+		sleepmgr_lock_mode(POWER_PERIPHERAL_LOCK);
+	} else if (!enable && handler->callback_enable) {
+		sleepmgr_unlock_mode(POWER_PERIPHERAL_LOCK);
+	}
+	handler->callback_enable = enable;
+}
+
 /**
  * \brief TCC callback of SW timer.
  *
@@ -183,6 +203,7 @@ void sw_timer_unregister_callback(struct sw_timer_module *const module_inst, int
 
 	handler = &module_inst->handler[timer_id];
 
+	sw_timer_set_callback_enable(handler, 0);
 	handler->used = 0;
 }
 
@@ -195,8 +216,8 @@ void sw_timer_enable_callback(struct sw_timer_module *const module_inst, int tim
 
 	handler = &module_inst->handler[timer_id];
 
-	handler->callback_enable = 1;
 	handler->expire_time = sw_timer_tick + (delay / module_inst->accuracy);
+	sw_timer_set_callback_enable(handler, 1);
 }
 
 void sw_timer_disable_callback(struct sw_timer_module *const module_inst, int timer_id)
@@ -208,7 +229,7 @@ void sw_timer_disable_callback(struct sw_timer_module *const module_inst, int ti
 
 	handler = &module_inst->handler[timer_id];
 
-	handler->callback_enable = 0;
+	sw_timer_set_callback_enable(handler, 0);
 }
 
 void sw_timer_task(struct sw_timer_module *const module_inst)
@@ -229,7 +250,7 @@ void sw_timer_task(struct sw_timer_module *const module_inst)
 					handler->expire_time = sw_timer_tick + handler->period;
 				} else {
 					/* One shot. */
-					handler->callback_enable = 0;
+					sw_timer_set_callback_enable(handler, 0);
 				}
 				/* Call callback function. */
 				handler->callback(module_inst, index, handler->context, handler->period);
@@ -20,7 +20,11 @@
 #include "DistanceDriver\DistanceSensor.h"
 #include "FreeRTOS.h"
 #include "IMU\lsm6dso_reg.h"
+#include "Memory/MemoryPool.h"
+#include "Power/Power.h"
+#include "RamPlan/RamPlan.h"
 #include "SeesawDriver/Seesaw.h"
+#include "SensorStream/SensorStream.h"
 #include "SerialConsole.h"
 #include "UiHandlerThread\UiHandlerThread.h"
 #include "WifiHandlerThread/WifiHandler.h"
@@ -46,6 +50,8 @@ void vApplicationDaemonTaskStartupHook(void);
 void vApplicationStackOverflowHook(void);
 void vApplicationMallocFailedHook(void);
 void vApplicationTickHook(void);
+void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint32_t *pulIdleTaskStackSize);
+void vApplicationGetTimerTaskMemory(StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer, uint32_t *pulTimerTaskStackSize);
 
 /****
  * Variables
@@ -55,8 +61,22 @@ static TaskHandle_t daemonTaskHandle = NULL;   //!< Daemon task handle
 static TaskHandle_t wifiTaskHandle = NULL;     //!< Wifi task handle
 static TaskHandle_t uiTaskHandle = NULL;       //!< UI task handle
 static TaskHandle_t controlTaskHandle = NULL;  //!< Control task handle
-
-char bufferPrint[64];  ///< Buffer for daemon task
+static TaskHandle_t streamTaskHandle = NULL;   //!< Sensor stream task handle
+
+static StackType_t idleTaskStack[configMINIMAL_STACK_SIZE] RAM_PLAN(kernel);        //!< Idle task stack
+static StaticTask_t idleTaskBuffer RAM_PLAN(kernel);                                 //!< Idle task control block
+static StackType_t timerTaskStack[configTIMER_TASK_STACK_DEPTH] RAM_PLAN(kernel);   //!< Timer (daemon) task stack
+static StaticTask_t timerTaskBuffer RAM_PLAN(kernel);                                //!< Timer (daemon) task control block
+static StackType_t cliTaskStack[CLI_TASK_SIZE] RAM_PLAN(cli);                        //!< CLI task stack
+static StaticTask_t cliTaskBuffer RAM_PLAN(cli);                                     //!< CLI task control block
+static StackType_t wifiTaskStack[WIFI_TASK_SIZE] RAM_PLAN(wifi);                     //!< Wifi task stack
+static StaticTask_t wifiTaskBuffer RAM_PLAN(wifi);                                   //!< Wifi task control block
+static StackType_t uiTaskStack[UI_TASK_SIZE] RAM_PLAN(ui);                           //!< UI task stack
+static StaticTask_t uiTaskBuffer RAM_PLAN(ui);                                       //!< UI task control block
+static StackType_t controlTaskStack[CONTROL_TASK_SIZE] RAM_PLAN(control);            //!< Control task stack
+static StaticTask_t controlTaskBuffer RAM_PLAN(control);                             //!< Control task control block
+static StackType_t streamTaskStack[SENSOR_STREAM_TASK_SIZE] RAM_PLAN(stream);        //!< Sensor stream task stack
+static StaticTask_t streamTaskBuffer RAM_PLAN(stream);                               //!< Sensor stream task control block
 
 /**
  * @brief Main application function.
@@ -68,6 +88,9 @@ int main(void)
     /* Initialize the board. */
     system_init();
 
+    // Sleep manager and the tickless idle timer. Before any driver takes a sleep lock
+    PowerInit();
+
     /* Initialize the UART console. */
     InitializeSerialConsole();
 
@@ -139,36 +162,43 @@ void vApplicationDaemonTaskStartupHook(void)
  */
 static void StartTasks(void)
 {
-    snprintf(bufferPrint, 64, "Heap before starting tasks: %d\r\n", xPortGetFreeHeapSize());
-    SerialConsoleWriteString(bufferPrint);
-
-    // Initialize Tasks here
-
-    if (xTaskCreate(vCommandConsoleTask, "CLI_TASK", CLI_TASK_SIZE, NULL, CLI_PRIORITY, &cliTaskHandle) != pdPASS) {
-        SerialConsoleWriteString("ERR: CLI task could not be initialized!\r\n");
-    }
-
-    snprintf(bufferPrint, 64, "Heap after starting CLI: %d\r\n", xPortGetFreeHeapSize());
-    SerialConsoleWriteString(bufferPrint);
-
-    if (xTaskCreate(vWifiTask, "WIFI_TASK", WIFI_TASK_SIZE, NULL, WIFI_PRIORITY, &wifiTaskHandle) != pdPASS) {
-        SerialConsoleWriteString("ERR: WIFI task could not be initialized!\r\n");
-    }
-    snprintf(bufferPrint, 64, "Heap after starting WIFI: %d\r\n", xPortGetFreeHeapSize());
-    SerialConsoleWriteString(bufferPrint);
-
-    if (xTaskCreate(vUiHandlerTask, "UI Task", UI_TASK_SIZE, NULL, UI_TASK_PRIORITY, &uiTaskHandle) != pdPASS) {
-        SerialConsoleWriteString("ERR: UI task could not be initialized!\r\n");
+    MemoryPoolsInit();
+    UiHandlerInit();
+
+    // Stacks and control blocks are in the RAM plan, so creating a task cannot fail
+    cliTaskHandle = xTaskCreateStatic(vCommandConsoleTask, "CLI_TASK", CLI_TASK_SIZE, NULL, CLI_PRIORITY, cliTaskStack, &cliTaskBuffer);
+    wifiTaskHandle = xTaskCreateStatic(vWifiTask, "WIFI_TASK", WIFI_TASK_SIZE, NULL, WIFI_PRIORITY, wifiTaskStack, &wifiTaskBuffer);
+    uiTaskHandle = xTaskCreateStatic(vUiHandlerTask, "UI Task", UI_TASK_SIZE, NULL, UI_TASK_PRIORITY, uiTaskStack, &uiTaskBuffer);
+    controlTaskHandle =
+        xTaskCreateStatic(vControlHandlerTask, "Control Task", CONTROL_TASK_SIZE, NULL, CONTROL_TASK_PRIORITY, controlTaskStack, &controlTaskBuffer);
+    streamTaskHandle =
+        xTaskCreateStatic(vSensorStreamTask, "STREAM", SENSOR_STREAM_TASK_SIZE, NULL, SENSOR_STREAM_PRIORITY, streamTaskStack, &streamTaskBuffer);
+
+    if (RamPlanReport() != 0) {
+        SerialConsoleWriteString("ERR: The RAM plan does not hold!\r\n");
     }
+}
 
-    snprintf(bufferPrint, 64, "Heap after starting UI Task: %d\r\n", xPortGetFreeHeapSize());
-    SerialConsoleWriteString(bufferPrint);
+/**
+ * function          vApplicationGetIdleTaskMemory
+ * @brief            Hands FreeRTOS the stack and control block of the idle task, from the RAM plan
+ */
+void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint32_t *pulIdleTaskStackSize)
+{
+    *ppxIdleTaskTCBBuffer = &idleTaskBuffer;
+    *ppxIdleTaskStackBuffer = idleTaskStack;
+    *pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
 
-    if (xTaskCreate(vControlHandlerTask, "Control Task", CONTROL_TASK_SIZE, NULL, CONTROL_TASK_PRIORITY, &controlTaskHandle) != pdPASS) {
-        SerialConsoleWriteString("ERR: Control task could not be initialized!\r\n");
-    }
-    snprintf(bufferPrint, 64, "Heap after starting Control Task: %d\r\n", xPortGetFreeHeapSize());
-    SerialConsoleWriteString(bufferPrint);
+/**
+ * function          vApplicationGetTimerTaskMemory
+ * @brief            Hands FreeRTOS the stack and control block of the timer (daemon) task, from the RAM plan
+ */
+void vApplicationGetTimerTaskMemory(StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer, uint32_t *pulTimerTaskStackSize)
+{
+    *ppxTimerTaskTCBBuffer = &timerTaskBuffer;
+    *ppxTimerTaskStackBuffer = timerTaskStack;
+    *pulTimerTaskStackSize = configTIMER_TASK_STACK_DEPTH;
 }
 
 